@@ -0,0 +1,1474 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+// Frozen copies of the mo kernels and of TempToPTemp::execute as they were before they
+// were rewritten, and of the readers of the lookup tables they called, which read the
+// netcdf files on each call. The bodies are kept as they were, but for the scratch
+// variables of evalSatVaporPressure and evalSatSpecificHumidity, made local to their
+// functors (shared, they raced between the threads of the loop). Do not change them with
+// the kernels: vader_benchmarks --verify checks the rewritten kernels against them.
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "atlas/array.h"
+#include "atlas/field.h"
+#include "atlas/functionspace.h"
+#include "atlas/util/Config.h"
+
+#include "benchmark/reference_kernels.h"
+
+#include "mo/constants.h"
+#include "mo/functions.h"
+
+#include "oops/base/Variables.h"
+#include "oops/util/Logger.h"
+
+#include "vader/vadervariables.h"
+
+using atlas::array::make_view;
+using atlas::idx_t;
+using atlas::util::Config;
+
+namespace mo {
+namespace reference {
+namespace functions {
+
+using mo::functions::parallelFor;
+using mo::functions::umGetLookUp2D_f90;
+using mo::functions::umGetLookUp_f90;
+
+std::vector<double> getLookUp(const std::string & sVPFilePath,
+                              const std::string & shortName,
+                              const std::size_t lookupSize) {
+  std::vector<double> values(lookupSize, 0);
+
+  umGetLookUp_f90(static_cast<int>(sVPFilePath.size()),
+                  sVPFilePath.c_str(),
+                  static_cast<int>(shortName.size()),
+                  shortName.c_str(),
+                  static_cast<int>(lookupSize),
+                  values[0]);
+
+  return std::vector<double>(values.begin(), values.end());
+}
+
+
+std::vector<std::vector<double>> getLookUps(const std::string & sVPFilePath,
+                                            const oops::Variables & vars,
+                                            const std::size_t lookupSize) {
+  std::vector<std::vector<double>> values(vars.size(), std::vector<double>(lookupSize));
+
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    values[i] = getLookUp(sVPFilePath, vars[i], lookupSize);
+  }
+
+  return values;
+}
+
+void getMIOFields(atlas::FieldSet & augStateFlds) {
+  const auto rhtView = make_view<const double, 2>(augStateFlds["rht"]);
+  const auto clView = make_view<const double, 2>
+                (augStateFlds["liquid_cloud_volume_fraction_in_atmosphere_layer"]);
+  const auto cfView = make_view<const double, 2>
+                (augStateFlds["ice_cloud_volume_fraction_in_atmosphere_layer"]);
+
+  auto cleffView = make_view<double, 2>(augStateFlds["cleff"]);
+  auto cfeffView = make_view<double, 2>(augStateFlds["cfeff"]);
+
+  Eigen::MatrixXd mioCoeffCl = createMIOCoeff(constants::mioCoefficientsFilePath, "qcl_coef");
+  Eigen::MatrixXd mioCoeffCf = createMIOCoeff(constants::mioCoefficientsFilePath, "qcf_coef");
+
+  for  (atlas::idx_t jn = 0; jn < augStateFlds["rht"].shape(0); ++jn) {
+    for (int jl = 0; jl < augStateFlds["rht"].levels(); ++jl) {
+      if (jl < constants::mioLevs) {
+        std::size_t ibin = (rhtView(jn, jl) > 1.0) ? constants::mioBins - 1 :
+                           static_cast<std::size_t>(floor(rhtView(jn, jl) / constants::rHTBin));
+
+        std::double_t ceffdenom = (1.0 -  clView(jn, jl) * cfView(jn, jl) );
+        if (ceffdenom > constants::tol) {
+          std::double_t clcf = clView(jn, jl) * cfView(jn, jl);
+          cleffView(jn, jl) = mioCoeffCl(jl, ibin) * (clView(jn, jl) - clcf) / ceffdenom;
+          cfeffView(jn, jl) = mioCoeffCf(jl, ibin) * (cfView(jn, jl) - clcf) / ceffdenom;
+        } else {
+          cleffView(jn, jl) = 0.5;
+          cfeffView(jn, jl) = 0.5;
+        }
+      } else {
+        cleffView(jn, jl) = 0.0;
+        cfeffView(jn, jl) = 0.0;
+      }
+    }
+  }
+}
+
+Eigen::MatrixXd createMIOCoeff(const std::string mioFileName,
+                               const std::string s)
+{
+    Eigen::MatrixXd mioCoeff(static_cast<std::size_t>(constants::mioLevs),
+                             static_cast<std::size_t>(constants::mioBins));
+
+    std::vector<double> valuesvec(constants::mioLookUpLength, 0);
+
+    umGetLookUp2D_f90(static_cast<int>(mioFileName.size()),
+                      mioFileName.c_str(),
+                      static_cast<int>(s.size()),
+                      s.c_str(),
+                      static_cast<int>(constants::mioBins),
+                      static_cast<int>(constants::mioLevs),
+                      valuesvec[0]);
+
+    for (int j = 0; j < constants::mioLevs; ++j) {
+        for (int i = 0; i < constants::mioBins; ++i) {
+            // Fortran returns column major order, but C++ needs row major
+            mioCoeff(j, i) = valuesvec[i * constants::mioLevs+j];
+        }
+    }
+    return mioCoeff;
+}
+
+}  // namespace functions
+
+// ------------------------------------------------------------------------------------------------
+// mo/common_varchange.cc
+
+bool evalSatVaporPressure(atlas::FieldSet & fields)
+{
+  oops::Log::trace() << "[svp()] starting ..." << std::endl;
+
+  // normalised T lambda function
+  // which enforces upper and lower bounds on T
+  auto normalisedT = [](const double tVal) {
+    double t = (tVal - constants::TLoBound)/constants::Tinc;
+    double t1 = (t < 0.0 ? 0.0 : t);
+    double t2 = (t1 >= static_cast<double>(constants::svpLookUpLength - 1)) ?
+                       static_cast<double>(constants::svpLookUpLength - 1) : t1;
+    return t2;
+  };
+
+  // lambda function returning the index of a given temperature value;
+  // avoids returning last index in table
+  auto index = [](const double normalisedTVal) {
+    std::size_t i = static_cast<std::size_t>(normalisedTVal);
+    return (i == constants::svpLookUpLength - 1 ? constants::svpLookUpLength - 2 : i);
+  };
+
+  // weight lamba function
+  auto weight = [index](const double normalisedTVal) {
+    std::size_t i = index(normalisedTVal);
+    return ( normalisedTVal -  static_cast<double>(i) );
+  };
+
+  // lambda function to interpolate values from table to given temperature
+  auto interp = [](const double weight, const double v1, const double v2) {
+     return (weight * v2 + (1 - weight) * v1);
+  };
+
+  // lambda function to determine the gradient of variable in table
+  // with respect to temperature
+  auto normalisedDiff = [](const double v1, const double v2) {
+     return (v2 - v1)/ constants::Tinc;
+  };
+
+  // The check for the presence of required input fields will be performed by the Vader
+  // algorithm when this code is in a Vader Recipe. At that time this check can be removed.
+  if ( !fields.has(vader::VV_TS) ||
+       !fields.has(vader::VV_SVP)) {
+    return false;
+  }
+
+  if (fields[vader::VV_SVP].shape(0) != fields[vader::VV_TS].shape(0)
+      || fields[vader::VV_SVP].levels() != fields[vader::VV_TS].levels()) {
+    // svp field not compatible with air temperature field, cannot continue.
+    return false;
+  }
+  const auto tView  = make_view<const double, 2>(fields["air_temperature"]);
+  const std::vector<std::string> vars{"svp", "dlsvp", "svpW", "dlsvpW"};
+  oops::Variables lookUpVars(vars);
+  auto lookUpData = functions::getLookUps(constants::commonVarChangeFilePath, lookUpVars,
+                               constants::svpLookUpLength);
+
+  const std::vector<std::string> fnames {"svp", "dlsvpdT"};
+  int ival = 0;  // set ival = 2 to get svp wrt water
+  for (auto & ef : fnames) {
+    if (fields.has(ef)) {
+      auto svpView = make_view<double, 2>(fields[ef]);
+
+      auto conf = atlas::util::Config("levels", fields[ef].levels()) |
+                  atlas::util::Config("include_halo", true);
+
+      // check this recipe to calculate svp is correct
+      const std::vector<double> Lookup = lookUpData[ival];
+      ++ival;
+      auto evaluateSVP = [&] (atlas::idx_t i, atlas::idx_t j) {
+      const std::size_t indx = index(normalisedT(tView(i, j)));
+      const double w = weight(normalisedT(tView(i, j)));
+      svpView(i, j) = interp(w, Lookup.at(indx), Lookup.at(indx+1)); };
+
+      auto fspace = fields[ef].functionspace();
+
+      functions::parallelFor(fspace, evaluateSVP, conf);
+    }
+  }
+
+  oops::Log::trace() << "[svp()] ... exit" << std::endl;
+
+  return true;
+}
+
+bool evalSatSpecificHumidity(atlas::FieldSet & fields)
+{
+  oops::Log::trace() << "[getQsat()] starting ..." << std::endl;
+
+  const auto pbarView = make_view<const double, 2>(fields["air_pressure"]);
+  const auto svpView = make_view<const double, 2>(fields["svp"]);
+  const auto tView = make_view<const double, 2>(fields["air_temperature"]);
+  auto qsatView = make_view<double, 2>(fields["qsat"]);
+
+  auto conf = atlas::util::Config("levels", fields["qsat"].levels()) |
+              atlas::util::Config("include_halo", true);
+
+  auto evaluateQsat = [&] (atlas::idx_t i, atlas::idx_t j) {
+    // This formula for fsubw
+    // is taken from equation A4.7 of Adrian Gill's book: Atmosphere-Ocean
+    // Dynamics.  Note that his formula works in terms of pressure in MB and
+    // temperature in Celsius, so conversion of units leads to the slightly
+    // different equation used here.
+    const double fsubw = 1.0 + 1.0E-8 * pbarView(i, j) * (4.5 +
+            6.0e-4 * (tView(i, j) - constants::zerodegc) *
+                     (tView(i, j) - constants::zerodegc));
+
+    // Note that at very low pressures we apply a fix, to prevent a
+    // singularity (Qsat tends to 1.0 kg/kg).
+    qsatView(i, j) = fsubw * constants::rd_over_rv * svpView(i, j) /
+          (std::max(pbarView(i, j), svpView(i, j)) -
+          (1.0 - constants::rd_over_rv) * svpView(i, j));
+  };
+
+  auto fspace = fields["qsat"].functionspace();
+
+  functions::parallelFor(fspace, evaluateQsat, conf);
+
+  oops::Log::trace() << "[getQsat()] ... exit" << std::endl;
+
+  return true;
+}
+
+bool evalAirPressureLevels(atlas::FieldSet & fields)
+{
+  oops::Log::trace() << "[evalAirPressureLevels()] starting ..." << std::endl;
+
+  const auto ds_elmo = make_view<const double, 2>(fields["exner_levels_minus_one"]);
+  const auto ds_plmo = make_view<const double, 2>(fields["air_pressure_levels_minus_one"]);
+  const auto ds_t = make_view<const double, 2>(fields["potential_temperature"]);
+  const auto ds_hl = make_view<const double, 2>(fields["height_levels"]);
+  auto ds_pl = make_view<double, 2>(fields["air_pressure_levels"]);
+
+  idx_t levels(fields["air_pressure_levels"].levels());
+  for (idx_t jn = 0; jn < fields["air_pressure_levels"].shape(0); ++jn) {
+    for (idx_t jl = 0; jl < levels - 1; ++jl) {
+      ds_pl(jn, jl) = ds_plmo(jn, jl);
+    }
+
+    // Note that I am calculating the exner pressure above the top first and then
+    // converting it to pressure
+    // Note that strictly speaking we should be using virtual potential temperature here
+    // but given that there should be no moisture at the top of the model, we should be
+    // able to ignore that contribution.
+    //
+    // exner^k+1 = exner^k - g (height^k+1 - height^k) / (cp theta_v)
+    //
+    // pressure^k+1 = reference_pressure * (exner^k+1)**((1.0 / constants::rd_over_cp)
+    //
+    // where k is the model level index on half levels just below model top.
+
+    ds_pl(jn, levels-1) =  constants::p_zero * pow(
+      ds_elmo(jn, levels-2) - (constants::grav * (ds_hl(jn, levels-1) - ds_hl(jn, levels-2))) /
+      (constants::cp * ds_t(jn, levels-2)), (1.0 / constants::rd_over_cp));
+
+    ds_pl(jn, levels-1) = ds_pl(jn, levels-1) > 0.0 ? ds_pl(jn, levels-1) : constants::deps;
+  }
+
+  oops::Log::trace() << "[evalAirPressureLevels()] ... exit" << std::endl;
+
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+// mo/common_linearvarchange.cc
+
+/// \details Calculate the tangent linear of virtual potential temperature
+///          from the specific humidity and the potential temperature.
+void evalVirtualPotentialTemperatureTL(atlas::FieldSet & incFlds,
+                                       const atlas::FieldSet & augStateFlds) {
+  const auto qView = make_view<const double, 2>(augStateFlds["specific_humidity"]);
+  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
+  const auto qIncView = make_view<const double, 2>(incFlds["specific_humidity"]);
+  const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
+  auto vthetaIncView = make_view<double, 2>(incFlds["virtual_potential_temperature"]);
+
+  auto fspace = incFlds["virtual_potential_temperature"].functionspace();
+
+  auto evaluateVThetaTL = [&] (idx_t i, idx_t j) {
+    vthetaIncView(i, j) = thetaView(i, j) * constants::c_virtual * qIncView(i, j) +
+        thetaIncView(i, j) * (1.0 + constants::c_virtual * qView(i, j));
+  };
+
+  auto conf = Config("levels", incFlds["virtual_potential_temperature"].levels()) |
+              Config("include_halo", true);
+
+  functions::parallelFor(fspace, evaluateVThetaTL, conf);
+}
+
+/// \details Calculate the tangent linear of virtual potential temperature
+///          from the specific humidity and the potential temperature.
+void evalVirtualPotentialTemperatureAD(atlas::FieldSet & hatFlds,
+                                       const atlas::FieldSet & augStateFlds) {
+  const auto qView = make_view<const double, 2>(augStateFlds["specific_humidity"]);
+  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
+  auto qHatView = make_view<double, 2>(hatFlds["specific_humidity"]);
+  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
+  auto vthetaHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
+
+  auto fspace = hatFlds["virtual_potential_temperature"].functionspace();
+
+  auto evaluateVThetaAD = [&] (idx_t i, idx_t j) {
+    qHatView(i, j) += thetaView(i, j) * constants::c_virtual * vthetaHatView(i, j);
+    thetaHatView(i, j) +=  vthetaHatView(i, j) * (1.0 + constants::c_virtual * qView(i, j));
+    vthetaHatView(i, j) = 0;
+  };
+
+  auto conf = Config("levels", hatFlds["virtual_potential_temperature"].levels()) |
+              Config("include_halo", true);
+
+  functions::parallelFor(fspace, evaluateVThetaAD, conf);
+}
+
+// ------------------------------------------------------------------------------------------------
+// mo/control2analysis_varchange.cc
+
+void hexner2PThetav(atlas::FieldSet & fields) {
+  const auto rpView = make_view<const double, 2>(fields["height_levels"]);
+  const auto hexnerView = make_view<const double, 2>(fields["hydrostatic_exner_levels"]);
+  auto pView = make_view<double, 2>(fields["air_pressure_levels_minus_one"]);
+  auto vthetaView = make_view<double, 2>(fields["virtual_potential_temperature"]);
+
+  for (idx_t jn = 0; jn < fields["hydrostatic_exner_levels"].shape(0); ++jn) {
+    pView(jn, 0) = constants::p_zero * pow(hexnerView(jn, 0), (constants::cp / constants::rd));
+
+    for (idx_t jl = 1; jl < fields["hydrostatic_exner_levels"].levels(); ++jl) {
+      vthetaView(jn, jl) = -constants::grav * (rpView(jn, jl) - rpView(jn, jl-1)) /
+         (constants::cp * (hexnerView(jn, jl) - hexnerView(jn, jl-1)));
+    }
+    vthetaView(jn, 0) = vthetaView(jn, 1);
+  }
+}
+
+void evalVirtualPotentialTemperature(atlas::FieldSet & fields) {
+  const auto qView = make_view<const double, 2>(fields["specific_humidity"]);
+  const auto thetaView = make_view<const double, 2>(fields["potential_temperature"]);
+  auto vthetaView = make_view<double, 2>(fields["virtual_potential_temperature"]);
+
+  auto fspace = fields["virtual_potential_temperature"].functionspace();
+
+  auto evaluateVTheta = [&] (idx_t i, idx_t j) {
+    vthetaView(i, j) = thetaView(i, j) * (1.0 + constants::c_virtual * qView(i, j)); };
+
+  auto conf = Config("levels", fields["virtual_potential_temperature"].levels()) |
+              Config("include_halo", true);
+
+  functions::parallelFor(fspace, evaluateVTheta, conf);
+}
+
+/// \details Calculate the hydrostatic exner pressure (on levels)
+///          using air_pressure_minus_one and virtual potential temperature.
+void evalHydrostaticExnerLevels(atlas::FieldSet & fields) {
+  const auto rpView = make_view<const double, 2>(fields["height_levels"]);
+  const auto vthetaView = make_view<const double, 2>(fields["virtual_potential_temperature"]);
+  const auto pView = make_view<const double, 2>(fields["air_pressure_levels_minus_one"]);
+  auto hexnerView = make_view<double, 2>(fields["hydrostatic_exner_levels"]);
+
+  for (idx_t jn = 0; jn < fields["hydrostatic_exner_levels"].shape(0); ++jn) {
+    hexnerView(jn, 0) = pow(pView(jn, 0) / constants::p_zero,
+      constants::rd_over_cp);
+    for (idx_t jl = 1; jl < fields["hydrostatic_exner_levels"].levels(); ++jl) {
+      hexnerView(jn, jl) = hexnerView(jn, jl-1) -
+        (constants::grav * (rpView(jn, jl) - rpView(jn, jl-1))) /
+        (constants::cp * vthetaView(jn, jl-1));
+    }
+  }
+}
+
+
+/// \details Calculate the hydrostatic pressure (on levels)
+///           from hydrostatic exner
+void evalHydrostaticPressureLevels(atlas::FieldSet & fields) {
+  const auto hexnerView = make_view<double, 2>(fields["hydrostatic_exner_levels"]);
+  auto hpView = make_view<double, 2>(fields["hydrostatic_pressure_levels"]);
+
+  for (idx_t jn = 0; jn < fields["hydrostatic_pressure_levels"].shape(0); ++jn) {
+    for (idx_t jl = 0; jl < fields["hydrostatic_pressure_levels"].levels(); ++jl) {
+       hpView(jn, jl) = constants::p_zero *
+         pow(hexnerView(jn, jl), 1.0 / constants::rd_over_cp);
+    }
+  }
+}
+
+
+/// \details Calculate qT increment from the sum of q, qcl and qcf increments
+void qqclqcf2qt(atlas::FieldSet & fields) {
+  const auto qIncView = make_view<const double, 2>(fields["specific_humidity"]);
+  const auto qclIncView = make_view<const double, 2>
+                    (fields["mass_content_of_cloud_liquid_water_in_atmosphere_layer"]);
+  const auto qcfIncView = make_view<const double, 2>
+                    (fields["mass_content_of_cloud_ice_in_atmosphere_layer"]);
+  auto qtIncView = make_view<double, 2>(fields["qt"]);
+
+  for (atlas::idx_t jn = 0; jn < fields["specific_humidity"].shape(0); ++jn) {
+    for (atlas::idx_t jl = 0; jl < fields["specific_humidity"].levels(); ++jl) {
+      qtIncView(jn, jl) = qIncView(jn, jl) + qclIncView(jn, jl) + qcfIncView(jn, jl);
+    }
+  }
+}
+
+/// \details Calculate the dry air density
+///          from the air_pressure_levels_minus_one,
+///          air_temperature (which needs to be interpolated).
+void evalDryAirDensity(atlas::FieldSet & fields) {
+  const auto hlView = make_view<const double, 2>(fields["height_levels"]);
+  const auto hView = make_view<const double, 2>(fields["height"]);
+  const auto tView = make_view<const double, 2>(fields["air_temperature"]);
+  const auto pView = make_view<const double, 2>(fields["air_pressure_levels_minus_one"]);
+  auto rhoView = make_view<double, 2>(fields["dry_air_density_levels_minus_one"]);
+
+  for (idx_t jn = 0; jn < fields["dry_air_density_levels_minus_one"].shape(0); ++jn) {
+    rhoView(jn, 0) = pView(jn, 0) / (constants::rd * tView(jn, 0));
+    for (idx_t jl = 1; jl < fields["dry_air_density_levels_minus_one"].levels(); ++jl) {
+      rhoView(jn, jl) = pView(jn, jl) * (hView(jn, jl) - hView(jn, jl-1)) /
+        (constants::rd * (
+        (hView(jn, jl) - hlView(jn, jl)) * tView(jn, jl-1) +
+        (hlView(jn, jl) - hView(jn, jl-1)) * tView(jn, jl)));
+    }
+  }
+}
+
+/// \details Calculate exner pressure levels
+///          from air_pressure_levels_minus_one and using hydrostatic balance relation
+///          for topmost level
+void evalExnerPressureLevels(atlas::FieldSet & fields) {
+  oops::Log::trace() << "[evalAirPressureLevels()] starting ..." << std::endl;
+
+  const auto exnerMinusOneView = make_view<const double, 2>(fields["exner_levels_minus_one"]);
+  // Note that it is unclear whether this should be virtual_potential_temperature
+  // or potential_temperature in this case. Either way the difference will be tiny since
+  // the amount of moisture at a model top is tiny.
+  const auto vthetaView = make_view<const double, 2>(fields["virtual_potential_temperature"]);
+  const auto hlView = make_view<const double, 2>(fields["height_levels"]);
+  auto exnerView = make_view<double, 2>(fields["exner_pressure_levels"]);
+
+  idx_t levels(fields["exner_pressure_levels"].levels());
+  for (idx_t jn = 0; jn < fields["exner_pressure_levels"].shape(0); ++jn) {
+    for (idx_t jl = 1; jl < levels - 1; ++jl) {
+      exnerView(jn, jl) = exnerMinusOneView(jn, jl);
+    }
+
+    exnerView(jn, levels - 1) = exnerView(jn, levels - 2) -
+      (constants::grav * (hlView(jn, levels - 1) - hlView(jn, levels - 2))) /
+      (constants::cp * vthetaView(jn, levels - 2));
+
+    exnerView(jn, levels - 1) = exnerView(jn, levels-1) > 0.0 ?
+      exnerView(jn, levels - 1) : constants::deps;
+  }
+}
+
+
+void evalMoistureControlDependencies(atlas::FieldSet & fields) {
+  const auto qtView = make_view<const double, 2>(fields["qt"]);
+  const auto qView = make_view<const double, 2>(fields["specific_humidity"]);
+  const auto thetaView = make_view<const double, 2>(fields["potential_temperature"]);
+  const auto exnerView = make_view<const double, 2>(fields["exner"]);
+  const auto dlsvpdTView = make_view<const double, 2>(fields["dlsvpdT"]);
+  const auto qsatView = make_view<const double, 2>(fields["qsat"]);
+  const auto muAView = make_view<const double, 2>(fields["muA"]);
+  const auto muH1View = make_view<const double, 2>(fields["muH1"]);
+
+  // this is effectively the (2x2) matrix = A
+  //  (mu')       = A (qt')     where A is
+  //  (theta_v')      (theta')
+  //
+  //  ( muA/qsat    - (muA/qsat) muH1 qT exner_bar dlsvpdT )
+  //  (                                                 )
+  //  (c_v theta q     (1+ cv) q                        )
+  auto muRow1Column1View = make_view<double, 2>(fields["muRow1Column1"]);
+  auto muRow1Column2View = make_view<double, 2>(fields["muRow1Column2"]);
+  auto muRow2Column1View = make_view<double, 2>(fields["muRow2Column1"]);
+  auto muRow2Column2View = make_view<double, 2>(fields["muRow2Column2"]);
+  auto muRecipDeterminantView = make_view<double, 2>(fields["muRecipDeterminant"]);
+
+  // the comments below are there to allow checking with the VAR code.
+  for (atlas::idx_t jn = 0; jn < fields["potential_temperature"].shape(0); ++jn) {
+    for (atlas::idx_t jl = 0; jl < fields["potential_temperature"].levels(); ++jl) {
+      muRow1Column1View(jn, jl) = muAView(jn, jl) / qsatView(jn, jl);  // beta2 * muA
+      muRow1Column2View(jn, jl) = -  qtView(jn, jl)  * muH1View(jn, jl)
+        * exnerView(jn, jl) * dlsvpdTView(jn, jl) * muRow1Column1View(jn, jl);
+      // alpha2 * muA
+      muRow2Column1View(jn, jl) = constants::c_virtual * thetaView(jn, jl);   // beta1
+      muRow2Column2View(jn, jl) = 1.0 + constants::c_virtual * qView(jn, jl);  // alpha1
+      muRecipDeterminantView(jn, jl) = 1.0 /(
+        muRow2Column2View(jn, jl) * muRow1Column1View(jn, jl)
+        - muRow1Column2View(jn, jl) * muRow2Column1View(jn, jl));
+           // 1/( alpha1 * beta2 * muA - alpha2 * muA * beta1)
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------------------
+// mo/control2analysis_linearvarchange.cc
+
+void thetavP2HexnerTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
+  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
+  const auto thetavView = make_view<const double, 2>(
+    augStateFlds["virtual_potential_temperature"]);
+  const auto pView = make_view<const double, 2>(augStateFlds["air_pressure_levels_minus_one"]);
+  const auto hexnerView = make_view<const double, 2>(augStateFlds["hydrostatic_exner_levels"]);
+  const auto thetavIncView = make_view<const double, 2>(incFlds["virtual_potential_temperature"]);
+  const auto pIncView = make_view<const double, 2>(incFlds["air_pressure_levels_minus_one"]);
+  auto hexnerIncView = make_view<double, 2>(incFlds["hydrostatic_exner_levels"]);
+
+  for (atlas::idx_t jn = 0; jn < incFlds["hydrostatic_exner_levels"].shape(0); ++jn) {
+    hexnerIncView(jn, 0) = constants::rd_over_cp *
+      hexnerView(jn, 0) * pIncView(jn, 0) / pView(jn, 0);
+
+    for (atlas::idx_t jl = 1; jl < incFlds["hydrostatic_exner_levels"].levels(); ++jl) {
+      hexnerIncView(jn, jl) = hexnerIncView(jn, jl-1) +
+        ((constants::grav * thetavIncView(jn, jl-1) *
+          (hlView(jn, jl) - hlView(jn, jl-1))) /
+         (constants::cp * thetavView(jn, jl-1) * thetavView(jn, jl-1)));
+    }
+  }
+}
+
+void thetavP2HexnerAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
+  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
+  const auto thetavView = make_view<const double, 2>(
+    augStateFlds["virtual_potential_temperature"]);
+  const auto pView = make_view<const double, 2>(augStateFlds["air_pressure_levels_minus_one"]);
+  const auto hexnerView = make_view<const double, 2>(augStateFlds["hydrostatic_exner_levels"]);
+  auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
+  auto pHatView = make_view<double, 2>(hatFlds["air_pressure_levels_minus_one"]);
+  auto hexnerHatView = make_view<double, 2>(hatFlds["hydrostatic_exner_levels"]);
+
+  for (atlas::idx_t jn = 0; jn < hatFlds["hydrostatic_exner_levels"].shape(0); ++jn) {
+    for (atlas::idx_t jl = hatFlds["hydrostatic_exner_levels"].levels() - 1; jl > 0; --jl) {
+      thetavHatView(jn, jl-1) = thetavHatView(jn, jl-1) +
+        ((constants::grav * hexnerHatView(jn, jl) *
+        (hlView(jn, jl) - hlView(jn, jl-1))) /
+        (constants::cp * thetavView(jn, jl-1) * thetavView(jn, jl-1)));
+
+      hexnerHatView(jn, jl-1) = hexnerHatView(jn, jl-1) +
+        hexnerHatView(jn, jl);
+      hexnerHatView(jn, jl) = 0.0;
+    }
+    pHatView(jn, 0) = pHatView(jn, 0) +
+      constants::rd_over_cp *
+      hexnerView(jn, 0) * hexnerHatView(jn, 0) / pView(jn, 0);
+    hexnerHatView(jn, 0) = 0.0;
+  }
+}
+
+void hexner2ThetavTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
+  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
+  const auto thetavView = make_view<const double, 2>(augStateFlds["virtual_potential_temperature"]);
+  const auto hexnerIncView = make_view<const double, 2>(incFlds["hydrostatic_exner_levels"]);
+  auto thetavIncView = make_view<double, 2>(incFlds["virtual_potential_temperature"]);
+
+  atlas::idx_t levels = incFlds["virtual_potential_temperature"].levels();
+  for (atlas::idx_t jn = 0; jn < incFlds["virtual_potential_temperature"].shape(0); ++jn) {
+    for (atlas::idx_t jl = 0; jl < levels; ++jl) {
+      thetavIncView(jn, jl) =
+        (hexnerIncView(jn, jl+1) - hexnerIncView(jn, jl)) *
+        (constants::cp * thetavView(jn, jl) * thetavView(jn, jl)) /
+        (constants::grav * (hlView(jn, jl+1) - hlView(jn, jl)));
+    }
+  }
+}
+
+void hexner2ThetavAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
+  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
+  const auto thetavView = make_view<const double, 2>(augStateFlds["virtual_potential_temperature"]);
+  auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
+  auto hexnerHatView = make_view<double, 2>(hatFlds["hydrostatic_exner_levels"]);
+
+  atlas::idx_t levelsm1 = hatFlds["virtual_potential_temperature"].levels()-1;
+  for (atlas::idx_t jn = 0; jn < hatFlds["virtual_potential_temperature"].shape(0); ++jn) {
+    for (atlas::idx_t jl = levelsm1; jl > -1; --jl) {
+      hexnerHatView(jn, jl+1) += thetavHatView(jn, jl) *
+        (constants::cp * thetavView(jn, jl) * thetavView(jn, jl)) /
+        (constants::grav * (hlView(jn, jl+1) - hlView(jn, jl)) );
+      hexnerHatView(jn, jl) -= thetavHatView(jn, jl) *
+        (constants::cp * thetavView(jn, jl) * thetavView(jn, jl)) /
+        (constants::grav * (hlView(jn, jl+1) - hlView(jn, jl)));
+      thetavHatView(jn, jl) = 0.0;
+    }
+  }
+}
+
+void evalDryAirDensityTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
+  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
+  const auto hView = make_view<const double, 2>(augStateFlds["height"]);
+  const auto exnerView = make_view<const double, 2>(augStateFlds["exner_levels_minus_one"]);
+  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
+  const auto rhoView = make_view<const double, 2>(augStateFlds["dry_air_density_levels_minus_one"]);
+  const auto exnerIncView = make_view<const double, 2>(incFlds["exner_levels_minus_one"]);
+  const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
+  auto rhoIncView = make_view<double, 2>(incFlds["dry_air_density_levels_minus_one"]);
+
+  for (atlas::idx_t jn = 0; jn < rhoIncView.shape(0); ++jn) {
+    for (atlas::idx_t jl = 1; jl < incFlds["dry_air_density_levels_minus_one"].levels(); ++jl) {
+      rhoIncView(jn, jl) = rhoView(jn, jl) * (
+        exnerIncView(jn, jl) / exnerView(jn, jl) -
+        (((hlView(jn, jl) - hView(jn, jl-1)) * thetaIncView(jn, jl) +
+          (hView(jn, jl) - hlView(jn, jl)) * thetaIncView(jn, jl-1)) /
+         ((hlView(jn, jl) - hView(jn, jl-1)) * thetaView(jn, jl) +
+          (hView(jn, jl) - hlView(jn, jl)) * thetaView(jn, jl-1))));
+    }
+
+    rhoIncView(jn, 0) = rhoView(jn, 0) * (
+        exnerIncView(jn, 0) / exnerView(jn, 0) -
+        thetaIncView(jn, 0)/ thetaView(jn, 0));
+  }
+}
+
+void evalDryAirDensityAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
+  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
+  const auto hView = make_view<const double, 2>(augStateFlds["height"]);
+  const auto exnerView = make_view<const double, 2>(augStateFlds["exner_levels_minus_one"]);
+  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
+  const auto rhoView = make_view<const double, 2>(augStateFlds["dry_air_density_levels_minus_one"]);
+  auto exnerHatView = make_view<double, 2>(hatFlds["exner_levels_minus_one"]);
+  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
+  auto rhoHatView = make_view<double, 2>(hatFlds["dry_air_density_levels_minus_one"]);
+
+  for (atlas::idx_t jn = 0; jn < rhoHatView.shape(0); ++jn) {
+    exnerHatView(jn, 0) += rhoView(jn, 0) * rhoHatView(jn, 0) /
+      exnerView(jn, 0);
+    thetaHatView(jn, 0) -= rhoView(jn, 0) * rhoHatView(jn, 0) /
+      thetaView(jn, 0);
+    rhoHatView(jn, 0) = 0.0;
+
+    for (atlas::idx_t jl = hatFlds["dry_air_density_levels_minus_one"].levels()-1; jl >= 1; --jl) {
+      exnerHatView(jn, jl) += rhoView(jn, jl) * rhoHatView(jn, jl) /
+        exnerView(jn, jl);
+      thetaHatView(jn, jl) -= rhoView(jn, jl) * rhoHatView(jn, jl) *
+        (hlView(jn, jl) - hView(jn, jl-1)) /
+        ((hlView(jn, jl) - hView(jn, jl-1)) * thetaView(jn, jl) +
+        (hView(jn, jl) - hlView(jn, jl)) * thetaView(jn, jl-1) );
+      thetaHatView(jn, jl-1) -= rhoView(jn, jl) * rhoHatView(jn, jl) *
+        (hView(jn, jl) - hlView(jn, jl)) /
+        ((hlView(jn, jl) - hView(jn, jl-1)) * thetaView(jn, jl) +
+        (hView(jn, jl) - hlView(jn, jl)) * thetaView(jn, jl-1));
+      rhoHatView(jn, jl) = 0.0;
+    }
+  }
+}
+
+
+/// \details This calculates air temperature increments.
+void evalAirTemperatureTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
+  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
+  const auto hView = make_view<const double, 2>(augStateFlds["height"]);
+  const auto exnerLevelsView = make_view<const double, 2>(augStateFlds["exner_levels_minus_one"]);
+  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
+  const auto exnerLevelsIncView = make_view<const double, 2>(incFlds["exner_levels_minus_one"]);
+  const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
+  auto tIncView = make_view<double, 2>(incFlds["air_temperature"]);
+
+  atlas::idx_t lvls(incFlds["air_temperature"].levels());
+  atlas::idx_t lvlsm1 = lvls - 1;
+  double exnerTopVal;
+  double exnerTopIncVal;
+
+  // Active code
+  for (atlas::idx_t jn = 0; jn < tIncView.shape(0); ++jn) {
+    // Passive code: Value above model top is assumed to be in hydrostatic balance.
+    exnerTopVal = exnerLevelsView(jn, lvlsm1) -
+      (constants::grav * (hlView(jn, lvls) - hlView(jn, lvlsm1))) /
+      (constants::cp * thetaView(jn, lvlsm1));
+
+    // Active code;
+    for (atlas::idx_t jl= 0; jl < lvls - 1; ++jl) {
+       tIncView(jn, jl) = (
+         ( (hView(jn, jl) - hlView(jn, jl)) * exnerLevelsView(jn, jl + 1) +
+           (hlView(jn, jl+1)  - hView(jn, jl)) * exnerLevelsView(jn, jl) ) *
+           thetaIncView(jn, jl) +
+         ( (hView(jn, jl) - hlView(jn, jl)) * exnerLevelsIncView(jn, jl + 1) +
+           (hlView(jn, jl+1)  - hView(jn, jl)) * exnerLevelsIncView(jn, jl) ) *
+         thetaView(jn, jl) ) /
+         (hlView(jn, jl+1) - hlView(jn, jl));
+    }
+
+    exnerTopIncVal = exnerLevelsIncView(jn, lvlsm1) +
+      thetaIncView(jn, lvlsm1) * (exnerLevelsView(jn, lvlsm1) - exnerTopVal) /
+      thetaView(jn, lvlsm1);
+
+    tIncView(jn, lvlsm1) = (
+      ( (hView(jn, lvlsm1) - hlView(jn, lvlsm1)) * exnerTopVal +
+        (hlView(jn, lvls)  - hView(jn, lvlsm1)) * exnerLevelsView(jn, lvlsm1) ) *
+         thetaIncView(jn, lvlsm1) +
+      ( (hView(jn, lvlsm1) - hlView(jn, lvlsm1)) * exnerTopIncVal +
+        (hlView(jn, lvls)  - hView(jn, lvlsm1)) * exnerLevelsIncView(jn, lvlsm1) ) *
+         thetaView(jn, lvlsm1)) /
+      (hlView(jn, lvls) - hlView(jn, lvlsm1));
+  }
+}
+
+
+/// \details This calculates air temperature increments.
+void evalAirTemperatureAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
+  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
+  const auto hView = make_view<const double, 2>(augStateFlds["height"]);
+  const auto exnerLevelsView = make_view<const double, 2>(augStateFlds["exner_levels_minus_one"]);
+  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
+  auto exnerLevelsHatView = make_view<double, 2>(hatFlds["exner_levels_minus_one"]);
+  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
+  auto tHatView = make_view<double, 2>(hatFlds["air_temperature"]);
+
+  atlas::idx_t lvls(hatFlds["air_temperature"].levels());
+  atlas::idx_t lvlsm1 = lvls - 1;
+  double exnerTopVal(0);
+  double exnerTopHatVal(0);
+
+  for (atlas::idx_t jn = 0; jn < tHatView.shape(0); ++jn) {
+    // Passive code: Value above model top is assumed to be in hydrostatic balance.
+    exnerTopVal = exnerLevelsView(jn, lvlsm1) -
+      (constants::grav * (hlView(jn, lvls) - hlView(jn, lvlsm1))) /
+      (constants::cp * thetaView(jn, lvlsm1));
+
+    // Active code
+    thetaHatView(jn, lvlsm1) += ( (hView(jn, lvlsm1) - hlView(jn, lvlsm1)) * exnerTopVal +
+      (hlView(jn, lvls)  - hView(jn, lvlsm1)) * exnerLevelsView(jn, lvlsm1) ) *
+      tHatView(jn, lvlsm1) /
+      (hlView(jn, lvls) - hlView(jn, lvlsm1));
+
+    exnerTopHatVal = (hView(jn, lvlsm1) - hlView(jn, lvlsm1)) *
+      tHatView(jn, lvlsm1) * thetaView(jn, lvlsm1) /
+      (hlView(jn, lvls) - hlView(jn, lvlsm1));
+
+    exnerLevelsHatView(jn, lvlsm1) += (hlView(jn, lvls)  - hView(jn, lvlsm1)) *
+      tHatView(jn, lvlsm1) * thetaView(jn, lvlsm1) /
+      (hlView(jn, lvls) - hlView(jn, lvlsm1));
+
+    tHatView(jn, lvlsm1) = 0.0;
+
+    exnerLevelsHatView(jn, lvlsm1) += exnerTopHatVal;
+    thetaHatView(jn, lvlsm1) += exnerTopHatVal * (exnerLevelsView(jn, lvlsm1) - exnerTopVal) /
+        thetaView(jn, lvlsm1);
+    exnerTopHatVal = 0.0;
+
+
+
+    for (atlas::idx_t jl = lvls - 2; jl >= 0; --jl) {
+      thetaHatView(jn, jl) += (
+        (hView(jn, jl) - hlView(jn, jl)) * exnerLevelsView(jn, jl + 1) +
+        (hlView(jn, jl + 1) - hView(jn, jl)) * exnerLevelsView(jn, jl) ) *
+        tHatView(jn, jl) /
+        (hlView(jn, jl + 1) - hlView(jn, jl));
+
+      exnerLevelsHatView(jn, jl + 1) += (hView(jn, jl) - hlView(jn, jl)) *
+        tHatView(jn, jl) * thetaView(jn, jl) /
+        (hlView(jn, jl + 1) - hlView(jn, jl));
+
+      exnerLevelsHatView(jn, jl) += (hlView(jn, jl + 1)  - hView(jn, jl)) *
+        tHatView(jn, jl) * thetaView(jn, jl) /
+        (hlView(jn, jl + 1) - hlView(jn, jl));
+
+      tHatView(jn, jl) = 0.0;
+    }
+  }
+}
+
+
+void qqclqcf2qtTL(atlas::FieldSet & incFields, const atlas::FieldSet &) {
+  qqclqcf2qt(incFields);
+}
+
+void qqclqcf2qtAD(atlas::FieldSet & hatFields, const atlas::FieldSet &) {
+  auto qHatView = make_view<double, 2>(hatFields["specific_humidity"]);
+  auto qclHatView = make_view<double, 2>
+                    (hatFields["mass_content_of_cloud_liquid_water_in_atmosphere_layer"]);
+  auto qcfHatView = make_view<double, 2>
+                    (hatFields["mass_content_of_cloud_ice_in_atmosphere_layer"]);
+  auto qtHatView = make_view<double, 2>(hatFields["qt"]);
+
+  for (atlas::idx_t jn = 0; jn < hatFields["qt"].shape(0); ++jn) {
+    for (atlas::idx_t jl = 0; jl < hatFields["qt"].levels(); ++jl) {
+      qHatView(jn, jl) += qtHatView(jn, jl);
+      qclHatView(jn, jl) += qtHatView(jn, jl);
+      qcfHatView(jn, jl) += qtHatView(jn, jl);
+      qtHatView(jn, jl) = 0.0;
+    }
+  }
+}
+
+void qtTemperature2qqclqcfTL(atlas::FieldSet & incFlds,
+                             const atlas::FieldSet & augStateFlds) {
+  const auto qsatView = make_view<const double, 2>(augStateFlds["qsat"]);
+  const auto dlsvpdTView = make_view<const double, 2>(augStateFlds["dlsvpdT"]);
+  const auto cleffView = make_view<const double, 2>(augStateFlds["cleff"]);
+  const auto cfeffView = make_view<const double, 2>(augStateFlds["cfeff"]);
+
+  const auto qtIncView = make_view<const double, 2>(incFlds["qt"]);
+  const auto temperIncView = make_view<const double, 2>(incFlds["air_temperature"]);
+  auto qclIncView = make_view<double, 2>
+                    (incFlds["mass_content_of_cloud_liquid_water_in_atmosphere_layer"]);
+  auto qcfIncView = make_view<double, 2>
+                    (incFlds["mass_content_of_cloud_ice_in_atmosphere_layer"]);
+  auto qIncView = make_view<double, 2>(incFlds["specific_humidity"]);
+
+
+  double maxCldInc;
+  for (atlas::idx_t jn = 0; jn < incFlds["qt"].shape(0); ++jn) {
+    for (atlas::idx_t jl = 0; jl < incFlds["qt"].levels(); ++jl) {
+        maxCldInc = qtIncView(jn, jl) - qsatView(jn, jl) *
+            dlsvpdTView(jn, jl) * temperIncView(jn, jl);
+        qclIncView(jn, jl) = cleffView(jn, jl) * maxCldInc;
+        qcfIncView(jn, jl) = cfeffView(jn, jl) * maxCldInc;
+        qIncView(jn, jl) = qtIncView(jn, jl) - qclIncView(jn, jl) - qcfIncView(jn, jl);
+    }
+  }
+}
+
+void qtTemperature2qqclqcfAD(atlas::FieldSet & hatFlds,
+                             const atlas::FieldSet & augStateFlds) {
+  const auto qsatView = make_view<const double, 2>(augStateFlds["qsat"]);
+  const auto dlsvpdTView = make_view<const double, 2>(augStateFlds["dlsvpdT"]);
+  const auto cleffView = make_view<const double, 2>(augStateFlds["cleff"]);
+  const auto cfeffView = make_view<const double, 2>(augStateFlds["cfeff"]);
+
+  auto temperHatView = make_view<double, 2>(hatFlds["air_temperature"]);
+  auto qtHatView = make_view<double, 2>(hatFlds["qt"]);
+  auto qHatView = make_view<double, 2>(hatFlds["specific_humidity"]);
+  auto qclHatView = make_view<double, 2>
+                    (hatFlds["mass_content_of_cloud_liquid_water_in_atmosphere_layer"]);
+  auto qcfHatView = make_view<double, 2>
+                    (hatFlds["mass_content_of_cloud_ice_in_atmosphere_layer"]);
+
+  double qsatdlsvpdT;
+  for (atlas::idx_t jn = 0; jn < hatFlds["qt"].shape(0); ++jn) {
+    for (atlas::idx_t jl = 0; jl < hatFlds["qt"].levels(); ++jl) {
+      qsatdlsvpdT = qsatView(jn, jl) * dlsvpdTView(jn, jl);
+      temperHatView(jn, jl) += ((cleffView(jn, jl) + cfeffView(jn, jl)) * qHatView(jn, jl)
+                                - cleffView(jn, jl) * qclHatView(jn, jl)
+                                - cfeffView(jn, jl) * qcfHatView(jn, jl)) * qsatdlsvpdT;
+      qtHatView(jn, jl) += cleffView(jn, jl) * qclHatView(jn, jl)
+              + cfeffView(jn, jl) * qcfHatView(jn, jl)
+              + (1.0 - cleffView(jn, jl) - cfeffView(jn, jl))
+              * qHatView(jn, jl);
+      qHatView(jn, jl) = 0.0;
+      qclHatView(jn, jl) = 0.0;
+      qcfHatView(jn, jl) = 0.0;
+    }
+  }
+}
+
+
+void evalHydrostaticPressureTL(atlas::FieldSet & incFlds,
+                               const atlas::FieldSet & augStateFlds) {
+  const auto gPIncView = make_view<const double, 2>(
+    incFlds["geostrophic_pressure_levels_minus_one"]);
+  const auto uPIncView = make_view<const double, 2>(
+    incFlds["unbalanced_pressure_levels_minus_one"]);
+
+  const auto pView = make_view<const double, 2>(augStateFlds["air_pressure_levels"]);
+  // First index of interpWeightView is horizontal index, the second is bin index here
+  const auto interpWeightView = make_view<const double, 2>(augStateFlds["interpolation_weights"]);
+
+  // Bins Vertical regression matrix stored in one field
+  // B = (vertical regression matrix bin_0)
+  //     (vertical regression matrix bin_1)
+  //     (          ...                   )
+  //     (vertical regression matrix bin_m)
+  // Since each matrix is square we can easily infer the bin index from the row index
+  // First index of vertRegView is bin_index * number of levels + level index,
+  //     the second is number of levels associated with matrix column.
+  const auto vertRegView = make_view<const double, 2>(augStateFlds["vertical_regression_matrices"]);
+
+  auto hPIncView = make_view<double, 2>(incFlds["hydrostatic_pressure_levels"]);
+
+  atlas::idx_t levels = incFlds["geostrophic_pressure_levels_minus_one"].levels();
+  atlas::idx_t nBins = augStateFlds["interpolation_weights"].shape(1);
+
+  for (atlas::idx_t jn = 0; jn < incFlds["hydrostatic_pressure_levels"].shape(0); ++jn) {
+    for (atlas::idx_t b = 0; b < nBins; ++b) {
+      if (interpWeightView(jn , b) > __FLT_EPSILON__) {
+        for (atlas::idx_t jl = 0; jl < levels; ++jl) {
+          hPIncView(jn, jl) = uPIncView(jn, jl);
+          for (atlas::idx_t jl2 = 0; jl2 < levels; ++jl2) {
+            hPIncView(jn, jl) +=
+                                 interpWeightView(jn, b) *
+                                 vertRegView(b * levels + jl, jl2) *
+                                 gPIncView(jn, jl2);
+          }
+        }
+      }
+    }
+    hPIncView(jn, levels) =
+      hPIncView(jn, levels-1) *
+      std::pow(pView(jn, levels-1) / pView(jn, levels), constants::rd_over_cp - 1.0);
+  }
+}
+
+
+void evalHydrostaticPressureAD(atlas::FieldSet & hatFlds,
+                               const atlas::FieldSet & augStateFlds) {
+  auto gpHatView = make_view<double, 2>(hatFlds["geostrophic_pressure_levels_minus_one"]);
+  auto uPHatView = make_view<double, 2>(hatFlds["unbalanced_pressure_levels_minus_one"]);
+
+  const auto pView = make_view<const double, 2>(augStateFlds["air_pressure_levels"]);
+  // First index of interpWeightView is horizontal index, the second is bin index here
+  const auto interpWeightView = make_view<const double, 2>(augStateFlds["interpolation_weights"]);
+
+  // Bins Vertical regression matrix stored in one field
+  // B = (vertical regression matrix bin_0)
+  //     (vertical regression matrix bin_1)
+  //     (          ...                   )
+  //     (vertical regression matrix bin_m)
+  // Since each matrix is square we can easily infer the bin index from the row index
+  // First index of vertRegView is bin_index * number of levels + level index,
+  //     the second is level index
+  const auto vertRegView = make_view<const double, 2>(augStateFlds["vertical_regression_matrices"]);
+
+  auto hPHatView = make_view<double, 2>(hatFlds["hydrostatic_pressure_levels"]);
+
+  atlas::idx_t levels = hatFlds["geostrophic_pressure_levels_minus_one"].levels();
+  atlas::idx_t nBins = augStateFlds["vertical_regression_matrices"].shape(0) / levels;
+
+  for (atlas::idx_t jn = 0; jn < hatFlds["hydrostatic_pressure_levels"].shape(0); ++jn) {
+    hPHatView(jn, levels - 1) +=
+     hPHatView(jn, levels) *
+     std::pow(pView(jn, levels-1) / pView(jn, levels), constants::rd_over_cp - 1.0);
+    hPHatView(jn, levels) = 0.0;
+
+    for (atlas::idx_t b = nBins -1; b >= 0; --b) {
+      if (interpWeightView(jn , b) > __FLT_EPSILON__) {
+        for (atlas::idx_t jl = levels - 1; jl >= 0; --jl) {
+          for (atlas::idx_t jl2 = levels - 1; jl2 >= 0; --jl2) {
+            gpHatView(jn, jl2) +=
+                                  interpWeightView(jn, b) *
+                                  vertRegView(b * levels + jl, jl2) *
+                                  hPHatView(jn, jl);
+          }
+          uPHatView(jn, jl) += hPHatView(jn, jl);
+          hPHatView(jn, jl) = 0.0;
+        }
+      }
+    }
+  }
+}
+
+/// \details This calculates the hydrostatic exner field from the hydrostatic pressure
+void evalHydrostaticExnerTL(atlas::FieldSet & incFlds,
+                            const atlas::FieldSet & augStateFlds) {
+  const auto pView = make_view<const double, 2>(augStateFlds["hydrostatic_pressure_levels"]);
+  const auto exnerView = make_view<const double, 2>(augStateFlds["hydrostatic_exner_levels"]);
+  const auto pIncView = make_view<const double, 2>(incFlds["hydrostatic_pressure_levels"]);
+  auto exnerIncView = make_view<double, 2>(incFlds["hydrostatic_exner_levels"]);
+
+  atlas::idx_t levels = incFlds["hydrostatic_exner_levels"].levels();
+  for (atlas::idx_t jn = 0; jn < incFlds["hydrostatic_exner_levels"].shape(0); ++jn) {
+    for (atlas::idx_t jl = 0; jl < levels; ++jl) {
+      exnerIncView(jn, jl) = pIncView(jn, jl) *
+        (constants::rd_over_cp * exnerView(jn, jl)) /
+        pView(jn, jl);
+    }
+  }
+}
+
+/// \details This is the adjoint of the calculation of hydrostatic exner increments
+void evalHydrostaticExnerAD(atlas::FieldSet & hatFlds,
+                            const atlas::FieldSet & augStateFlds) {
+  const auto pView = make_view<const double, 2>(augStateFlds["hydrostatic_pressure_levels"]);
+  const auto exnerView = make_view<const double, 2>(augStateFlds["hydrostatic_exner_levels"]);
+  auto pHatView = make_view<double, 2>(hatFlds["hydrostatic_pressure_levels"]);
+  auto exnerHatView = make_view<double, 2>(hatFlds["hydrostatic_exner_levels"]);
+
+  atlas::idx_t levels = hatFlds["hydrostatic_exner_levels"].levels();
+  for (atlas::idx_t jn = 0; jn < hatFlds["hydrostatic_exner_levels"].shape(0); ++jn) {
+    for (atlas::idx_t jl = 0; jl < levels; ++jl) {
+      pHatView(jn, jl) += exnerHatView(jn, jl) *
+        (constants::rd_over_cp * exnerView(jn, jl)) /
+        pView(jn, jl);
+      exnerHatView(jn, jl) = 0.0;
+    }
+  }
+}
+
+
+/// \details This is function calculates the linear moisture
+///          control variable (muInc and thetavInc) from (thetaInc) and (qtInc)
+///          We are ignoring the scaled pressure contribution to mu, because we have
+///          found in the past that it gives no benefit and that its contribution
+///          is small.
+void evalMuThetavTL(atlas::FieldSet & incFlds,  const atlas::FieldSet & augState) {
+  const auto muRow1Column1View = make_view<const double, 2>(augState["muRow1Column1"]);
+  const auto muRow1Column2View = make_view<const double, 2>(augState["muRow1Column2"]);
+  const auto muRow2Column1View = make_view<const double, 2>(augState["muRow2Column1"]);
+  const auto muRow2Column2View = make_view<const double, 2>(augState["muRow2Column2"]);
+  const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
+  const auto qtIncView = make_view<const double, 2>(incFlds["qt"]);
+  auto muIncView = make_view<double, 2>(incFlds["mu"]);
+  auto thetavIncView = make_view<double, 2>(incFlds["virtual_potential_temperature"]);
+
+  for (atlas::idx_t jn = 0; jn < incFlds["mu"].shape(0); ++jn) {
+    for (atlas::idx_t jl = 0; jl < incFlds["mu"].levels(); ++jl) {
+      muIncView(jn, jl) = muRow1Column1View(jn, jl)  * qtIncView(jn, jl)
+                        + muRow1Column2View(jn, jl)  * thetaIncView(jn, jl);
+      thetavIncView(jn, jl) = muRow2Column1View(jn, jl)  * qtIncView(jn, jl)
+                            + muRow2Column2View(jn, jl)  * thetaIncView(jn, jl);
+    }
+  }
+}
+
+
+void evalMuThetavAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState) {
+  const auto muRow1Column1View = make_view<const double, 2>(augState["muRow1Column1"]);
+  const auto muRow1Column2View = make_view<const double, 2>(augState["muRow1Column2"]);
+  const auto muRow2Column1View = make_view<const double, 2>(augState["muRow2Column1"]);
+  const auto muRow2Column2View = make_view<const double, 2>(augState["muRow2Column2"]);
+  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
+  auto qtHatView = make_view<double, 2>(hatFlds["qt"]);
+  auto muHatView = make_view<double, 2>(hatFlds["mu"]);
+  auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
+
+  for (atlas::idx_t jn = 0; jn < hatFlds["mu"].shape(0); ++jn) {
+    for (atlas::idx_t jl = 0; jl < hatFlds["mu"].levels(); ++jl) {
+      thetaHatView(jn, jl) += muRow2Column2View(jn, jl) * thetavHatView(jn, jl);
+      qtHatView(jn, jl) += muRow2Column1View(jn, jl) * thetavHatView(jn, jl);
+      thetaHatView(jn, jl) += muRow1Column2View(jn, jl) * muHatView(jn, jl);
+      qtHatView(jn, jl) += muRow1Column1View(jn, jl) * muHatView(jn, jl);
+      thetavHatView(jn, jl) = 0.0;
+      muHatView(jn, jl) = 0.0;
+    }
+  }
+}
+
+
+void evalQtThetaTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augState) {
+  // Using Cramer's rule to calculate inverse.
+  const auto muRecipDeterView = make_view<const double, 2>(augState["muRecipDeterminant"]);
+  const auto muRow1Column1View = make_view<const double, 2>(augState["muRow1Column1"]);
+  const auto muRow1Column2View = make_view<const double, 2>(augState["muRow1Column2"]);
+  const auto muRow2Column1View = make_view<const double, 2>(augState["muRow2Column1"]);
+  const auto muRow2Column2View  = make_view<const double, 2>(augState["muRow2Column2"]);
+  const auto muIncView = make_view<const double, 2>(incFlds["mu"]);
+  const auto thetavIncView = make_view<const double, 2>(incFlds["virtual_potential_temperature"]);
+  auto qtIncView = make_view<double, 2>(incFlds["qt"]);
+  auto thetaIncView = make_view<double, 2>(incFlds["potential_temperature"]);
+
+  for (atlas::idx_t jn = 0; jn < incFlds["mu"].shape(0); ++jn) {
+    for (atlas::idx_t jl = 0; jl < incFlds["mu"].levels(); ++jl) {
+      // VAR equivalent in Var_UpPFtheta_qT.f90 for thetaIncView
+      // (beta2 * muA * theta_v' +   beta1 * mu') /
+      // (alpha1 * beta2 * muA - alpha2 * muA * beta1)
+      thetaIncView(jn, jl) =  muRecipDeterView(jn, jl) * (
+                             muRow1Column1View(jn, jl) * thetavIncView(jn, jl)
+                           - muRow2Column1View(jn, jl) * muIncView(jn, jl) );
+
+      // VAR equivalent in Var_UpPFtheta_qT.f90 for qtIncView
+      // (alpha1 * mu_v' -   alpha2 * muA * thetav') /
+      // (alpha1 * beta2 * muA - alpha2 * muA * beta1)
+      qtIncView(jn, jl) =  muRecipDeterView(jn, jl) * (
+                           muRow2Column2View(jn, jl) * muIncView(jn, jl) -
+                           muRow1Column2View(jn, jl) * thetavIncView(jn, jl) );
+    }
+  }
+}
+
+
+void evalQtThetaAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState) {
+  const auto muRecipDeterView = make_view<const double, 2>(augState["muRecipDeterminant"]);
+  const auto muRow1Column1View = make_view<const double, 2>(augState["muRow1Column1"]);
+  const auto muRow1Column2View = make_view<const double, 2>(augState["muRow1Column2"]);
+  const auto muRow2Column1View = make_view<const double, 2>(augState["muRow2Column1"]);
+  const auto muRow2Column2View  = make_view<const double, 2>(augState["muRow2Column2"]);
+  auto qtHatView = make_view<double, 2>(hatFlds["qt"]);
+  auto muHatView = make_view<double, 2>(hatFlds["mu"]);
+  auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
+  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
+
+  for (atlas::idx_t jn = 0; jn < hatFlds["mu"].shape(0); ++jn) {
+    for (atlas::idx_t jl = 0; jl < hatFlds["mu"].levels(); ++jl) {
+      thetavHatView(jn, jl) += muRecipDeterView(jn, jl) *
+                               muRow1Column1View(jn, jl) * thetaHatView(jn, jl);
+      muHatView(jn, jl) -= muRecipDeterView(jn, jl) *
+                           muRow2Column1View(jn, jl) * thetaHatView(jn, jl);
+      thetavHatView(jn, jl) -= muRecipDeterView(jn, jl) *
+                               muRow1Column2View(jn, jl) * qtHatView(jn, jl);
+      muHatView(jn, jl) += muRecipDeterView(jn, jl) *
+                           muRow2Column2View(jn, jl) * qtHatView(jn, jl);
+      thetaHatView(jn, jl) = 0.0;
+      qtHatView(jn, jl) = 0.0;
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------------------
+// mo/model2geovals_varchange.cc
+
+void initField_rank2(atlas::Field & field, const double value_init)
+{
+  setUniformValue_rank2(field, value_init);
+}
+
+
+void setUniformValue_rank2(atlas::Field & field, const double value)
+{
+  auto ds_view = make_view<double, 2>(field);
+
+  ds_view.assign(value);
+}
+
+
+bool evalTotalMassMoistAir(atlas::FieldSet & fields)
+{
+  oops::Log::trace() << "[evalTotalMassMoistAir()] starting ..." << std::endl;
+
+  const auto ds_m_v  = make_view<const double, 2>(fields["m_v"]);
+  const auto ds_m_ci = make_view<const double, 2>(fields["m_ci"]);
+  const auto ds_m_cl = make_view<const double, 2>(fields["m_cl"]);
+  const auto ds_m_r  = make_view<const double, 2>(fields["m_r"]);
+  auto ds_m_t  = make_view<double, 2>(fields["m_t"]);
+
+  auto fspace = fields["m_t"].functionspace();
+
+  auto evaluateMt = [&] (idx_t i, idx_t j) {
+    ds_m_t(i, j) = 1 + ds_m_v(i, j) + ds_m_ci(i, j) + ds_m_cl(i, j) + ds_m_r(i, j); };
+
+  auto conf = Config("levels", fields["m_t"].levels()) |
+              Config("include_halo", true);
+
+  functions::parallelFor(fspace, evaluateMt, conf);
+
+  oops::Log::trace() << "[evalTotalMassMoistAir()] ... exit" << std::endl;
+
+  return true;
+}
+
+/// \brief function to evaluate the quantity:
+///   qx = m_x/m_t
+/// where ...
+///   m_x = [ mv | mci | mcl | m_r ]
+///   m_t  = total mass of moist air
+///
+bool evalRatioToMt(atlas::FieldSet & fields, const std::vector<std::string> & vars)
+{
+  oops::Log::trace() << "[evalRatioToMt()] starting ..." << std::endl;
+
+  // fields[0] = m_x = [ mv | mci | mcl | m_r ]
+  const auto ds_m_x  = make_view<const double, 2>(fields[vars[0]]);
+  const auto ds_m_t  = make_view<const double, 2>(fields[vars[1]]);
+  auto ds_tfield  = make_view<double, 2>(fields[vars[2]]);
+
+  auto fspace = fields[vars[1]].functionspace();
+
+  auto evaluateRatioToMt = [&] (idx_t i, idx_t j) {
+    ds_tfield(i, j) = ds_m_x(i, j) / ds_m_t(i, j);
+  };
+
+  auto conf = Config("levels", fields[1].levels()) |
+              Config("include_halo", true);
+
+  functions::parallelFor(fspace, evaluateRatioToMt, conf);
+
+  oops::Log::trace() << "[evalRatioToMt()] ... exit" << std::endl;
+
+  return true;
+}
+
+
+bool evalSpecificHumidity(atlas::FieldSet & fields)
+{
+  oops::Log::trace() << "[evalSpecificHumidity()] starting ..." << std::endl;
+
+  std::vector<std::string> fnames {"m_v", "m_t", "specific_humidity"};
+
+  bool rvalue = evalRatioToMt(fields, fnames);
+
+  oops::Log::trace() << "[evalSpecificHumidity()] ... exit" << std::endl;
+
+  return rvalue;
+}
+
+bool evalRelativeHumidity(atlas::FieldSet & fields)
+{
+  oops::Log::trace() << "[evalRelativeHumidity()] starting ..." << std::endl;
+
+  bool cap_super_sat(false);
+
+  if (fields["relative_humidity"].metadata().has("cap_super_sat")) {
+    fields["relative_humidity"].metadata().get("cap_super_sat", cap_super_sat);
+  }
+
+  const auto qView = make_view<const double, 2>(fields["specific_humidity"]);
+  const auto qsatView = make_view<const double, 2>(fields["qsat"]);
+  auto rhView = make_view<double, 2>(fields["relative_humidity"]);
+
+  auto conf = Config("levels", fields["relative_humidity"].levels()) |
+              Config("include_halo", true);
+
+  auto evaluateRH = [&] (idx_t i, idx_t j) {
+    rhView(i, j) = fmax(qView(i, j) / qsatView(i, j) * 100.0, 0.0);
+    rhView(i, j) = (cap_super_sat && (rhView(i, j) > 100.0)) ? 100.0 : rhView(i, j);
+  };
+
+  auto fspace = fields["relative_humidity"].functionspace();
+
+  functions::parallelFor(fspace, evaluateRH, conf);
+
+  oops::Log::trace() << "[evalRelativeHumidity()] ... exit" << std::endl;
+
+  return true;
+}
+
+bool evalTotalRelativeHumidity(atlas::FieldSet & fields)
+{
+  oops::Log::trace() << "[evalTotalRelativeHumidity()] starting ..." << std::endl;
+
+  const auto qView = make_view<const double, 2>(fields["specific_humidity"]);
+  const auto qclView = make_view<const double, 2>
+                 (fields["mass_content_of_cloud_liquid_water_in_atmosphere_layer"]);
+  const auto qciView = make_view<const double, 2>
+                 (fields["mass_content_of_cloud_ice_in_atmosphere_layer"]);
+  const auto qrainView = make_view<const double, 2>(fields["qrain"]);
+  const auto qsatView = make_view<const double, 2>(fields["qsat"]);
+  auto rhtView = make_view<double, 2>(fields["rht"]);
+
+  auto conf = Config("levels", fields["rht"].levels()) |
+              Config("include_halo", true);
+
+  auto evaluateRHT = [&] (idx_t i, idx_t j) {
+    rhtView(i, j) = (qView(i, j) + qclView(i, j) + qciView(i, j)
+    + qrainView(i, j)) / qsatView(i, j) * 100.0;
+
+    if (rhtView(i, j) < 0.0)
+    {
+        rhtView(i, j) = 0.0;
+    }
+  };
+
+  auto fspace = fields["rht"].functionspace();
+
+  functions::parallelFor(fspace, evaluateRHT, conf);
+
+  oops::Log::trace() << "[evalTotalRelativeHumidity()] ... exit" << std::endl;
+
+  return true;
+}
+
+bool evalMassCloudIce(atlas::FieldSet & fields)
+{
+  oops::Log::trace() << "[evalMassCloudIce()] starting ..." << std::endl;
+
+  std::vector<std::string> fnames {"m_ci", "m_t",
+                                   "mass_content_of_cloud_ice_in_atmosphere_layer"};
+  bool rvalue = evalRatioToMt(fields, fnames);
+
+  oops::Log::trace() << "[evalMassCloudIce()] ... exit" << std::endl;
+
+  return rvalue;
+}
+
+
+bool evalMassCloudLiquid(atlas::FieldSet & fields)
+{
+  oops::Log::trace() << "[evalMassCloudLiquid()] starting ..." << std::endl;
+
+  std::vector<std::string> fnames {"m_cl", "m_t",
+                                   "mass_content_of_cloud_liquid_water_in_atmosphere_layer"};
+  bool rvalue = evalRatioToMt(fields, fnames);
+
+  oops::Log::trace() << "[evalMassCloudLiquid()] ... exit" << std::endl;
+
+  return rvalue;
+}
+
+
+bool evalMassRain(atlas::FieldSet & fields)
+{
+  oops::Log::trace() << "[evalMassRain()] starting ..." << std::endl;
+
+  std::vector<std::string> fnames {"m_r", "m_t", "qrain"};
+  bool rvalue = evalRatioToMt(fields, fnames);
+
+  oops::Log::trace() << "[evalMassRain()] ... exit" << std::endl;
+
+  return rvalue;
+}
+
+
+bool evalAirTemperature(atlas::FieldSet & fields)
+{
+  oops::Log::trace() << "[evalAirTemperature()] starting ..." << std::endl;
+
+  const auto ds_theta  = make_view<const double, 2>(fields["potential_temperature"]);
+  const auto ds_exner = make_view<const double, 2>(fields["exner"]);
+  auto ds_atemp = make_view<double, 2>(fields["air_temperature"]);
+
+  auto fspace = fields["air_temperature"].functionspace();
+
+  auto evaluateAirTemp = [&] (idx_t i, idx_t j) {
+    ds_atemp(i, j) = ds_theta(i, j) * ds_exner(i, j); };
+
+  auto conf = Config("levels", fields["air_temperature"].levels()) |
+              Config("include_halo", true);
+
+  functions::parallelFor(fspace, evaluateAirTemp, conf);
+
+  oops::Log::trace() << "[evalAirTemperature()] ... exit" << std::endl;
+
+  return true;
+}
+
+
+
+
+
+bool evalSpecificHumidityFromRH_2m(atlas::FieldSet & fields)
+{
+  oops::Log::trace() << "[evalSpecificHumidityFromRH_2m()] starting ..." << std::endl;
+
+  const auto ds_qsat = make_view<const double, 2>(fields["qsat"]);
+  const auto ds_rh = make_view<const double, 2>(fields["relative_humidity_2m"]);
+  auto ds_q2m = make_view<double, 2>(fields["specific_humidity_at_two_meters_above_surface"]);
+
+  auto fspace = fields["specific_humidity_at_two_meters_above_surface"].functionspace();
+
+  auto evaluateSpecificHumidity_2m = [&] (idx_t i, idx_t j) {
+    ds_q2m(i, j) = ds_rh(i, j) * ds_qsat(i, j); };
+
+  auto conf = Config("levels",
+    fields["specific_humidity_at_two_meters_above_surface"].levels()) |
+              Config("include_halo", true);
+
+  functions::parallelFor(fspace, evaluateSpecificHumidity_2m, conf);
+
+  oops::Log::trace() << "[evalSpecificHumidityFromRH_2m()] ... exit" << std::endl;
+
+  return true;
+}
+
+
+bool evalParamAParamB(atlas::FieldSet & fields)
+{
+  oops::Log::trace() << "[evalParamAParamB2()] starting ..." << std::endl;
+
+  std::size_t blindex;
+  if (!fields["height"].metadata().has("boundary_layer_index")) {
+    oops::Log::error() << "ERROR - data validation failed "
+                          "we expect boundary_layer_index value "
+                          "in the meta data of the height field" << std::endl;
+  }
+  fields["height"].metadata().get("boundary_layer_index", blindex);
+
+  const auto heightView = make_view<const double, 2>(fields["height"]);
+  const auto heightLevelsView = make_view<const double, 2>(fields["height_levels"]);
+  const auto pressureLevelsView = make_view<const double, 2>
+      (fields["air_pressure_levels_minus_one"]);
+  const auto specificHumidityView = make_view<const double, 2>(fields["specific_humidity"]);
+  auto param_aView = make_view<double, 2>(fields["param_a"]);
+  auto param_bView = make_view<double, 2>(fields["param_b"]);
+
+  // temperature at level above boundary layer
+  double t_bl;
+  // temperature at model surface height
+  double t_msh;
+
+  double exp_pmsh = constants::Lclr * constants::rd / constants::grav;
+
+  for (idx_t jn = 0; jn < param_aView.shape(0); ++jn) {
+    t_bl = (-constants::grav / constants::rd) *
+           (heightLevelsView(jn, blindex + 1) - heightLevelsView(jn, blindex)) /
+           log(pressureLevelsView(jn, blindex + 1) / pressureLevelsView(jn, blindex));
+
+    t_bl = t_bl / (1.0 + constants::c_virtual * specificHumidityView(jn, blindex));
+
+    t_msh = t_bl + constants::Lclr * (heightView(jn, blindex) - heightLevelsView(jn, 0));
+
+    param_aView(jn, 0) = heightLevelsView(jn, 0) + t_msh / constants::Lclr;
+    param_bView(jn, 0) = t_msh / (pow(pressureLevelsView(jn, 0), exp_pmsh) * constants::Lclr);
+  }
+
+  oops::Log::trace() << "[evalParamAParamB()] ... exit" << std::endl;
+
+  return true;
+}
+
+}  // namespace reference
+}  // namespace mo
+
+namespace vader {
+namespace reference {
+
+// ------------------------------------------------------------------------------------------------
+// vader/recipes/TempToPTemp.cc (the parameters are the defaults of TempToPTemp())
+
+bool tempToPTemp(atlas::FieldSet & afieldset)
+{
+    const double default_kappa = 0.2857;
+    const double p0_not_in_params = -1.0;
+    const double default_Pa_p0 = 100000.0;
+    const double default_hPa_p0 = 1000.0;
+    double p0_ = p0_not_in_params;
+    const double kappa_ = default_kappa;
+
+    bool potential_temperature_filled = false;
+
+    atlas::Field temperature = afieldset.field(VV_TS);
+    atlas::Field surface_pressure = afieldset.field(VV_PS);
+    atlas::Field potential_temperature = afieldset.field(VV_PT);
+    std::string t_units, ps_units;
+
+    temperature.metadata().get("units", t_units);
+    surface_pressure.metadata().get("units", ps_units);
+    if (p0_ == p0_not_in_params)
+    {
+        if (ps_units == "Pa")
+        {
+            p0_ = default_Pa_p0;
+        } else if (ps_units == "hPa") {
+            p0_ = default_hPa_p0;
+        } else {
+            oops::Log::error() <<
+              "TempToPTemp::execute failed because p0 could not be determined." << std::endl;
+            return false;
+        }
+    }
+
+    auto temperature_view = atlas::array::make_view<double, 2>(temperature);
+    auto surface_pressure_view = atlas::array::make_view<double, 2>(surface_pressure);
+    auto potential_temperature_view = atlas::array::make_view<double, 2>(potential_temperature);
+
+    size_t grid_size = surface_pressure.size();
+
+    int nlevels = temperature.levels();
+    for (int level = 0; level < nlevels; ++level) {
+      for ( size_t jnode = 0; jnode < grid_size ; ++jnode ) {
+        potential_temperature_view(jnode, level) =
+            temperature_view(jnode, level) * pow(p0_ / surface_pressure_view(jnode, 0), kappa_);
+      }
+    }
+
+    potential_temperature_filled = true;
+
+    return potential_temperature_filled;
+}
+
+}  // namespace reference
+}  // namespace vader
@@ -0,0 +1,111 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <string>
+#include <vector>
+
+#include "atlas/field.h"
+
+#include "oops/base/Variables.h"
+
+/// Frozen copies of the mo kernels before they were rewritten (see reference_kernels.cc),
+/// with the names and signatures they had
+namespace mo {
+namespace reference {
+namespace functions {
+
+// mo/functions.cc
+std::vector<double> getLookUp(const std::string & sVPFilePath,
+                              const std::string & shortName,
+                              const std::size_t lookupSize);
+std::vector<std::vector<double>> getLookUps(const std::string & sVPFilePath,
+                                            const oops::Variables & vars,
+                                            const std::size_t lookupSize);
+void getMIOFields(atlas::FieldSet & augStateFlds);
+Eigen::MatrixXd createMIOCoeff(const std::string mioFileName,
+                               const std::string s);
+
+}  // namespace functions
+
+// mo/common_varchange.cc
+bool evalSatVaporPressure(atlas::FieldSet & fields);
+bool evalSatSpecificHumidity(atlas::FieldSet & fields);
+bool evalAirPressureLevels(atlas::FieldSet & fields);
+
+// mo/common_linearvarchange.cc
+void evalVirtualPotentialTemperatureTL(atlas::FieldSet & incFlds,
+                                       const atlas::FieldSet & augStateFlds);
+void evalVirtualPotentialTemperatureAD(atlas::FieldSet & hatFlds,
+                                       const atlas::FieldSet & augStateFlds);
+
+// mo/control2analysis_varchange.cc
+void hexner2PThetav(atlas::FieldSet & fields);
+void evalVirtualPotentialTemperature(atlas::FieldSet & fields);
+void evalHydrostaticExnerLevels(atlas::FieldSet & fields);
+void evalHydrostaticPressureLevels(atlas::FieldSet & fields);
+void qqclqcf2qt(atlas::FieldSet & fields);
+void evalDryAirDensity(atlas::FieldSet & fields);
+void evalExnerPressureLevels(atlas::FieldSet & fields);
+void evalMoistureControlDependencies(atlas::FieldSet & fields);
+
+// mo/control2analysis_linearvarchange.cc
+void thetavP2HexnerTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds);
+void thetavP2HexnerAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds);
+void hexner2ThetavTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds);
+void hexner2ThetavAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds);
+void evalDryAirDensityTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds);
+void evalDryAirDensityAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds);
+void evalAirTemperatureTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds);
+void evalAirTemperatureAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds);
+void qqclqcf2qtTL(atlas::FieldSet & incFields, const atlas::FieldSet &);
+void qqclqcf2qtAD(atlas::FieldSet & hatFields, const atlas::FieldSet &);
+void qtTemperature2qqclqcfTL(atlas::FieldSet & incFlds,
+                             const atlas::FieldSet & augStateFlds);
+void qtTemperature2qqclqcfAD(atlas::FieldSet & hatFlds,
+                             const atlas::FieldSet & augStateFlds);
+void evalHydrostaticPressureTL(atlas::FieldSet & incFlds,
+                               const atlas::FieldSet & augStateFlds);
+void evalHydrostaticPressureAD(atlas::FieldSet & hatFlds,
+                               const atlas::FieldSet & augStateFlds);
+void evalHydrostaticExnerTL(atlas::FieldSet & incFlds,
+                            const atlas::FieldSet & augStateFlds);
+void evalHydrostaticExnerAD(atlas::FieldSet & hatFlds,
+                            const atlas::FieldSet & augStateFlds);
+void evalMuThetavTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augState);
+void evalMuThetavAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState);
+void evalQtThetaTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augState);
+void evalQtThetaAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState);
+
+// mo/model2geovals_varchange.cc
+void initField_rank2(atlas::Field & field, const double value_init);
+void setUniformValue_rank2(atlas::Field & field, const double value);
+bool evalTotalMassMoistAir(atlas::FieldSet & fields);
+bool evalRatioToMt(atlas::FieldSet & fields, const std::vector<std::string> & vars);
+bool evalSpecificHumidity(atlas::FieldSet & fields);
+bool evalRelativeHumidity(atlas::FieldSet & fields);
+bool evalTotalRelativeHumidity(atlas::FieldSet & fields);
+bool evalMassCloudIce(atlas::FieldSet & fields);
+bool evalMassCloudLiquid(atlas::FieldSet & fields);
+bool evalMassRain(atlas::FieldSet & fields);
+bool evalAirTemperature(atlas::FieldSet & fields);
+bool evalSpecificHumidityFromRH_2m(atlas::FieldSet & fields);
+bool evalParamAParamB(atlas::FieldSet & fields);
+
+}  // namespace reference
+}  // namespace mo
+
+namespace vader {
+namespace reference {
+
+// vader/recipes/TempToPTemp.cc: TempToPTemp::execute, with the default parameters
+bool tempToPTemp(atlas::FieldSet & afieldset);
+
+}  // namespace reference
+}  // namespace vader
@@ -0,0 +1,1134 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+// Benchmarks of the mo kernels, of the TempToPTemp recipe and of Vader::changeVar on
+// synthetic cubed-sphere states, and of the per-call overhead of Vader::changeVar.
+//
+// Usage: vader_benchmarks [--resolution N] [--levels L] [--iterations I] [--block-size B]
+//                         [--reference-block-size R] [--function-space all|nodes|cells]
+//                         [--lookups 0|1] [--verify 0|1] [--max-slowdown S] [--json FILE]
+//
+// Every nonlinear, tangent linear and adjoint kernel is run on NodeColumns and/or
+// CellColumns fields of N x N x 6 columns and L levels. A kernel is timed with a
+// column block size of B, reporting the time per call, the throughput in columns/s
+// and the memory traffic in GB/s. The traffic counts every field read and every
+// field written once (the fields accumulated into by an adjoint count twice).
+//
+// Unless R is 0, each kernel is also timed with a block size of R (1 by default,
+// the columns one at a time) and the outputs of the two runs are checked to be
+// bitwise equal. The exit code is 1 if any of them differ.
+//
+// evalSatVaporPressure and getMIOFields read the SVP and MIO lookup tables (from
+// Data/parameters, relative to the working directory) and are only run with --lookups 1.
+// --json writes the results to FILE for tracking across releases.
+//
+// With --verify 1 (the default) the optimised paths are checked against the paths they
+// replace, which serve as references: the precomputed and fused linear variable changes
+// against the unfused kernels, the chunked Vader::changeVar against the whole-field one,
+// the single precision kernels against the double precision ones, and every rewritten
+// nonlinear, tangent linear and adjoint kernel (and TempToPTemp::execute) against the
+// frozen copy of its original code (reference_kernels.h). The outputs must agree within
+// the tolerance of the path, relative to the largest magnitude of each output, and the
+// time ratio to the reference is reported; a path more than S times slower than its
+// reference (2 by default, no limit if S is 0) fails, unless the reference takes less
+// than a tenth of a millisecond. Every tangent linear and adjoint pair is also checked by
+// the dot product test <TL x, y> = <x, AD y> on random increments. The exit code is 1 if
+// any check fails. The vader_benchmarks_verify tests run these checks at a small
+// resolution, with the lookup tables of test/testdata, and without the time limit.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "atlas/array.h"
+#include "atlas/field.h"
+#include "atlas/functionspace.h"
+#include "atlas/grid.h"
+#include "atlas/library.h"
+#include "atlas/meshgenerator.h"
+#include "atlas/option.h"
+#include "atlas/parallel/omp/omp.h"
+
+#include "eckit/config/LocalConfiguration.h"
+#include "eckit/log/JSON.h"
+
+#include "benchmark/reference_kernels.h"
+
+#include "mo/common_linearvarchange.h"
+#include "mo/common_varchange.h"
+#include "mo/constants.h"
+#include "mo/control2analysis_linearvarchange.h"
+#include "mo/control2analysis_varchange.h"
+#include "mo/functions.h"
+#include "mo/hydrostatic_balance.h"
+#include "mo/model2geovals_varchange.h"
+#include "mo/trajectory_coefficients.h"
+
+#include "oops/base/Variables.h"
+
+#include "vader/recipes/TempToPTemp.h"
+#include "vader/vader.h"
+#include "vader/VaderParameters.h"
+
+using atlas::array::make_view;
+using atlas::idx_t;
+
+namespace {
+
+struct Options {
+  int resolution = 48;
+  int levels = 70;
+  int iterations = 10;
+  int blockSize = mo::constants::columnBlockSize;
+  int referenceBlockSize = 1;
+  std::string functionSpace = "all";
+  bool lookups = false;
+  bool verify = true;
+  double maxSlowdown = 2.0;
+  std::string json;
+};
+
+Options parseOptions(int argc, char ** argv) {
+  Options options;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string arg(argv[i]);
+    const std::string value(argv[i + 1]);
+    if (arg == "--resolution") {
+      options.resolution = std::atoi(value.c_str());
+    } else if (arg == "--levels") {
+      options.levels = std::atoi(value.c_str());
+    } else if (arg == "--iterations") {
+      options.iterations = std::atoi(value.c_str());
+    } else if (arg == "--block-size") {
+      options.blockSize = std::atoi(value.c_str());
+    } else if (arg == "--reference-block-size") {
+      options.referenceBlockSize = std::atoi(value.c_str());
+    } else if (arg == "--function-space" &&
+               (value == "all" || value == "nodes" || value == "cells")) {
+      options.functionSpace = value;
+    } else if (arg == "--lookups") {
+      options.lookups = std::atoi(value.c_str()) != 0;
+    } else if (arg == "--verify") {
+      options.verify = std::atoi(value.c_str()) != 0;
+    } else if (arg == "--max-slowdown") {
+      options.maxSlowdown = std::atof(value.c_str());
+    } else if (arg == "--json") {
+      options.json = value;
+    } else {
+      std::cerr << "unknown option " << arg << " " << value << std::endl;
+      std::exit(1);
+    }
+  }
+  return options;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Synthetic state: smooth, physically plausible profiles with some horizontal variation.
+// Increments are small relative perturbations of the state.
+constexpr idx_t nBins = 2;  // regression bins of evalHydrostaticPressureTL/AD
+
+double syntheticState(const std::string & name, const idx_t jn, const idx_t jl) {
+  const double x = 0.01 * static_cast<double>(jn % 97);
+  const double z = static_cast<double>(jl);
+  if (name == "height_levels") return 300.0 * z + x;
+  if (name == "height") return 300.0 * z + 150.0 + x;
+  const double p = 1.0e5 * std::exp(-0.05 * z) * (1.0 - 0.01 * x);
+  if (name == "air_pressure" || name == "air_pressure_levels" ||
+      name == "air_pressure_levels_minus_one" || name == "hydrostatic_pressure_levels" ||
+      name == "geostrophic_pressure_levels_minus_one" ||
+      name == "unbalanced_pressure_levels_minus_one" || name == "surface_pressure") {
+    return p;
+  }
+  if (name == "exner" || name == "exner_levels_minus_one" ||
+      name == "hydrostatic_exner_levels" || name == "exner_pressure_levels") {
+    return std::pow(p / mo::constants::p_zero, mo::constants::rd_over_cp);
+  }
+  if (name == "virtual_potential_temperature" || name == "potential_temperature") {
+    return 290.0 + 2.0 * z + x;
+  }
+  const double t = 288.0 - 0.5 * z + x;
+  if (name == "air_temperature") return t;
+  if (name == "dry_air_density_levels_minus_one") return p / (mo::constants::rd * t);
+  if (name == "specific_humidity" || name == "qt" || name == "m_v") {
+    return 1.0e-2 * std::exp(-0.1 * z) * (1.0 + x);
+  }
+  if (name == "mass_content_of_cloud_ice_in_atmosphere_layer" || name == "m_ci" ||
+      name == "mass_content_of_cloud_liquid_water_in_atmosphere_layer" || name == "m_cl") {
+    return 1.0e-4 * std::exp(-0.1 * z) * (1.0 + x);
+  }
+  if (name == "qrain" || name == "m_r") return 1.0e-5 * std::exp(-0.1 * z);
+  if (name == "m_t") return 1.01 + 1.0e-3 * x;
+  if (name == "qsat") return 1.5e-2 * std::exp(-0.08 * z) * (1.0 + x);
+  if (name == "svp") return 1.0e3 * std::exp(-0.05 * z);
+  if (name == "dlsvpdT") return 6.0e-2 + 1.0e-3 * x;
+  if (name == "relative_humidity" || name == "relative_humidity_2m") return 0.5 + 0.4 * x;
+  // all the bins of the MIO, and fully cloudy points for x >= 0.9
+  if (name == "rht") return 0.5 + 0.6 * x;
+  if (name == "liquid_cloud_volume_fraction_in_atmosphere_layer") return std::min(0.2 + x, 1.0);
+  if (name == "ice_cloud_volume_fraction_in_atmosphere_layer") return std::min(0.1 + x, 1.0);
+  if (name == "cleff") return 0.3 + 0.1 * x;
+  if (name == "cfeff") return 0.2 + 0.1 * x;
+  if (name == "interpolation_weights") return 1.0 / nBins;
+  if (name == "vertical_regression_matrices") {
+    return 1.0e-2 * std::exp(-0.1 * std::abs(static_cast<double>(jn % 97) - z));
+  }
+  if (name == "mu") return 1.0e-3 * (1.0 + x);
+  // the mu factors of the moisture control variable
+  return 1.0 + 0.1 * x;
+}
+
+double syntheticValue(const std::string & name, const idx_t jn, const idx_t jl,
+                      const bool increment) {
+  const double value = syntheticState(name, jn, jl);
+  if (!increment) return value;
+  const double x = 0.01 * static_cast<double>(jn % 97);
+  return 1.0e-3 * value * std::sin(0.1 * static_cast<double>(jl) + x + 0.3);
+}
+
+template<typename T>
+void fillField(atlas::Field & field, const bool increment) {
+  auto view = make_view<T, 2>(field);
+  for (idx_t jn = 0; jn < field.shape(0); ++jn) {
+    for (idx_t jl = 0; jl < field.shape(1); ++jl) {
+      view(jn, jl) = static_cast<T>(syntheticValue(field.name(), jn, jl, increment));
+    }
+  }
+}
+
+void fillField(atlas::Field & field, const bool increment) {
+  if (field.datatype() == atlas::array::make_datatype<float>()) {
+    fillField<float>(field, increment);
+  } else {
+    fillField<double>(field, increment);
+  }
+}
+
+template<typename T>
+std::vector<double> copyField(const atlas::Field & field) {
+  const auto view = make_view<const T, 2>(field);
+  std::vector<double> values;
+  values.reserve(field.size());
+  for (idx_t jn = 0; jn < field.shape(0); ++jn) {
+    for (idx_t jl = 0; jl < field.shape(1); ++jl) values.push_back(view(jn, jl));
+  }
+  return values;
+}
+
+/// The values of a double or float field, in double
+std::vector<double> copyField(const atlas::Field & field) {
+  return field.datatype() == atlas::array::make_datatype<float>() ? copyField<float>(field) :
+                                                                     copyField<double>(field);
+}
+
+// (name, levels) of the fields of a benchmark fieldset
+typedef std::vector<std::pair<std::string, int>> FieldSpecs;
+
+atlas::FieldSet createFieldSet(const atlas::FunctionSpace & fspace, const FieldSpecs & specs,
+                               const bool increment, const bool singlePrecision = false) {
+  atlas::FieldSet fset;
+  for (const auto & spec : specs) {
+    const auto config = atlas::option::name(spec.first) | atlas::option::levels(spec.second);
+    atlas::Field field = singlePrecision ? fspace.createField<float>(config) :
+                                           fspace.createField<double>(config);
+    fillField(field, increment);
+    fset.add(field);
+  }
+  return fset;
+}
+
+// Random increments of the magnitude of the synthetic ones, reproducible from seed
+void fillRandom(atlas::FieldSet & fset, const unsigned int seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  for (idx_t jf = 0; jf < fset.size(); ++jf) {
+    auto view = make_view<double, 2>(fset[jf]);
+    for (idx_t jn = 0; jn < fset[jf].shape(0); ++jn) {
+      for (idx_t jl = 0; jl < fset[jf].shape(1); ++jl) {
+        view(jn, jl) = 1.0e-3 * std::abs(syntheticState(fset[jf].name(), jn, jl)) *
+                       uniform(generator);
+      }
+    }
+  }
+}
+
+std::vector<std::vector<double>> fieldValues(const atlas::FieldSet & fset) {
+  std::vector<std::vector<double>> values;
+  for (idx_t jf = 0; jf < fset.size(); ++jf) values.push_back(copyField(fset[jf]));
+  return values;
+}
+
+double dotProduct(const std::vector<std::vector<double>> & a,
+                  const std::vector<std::vector<double>> & b) {
+  double dot = 0.0;
+  for (std::size_t jf = 0; jf < a.size(); ++jf) {
+    for (std::size_t ji = 0; ji < a[jf].size(); ++ji) dot += a[jf][ji] * b[jf][ji];
+  }
+  return dot;
+}
+
+// ------------------------------------------------------------------------------------------------
+struct Kernel {
+  std::string name;
+  std::function<void()> run;
+  std::vector<atlas::Field> outputs;  // reset before each run, compared between block sizes
+  bool increment;                      // the outputs are increments
+  std::size_t bytes;                   // memory traffic of a run
+  // --verify: the kernel the outputs are compared to, and the relative tolerance
+  std::string reference = "";
+  double tolerance = 0.0;
+  // --verify: dot product test of an adjoint kernel, returning the relative difference
+  // of <TL x, y> and <x, AD y>, and its tolerance
+  std::function<double()> adjointTest;
+  double adjointTolerance = 0.0;
+};
+
+struct Result {
+  std::string kernel;
+  std::string functionSpace;
+  idx_t columns;
+  double seconds;
+  std::size_t bytes;
+  double referenceSeconds;
+  bool bitwise;
+  std::string reference = "";
+  double referenceError = 0.0;
+  double referenceRatio = 0.0;
+  bool adjointTested = false;
+  double adjointError = 0.0;
+  bool verified = true;
+};
+
+constexpr double doubleTolerance = 1.0e-10;
+constexpr double floatTolerance = 1.0e-5;
+// --max-slowdown: shortest reference time checked, below which the time ratio is that of
+// the timer and of the thread start-up rather than of the kernels
+constexpr double minCheckedSeconds = 1.0e-4;
+
+/// Compares the outputs of the last kernel added to those of the kernel named reference
+void compareTo(std::vector<Kernel> & kernels, const std::string & reference,
+               const double tolerance) {
+  kernels.back().reference = reference;
+  kernels.back().tolerance = tolerance;
+}
+
+/// Dot product test of tl and ad on random increments of the fields of incrementSpecs
+void addAdjointTest(Kernel & kernel, const std::function<void(atlas::FieldSet &)> & tl,
+                    const std::function<void(atlas::FieldSet &)> & ad,
+                    const atlas::FunctionSpace & fspace, const FieldSpecs & incrementSpecs,
+                    const double tolerance) {
+  kernel.adjointTest = [tl, ad, fspace, incrementSpecs]() {
+    atlas::FieldSet dx = createFieldSet(fspace, incrementSpecs, true);
+    atlas::FieldSet dy = createFieldSet(fspace, incrementSpecs, true);
+    fillRandom(dx, 1);
+    fillRandom(dy, 2);
+    const auto x = fieldValues(dx);
+    const auto y = fieldValues(dy);
+    tl(dx);
+    ad(dy);
+    const double tlDot = dotProduct(fieldValues(dx), y);
+    const double adDot = dotProduct(x, fieldValues(dy));
+    return std::abs(tlDot - adDot) /
+           std::max({std::abs(tlDot), std::abs(adDot), std::numeric_limits<double>::min()});
+  };
+  kernel.adjointTolerance = tolerance;
+}
+
+bool isOutput(const std::string & name, const std::vector<std::string> & outputs) {
+  return std::find(outputs.begin(), outputs.end(), name) != outputs.end();
+}
+
+std::size_t traffic(const atlas::FieldSet & fset, const std::vector<std::string> & outputs,
+                    const bool accumulate) {
+  std::size_t bytes = 0;
+  for (idx_t i = 0; i < fset.size(); ++i) {
+    const atlas::Field & field = fset[i];
+    bytes += field.bytes() * ((isOutput(field.name(), outputs) && accumulate) ? 2 : 1);
+  }
+  return bytes;
+}
+
+std::vector<atlas::Field> fields(atlas::FieldSet & fset, const std::vector<std::string> & names) {
+  std::vector<atlas::Field> fieldList;
+  for (const auto & name : names) fieldList.push_back(fset[name]);
+  return fieldList;
+}
+
+/// Kernel of a nonlinear function of a single fieldset
+template<typename Function>
+Kernel nonlinear(const std::string & name, const Function & function, atlas::FieldSet state,
+                 const std::vector<std::string> & outputs) {
+  return Kernel{name, [state, function]() mutable {function(state);},
+                fields(state, outputs), false, traffic(state, {}, false)};
+}
+
+template<typename Function>
+Kernel nonlinear(const std::string & name, const Function & function,
+                 const atlas::FunctionSpace & fspace, const FieldSpecs & specs,
+                 const std::vector<std::string> & outputs) {
+  return nonlinear(name, function, createFieldSet(fspace, specs, false), outputs);
+}
+
+/// Adds the kernel of a nonlinear function, compared to the kernel named reference unless
+/// it is empty, and its single precision twin, compared to it
+template<typename Function>
+void addWithFloat(std::vector<Kernel> & kernels, const std::string & name,
+                  const Function & function, const atlas::FunctionSpace & fspace,
+                  const FieldSpecs & specs, const std::vector<std::string> & outputs,
+                  const std::string & reference = "",
+                  const double tolerance = doubleTolerance) {
+  kernels.push_back(nonlinear(name, function, fspace, specs, outputs));
+  if (!reference.empty()) compareTo(kernels, reference, tolerance);
+  kernels.push_back(nonlinear(name + " (float)", function,
+                              createFieldSet(fspace, specs, false, true), outputs));
+  compareTo(kernels, name, floatTolerance);
+}
+
+/// Adds the kernel of the frozen copy of a rewritten nonlinear function (see
+/// reference_kernels.h), named "reference::" + name, and the kernel of the function,
+/// compared to it
+template<typename Function, typename Reference>
+void addWithReference(std::vector<Kernel> & kernels, const std::string & name,
+                      const Function & function, const Reference & reference,
+                      const atlas::FunctionSpace & fspace, const FieldSpecs & specs,
+                      const std::vector<std::string> & outputs,
+                      const double tolerance = doubleTolerance) {
+  kernels.push_back(nonlinear("reference::" + name, reference, fspace, specs, outputs));
+  kernels.push_back(nonlinear(name, function, fspace, specs, outputs));
+  compareTo(kernels, "reference::" + name, tolerance);
+}
+
+/// As addWithFloat, after the kernel of the frozen copy of the function (see
+/// reference_kernels.h), which is the reference of the double precision kernel
+template<typename Function, typename Reference>
+void addWithReferenceAndFloat(std::vector<Kernel> & kernels, const std::string & name,
+                              const Function & function, const Reference & reference,
+                              const atlas::FunctionSpace & fspace, const FieldSpecs & specs,
+                              const std::vector<std::string> & outputs,
+                              const double tolerance = doubleTolerance) {
+  kernels.push_back(nonlinear("reference::" + name, reference, fspace, specs, outputs));
+  addWithFloat(kernels, name, function, fspace, specs, outputs, "reference::" + name,
+               tolerance);
+}
+
+/// Kernel of a tangent linear (accumulate = false) or adjoint (accumulate = true)
+/// function of an increment fieldset and a state fieldset
+template<typename Function>
+Kernel linear(const std::string & name, const Function & function, atlas::FieldSet state,
+              atlas::FieldSet increments, const std::vector<std::string> & outputs,
+              const bool accumulate) {
+  return Kernel{name, [state, increments, function]() mutable {function(increments, state);},
+                fields(increments, outputs), true,
+                traffic(state, {}, false) + traffic(increments, outputs, accumulate)};
+}
+
+template<typename Function>
+Kernel linear(const std::string & name, const Function & function,
+              const atlas::FunctionSpace & fspace, const FieldSpecs & stateSpecs,
+              const FieldSpecs & incrementSpecs, const std::vector<std::string> & outputs,
+              const bool accumulate) {
+  return linear(name, function, createFieldSet(fspace, stateSpecs, false),
+                createFieldSet(fspace, incrementSpecs, true), outputs, accumulate);
+}
+
+std::vector<std::string> names(const FieldSpecs & specs) {
+  std::vector<std::string> fieldNames;
+  for (const auto & spec : specs) fieldNames.push_back(spec.first);
+  return fieldNames;
+}
+
+/// Adds the tangent linear and adjoint kernels of a linear variable change.
+/// The adjoint outputs are all the increments.
+template<typename TL, typename AD>
+void addLinear(std::vector<Kernel> & kernels, const std::string & name, const TL & tl,
+               const AD & ad, const atlas::FunctionSpace & fspace,
+               const FieldSpecs & stateSpecs, const FieldSpecs & incrementSpecs,
+               const std::vector<std::string> & tlOutputs) {
+  kernels.push_back(linear(name + "TL", tl, fspace, stateSpecs, incrementSpecs,
+                           tlOutputs, false));
+  kernels.push_back(linear(name + "AD", ad, fspace, stateSpecs, incrementSpecs,
+                           names(incrementSpecs), true));
+  addAdjointTest(kernels.back(),
+    [tl, fspace, stateSpecs](atlas::FieldSet & incs) {
+      tl(incs, createFieldSet(fspace, stateSpecs, false));},
+    [ad, fspace, stateSpecs](atlas::FieldSet & hats) {
+      ad(hats, createFieldSet(fspace, stateSpecs, false));},
+    fspace, incrementSpecs, doubleTolerance);
+}
+
+/// As addLinear, after the kernels of the frozen copies of the tangent linear and adjoint
+/// (see reference_kernels.h), which are their references
+template<typename TL, typename AD, typename ReferenceTL, typename ReferenceAD>
+void addLinearWithReference(std::vector<Kernel> & kernels, const std::string & name,
+                            const TL & tl, const AD & ad, const ReferenceTL & referenceTL,
+                            const ReferenceAD & referenceAD,
+                            const atlas::FunctionSpace & fspace, const FieldSpecs & stateSpecs,
+                            const FieldSpecs & incrementSpecs,
+                            const std::vector<std::string> & tlOutputs) {
+  kernels.push_back(linear("reference::" + name + "TL", referenceTL, fspace, stateSpecs,
+                           incrementSpecs, tlOutputs, false));
+  kernels.push_back(linear("reference::" + name + "AD", referenceAD, fspace, stateSpecs,
+                           incrementSpecs, names(incrementSpecs), true));
+  addLinear(kernels, name, tl, ad, fspace, stateSpecs, incrementSpecs, tlOutputs);
+  kernels[kernels.size() - 2].reference = "reference::" + name + "TL";
+  kernels[kernels.size() - 2].tolerance = doubleTolerance;
+  compareTo(kernels, "reference::" + name + "AD", doubleTolerance);
+}
+
+/// Adds the tangent linear and adjoint kernels of a mo::precomputed linear variable
+/// change, reading its trajectory from a coefficient store of value type T. They are
+/// compared to the unfused kernels of the same name.
+template<typename T, typename TL, typename AD>
+void addPrecomputed(std::vector<Kernel> & kernels, const std::string & name, const TL & tl,
+                    const AD & ad, const atlas::FunctionSpace & fspace,
+                    const std::shared_ptr<const mo::TrajectoryCoefficients<T>> & store,
+                    const FieldSpecs & incrementSpecs,
+                    const std::vector<std::string> & tlOutputs) {
+  const std::string suffix = std::is_same<T, float>::value ? " (float)" : "";
+  for (const bool adjoint : {false, true}) {
+    atlas::FieldSet increments = createFieldSet(fspace, incrementSpecs, true);
+    const std::vector<std::string> outputs = adjoint ? names(incrementSpecs) : tlOutputs;
+    kernels.push_back(Kernel{"precomputed::" + name + (adjoint ? "AD" : "TL") + suffix,
+      [increments, store, tl, ad, adjoint]() mutable {
+        if (adjoint) {
+          ad(increments, *store);
+        } else {
+          tl(increments, *store);
+        }
+      }, fields(increments, outputs), true,
+      store->bytes() + traffic(increments, outputs, adjoint)});
+    const double tolerance = std::is_same<T, float>::value ? floatTolerance : doubleTolerance;
+    compareTo(kernels, name + (adjoint ? "AD" : "TL"), tolerance);
+  }
+  addAdjointTest(kernels.back(),
+    [tl, store](atlas::FieldSet & incs) {tl(incs, *store);},
+    [ad, store](atlas::FieldSet & hats) {ad(hats, *store);},
+    fspace, incrementSpecs, std::is_same<T, float>::value ? floatTolerance : doubleTolerance);
+}
+
+template<typename T>
+void addPrecomputedKernels(std::vector<Kernel> & kernels, const atlas::FunctionSpace & fspace,
+                           const int nl, const std::vector<std::string> & muFactors) {
+  FieldSpecs stateSpecs{{"dry_air_density_levels_minus_one", nl},
+                        {"exner_levels_minus_one", nl}, {"height", nl},
+                        {"height_levels", nl + 1}, {"potential_temperature", nl}};
+  for (const auto & factor : muFactors) stateSpecs.emplace_back(factor, nl);
+  const auto store = std::make_shared<const mo::TrajectoryCoefficients<T>>(
+    mo::setupTrajectoryCoefficients<T>(createFieldSet(fspace, stateSpecs, false)));
+
+  addPrecomputed(kernels, "evalDryAirDensity", mo::precomputed::evalDryAirDensityTL<T>,
+    mo::precomputed::evalDryAirDensityAD<T>, fspace, store,
+    {{"dry_air_density_levels_minus_one", nl}, {"exner_levels_minus_one", nl},
+     {"potential_temperature", nl}}, {"dry_air_density_levels_minus_one"});
+  addPrecomputed(kernels, "evalAirTemperature", mo::precomputed::evalAirTemperatureTL<T>,
+    mo::precomputed::evalAirTemperatureAD<T>, fspace, store,
+    {{"air_temperature", nl}, {"exner_levels_minus_one", nl}, {"potential_temperature", nl}},
+    {"air_temperature"});
+  const FieldSpecs muIncrementSpecs{{"mu", nl}, {"potential_temperature", nl}, {"qt", nl},
+                                    {"virtual_potential_temperature", nl}};
+  addPrecomputed(kernels, "evalMuThetav", mo::precomputed::evalMuThetavTL<T>,
+    mo::precomputed::evalMuThetavAD<T>, fspace, store, muIncrementSpecs,
+    {"mu", "virtual_potential_temperature"});
+  addPrecomputed(kernels, "evalQtTheta", mo::precomputed::evalQtThetaTL<T>,
+    mo::precomputed::evalQtThetaAD<T>, fspace, store, muIncrementSpecs,
+    {"qt", "potential_temperature"});
+}
+
+// ------------------------------------------------------------------------------------------------
+std::vector<Kernel> createKernels(const atlas::FunctionSpace & fspace, const int nl,
+                                  const bool lookups) {
+  const int nl1 = nl + 1;
+  const std::string q = "specific_humidity";
+  const std::string qcl = "mass_content_of_cloud_liquid_water_in_atmosphere_layer";
+  const std::string qcf = "mass_content_of_cloud_ice_in_atmosphere_layer";
+  std::vector<Kernel> kernels;
+
+  // ++ common ++
+  if (lookups) {
+    const FieldSpecs svpSpecs{{"air_temperature", nl}, {"svp", nl}, {"dlsvpdT", nl}};
+    addWithReferenceAndFloat(kernels, "evalSatVaporPressure", mo::evalSatVaporPressure,
+      mo::reference::evalSatVaporPressure, fspace, svpSpecs, {"svp", "dlsvpdT"});
+    const FieldSpecs mioSpecs{{"rht", nl}, {"liquid_cloud_volume_fraction_in_atmosphere_layer", nl},
+                              {"ice_cloud_volume_fraction_in_atmosphere_layer", nl},
+                              {"cleff", nl}, {"cfeff", nl}};
+    addWithReferenceAndFloat(kernels, "getMIOFields", mo::functions::getMIOFields,
+      mo::reference::functions::getMIOFields, fspace, mioSpecs, {"cleff", "cfeff"}, 0.0);
+  }
+  const FieldSpecs qsatSpecs{{"air_pressure", nl}, {"svp", nl}, {"air_temperature", nl},
+                             {"qsat", nl}};
+  addWithReferenceAndFloat(kernels, "evalSatSpecificHumidity", mo::evalSatSpecificHumidity,
+    mo::reference::evalSatSpecificHumidity, fspace, qsatSpecs, {"qsat"});
+  addWithReference(kernels, "evalAirPressureLevels", mo::evalAirPressureLevels,
+    mo::reference::evalAirPressureLevels, fspace,
+    {{"exner_levels_minus_one", nl}, {"air_pressure_levels_minus_one", nl},
+     {"potential_temperature", nl}, {"height_levels", nl1}, {"air_pressure_levels", nl1}},
+    {"air_pressure_levels"});
+  addLinearWithReference(kernels, "evalVirtualPotentialTemperature",
+    mo::evalVirtualPotentialTemperatureTL, mo::evalVirtualPotentialTemperatureAD,
+    mo::reference::evalVirtualPotentialTemperatureTL,
+    mo::reference::evalVirtualPotentialTemperatureAD, fspace,
+    {{"potential_temperature", nl}, {q, nl}},
+    {{"potential_temperature", nl}, {q, nl}, {"virtual_potential_temperature", nl}},
+    {"virtual_potential_temperature"});
+
+  // ++ control to analysis ++
+  addWithReference(kernels, "hexner2PThetav", mo::hexner2PThetav, mo::reference::hexner2PThetav,
+    fspace, {{"hydrostatic_exner_levels", nl1}, {"height_levels", nl1},
+             {"air_pressure_levels_minus_one", nl}, {"virtual_potential_temperature", nl1}},
+    {"air_pressure_levels_minus_one", "virtual_potential_temperature"});
+  addWithReferenceAndFloat(kernels, "evalVirtualPotentialTemperature",
+    mo::evalVirtualPotentialTemperature, mo::reference::evalVirtualPotentialTemperature,
+    fspace, {{"potential_temperature", nl}, {q, nl}, {"virtual_potential_temperature", nl}},
+    {"virtual_potential_temperature"});
+  const FieldSpecs hexnerSpecs{{"air_pressure_levels_minus_one", nl}, {"height_levels", nl1},
+                               {"virtual_potential_temperature", nl1},
+                               {"hydrostatic_exner_levels", nl1}};
+  addWithReference(kernels, "evalHydrostaticExnerLevels", mo::evalHydrostaticExnerLevels,
+    mo::reference::evalHydrostaticExnerLevels, fspace, hexnerSpecs,
+    {"hydrostatic_exner_levels"});
+  addWithReference(kernels, "evalHydrostaticPressureLevels", mo::evalHydrostaticPressureLevels,
+    mo::reference::evalHydrostaticPressureLevels, fspace,
+    {{"hydrostatic_exner_levels", nl1}, {"hydrostatic_pressure_levels", nl1}},
+    {"hydrostatic_pressure_levels"});
+  addWithReference(kernels, "qqclqcf2qt", mo::qqclqcf2qt, mo::reference::qqclqcf2qt, fspace,
+    {{q, nl}, {qcl, nl}, {qcf, nl}, {"qt", nl}}, {"qt"});
+  addWithReference(kernels, "evalDryAirDensity", mo::evalDryAirDensity,
+    mo::reference::evalDryAirDensity, fspace,
+    {{"air_pressure_levels_minus_one", nl}, {"air_temperature", nl}, {"height", nl},
+     {"height_levels", nl1}, {"dry_air_density_levels_minus_one", nl}},
+    {"dry_air_density_levels_minus_one"});
+  addWithReference(kernels, "evalExnerPressureLevels", mo::evalExnerPressureLevels,
+    mo::reference::evalExnerPressureLevels, fspace,
+    {{"exner_levels_minus_one", nl}, {"virtual_potential_temperature", nl1},
+     {"height_levels", nl1}, {"exner_pressure_levels", nl1}}, {"exner_pressure_levels"});
+  const std::vector<std::string> muFactors{"muRow1Column1", "muRow1Column2", "muRow2Column1",
+                                           "muRow2Column2", "muRecipDeterminant"};
+  FieldSpecs muSpecs{{"qt", nl}, {q, nl}, {"potential_temperature", nl}, {"exner", nl},
+                     {"dlsvpdT", nl}, {"qsat", nl}, {"muA", nl}, {"muH1", nl}};
+  for (const auto & factor : muFactors) muSpecs.emplace_back(factor, nl);
+  addWithReference(kernels, "evalMoistureControlDependencies",
+    mo::evalMoistureControlDependencies, mo::reference::evalMoistureControlDependencies,
+    fspace, muSpecs, muFactors);
+
+  addLinearWithReference(kernels, "thetavP2Hexner", mo::thetavP2HexnerTL,
+    mo::thetavP2HexnerAD, mo::reference::thetavP2HexnerTL, mo::reference::thetavP2HexnerAD,
+    fspace,
+    {{"air_pressure_levels_minus_one", nl}, {"height_levels", nl1},
+     {"hydrostatic_exner_levels", nl1}, {"virtual_potential_temperature", nl1}},
+    {{"air_pressure_levels_minus_one", nl}, {"hydrostatic_exner_levels", nl1},
+     {"virtual_potential_temperature", nl1}}, {"hydrostatic_exner_levels"});
+  addLinearWithReference(kernels, "hexner2Thetav", mo::hexner2ThetavTL, mo::hexner2ThetavAD,
+    mo::reference::hexner2ThetavTL, mo::reference::hexner2ThetavAD, fspace,
+    {{"height_levels", nl1}, {"virtual_potential_temperature", nl1}},
+    {{"hydrostatic_exner_levels", nl1}, {"virtual_potential_temperature", nl1}},
+    {"virtual_potential_temperature"});
+  addLinearWithReference(kernels, "evalDryAirDensity", mo::evalDryAirDensityTL,
+    mo::evalDryAirDensityAD, mo::reference::evalDryAirDensityTL,
+    mo::reference::evalDryAirDensityAD, fspace,
+    {{"dry_air_density_levels_minus_one", nl}, {"exner_levels_minus_one", nl},
+     {"height", nl}, {"height_levels", nl1}, {"potential_temperature", nl}},
+    {{"dry_air_density_levels_minus_one", nl}, {"exner_levels_minus_one", nl},
+     {"potential_temperature", nl}}, {"dry_air_density_levels_minus_one"});
+  addLinearWithReference(kernels, "evalAirTemperature", mo::evalAirTemperatureTL,
+    mo::evalAirTemperatureAD, mo::reference::evalAirTemperatureTL,
+    mo::reference::evalAirTemperatureAD, fspace,
+    {{"exner_levels_minus_one", nl}, {"height", nl}, {"height_levels", nl1},
+     {"potential_temperature", nl}},
+    {{"air_temperature", nl}, {"exner_levels_minus_one", nl}, {"potential_temperature", nl}},
+    {"air_temperature"});
+  addLinearWithReference(kernels, "qqclqcf2qt", mo::qqclqcf2qtTL, mo::qqclqcf2qtAD,
+    mo::reference::qqclqcf2qtTL, mo::reference::qqclqcf2qtAD, fspace, {},
+    {{q, nl}, {qcl, nl}, {qcf, nl}, {"qt", nl}}, {"qt"});
+  addLinearWithReference(kernels, "qtTemperature2qqclqcf", mo::qtTemperature2qqclqcfTL,
+    mo::qtTemperature2qqclqcfAD, mo::reference::qtTemperature2qqclqcfTL,
+    mo::reference::qtTemperature2qqclqcfAD, fspace,
+    {{"cfeff", nl}, {"cleff", nl}, {"dlsvpdT", nl}, {"qsat", nl}},
+    {{"air_temperature", nl}, {qcf, nl}, {qcl, nl}, {"qt", nl}, {q, nl}}, {q, qcl, qcf});
+  {
+    // The regression matrices, one (levels x levels) matrix per bin, are not a function
+    // space field.
+    atlas::FieldSet state = createFieldSet(fspace,
+      {{"air_pressure_levels", nl1}, {"interpolation_weights", nBins}}, false);
+    atlas::Field vertReg("vertical_regression_matrices", atlas::array::make_datatype<double>(),
+                         atlas::array::make_shape(nBins * nl, nl));
+    fillField(vertReg, false);
+    state.add(vertReg);
+    const FieldSpecs incrementSpecs{{"geostrophic_pressure_levels_minus_one", nl},
+                                    {"unbalanced_pressure_levels_minus_one", nl},
+                                    {"hydrostatic_pressure_levels", nl1}};
+    kernels.push_back(linear("reference::evalHydrostaticPressureTL",
+      mo::reference::evalHydrostaticPressureTL, state,
+      createFieldSet(fspace, incrementSpecs, true), {"hydrostatic_pressure_levels"}, false));
+    kernels.push_back(linear("reference::evalHydrostaticPressureAD",
+      mo::reference::evalHydrostaticPressureAD, state,
+      createFieldSet(fspace, incrementSpecs, true), names(incrementSpecs), true));
+    kernels.push_back(linear("evalHydrostaticPressureTL", mo::evalHydrostaticPressureTL, state,
+      createFieldSet(fspace, incrementSpecs, true), {"hydrostatic_pressure_levels"}, false));
+    compareTo(kernels, "reference::evalHydrostaticPressureTL", doubleTolerance);
+    kernels.push_back(linear("evalHydrostaticPressureAD", mo::evalHydrostaticPressureAD, state,
+      createFieldSet(fspace, incrementSpecs, true), names(incrementSpecs), true));
+    compareTo(kernels, "reference::evalHydrostaticPressureAD", doubleTolerance);
+    addAdjointTest(kernels.back(),
+      [state](atlas::FieldSet & incs) {mo::evalHydrostaticPressureTL(incs, state);},
+      [state](atlas::FieldSet & hats) {mo::evalHydrostaticPressureAD(hats, state);},
+      fspace, incrementSpecs, doubleTolerance);
+  }
+  addLinearWithReference(kernels, "evalHydrostaticExner", mo::evalHydrostaticExnerTL,
+    mo::evalHydrostaticExnerAD, mo::reference::evalHydrostaticExnerTL,
+    mo::reference::evalHydrostaticExnerAD, fspace,
+    {{"hydrostatic_exner_levels", nl1}, {"hydrostatic_pressure_levels", nl1}},
+    {{"hydrostatic_exner_levels", nl1}, {"hydrostatic_pressure_levels", nl1}},
+    {"hydrostatic_exner_levels"});
+  {
+    // The hydrostatic balance chain (hydrostatic pressure, hydrostatic exner, virtual
+    // potential temperature): unfused, and fused with its trajectory coefficients
+    // computed once, as in an outer loop
+    atlas::FieldSet state = createFieldSet(fspace,
+      {{"air_pressure_levels", nl1}, {"height_levels", nl1}, {"hydrostatic_exner_levels", nl1},
+       {"hydrostatic_pressure_levels", nl1}, {"interpolation_weights", nBins},
+       {"virtual_potential_temperature", nl}}, false);
+    // A single weighted bin: evalHydrostaticPressureTL/AD keep the regression of the last
+    // weighted bin only, whereas hydrostaticBalanceTL/AD sum over the bins
+    auto weightsView = make_view<double, 2>(state["interpolation_weights"]);
+    for (idx_t jn = 0; jn < state["interpolation_weights"].shape(0); ++jn) {
+      for (idx_t ib = 0; ib < nBins; ++ib) weightsView(jn, ib) = (ib == nBins - 1) ? 1.0 : 0.0;
+    }
+    atlas::Field vertReg("vertical_regression_matrices", atlas::array::make_datatype<double>(),
+                         atlas::array::make_shape(nBins * nl, nl));
+    fillField(vertReg, false);
+    state.add(vertReg);
+    const FieldSpecs chainSpecs{{"geostrophic_pressure_levels_minus_one", nl},
+                                {"unbalanced_pressure_levels_minus_one", nl},
+                                {"hydrostatic_pressure_levels", nl1},
+                                {"hydrostatic_exner_levels", nl1},
+                                {"virtual_potential_temperature", nl}};
+    const FieldSpecs fusedSpecs{{"geostrophic_pressure_levels_minus_one", nl},
+                                {"unbalanced_pressure_levels_minus_one", nl},
+                                {"virtual_potential_temperature", nl}};
+    const auto chainTL = [](atlas::FieldSet & incs, const atlas::FieldSet & traj) {
+      mo::evalHydrostaticPressureTL(incs, traj);
+      mo::evalHydrostaticExnerTL(incs, traj);
+      mo::hexner2ThetavTL(incs, traj);
+    };
+    const auto chainAD = [](atlas::FieldSet & hats, const atlas::FieldSet & traj) {
+      mo::hexner2ThetavAD(hats, traj);
+      mo::evalHydrostaticExnerAD(hats, traj);
+      mo::evalHydrostaticPressureAD(hats, traj);
+    };
+    kernels.push_back(linear("hydrostaticBalanceChainTL", chainTL, state,
+      createFieldSet(fspace, chainSpecs, true), {"virtual_potential_temperature"}, false));
+    kernels.push_back(linear("hydrostaticBalanceChainAD", chainAD, state,
+      createFieldSet(fspace, chainSpecs, true), names(chainSpecs), true));
+    addAdjointTest(kernels.back(),
+      [chainTL, state](atlas::FieldSet & incs) {chainTL(incs, state);},
+      [chainAD, state](atlas::FieldSet & hats) {chainAD(hats, state);},
+      fspace, chainSpecs, doubleTolerance);
+
+    const auto traj = std::make_shared<const mo::HydrostaticBalanceTraj>(
+      mo::setupHydrostaticBalanceTraj(state));
+    const std::size_t trajBytes = sizeof(double) * (traj->exnerOverPressure.size() +
+      traj->thetavCoefficient.size() + traj->topPressureRatio.size() +
+      traj->interpWeights.size() + traj->vertReg.size());
+    for (const bool adjoint : {false, true}) {
+      atlas::FieldSet increments = createFieldSet(fspace, fusedSpecs, true);
+      const std::vector<std::string> outputs = adjoint ? names(fusedSpecs) :
+        std::vector<std::string>{"virtual_potential_temperature"};
+      kernels.push_back(Kernel{adjoint ? "hydrostaticBalanceAD" : "hydrostaticBalanceTL",
+        [increments, traj, adjoint]() mutable {
+          if (adjoint) {
+            mo::hydrostaticBalanceAD(increments, *traj);
+          } else {
+            mo::hydrostaticBalanceTL(increments, *traj);
+          }
+        }, fields(increments, outputs), true, trajBytes + traffic(increments, outputs, adjoint)});
+      compareTo(kernels, adjoint ? "hydrostaticBalanceChainAD" : "hydrostaticBalanceChainTL",
+                doubleTolerance);
+    }
+    addAdjointTest(kernels.back(),
+      [traj](atlas::FieldSet & incs) {mo::hydrostaticBalanceTL(incs, *traj);},
+      [traj](atlas::FieldSet & hats) {mo::hydrostaticBalanceAD(hats, *traj);},
+      fspace, fusedSpecs, doubleTolerance);
+  }
+  FieldSpecs muStateSpecs;
+  for (const auto & factor : muFactors) muStateSpecs.emplace_back(factor, nl);
+  const FieldSpecs muIncrementSpecs{{"mu", nl}, {"potential_temperature", nl}, {"qt", nl},
+                                    {"virtual_potential_temperature", nl}};
+  addLinearWithReference(kernels, "evalMuThetav", mo::evalMuThetavTL, mo::evalMuThetavAD,
+    mo::reference::evalMuThetavTL, mo::reference::evalMuThetavAD, fspace,
+    muStateSpecs, muIncrementSpecs, {"mu", "virtual_potential_temperature"});
+  addLinearWithReference(kernels, "evalQtTheta", mo::evalQtThetaTL, mo::evalQtThetaAD,
+    mo::reference::evalQtThetaTL, mo::reference::evalQtThetaAD, fspace,
+    muStateSpecs, muIncrementSpecs, {"qt", "potential_temperature"});
+  addPrecomputedKernels<double>(kernels, fspace, nl, muFactors);
+  addPrecomputedKernels<float>(kernels, fspace, nl, muFactors);
+
+  // ++ model to geovals ++
+  const FieldSpecs mxSpecs{{"m_v", nl}, {"m_ci", nl}, {"m_cl", nl}, {"m_r", nl}, {"m_t", nl}};
+  addWithReferenceAndFloat(kernels, "evalTotalMassMoistAir", mo::evalTotalMassMoistAir,
+    mo::reference::evalTotalMassMoistAir, fspace, mxSpecs, {"m_t"});
+  const std::vector<std::pair<std::string, std::pair<std::string, std::string>>> ratios{
+    {"evalSpecificHumidity", {"m_v", q}}, {"evalMassCloudIce", {"m_ci", qcf}},
+    {"evalMassCloudLiquid", {"m_cl", qcl}}, {"evalMassRain", {"m_r", "qrain"}}};
+  const std::vector<bool(*)(atlas::FieldSet &)> ratioFunctions{
+    mo::evalSpecificHumidity, mo::evalMassCloudIce, mo::evalMassCloudLiquid, mo::evalMassRain};
+  const std::vector<bool(*)(atlas::FieldSet &)> referenceRatioFunctions{
+    mo::reference::evalSpecificHumidity, mo::reference::evalMassCloudIce,
+    mo::reference::evalMassCloudLiquid, mo::reference::evalMassRain};
+  for (std::size_t jr = 0; jr < ratios.size(); ++jr) {
+    addWithReferenceAndFloat(kernels, ratios[jr].first, ratioFunctions[jr],
+      referenceRatioFunctions[jr], fspace,
+      {{ratios[jr].second.first, nl}, {"m_t", nl}, {ratios[jr].second.second, nl}},
+      {ratios[jr].second.second});
+  }
+  FieldSpecs partitionSpecs(mxSpecs);
+  for (const auto & qx : {q, qcf, qcl, std::string("qrain")}) partitionSpecs.emplace_back(qx, nl);
+  const std::vector<std::string> partitionOutputs{"m_t", q, qcf, qcl, "qrain"};
+  // the partition computes m_t and the ratios as evalTotalMassMoistAir and evalRatioToMt do
+  addWithReference(kernels, "evalMoisturePartition", mo::evalMoisturePartition,
+    [referenceRatioFunctions](atlas::FieldSet & fields) {
+      mo::reference::evalTotalMassMoistAir(fields);
+      for (const auto & ratio : referenceRatioFunctions) ratio(fields);
+    }, fspace, partitionSpecs, partitionOutputs, 0.0);
+  kernels.push_back(nonlinear("evalMoisturePartition (float)", mo::evalMoisturePartition,
+    createFieldSet(fspace, partitionSpecs, false, true), partitionOutputs));
+  compareTo(kernels, "evalMoisturePartition", floatTolerance);
+  addWithReferenceAndFloat(kernels, "evalRelativeHumidity", mo::evalRelativeHumidity,
+    mo::reference::evalRelativeHumidity, fspace,
+    {{q, nl}, {"qsat", nl}, {"relative_humidity", nl}}, {"relative_humidity"});
+  addWithReference(kernels, "evalTotalRelativeHumidity", mo::evalTotalRelativeHumidity,
+    mo::reference::evalTotalRelativeHumidity, fspace,
+    {{q, nl}, {qcl, nl}, {qcf, nl}, {"qrain", nl}, {"qsat", nl}, {"rht", nl}}, {"rht"});
+  addWithReferenceAndFloat(kernels, "evalAirTemperature", mo::evalAirTemperature,
+    mo::reference::evalAirTemperature, fspace,
+    {{"potential_temperature", nl}, {"exner", nl}, {"air_temperature", nl}},
+    {"air_temperature"});
+  addWithReference(kernels, "evalSpecificHumidityFromRH_2m", mo::evalSpecificHumidityFromRH_2m,
+    mo::reference::evalSpecificHumidityFromRH_2m, fspace,
+    {{"qsat", 1}, {"relative_humidity_2m", 1},
+     {"specific_humidity_at_two_meters_above_surface", 1}},
+    {"specific_humidity_at_two_meters_above_surface"});
+  for (const bool reference : {true, false}) {
+    atlas::FieldSet fset = createFieldSet(fspace,
+      {{"air_pressure_levels_minus_one", nl}, {"height", nl}, {"height_levels", nl1},
+       {q, nl}, {"param_a", 1}, {"param_b", 1}}, false);
+    fset["height"].metadata().set("boundary_layer_index", static_cast<std::size_t>(nl / 10));
+    kernels.push_back(nonlinear(reference ? "reference::evalParamAParamB" : "evalParamAParamB",
+      reference ? mo::reference::evalParamAParamB : mo::evalParamAParamB, fset,
+      {"param_a", "param_b"}));
+  }
+  compareTo(kernels, "reference::evalParamAParamB", doubleTolerance);
+
+  // ++ vader ++
+  {
+    FieldSpecs specs{{"air_temperature", nl}, {"surface_pressure", 1},
+                     {"potential_temperature", nl}};
+    atlas::FieldSet fset = createFieldSet(fspace, specs, false);
+    fset["surface_pressure"].metadata().set("units", "Pa");
+    atlas::FieldSet referenceFset = createFieldSet(fspace, specs, false);
+    referenceFset["surface_pressure"].metadata().set("units", "Pa");
+    kernels.push_back(nonlinear("reference::TempToPTemp::execute", vader::reference::tempToPTemp,
+                                referenceFset, {"potential_temperature"}));
+    auto recipe = std::make_shared<vader::TempToPTemp>();
+    kernels.push_back(Kernel{"TempToPTemp::execute",
+                             [fset, recipe]() mutable {recipe->execute(fset);},
+                             fields(fset, {"potential_temperature"}), false,
+                             traffic(fset, {}, false)});
+    compareTo(kernels, "reference::TempToPTemp::execute", doubleTolerance);
+
+    // changeVar plans potential temperature and the moisture partition; the plan
+    // is cached after the first call.
+    specs.insert(specs.end(), partitionSpecs.begin(), partitionSpecs.end());
+    atlas::FieldSet changeVarFset = createFieldSet(fspace, specs, false);
+    changeVarFset["surface_pressure"].metadata().set("units", "Pa");
+    const std::vector<std::string> needed{"potential_temperature", "m_t", q, qcf, qcl,
+                                          "qrain"};
+    auto vader = std::make_shared<vader::Vader>(vader::VaderParameters());
+    kernels.push_back(Kernel{"Vader::changeVar",
+                             [changeVarFset, vader, needed]() mutable {
+                               oops::Variables neededVars(needed);
+                               vader->changeVar(changeVarFset, neededVars);},
+                             fields(changeVarFset, needed), false,
+                             traffic(changeVarFset, {}, false)});
+
+    // The same plan executed by blocks of columns (see VaderParameters blockColumns)
+    constexpr int blockColumns = 256;
+    atlas::FieldSet chunkedFset = createFieldSet(fspace, specs, false);
+    chunkedFset["surface_pressure"].metadata().set("units", "Pa");
+    eckit::LocalConfiguration chunkedConf;
+    chunkedConf.set("block columns", blockColumns);
+    vader::VaderParameters chunkedParams;
+    chunkedParams.validateAndDeserialize(chunkedConf);
+    auto chunkedVader = std::make_shared<vader::Vader>(chunkedParams);
+    kernels.push_back(Kernel{"Vader::changeVar (block columns " +
+                             std::to_string(blockColumns) + ")",
+                             [chunkedFset, chunkedVader, needed]() mutable {
+                               oops::Variables neededVars(needed);
+                               chunkedVader->changeVar(chunkedFset, neededVars);},
+                             fields(chunkedFset, needed), false,
+                             traffic(chunkedFset, {}, false)});
+    compareTo(kernels, "Vader::changeVar", 0.0);
+
+    // Per-call overhead of changeVar (plan lookup, binding, setup and dispatch): a
+    // fieldset of a single column, so that the time is that of Vader rather than of
+    // the recipe, and overheadCalls calls per run.
+    constexpr int overheadCalls = 1000;
+    atlas::FieldSet columnFset;
+    for (const auto & spec : FieldSpecs{{"air_temperature", nl}, {"surface_pressure", 1},
+                                        {"potential_temperature", nl}}) {
+      atlas::Field field(spec.first, atlas::array::make_datatype<double>(),
+                         atlas::array::make_shape(1, spec.second));
+      field.set_levels(spec.second);
+      fillField(field, false);
+      columnFset.add(field);
+    }
+    columnFset["surface_pressure"].metadata().set("units", "Pa");
+    kernels.push_back(Kernel{"Vader::changeVar x" + std::to_string(overheadCalls) +
+                             " (1 column)",
+                             [columnFset, vader]() mutable {
+                               for (int jc = 0; jc < overheadCalls; ++jc) {
+                                 oops::Variables neededVars(
+                                   std::vector<std::string>{"potential_temperature"});
+                                 vader->changeVar(columnFset, neededVars);
+                               }},
+                             fields(columnFset, {"potential_temperature"}), false,
+                             overheadCalls * traffic(columnFset, {}, false)});
+  }
+
+  return kernels;
+}
+
+// ------------------------------------------------------------------------------------------------
+double timeKernel(const Kernel & kernel, const int iterations) {
+  double seconds = 0.0;
+  for (int it = 0; it < iterations; ++it) {
+    for (auto field : kernel.outputs) fillField(field, kernel.increment);
+    const auto start = std::chrono::steady_clock::now();
+    kernel.run();
+    seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  return seconds / iterations;
+}
+
+std::vector<std::vector<double>> outputs(const Kernel & kernel) {
+  std::vector<std::vector<double>> values;
+  for (const auto & field : kernel.outputs) values.push_back(copyField(field));
+  return values;
+}
+
+// bitwise comparison (NaN outputs compare equal to themselves)
+bool bitwiseEqual(const std::vector<std::vector<double>> & a,
+                  const std::vector<std::vector<double>> & b) {
+  if (a.size() != b.size()) return false;
+  for (std::size_t jf = 0; jf < a.size(); ++jf) {
+    if (a[jf].size() != b[jf].size() ||
+        std::memcmp(a[jf].data(), b[jf].data(), a[jf].size() * sizeof(double)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// largest difference between the outputs of kernel and the outputs of the same name of
+// reference, relative to the largest magnitude of each reference output (infinite if
+// only one of them is NaN)
+double relativeError(const Kernel & kernel, const Kernel & reference) {
+  double error = 0.0;
+  for (const auto & field : kernel.outputs) {
+    for (const auto & referenceField : reference.outputs) {
+      if (referenceField.name() != field.name()) continue;
+      const std::vector<double> values = copyField(field);
+      const std::vector<double> referenceValues = copyField(referenceField);
+      if (values.size() != referenceValues.size()) return std::numeric_limits<double>::infinity();
+      double scale = 0.0;
+      double difference = 0.0;
+      for (std::size_t ji = 0; ji < values.size(); ++ji) {
+        if (std::isnan(values[ji]) != std::isnan(referenceValues[ji])) {
+          return std::numeric_limits<double>::infinity();
+        }
+        if (std::isnan(values[ji])) continue;
+        scale = std::max(scale, std::abs(referenceValues[ji]));
+        difference = std::max(difference, std::abs(values[ji] - referenceValues[ji]));
+      }
+      error = std::max(error, scale > 0.0 ? difference / scale : difference);
+    }
+  }
+  return error;
+}
+
+// --verify: compares the kernels to their references (once they have all run, so the
+// outputs of each kernel are those of its last run) and runs the adjoint tests
+void verify(const std::vector<Kernel> & kernels, const Options & options,
+            std::vector<Result>::iterator results) {
+  std::cout << std::endl << std::left << std::setw(40) << "verification" << std::setw(40)
+            << "reference" << std::right << std::setw(12) << "error" << std::setw(10)
+            << "ratio" << std::setw(12) << "adjoint" << std::setw(8) << "ok" << std::endl;
+  for (std::size_t jk = 0; jk < kernels.size(); ++jk) {
+    const Kernel & kernel = kernels[jk];
+    Result & result = results[jk];
+    if (kernel.reference.empty() && !kernel.adjointTest) continue;
+    if (!kernel.reference.empty()) {
+      const auto reference = std::find_if(kernels.begin(), kernels.end(),
+        [&kernel](const Kernel & candidate) {return candidate.name == kernel.reference;});
+      if (reference == kernels.end()) {
+        std::cerr << "no reference kernel " << kernel.reference << std::endl;
+        std::exit(1);
+      }
+      result.reference = kernel.reference;
+      result.referenceError = relativeError(kernel, *reference);
+      const double referenceSeconds = results[reference - kernels.begin()].seconds;
+      result.referenceRatio = result.seconds / std::max(referenceSeconds, 1.0e-12);
+      result.verified = result.referenceError <= kernel.tolerance &&
+        (options.maxSlowdown <= 0.0 || referenceSeconds < minCheckedSeconds ||
+         result.referenceRatio <= options.maxSlowdown);
+    }
+    if (kernel.adjointTest) {
+      result.adjointTested = true;
+      result.adjointError = kernel.adjointTest();
+      result.verified = result.verified && result.adjointError <= kernel.adjointTolerance;
+    }
+    std::cout << std::left << std::setw(40) << kernel.name << std::setw(40)
+              << (kernel.reference.empty() ? "-" : kernel.reference) << std::right
+              << std::scientific << std::setprecision(2) << std::setw(12)
+              << result.referenceError << std::fixed << std::setw(10) << result.referenceRatio
+              << std::scientific << std::setw(12) << result.adjointError
+              << std::setw(8) << (result.verified ? "yes" : "NO") << std::endl;
+  }
+}
+
+void benchmark(const atlas::FunctionSpace & fspace, const std::string & fspaceName,
+               const idx_t nColumns, const Options & options, std::vector<Result> & results) {
+  const std::vector<Kernel> kernels = createKernels(fspace, options.levels, options.lookups);
+  const bool compare = options.referenceBlockSize > 0;
+
+  std::cout << std::endl << fspaceName << ": " << nColumns << " columns" << std::endl;
+  std::cout << std::left << std::setw(40) << "kernel" << std::right
+            << std::setw(12) << "time [ms]" << std::setw(14) << "columns/s"
+            << std::setw(10) << "GB/s";
+  if (compare) {
+    std::cout << std::setw(14) << ("block " + std::to_string(options.referenceBlockSize) +
+                                   " [ms]")
+              << std::setw(10) << "speedup" << std::setw(10) << "bitwise";
+  }
+  std::cout << std::endl;
+
+  const std::size_t firstResult = results.size();
+  for (const auto & kernel : kernels) {
+    Result result{kernel.name, fspaceName, nColumns, 0.0, kernel.bytes, 0.0, true};
+    std::vector<std::vector<double>> reference;
+    if (compare) {
+      mo::functions::setColumnBlockSize(options.referenceBlockSize);
+      result.referenceSeconds = timeKernel(kernel, options.iterations);
+      reference = outputs(kernel);
+    }
+    mo::functions::setColumnBlockSize(options.blockSize);
+    result.seconds = timeKernel(kernel, options.iterations);
+    if (compare) result.bitwise = bitwiseEqual(outputs(kernel), reference);
+
+    const double seconds = std::max(result.seconds, 1.0e-12);
+    std::cout << std::left << std::setw(40) << kernel.name << std::right << std::fixed
+              << std::setprecision(3) << std::setw(12) << 1.0e3 * result.seconds
+              << std::scientific << std::setprecision(3) << std::setw(14)
+              << nColumns / seconds << std::fixed << std::setprecision(2) << std::setw(10)
+              << 1.0e-9 * result.bytes / seconds;
+    if (compare) {
+      std::cout << std::setprecision(3) << std::setw(14) << 1.0e3 * result.referenceSeconds
+                << std::setprecision(2) << std::setw(10) << result.referenceSeconds / seconds
+                << std::setw(10) << (result.bitwise ? "yes" : "NO");
+    }
+    std::cout << std::endl;
+    results.push_back(result);
+  }
+  if (options.verify) verify(kernels, options, results.begin() + firstResult);
+}
+
+void writeJSON(const std::string & fileName, const Options & options,
+               const std::vector<Result> & results) {
+  std::ofstream out(fileName);
+  eckit::JSON json(out);
+  json.startObject();
+  json << "benchmark" << "vader_benchmarks";
+  json << "resolution" << options.resolution;
+  json << "levels" << options.levels;
+  json << "iterations" << options.iterations;
+  json << "block_size" << options.blockSize;
+  json << "reference_block_size" << options.referenceBlockSize;
+  json << "max_slowdown" << options.maxSlowdown;
+  json << "threads" << atlas_omp_get_max_threads();
+  json << "results";
+  json.startList();
+  for (const auto & result : results) {
+    const double seconds = std::max(result.seconds, 1.0e-12);
+    json.startObject();
+    json << "kernel" << result.kernel;
+    json << "function_space" << result.functionSpace;
+    json << "columns" << result.columns;
+    json << "seconds" << result.seconds;
+    json << "bytes" << result.bytes;
+    json << "columns_per_second" << result.columns / seconds;
+    json << "gigabytes_per_second" << 1.0e-9 * result.bytes / seconds;
+    if (options.referenceBlockSize > 0) {
+      json << "reference_seconds" << result.referenceSeconds;
+      json << "bitwise" << result.bitwise;
+    }
+    if (!result.reference.empty()) {
+      json << "reference" << result.reference;
+      json << "reference_error" << result.referenceError;
+      json << "reference_ratio" << result.referenceRatio;
+    }
+    if (result.adjointTested) json << "adjoint_error" << result.adjointError;
+    if (options.verify) json << "verified" << result.verified;
+    json.endObject();
+  }
+  json.endList();
+  json.endObject();
+  out << std::endl;
+}
+
+}  // namespace
+
+// ------------------------------------------------------------------------------------------------
+int main(int argc, char ** argv) {
+  atlas::Library::instance().initialise(argc, argv);
+  const Options options = parseOptions(argc, argv);
+
+  const atlas::CubedSphereGrid grid("CS-LFR-" + std::to_string(options.resolution));
+  std::cout << "vader_benchmarks: CS-LFR-" << options.resolution << ", "
+            << options.levels << " levels, " << options.iterations << " iterations, block size "
+            << options.blockSize << ", " << atlas_omp_get_max_threads() << " threads"
+            << std::endl;
+
+  std::vector<Result> results;
+  if (options.functionSpace != "cells") {
+    const auto mesh = atlas::MeshGenerator("cubedsphere_dual").generate(grid);
+    const atlas::functionspace::CubedSphereNodeColumns fspace(mesh);
+    benchmark(fspace, "NodeColumns", fspace.size(), options, results);
+  }
+  if (options.functionSpace != "nodes") {
+    const auto mesh = atlas::MeshGenerator("cubedsphere").generate(grid);
+    const atlas::functionspace::CubedSphereCellColumns fspace(mesh);
+    benchmark(fspace, "CellColumns", fspace.size(), options, results);
+  }
+
+  if (!options.json.empty()) writeJSON(options.json, options, results);
+
+  atlas::Library::instance().finalise();
+  const bool allPassed = std::all_of(results.begin(), results.end(),
+    [](const Result & result) {return result.bitwise && result.verified;});
+  return allPassed ? 0 : 1;
+}
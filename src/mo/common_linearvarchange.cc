@@ -5,6 +5,8 @@
  * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
  */
 
+#include <type_traits>
+
 #include "atlas/array.h"
 #include "atlas/field.h"
 
@@ -12,6 +14,8 @@
 #include "mo/constants.h"
 #include "mo/functions.h"
 
+#include "vader/Instrumentation.h"
+
 using atlas::array::make_view;
 using atlas::idx_t;
 using atlas::util::Config;
@@ -20,49 +24,65 @@ namespace mo {
 
 /// \details Calculate the tangent linear of virtual potential temperature
 ///          from the specific humidity and the potential temperature.
+///          The increments and the trajectory can each be double or float.
 void evalVirtualPotentialTemperatureTL(atlas::FieldSet & incFlds,
                                        const atlas::FieldSet & augStateFlds) {
-  const auto qView = make_view<const double, 2>(augStateFlds["specific_humidity"]);
-  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
-  const auto qIncView = make_view<const double, 2>(incFlds["specific_humidity"]);
-  const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
-  auto vthetaIncView = make_view<double, 2>(incFlds["virtual_potential_temperature"]);
-
-  auto fspace = incFlds["virtual_potential_temperature"].functionspace();
-
-  auto evaluateVThetaTL = [&] (idx_t i, idx_t j) {
-    vthetaIncView(i, j) = thetaView(i, j) * constants::c_virtual * qIncView(i, j) +
-        thetaIncView(i, j) * (1.0 + constants::c_virtual * qView(i, j));
-  };
-
-  auto conf = Config("levels", incFlds["virtual_potential_temperature"].levels()) |
-              Config("include_halo", true);
-
-  functions::parallelFor(fspace, evaluateVThetaTL, conf);
+  const vader::ScopedTiming timing("evalVirtualPotentialTemperatureTL");
+  functions::dispatchValueType(incFlds["virtual_potential_temperature"], [&](const auto inc) {
+    typedef std::decay_t<decltype(inc)> T;
+    functions::dispatchValueType(augStateFlds["potential_temperature"], [&](const auto traj) {
+      typedef std::decay_t<decltype(traj)> U;
+      const auto qView = make_view<const U, 2>(augStateFlds["specific_humidity"]);
+      const auto thetaView = make_view<const U, 2>(augStateFlds["potential_temperature"]);
+      const auto qIncView = make_view<const T, 2>(incFlds["specific_humidity"]);
+      const auto thetaIncView = make_view<const T, 2>(incFlds["potential_temperature"]);
+      auto vthetaIncView = make_view<T, 2>(incFlds["virtual_potential_temperature"]);
+
+      auto fspace = incFlds["virtual_potential_temperature"].functionspace();
+
+      auto evaluateVThetaTL = [&] (idx_t i, idx_t j) {
+        vthetaIncView(i, j) = thetaView(i, j) * constants::c_virtual * qIncView(i, j) +
+            thetaIncView(i, j) * (1.0 + constants::c_virtual * qView(i, j));
+      };
+
+      auto conf = Config("levels", incFlds["virtual_potential_temperature"].levels()) |
+                  Config("include_halo", true);
+
+      functions::parallelFor(fspace, evaluateVThetaTL, conf);
+    });
+  });
 }
 
 /// \details Calculate the tangent linear of virtual potential temperature
 ///          from the specific humidity and the potential temperature.
+///          The adjoints and the trajectory can each be double or float.
 void evalVirtualPotentialTemperatureAD(atlas::FieldSet & hatFlds,
                                        const atlas::FieldSet & augStateFlds) {
-  const auto qView = make_view<const double, 2>(augStateFlds["specific_humidity"]);
-  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
-  auto qHatView = make_view<double, 2>(hatFlds["specific_humidity"]);
-  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
-  auto vthetaHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
-
-  auto fspace = hatFlds["virtual_potential_temperature"].functionspace();
-
-  auto evaluateVThetaAD = [&] (idx_t i, idx_t j) {
-    qHatView(i, j) += thetaView(i, j) * constants::c_virtual * vthetaHatView(i, j);
-    thetaHatView(i, j) +=  vthetaHatView(i, j) * (1.0 + constants::c_virtual * qView(i, j));
-    vthetaHatView(i, j) = 0;
-  };
-
-  auto conf = Config("levels", hatFlds["virtual_potential_temperature"].levels()) |
-              Config("include_halo", true);
-
-  functions::parallelFor(fspace, evaluateVThetaAD, conf);
+  const vader::ScopedTiming timing("evalVirtualPotentialTemperatureAD");
+  functions::dispatchValueType(hatFlds["virtual_potential_temperature"], [&](const auto hat) {
+    typedef std::decay_t<decltype(hat)> T;
+    functions::dispatchValueType(augStateFlds["potential_temperature"], [&](const auto traj) {
+      typedef std::decay_t<decltype(traj)> U;
+      const auto qView = make_view<const U, 2>(augStateFlds["specific_humidity"]);
+      const auto thetaView = make_view<const U, 2>(augStateFlds["potential_temperature"]);
+      auto qHatView = make_view<T, 2>(hatFlds["specific_humidity"]);
+      auto thetaHatView = make_view<T, 2>(hatFlds["potential_temperature"]);
+      auto vthetaHatView = make_view<T, 2>(hatFlds["virtual_potential_temperature"]);
+
+      auto fspace = hatFlds["virtual_potential_temperature"].functionspace();
+
+      auto evaluateVThetaAD = [&] (idx_t i, idx_t j) {
+        qHatView(i, j) += thetaView(i, j) * constants::c_virtual * vthetaHatView(i, j);
+        thetaHatView(i, j) +=  vthetaHatView(i, j) * (1.0 + constants::c_virtual * qView(i, j));
+        vthetaHatView(i, j) = 0;
+      };
+
+      auto conf = Config("levels", hatFlds["virtual_potential_temperature"].levels()) |
+                  Config("include_halo", true);
+
+      functions::parallelFor(fspace, evaluateVThetaAD, conf);
+    });
+  });
 }
 
 
@@ -10,6 +10,8 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "atlas/array/MakeView.h"
@@ -24,10 +26,12 @@
 #include "mo/common_varchange.h"
 #include "mo/constants.h"
 #include "mo/functions.h"
+#include "mo/svp_lookup.h"
 
 #include "oops/base/Variables.h"
 #include "oops/util/Logger.h"
 
+#include "vader/Instrumentation.h"
 #include "vader/vadervariables.h"
 
 using atlas::array::make_view;
@@ -37,45 +41,9 @@ namespace mo {
 
 bool evalSatVaporPressure(atlas::FieldSet & fields)
 {
+  const vader::ScopedTiming timing("evalSatVaporPressure");
   oops::Log::trace() << "[svp()] starting ..." << std::endl;
 
-  // normalised T lambda function
-  // which enforces upper and lower bounds on T
-  auto normalisedT = [](const double tVal) {
-    double t = (tVal - constants::TLoBound)/constants::Tinc;
-    double t1 = (t < 0.0 ? 0.0 : t);
-    double t2 = (t1 >= static_cast<double>(constants::svpLookUpLength - 1)) ?
-                       static_cast<double>(constants::svpLookUpLength - 1) : t1;
-    return t2;
-  };
-
-  // lambda function returning the index of a given temperature value;
-  // avoids returning last index in table
-  auto index = [](const double normalisedTVal) {
-    std::size_t i = static_cast<std::size_t>(normalisedTVal);
-    return (i == constants::svpLookUpLength - 1 ? constants::svpLookUpLength - 2 : i);
-  };
-
-  // weight lamba function
-  auto weight = [index](const double normalisedTVal) {
-    std::size_t i = index(normalisedTVal);
-    return ( normalisedTVal -  static_cast<double>(i) );
-  };
-
-  // lambda function to interpolate values from table to given temperature
-  auto interp = [](const double weight, const double v1, const double v2) {
-     return (weight * v2 + (1 - weight) * v1);
-  };
-
-  // lambda function to determine the gradient of variable in table
-  // with respect to temperature
-  auto normalisedDiff = [](const double v1, const double v2) {
-     return (v2 - v1)/ constants::Tinc;
-  };
-
-  double w;  // weight
-  std::size_t indx;  // index
-
   // The check for the presence of required input fields will be performed by the Vader
   // algorithm when this code is in a Vader Recipe. At that time this check can be removed.
   if ( !fields.has(vader::VV_TS) ||
@@ -88,34 +56,36 @@ bool evalSatVaporPressure(atlas::FieldSet & fields)
     // svp field not compatible with air temperature field, cannot continue.
     return false;
   }
-  const auto tView  = make_view<const double, 2>(fields["air_temperature"]);
-  const std::vector<std::string> vars{"svp", "dlsvp", "svpW", "dlsvpW"};
-  oops::Variables lookUpVars(vars);
-  auto lookUpData = functions::getLookUps(constants::commonVarChangeFilePath, lookUpVars,
-                               constants::svpLookUpLength);
-
-  const std::vector<std::string> fnames {"svp", "dlsvpdT"};
-  int ival = 0;  // set ival = 2 to get svp wrt water
-  for (auto & ef : fnames) {
-    if (fields.has(ef)) {
-      auto svpView = make_view<double, 2>(fields[ef]);
-
-      auto conf = atlas::util::Config("levels", fields[ef].levels()) |
-                  atlas::util::Config("include_halo", true);
-
-      // check this recipe to calculate svp is correct
-      const std::vector<double> Lookup = lookUpData[ival];
-      ++ival;
-      auto evaluateSVP = [&] (atlas::idx_t i, atlas::idx_t j) {
-      indx = index(normalisedT(tView(i, j)));
-      w = weight(normalisedT(tView(i, j)));
-      svpView(i, j) = interp(w, Lookup.at(indx), Lookup.at(indx+1)); };
-
-      auto fspace = fields[ef].functionspace();
-
-      functions::parallelFor(fspace, evaluateSVP, conf);
+  const svp::LookupTables & lookUps = svp::LookupTables::instance();
+
+  // output field and the table it is interpolated from
+  // (use svp::Table::svpW to get svp wrt water)
+  const std::vector<std::pair<std::string, svp::Table>> outputs{
+    {"svp", svp::Table::svp}, {"dlsvpdT", svp::Table::dlsvp}};
+
+  // The outputs have the value type (double or float) of air temperature; the tables
+  // are interpolated in double, as the pointwise kernels compute
+  functions::dispatchValueType(fields[vader::VV_TS], [&](const auto zero) {
+    typedef std::decay_t<decltype(zero)> T;
+    const auto tView  = make_view<const T, 2>(fields[vader::VV_TS]);
+    for (const auto & output : outputs) {
+      if (fields.has(output.first)) {
+        auto svpView = make_view<T, 2>(fields[output.first]);
+        const double * const table = lookUps.table(output.second);
+
+        auto conf = atlas::util::Config("levels", fields[output.first].levels()) |
+                    functions::columnsConfig(fields[output.first]) |
+                    functions::haloConfig();
+
+        auto evaluateSVP = [&] (atlas::idx_t i, atlas::idx_t j) {
+          svpView(i, j) = static_cast<T>(svp::lookup(table, tView(i, j))); };
+
+        auto fspace = fields[output.first].functionspace();
+
+        functions::parallelFor(fspace, evaluateSVP, conf);
+      }
     }
-  }
+  });
 
   oops::Log::trace() << "[svp()] ... exit" << std::endl;
 
@@ -124,37 +94,24 @@ bool evalSatVaporPressure(atlas::FieldSet & fields)
 
 bool evalSatSpecificHumidity(atlas::FieldSet & fields)
 {
+  const vader::ScopedTiming timing("evalSatSpecificHumidity");
   oops::Log::trace() << "[getQsat()] starting ..." << std::endl;
 
-  const auto pbarView = make_view<const double, 2>(fields["air_pressure"]);
-  const auto svpView = make_view<const double, 2>(fields["svp"]);
-  const auto tView = make_view<const double, 2>(fields["air_temperature"]);
-  auto qsatView = make_view<double, 2>(fields["qsat"]);
-
-  auto conf = atlas::util::Config("levels", fields["qsat"].levels()) |
-              atlas::util::Config("include_halo", true);
-
-  double fsubw;
-  auto evaluateQsat = [&] (atlas::idx_t i, atlas::idx_t j) {
-    // This formula for fsubw
-    // is taken from equation A4.7 of Adrian Gill's book: Atmosphere-Ocean
-    // Dynamics.  Note that his formula works in terms of pressure in MB and
-    // temperature in Celsius, so conversion of units leads to the slightly
-    // different equation used here.
-    fsubw = 1.0 + 1.0E-8 * pbarView(i, j) * (4.5 +
-            6.0e-4 * (tView(i, j) - constants::zerodegc) *
-                     (tView(i, j) - constants::zerodegc));
-
-    // Note that at very low pressures we apply a fix, to prevent a
-    // singularity (Qsat tends to 1.0 kg/kg).
-    qsatView(i, j) = fsubw * constants::rd_over_rv * svpView(i, j) /
-          (std::max(pbarView(i, j), svpView(i, j)) -
-          (1.0 - constants::rd_over_rv) * svpView(i, j));
-  };
-
-  auto fspace = fields["qsat"].functionspace();
-
-  functions::parallelFor(fspace, evaluateQsat, conf);
+  // This formula for fsubw
+  // is taken from equation A4.7 of Adrian Gill's book: Atmosphere-Ocean
+  // Dynamics.  Note that his formula works in terms of pressure in MB and
+  // temperature in Celsius, so conversion of units leads to the slightly
+  // different equation used here.
+  //
+  // Note that at very low pressures we apply a fix, to prevent a
+  // singularity (Qsat tends to 1.0 kg/kg).
+  functions::pointwise(fields["qsat"],
+    [](const double pbar, const double svp, const double t) {
+      const double fsubw = 1.0 + 1.0E-8 * pbar * (4.5 +
+                           6.0e-4 * (t - constants::zerodegc) * (t - constants::zerodegc));
+      return fsubw * constants::rd_over_rv * svp /
+             (std::max(pbar, svp) - (1.0 - constants::rd_over_rv) * svp);
+    }, fields["air_pressure"], fields["svp"], fields["air_temperature"]);
 
   oops::Log::trace() << "[getQsat()] ... exit" << std::endl;
 
@@ -163,6 +120,7 @@ bool evalSatSpecificHumidity(atlas::FieldSet & fields)
 
 bool evalAirPressureLevels(atlas::FieldSet & fields)
 {
+  const vader::ScopedTiming timing("evalAirPressureLevels");
   oops::Log::trace() << "[evalAirPressureLevels()] starting ..." << std::endl;
 
   const auto ds_elmo = make_view<const double, 2>(fields["exner_levels_minus_one"]);
@@ -171,10 +129,14 @@ bool evalAirPressureLevels(atlas::FieldSet & fields)
   const auto ds_hl = make_view<const double, 2>(fields["height_levels"]);
   auto ds_pl = make_view<double, 2>(fields["air_pressure_levels"]);
 
-  idx_t levels(fields["air_pressure_levels"].levels());
-  for (idx_t jn = 0; jn < fields["air_pressure_levels"].shape(0); ++jn) {
-    for (idx_t jl = 0; jl < levels - 1; ++jl) {
-      ds_pl(jn, jl) = ds_plmo(jn, jl);
+  const idx_t nColumns = functions::computedColumns(fields["air_pressure_levels"]);
+  const idx_t levels(fields["air_pressure_levels"].levels());
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels - 1; ++jl) {
+        ds_pl(jn, jl) = ds_plmo(jn, jl);
+      }
     }
 
     // Note that I am calculating the exner pressure above the top first and then
@@ -188,13 +150,14 @@ bool evalAirPressureLevels(atlas::FieldSet & fields)
     // pressure^k+1 = reference_pressure * (exner^k+1)**((1.0 / constants::rd_over_cp)
     //
     // where k is the model level index on half levels just below model top.
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      ds_pl(jn, levels-1) =  constants::p_zero * pow(
+        ds_elmo(jn, levels-2) - (constants::grav * (ds_hl(jn, levels-1) - ds_hl(jn, levels-2))) /
+        (constants::cp * ds_t(jn, levels-2)), (1.0 / constants::rd_over_cp));
 
-    ds_pl(jn, levels-1) =  constants::p_zero * pow(
-      ds_elmo(jn, levels-2) - (constants::grav * (ds_hl(jn, levels-1) - ds_hl(jn, levels-2))) /
-      (constants::cp * ds_t(jn, levels-2)), (1.0 / constants::rd_over_cp));
-
-    ds_pl(jn, levels-1) = ds_pl(jn, levels-1) > 0.0 ? ds_pl(jn, levels-1) : constants::deps;
-  }
+      ds_pl(jn, levels-1) = ds_pl(jn, levels-1) > 0.0 ? ds_pl(jn, levels-1) : constants::deps;
+    }
+  });
 
   oops::Log::trace() << "[evalAirPressureLevels()] ... exit" << std::endl;
 
@@ -18,6 +18,7 @@ namespace mo {
 /// \brief function to evaluate saturation water pressure (svp) [Pa]
 /// the Atlas field in the argument must contain an inizialised air temperature field
 /// and to have a defined svp field which is then calculated and returned as output
+/// (the fields are double or float: svp and dlsvpdT have the value type of air temperature)
 ///
 bool evalSatVaporPressure(atlas::FieldSet & fields);
 
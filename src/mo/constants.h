@@ -35,6 +35,9 @@ namespace constants {
   static constexpr std::double_t MinRhRef = 0.0;
   static constexpr std::double_t MaxRhRef = 150.0;
 
+  // default number of columns per tile in functions::forEachColumnBlock
+  static constexpr int columnBlockSize = 32;
+
   // tolerance for avoiding division by zero in getMIOFields
   static constexpr std::double_t tol = 1.0e-5;
 
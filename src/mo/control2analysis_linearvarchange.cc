@@ -11,14 +11,19 @@
 #include "mo/constants.h"
 #include "mo/control2analysis_linearvarchange.h"
 #include "mo/control2analysis_varchange.h"
+#include "mo/functions.h"
 
 #include "atlas/array/MakeView.h"
 
+#include "vader/Instrumentation.h"
+
 using atlas::array::make_view;
+using atlas::idx_t;
 
 namespace mo {
 
 void thetavP2HexnerTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("thetavP2HexnerTL");
   const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
   const auto thetavView = make_view<const double, 2>(
     augStateFlds["virtual_potential_temperature"]);
@@ -28,20 +33,27 @@ void thetavP2HexnerTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStat
   const auto pIncView = make_view<const double, 2>(incFlds["air_pressure_levels_minus_one"]);
   auto hexnerIncView = make_view<double, 2>(incFlds["hydrostatic_exner_levels"]);
 
-  for (atlas::idx_t jn = 0; jn < incFlds["hydrostatic_exner_levels"].shape(0); ++jn) {
-    hexnerIncView(jn, 0) = constants::rd_over_cp *
-      hexnerView(jn, 0) * pIncView(jn, 0) / pView(jn, 0);
+  const idx_t nColumns = incFlds["hydrostatic_exner_levels"].shape(0);
+  const idx_t levels = incFlds["hydrostatic_exner_levels"].levels();
 
-    for (atlas::idx_t jl = 1; jl < incFlds["hydrostatic_exner_levels"].levels(); ++jl) {
-      hexnerIncView(jn, jl) = hexnerIncView(jn, jl-1) +
-        ((constants::grav * thetavIncView(jn, jl-1) *
-          (hlView(jn, jl) - hlView(jn, jl-1))) /
-         (constants::cp * thetavView(jn, jl-1) * thetavView(jn, jl-1)));
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      hexnerIncView(jn, 0) = constants::rd_over_cp *
+        hexnerView(jn, 0) * pIncView(jn, 0) / pView(jn, 0);
+    }
+    for (idx_t jl = 1; jl < levels; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        hexnerIncView(jn, jl) = hexnerIncView(jn, jl-1) +
+          ((constants::grav * thetavIncView(jn, jl-1) *
+            (hlView(jn, jl) - hlView(jn, jl-1))) /
+           (constants::cp * thetavView(jn, jl-1) * thetavView(jn, jl-1)));
+      }
     }
-  }
+  });
 }
 
 void thetavP2HexnerAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("thetavP2HexnerAD");
   const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
   const auto thetavView = make_view<const double, 2>(
     augStateFlds["virtual_potential_temperature"]);
@@ -51,62 +63,80 @@ void thetavP2HexnerAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStat
   auto pHatView = make_view<double, 2>(hatFlds["air_pressure_levels_minus_one"]);
   auto hexnerHatView = make_view<double, 2>(hatFlds["hydrostatic_exner_levels"]);
 
-  for (atlas::idx_t jn = 0; jn < hatFlds["hydrostatic_exner_levels"].shape(0); ++jn) {
-    for (atlas::idx_t jl = hatFlds["hydrostatic_exner_levels"].levels() - 1; jl > 0; --jl) {
-      thetavHatView(jn, jl-1) = thetavHatView(jn, jl-1) +
-        ((constants::grav * hexnerHatView(jn, jl) *
-        (hlView(jn, jl) - hlView(jn, jl-1))) /
-        (constants::cp * thetavView(jn, jl-1) * thetavView(jn, jl-1)));
+  const idx_t nColumns = hatFlds["hydrostatic_exner_levels"].shape(0);
+  const idx_t levels = hatFlds["hydrostatic_exner_levels"].levels();
 
-      hexnerHatView(jn, jl-1) = hexnerHatView(jn, jl-1) +
-        hexnerHatView(jn, jl);
-      hexnerHatView(jn, jl) = 0.0;
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jl = levels - 1; jl > 0; --jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        thetavHatView(jn, jl-1) = thetavHatView(jn, jl-1) +
+          ((constants::grav * hexnerHatView(jn, jl) *
+          (hlView(jn, jl) - hlView(jn, jl-1))) /
+          (constants::cp * thetavView(jn, jl-1) * thetavView(jn, jl-1)));
+
+        hexnerHatView(jn, jl-1) = hexnerHatView(jn, jl-1) +
+          hexnerHatView(jn, jl);
+        hexnerHatView(jn, jl) = 0.0;
+      }
     }
-    pHatView(jn, 0) = pHatView(jn, 0) +
-      constants::rd_over_cp *
-      hexnerView(jn, 0) * hexnerHatView(jn, 0) / pView(jn, 0);
-    hexnerHatView(jn, 0) = 0.0;
-  }
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      pHatView(jn, 0) = pHatView(jn, 0) +
+        constants::rd_over_cp *
+        hexnerView(jn, 0) * hexnerHatView(jn, 0) / pView(jn, 0);
+      hexnerHatView(jn, 0) = 0.0;
+    }
+  });
 }
 
 void hexner2ThetavTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("hexner2ThetavTL");
   const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
   const auto thetavView = make_view<const double, 2>(augStateFlds["virtual_potential_temperature"]);
   const auto hexnerIncView = make_view<const double, 2>(incFlds["hydrostatic_exner_levels"]);
   auto thetavIncView = make_view<double, 2>(incFlds["virtual_potential_temperature"]);
 
-  atlas::idx_t levels = incFlds["virtual_potential_temperature"].levels();
-  for (atlas::idx_t jn = 0; jn < incFlds["virtual_potential_temperature"].shape(0); ++jn) {
-    for (atlas::idx_t jl = 0; jl < levels; ++jl) {
-      thetavIncView(jn, jl) =
-        (hexnerIncView(jn, jl+1) - hexnerIncView(jn, jl)) *
-        (constants::cp * thetavView(jn, jl) * thetavView(jn, jl)) /
-        (constants::grav * (hlView(jn, jl+1) - hlView(jn, jl)));
+  const idx_t nColumns = incFlds["virtual_potential_temperature"].shape(0);
+  const idx_t levels = incFlds["virtual_potential_temperature"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        thetavIncView(jn, jl) =
+          (hexnerIncView(jn, jl+1) - hexnerIncView(jn, jl)) *
+          (constants::cp * thetavView(jn, jl) * thetavView(jn, jl)) /
+          (constants::grav * (hlView(jn, jl+1) - hlView(jn, jl)));
+      }
     }
-  }
+  });
 }
 
 void hexner2ThetavAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("hexner2ThetavAD");
   const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
   const auto thetavView = make_view<const double, 2>(augStateFlds["virtual_potential_temperature"]);
   auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
   auto hexnerHatView = make_view<double, 2>(hatFlds["hydrostatic_exner_levels"]);
 
-  atlas::idx_t levelsm1 = hatFlds["virtual_potential_temperature"].levels()-1;
-  for (atlas::idx_t jn = 0; jn < hatFlds["virtual_potential_temperature"].shape(0); ++jn) {
-    for (atlas::idx_t jl = levelsm1; jl > -1; --jl) {
-      hexnerHatView(jn, jl+1) += thetavHatView(jn, jl) *
-        (constants::cp * thetavView(jn, jl) * thetavView(jn, jl)) /
-        (constants::grav * (hlView(jn, jl+1) - hlView(jn, jl)) );
-      hexnerHatView(jn, jl) -= thetavHatView(jn, jl) *
-        (constants::cp * thetavView(jn, jl) * thetavView(jn, jl)) /
-        (constants::grav * (hlView(jn, jl+1) - hlView(jn, jl)));
-      thetavHatView(jn, jl) = 0.0;
+  const idx_t nColumns = hatFlds["virtual_potential_temperature"].shape(0);
+  const idx_t levelsm1 = hatFlds["virtual_potential_temperature"].levels()-1;
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jl = levelsm1; jl > -1; --jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        hexnerHatView(jn, jl+1) += thetavHatView(jn, jl) *
+          (constants::cp * thetavView(jn, jl) * thetavView(jn, jl)) /
+          (constants::grav * (hlView(jn, jl+1) - hlView(jn, jl)) );
+        hexnerHatView(jn, jl) -= thetavHatView(jn, jl) *
+          (constants::cp * thetavView(jn, jl) * thetavView(jn, jl)) /
+          (constants::grav * (hlView(jn, jl+1) - hlView(jn, jl)));
+        thetavHatView(jn, jl) = 0.0;
+      }
     }
-  }
+  });
 }
 
 void evalDryAirDensityTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("evalDryAirDensityTL");
   const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
   const auto hView = make_view<const double, 2>(augStateFlds["height"]);
   const auto exnerView = make_view<const double, 2>(augStateFlds["exner_levels_minus_one"]);
@@ -116,23 +146,31 @@ void evalDryAirDensityTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augS
   const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
   auto rhoIncView = make_view<double, 2>(incFlds["dry_air_density_levels_minus_one"]);
 
-  for (atlas::idx_t jn = 0; jn < rhoIncView.shape(0); ++jn) {
-    for (atlas::idx_t jl = 1; jl < incFlds["dry_air_density_levels_minus_one"].levels(); ++jl) {
-      rhoIncView(jn, jl) = rhoView(jn, jl) * (
-        exnerIncView(jn, jl) / exnerView(jn, jl) -
-        (((hlView(jn, jl) - hView(jn, jl-1)) * thetaIncView(jn, jl) +
-          (hView(jn, jl) - hlView(jn, jl)) * thetaIncView(jn, jl-1)) /
-         ((hlView(jn, jl) - hView(jn, jl-1)) * thetaView(jn, jl) +
-          (hView(jn, jl) - hlView(jn, jl)) * thetaView(jn, jl-1))));
+  const idx_t nColumns = rhoIncView.shape(0);
+  const idx_t levels = incFlds["dry_air_density_levels_minus_one"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 1; jl < levels; ++jl) {
+        rhoIncView(jn, jl) = rhoView(jn, jl) * (
+          exnerIncView(jn, jl) / exnerView(jn, jl) -
+          (((hlView(jn, jl) - hView(jn, jl-1)) * thetaIncView(jn, jl) +
+            (hView(jn, jl) - hlView(jn, jl)) * thetaIncView(jn, jl-1)) /
+           ((hlView(jn, jl) - hView(jn, jl-1)) * thetaView(jn, jl) +
+            (hView(jn, jl) - hlView(jn, jl)) * thetaView(jn, jl-1))));
+      }
     }
 
-    rhoIncView(jn, 0) = rhoView(jn, 0) * (
-        exnerIncView(jn, 0) / exnerView(jn, 0) -
-        thetaIncView(jn, 0)/ thetaView(jn, 0));
-  }
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      rhoIncView(jn, 0) = rhoView(jn, 0) * (
+          exnerIncView(jn, 0) / exnerView(jn, 0) -
+          thetaIncView(jn, 0)/ thetaView(jn, 0));
+    }
+  });
 }
 
 void evalDryAirDensityAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("evalDryAirDensityAD");
   const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
   const auto hView = make_view<const double, 2>(augStateFlds["height"]);
   const auto exnerView = make_view<const double, 2>(augStateFlds["exner_levels_minus_one"]);
@@ -142,31 +180,39 @@ void evalDryAirDensityAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augS
   auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
   auto rhoHatView = make_view<double, 2>(hatFlds["dry_air_density_levels_minus_one"]);
 
-  for (atlas::idx_t jn = 0; jn < rhoHatView.shape(0); ++jn) {
-    exnerHatView(jn, 0) += rhoView(jn, 0) * rhoHatView(jn, 0) /
-      exnerView(jn, 0);
-    thetaHatView(jn, 0) -= rhoView(jn, 0) * rhoHatView(jn, 0) /
-      thetaView(jn, 0);
-    rhoHatView(jn, 0) = 0.0;
-
-    for (atlas::idx_t jl = hatFlds["dry_air_density_levels_minus_one"].levels()-1; jl >= 1; --jl) {
-      exnerHatView(jn, jl) += rhoView(jn, jl) * rhoHatView(jn, jl) /
-        exnerView(jn, jl);
-      thetaHatView(jn, jl) -= rhoView(jn, jl) * rhoHatView(jn, jl) *
-        (hlView(jn, jl) - hView(jn, jl-1)) /
-        ((hlView(jn, jl) - hView(jn, jl-1)) * thetaView(jn, jl) +
-        (hView(jn, jl) - hlView(jn, jl)) * thetaView(jn, jl-1) );
-      thetaHatView(jn, jl-1) -= rhoView(jn, jl) * rhoHatView(jn, jl) *
-        (hView(jn, jl) - hlView(jn, jl)) /
-        ((hlView(jn, jl) - hView(jn, jl-1)) * thetaView(jn, jl) +
-        (hView(jn, jl) - hlView(jn, jl)) * thetaView(jn, jl-1));
-      rhoHatView(jn, jl) = 0.0;
+  const idx_t nColumns = rhoHatView.shape(0);
+  const idx_t levels = hatFlds["dry_air_density_levels_minus_one"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      exnerHatView(jn, 0) += rhoView(jn, 0) * rhoHatView(jn, 0) /
+        exnerView(jn, 0);
+      thetaHatView(jn, 0) -= rhoView(jn, 0) * rhoHatView(jn, 0) /
+        thetaView(jn, 0);
+      rhoHatView(jn, 0) = 0.0;
     }
-  }
+
+    for (idx_t jl = levels-1; jl >= 1; --jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        exnerHatView(jn, jl) += rhoView(jn, jl) * rhoHatView(jn, jl) /
+          exnerView(jn, jl);
+        thetaHatView(jn, jl) -= rhoView(jn, jl) * rhoHatView(jn, jl) *
+          (hlView(jn, jl) - hView(jn, jl-1)) /
+          ((hlView(jn, jl) - hView(jn, jl-1)) * thetaView(jn, jl) +
+          (hView(jn, jl) - hlView(jn, jl)) * thetaView(jn, jl-1) );
+        thetaHatView(jn, jl-1) -= rhoView(jn, jl) * rhoHatView(jn, jl) *
+          (hView(jn, jl) - hlView(jn, jl)) /
+          ((hlView(jn, jl) - hView(jn, jl-1)) * thetaView(jn, jl) +
+          (hView(jn, jl) - hlView(jn, jl)) * thetaView(jn, jl-1));
+        rhoHatView(jn, jl) = 0.0;
+      }
+    }
+  });
 }
 
 
-/// \details This calculates air temperature increments.
+namespace detail {
+template<idx_t L>
 void evalAirTemperatureTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
   const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
   const auto hView = make_view<const double, 2>(augStateFlds["height"]);
@@ -176,47 +222,59 @@ void evalAirTemperatureTL(atlas::FieldSet & incFlds, const atlas::FieldSet & aug
   const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
   auto tIncView = make_view<double, 2>(incFlds["air_temperature"]);
 
-  atlas::idx_t lvls(incFlds["air_temperature"].levels());
-  atlas::idx_t lvlsm1 = lvls - 1;
-  double exnerTopVal;
-  double exnerTopIncVal;
-
-  // Active code
-  for (atlas::idx_t jn = 0; jn < tIncView.shape(0); ++jn) {
-    // Passive code: Value above model top is assumed to be in hydrostatic balance.
-    exnerTopVal = exnerLevelsView(jn, lvlsm1) -
-      (constants::grav * (hlView(jn, lvls) - hlView(jn, lvlsm1))) /
-      (constants::cp * thetaView(jn, lvlsm1));
+  const idx_t nColumns = tIncView.shape(0);
+  const idx_t lvls = functions::levelCount<L>(incFlds["air_temperature"].levels());
+  const idx_t lvlsm1 = lvls - 1;
 
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
     // Active code;
-    for (atlas::idx_t jl= 0; jl < lvls - 1; ++jl) {
-       tIncView(jn, jl) = (
-         ( (hView(jn, jl) - hlView(jn, jl)) * exnerLevelsView(jn, jl + 1) +
-           (hlView(jn, jl+1)  - hView(jn, jl)) * exnerLevelsView(jn, jl) ) *
-           thetaIncView(jn, jl) +
-         ( (hView(jn, jl) - hlView(jn, jl)) * exnerLevelsIncView(jn, jl + 1) +
-           (hlView(jn, jl+1)  - hView(jn, jl)) * exnerLevelsIncView(jn, jl) ) *
-         thetaView(jn, jl) ) /
-         (hlView(jn, jl+1) - hlView(jn, jl));
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl= 0; jl < lvls - 1; ++jl) {
+        tIncView(jn, jl) = (
+          ( (hView(jn, jl) - hlView(jn, jl)) * exnerLevelsView(jn, jl + 1) +
+            (hlView(jn, jl+1)  - hView(jn, jl)) * exnerLevelsView(jn, jl) ) *
+            thetaIncView(jn, jl) +
+          ( (hView(jn, jl) - hlView(jn, jl)) * exnerLevelsIncView(jn, jl + 1) +
+            (hlView(jn, jl+1)  - hView(jn, jl)) * exnerLevelsIncView(jn, jl) ) *
+          thetaView(jn, jl) ) /
+          (hlView(jn, jl+1) - hlView(jn, jl));
+      }
     }
 
-    exnerTopIncVal = exnerLevelsIncView(jn, lvlsm1) +
-      thetaIncView(jn, lvlsm1) * (exnerLevelsView(jn, lvlsm1) - exnerTopVal) /
-      thetaView(jn, lvlsm1);
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      // Passive code: Value above model top is assumed to be in hydrostatic balance.
+      const double exnerTopVal = exnerLevelsView(jn, lvlsm1) -
+        (constants::grav * (hlView(jn, lvls) - hlView(jn, lvlsm1))) /
+        (constants::cp * thetaView(jn, lvlsm1));
 
-    tIncView(jn, lvlsm1) = (
-      ( (hView(jn, lvlsm1) - hlView(jn, lvlsm1)) * exnerTopVal +
-        (hlView(jn, lvls)  - hView(jn, lvlsm1)) * exnerLevelsView(jn, lvlsm1) ) *
-         thetaIncView(jn, lvlsm1) +
-      ( (hView(jn, lvlsm1) - hlView(jn, lvlsm1)) * exnerTopIncVal +
-        (hlView(jn, lvls)  - hView(jn, lvlsm1)) * exnerLevelsIncView(jn, lvlsm1) ) *
-         thetaView(jn, lvlsm1)) /
-      (hlView(jn, lvls) - hlView(jn, lvlsm1));
-  }
-}
+      // Active code
+      const double exnerTopIncVal = exnerLevelsIncView(jn, lvlsm1) +
+        thetaIncView(jn, lvlsm1) * (exnerLevelsView(jn, lvlsm1) - exnerTopVal) /
+        thetaView(jn, lvlsm1);
 
+      tIncView(jn, lvlsm1) = (
+        ( (hView(jn, lvlsm1) - hlView(jn, lvlsm1)) * exnerTopVal +
+          (hlView(jn, lvls)  - hView(jn, lvlsm1)) * exnerLevelsView(jn, lvlsm1) ) *
+           thetaIncView(jn, lvlsm1) +
+        ( (hView(jn, lvlsm1) - hlView(jn, lvlsm1)) * exnerTopIncVal +
+          (hlView(jn, lvls)  - hView(jn, lvlsm1)) * exnerLevelsIncView(jn, lvlsm1) ) *
+           thetaView(jn, lvlsm1)) /
+        (hlView(jn, lvls) - hlView(jn, lvlsm1));
+    }
+  });
+}
+}  // namespace detail
 
 /// \details This calculates air temperature increments.
+void evalAirTemperatureTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("evalAirTemperatureTL");
+  functions::dispatchLevels(incFlds["air_temperature"].levels(), [&](const auto levels) {
+    detail::evalAirTemperatureTL<decltype(levels)::value>(incFlds, augStateFlds); });
+}
+
+
+namespace detail {
+template<idx_t L>
 void evalAirTemperatureAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
   const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
   const auto hView = make_view<const double, 2>(augStateFlds["height"]);
@@ -226,66 +284,93 @@ void evalAirTemperatureAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & aug
   auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
   auto tHatView = make_view<double, 2>(hatFlds["air_temperature"]);
 
-  atlas::idx_t lvls(hatFlds["air_temperature"].levels());
-  atlas::idx_t lvlsm1 = lvls - 1;
-  double exnerTopVal(0);
-  double exnerTopHatVal(0);
-
-  for (atlas::idx_t jn = 0; jn < tHatView.shape(0); ++jn) {
-    // Passive code: Value above model top is assumed to be in hydrostatic balance.
-    exnerTopVal = exnerLevelsView(jn, lvlsm1) -
-      (constants::grav * (hlView(jn, lvls) - hlView(jn, lvlsm1))) /
-      (constants::cp * thetaView(jn, lvlsm1));
-
-    // Active code
-    thetaHatView(jn, lvlsm1) += ( (hView(jn, lvlsm1) - hlView(jn, lvlsm1)) * exnerTopVal +
-      (hlView(jn, lvls)  - hView(jn, lvlsm1)) * exnerLevelsView(jn, lvlsm1) ) *
-      tHatView(jn, lvlsm1) /
-      (hlView(jn, lvls) - hlView(jn, lvlsm1));
+  const idx_t nColumns = tHatView.shape(0);
+  const idx_t lvls = functions::levelCount<L>(hatFlds["air_temperature"].levels());
+  const idx_t lvlsm1 = lvls - 1;
 
-    exnerTopHatVal = (hView(jn, lvlsm1) - hlView(jn, lvlsm1)) *
-      tHatView(jn, lvlsm1) * thetaView(jn, lvlsm1) /
-      (hlView(jn, lvls) - hlView(jn, lvlsm1));
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      // Passive code: Value above model top is assumed to be in hydrostatic balance.
+      const double exnerTopVal = exnerLevelsView(jn, lvlsm1) -
+        (constants::grav * (hlView(jn, lvls) - hlView(jn, lvlsm1))) /
+        (constants::cp * thetaView(jn, lvlsm1));
 
-    exnerLevelsHatView(jn, lvlsm1) += (hlView(jn, lvls)  - hView(jn, lvlsm1)) *
-      tHatView(jn, lvlsm1) * thetaView(jn, lvlsm1) /
-      (hlView(jn, lvls) - hlView(jn, lvlsm1));
+      // Active code
+      thetaHatView(jn, lvlsm1) += ( (hView(jn, lvlsm1) - hlView(jn, lvlsm1)) * exnerTopVal +
+        (hlView(jn, lvls)  - hView(jn, lvlsm1)) * exnerLevelsView(jn, lvlsm1) ) *
+        tHatView(jn, lvlsm1) /
+        (hlView(jn, lvls) - hlView(jn, lvlsm1));
 
-    tHatView(jn, lvlsm1) = 0.0;
+      const double exnerTopHatVal = (hView(jn, lvlsm1) - hlView(jn, lvlsm1)) *
+        tHatView(jn, lvlsm1) * thetaView(jn, lvlsm1) /
+        (hlView(jn, lvls) - hlView(jn, lvlsm1));
 
-    exnerLevelsHatView(jn, lvlsm1) += exnerTopHatVal;
-    thetaHatView(jn, lvlsm1) += exnerTopHatVal * (exnerLevelsView(jn, lvlsm1) - exnerTopVal) /
-        thetaView(jn, lvlsm1);
-    exnerTopHatVal = 0.0;
+      exnerLevelsHatView(jn, lvlsm1) += (hlView(jn, lvls)  - hView(jn, lvlsm1)) *
+        tHatView(jn, lvlsm1) * thetaView(jn, lvlsm1) /
+        (hlView(jn, lvls) - hlView(jn, lvlsm1));
 
+      tHatView(jn, lvlsm1) = 0.0;
 
+      exnerLevelsHatView(jn, lvlsm1) += exnerTopHatVal;
+      thetaHatView(jn, lvlsm1) += exnerTopHatVal * (exnerLevelsView(jn, lvlsm1) - exnerTopVal) /
+          thetaView(jn, lvlsm1);
+    }
 
-    for (atlas::idx_t jl = lvls - 2; jl >= 0; --jl) {
-      thetaHatView(jn, jl) += (
-        (hView(jn, jl) - hlView(jn, jl)) * exnerLevelsView(jn, jl + 1) +
-        (hlView(jn, jl + 1) - hView(jn, jl)) * exnerLevelsView(jn, jl) ) *
-        tHatView(jn, jl) /
-        (hlView(jn, jl + 1) - hlView(jn, jl));
+    for (idx_t jl = lvls - 2; jl >= 0; --jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        thetaHatView(jn, jl) += (
+          (hView(jn, jl) - hlView(jn, jl)) * exnerLevelsView(jn, jl + 1) +
+          (hlView(jn, jl + 1) - hView(jn, jl)) * exnerLevelsView(jn, jl) ) *
+          tHatView(jn, jl) /
+          (hlView(jn, jl + 1) - hlView(jn, jl));
 
-      exnerLevelsHatView(jn, jl + 1) += (hView(jn, jl) - hlView(jn, jl)) *
-        tHatView(jn, jl) * thetaView(jn, jl) /
-        (hlView(jn, jl + 1) - hlView(jn, jl));
+        exnerLevelsHatView(jn, jl + 1) += (hView(jn, jl) - hlView(jn, jl)) *
+          tHatView(jn, jl) * thetaView(jn, jl) /
+          (hlView(jn, jl + 1) - hlView(jn, jl));
 
-      exnerLevelsHatView(jn, jl) += (hlView(jn, jl + 1)  - hView(jn, jl)) *
-        tHatView(jn, jl) * thetaView(jn, jl) /
-        (hlView(jn, jl + 1) - hlView(jn, jl));
+        exnerLevelsHatView(jn, jl) += (hlView(jn, jl + 1)  - hView(jn, jl)) *
+          tHatView(jn, jl) * thetaView(jn, jl) /
+          (hlView(jn, jl + 1) - hlView(jn, jl));
 
-      tHatView(jn, jl) = 0.0;
+        tHatView(jn, jl) = 0.0;
+      }
     }
-  }
+  });
+}
+}  // namespace detail
+
+/// \details This calculates air temperature increments.
+void evalAirTemperatureAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("evalAirTemperatureAD");
+  functions::dispatchLevels(hatFlds["air_temperature"].levels(), [&](const auto levels) {
+    detail::evalAirTemperatureAD<decltype(levels)::value>(hatFlds, augStateFlds); });
 }
 
 
 void qqclqcf2qtTL(atlas::FieldSet & incFields, const atlas::FieldSet &) {
-  qqclqcf2qt(incFields);
+  const vader::ScopedTiming timing("qqclqcf2qtTL");
+  const auto qIncView = make_view<const double, 2>(incFields["specific_humidity"]);
+  const auto qclIncView = make_view<const double, 2>
+                    (incFields["mass_content_of_cloud_liquid_water_in_atmosphere_layer"]);
+  const auto qcfIncView = make_view<const double, 2>
+                    (incFields["mass_content_of_cloud_ice_in_atmosphere_layer"]);
+  auto qtIncView = make_view<double, 2>(incFields["qt"]);
+
+  // All the columns, halo included, like qqclqcf2qtAD (not computedColumns, as qqclqcf2qt)
+  const idx_t nColumns = incFields["qt"].shape(0);
+  const idx_t levels = incFields["qt"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        qtIncView(jn, jl) = qIncView(jn, jl) + qclIncView(jn, jl) + qcfIncView(jn, jl);
+      }
+    }
+  });
 }
 
 void qqclqcf2qtAD(atlas::FieldSet & hatFields, const atlas::FieldSet &) {
+  const vader::ScopedTiming timing("qqclqcf2qtAD");
   auto qHatView = make_view<double, 2>(hatFields["specific_humidity"]);
   auto qclHatView = make_view<double, 2>
                     (hatFields["mass_content_of_cloud_liquid_water_in_atmosphere_layer"]);
@@ -293,18 +378,24 @@ void qqclqcf2qtAD(atlas::FieldSet & hatFields, const atlas::FieldSet &) {
                     (hatFields["mass_content_of_cloud_ice_in_atmosphere_layer"]);
   auto qtHatView = make_view<double, 2>(hatFields["qt"]);
 
-  for (atlas::idx_t jn = 0; jn < hatFields["qt"].shape(0); ++jn) {
-    for (atlas::idx_t jl = 0; jl < hatFields["qt"].levels(); ++jl) {
-      qHatView(jn, jl) += qtHatView(jn, jl);
-      qclHatView(jn, jl) += qtHatView(jn, jl);
-      qcfHatView(jn, jl) += qtHatView(jn, jl);
-      qtHatView(jn, jl) = 0.0;
+  const idx_t nColumns = hatFields["qt"].shape(0);
+  const idx_t levels = hatFields["qt"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        qHatView(jn, jl) += qtHatView(jn, jl);
+        qclHatView(jn, jl) += qtHatView(jn, jl);
+        qcfHatView(jn, jl) += qtHatView(jn, jl);
+        qtHatView(jn, jl) = 0.0;
+      }
     }
-  }
+  });
 }
 
 void qtTemperature2qqclqcfTL(atlas::FieldSet & incFlds,
                              const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("qtTemperature2qqclqcfTL");
   const auto qsatView = make_view<const double, 2>(augStateFlds["qsat"]);
   const auto dlsvpdTView = make_view<const double, 2>(augStateFlds["dlsvpdT"]);
   const auto cleffView = make_view<const double, 2>(augStateFlds["cleff"]);
@@ -318,21 +409,25 @@ void qtTemperature2qqclqcfTL(atlas::FieldSet & incFlds,
                     (incFlds["mass_content_of_cloud_ice_in_atmosphere_layer"]);
   auto qIncView = make_view<double, 2>(incFlds["specific_humidity"]);
 
+  const idx_t nColumns = incFlds["qt"].shape(0);
+  const idx_t levels = incFlds["qt"].levels();
 
-  double maxCldInc;
-  for (atlas::idx_t jn = 0; jn < incFlds["qt"].shape(0); ++jn) {
-    for (atlas::idx_t jl = 0; jl < incFlds["qt"].levels(); ++jl) {
-        maxCldInc = qtIncView(jn, jl) - qsatView(jn, jl) *
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        const double maxCldInc = qtIncView(jn, jl) - qsatView(jn, jl) *
             dlsvpdTView(jn, jl) * temperIncView(jn, jl);
         qclIncView(jn, jl) = cleffView(jn, jl) * maxCldInc;
         qcfIncView(jn, jl) = cfeffView(jn, jl) * maxCldInc;
         qIncView(jn, jl) = qtIncView(jn, jl) - qclIncView(jn, jl) - qcfIncView(jn, jl);
+      }
     }
-  }
+  });
 }
 
 void qtTemperature2qqclqcfAD(atlas::FieldSet & hatFlds,
                              const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("qtTemperature2qqclqcfAD");
   const auto qsatView = make_view<const double, 2>(augStateFlds["qsat"]);
   const auto dlsvpdTView = make_view<const double, 2>(augStateFlds["dlsvpdT"]);
   const auto cleffView = make_view<const double, 2>(augStateFlds["cleff"]);
@@ -346,27 +441,32 @@ void qtTemperature2qqclqcfAD(atlas::FieldSet & hatFlds,
   auto qcfHatView = make_view<double, 2>
                     (hatFlds["mass_content_of_cloud_ice_in_atmosphere_layer"]);
 
-  double qsatdlsvpdT;
-  for (atlas::idx_t jn = 0; jn < hatFlds["qt"].shape(0); ++jn) {
-    for (atlas::idx_t jl = 0; jl < hatFlds["qt"].levels(); ++jl) {
-      qsatdlsvpdT = qsatView(jn, jl) * dlsvpdTView(jn, jl);
-      temperHatView(jn, jl) += ((cleffView(jn, jl) + cfeffView(jn, jl)) * qHatView(jn, jl)
-                                - cleffView(jn, jl) * qclHatView(jn, jl)
-                                - cfeffView(jn, jl) * qcfHatView(jn, jl)) * qsatdlsvpdT;
-      qtHatView(jn, jl) += cleffView(jn, jl) * qclHatView(jn, jl)
-              + cfeffView(jn, jl) * qcfHatView(jn, jl)
-              + (1.0 - cleffView(jn, jl) - cfeffView(jn, jl))
-              * qHatView(jn, jl);
-      qHatView(jn, jl) = 0.0;
-      qclHatView(jn, jl) = 0.0;
-      qcfHatView(jn, jl) = 0.0;
+  const idx_t nColumns = hatFlds["qt"].shape(0);
+  const idx_t levels = hatFlds["qt"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        const double qsatdlsvpdT = qsatView(jn, jl) * dlsvpdTView(jn, jl);
+        temperHatView(jn, jl) += ((cleffView(jn, jl) + cfeffView(jn, jl)) * qHatView(jn, jl)
+                                  - cleffView(jn, jl) * qclHatView(jn, jl)
+                                  - cfeffView(jn, jl) * qcfHatView(jn, jl)) * qsatdlsvpdT;
+        qtHatView(jn, jl) += cleffView(jn, jl) * qclHatView(jn, jl)
+                + cfeffView(jn, jl) * qcfHatView(jn, jl)
+                + (1.0 - cleffView(jn, jl) - cfeffView(jn, jl))
+                * qHatView(jn, jl);
+        qHatView(jn, jl) = 0.0;
+        qclHatView(jn, jl) = 0.0;
+        qcfHatView(jn, jl) = 0.0;
+      }
     }
-  }
+  });
 }
 
 
 void evalHydrostaticPressureTL(atlas::FieldSet & incFlds,
                                const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("evalHydrostaticPressureTL");
   const auto gPIncView = make_view<const double, 2>(
     incFlds["geostrophic_pressure_levels_minus_one"]);
   const auto uPIncView = make_view<const double, 2>(
@@ -388,32 +488,38 @@ void evalHydrostaticPressureTL(atlas::FieldSet & incFlds,
 
   auto hPIncView = make_view<double, 2>(incFlds["hydrostatic_pressure_levels"]);
 
-  atlas::idx_t levels = incFlds["geostrophic_pressure_levels_minus_one"].levels();
-  atlas::idx_t nBins = augStateFlds["interpolation_weights"].shape(1);
-
-  for (atlas::idx_t jn = 0; jn < incFlds["hydrostatic_pressure_levels"].shape(0); ++jn) {
-    for (atlas::idx_t b = 0; b < nBins; ++b) {
-      if (interpWeightView(jn , b) > __FLT_EPSILON__) {
-        for (atlas::idx_t jl = 0; jl < levels; ++jl) {
-          hPIncView(jn, jl) = uPIncView(jn, jl);
-          for (atlas::idx_t jl2 = 0; jl2 < levels; ++jl2) {
-            hPIncView(jn, jl) +=
-                                 interpWeightView(jn, b) *
-                                 vertRegView(b * levels + jl, jl2) *
-                                 gPIncView(jn, jl2);
+  const idx_t nColumns = incFlds["hydrostatic_pressure_levels"].shape(0);
+  const idx_t levels = incFlds["geostrophic_pressure_levels_minus_one"].levels();
+  const idx_t nBins = augStateFlds["interpolation_weights"].shape(1);
+
+  // The vertical regression couples all the levels of a column, so the columns
+  // of a tile are processed one after the other.
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t b = 0; b < nBins; ++b) {
+        if (interpWeightView(jn , b) > __FLT_EPSILON__) {
+          for (idx_t jl = 0; jl < levels; ++jl) {
+            hPIncView(jn, jl) = uPIncView(jn, jl);
+            for (idx_t jl2 = 0; jl2 < levels; ++jl2) {
+              hPIncView(jn, jl) +=
+                                   interpWeightView(jn, b) *
+                                   vertRegView(b * levels + jl, jl2) *
+                                   gPIncView(jn, jl2);
+            }
           }
         }
       }
+      hPIncView(jn, levels) =
+        hPIncView(jn, levels-1) *
+        std::pow(pView(jn, levels-1) / pView(jn, levels), constants::rd_over_cp - 1.0);
     }
-    hPIncView(jn, levels) =
-      hPIncView(jn, levels-1) *
-      std::pow(pView(jn, levels-1) / pView(jn, levels), constants::rd_over_cp - 1.0);
-  }
+  });
 }
 
 
 void evalHydrostaticPressureAD(atlas::FieldSet & hatFlds,
                                const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("evalHydrostaticPressureAD");
   auto gpHatView = make_view<double, 2>(hatFlds["geostrophic_pressure_levels_minus_one"]);
   auto uPHatView = make_view<double, 2>(hatFlds["unbalanced_pressure_levels_minus_one"]);
 
@@ -433,67 +539,82 @@ void evalHydrostaticPressureAD(atlas::FieldSet & hatFlds,
 
   auto hPHatView = make_view<double, 2>(hatFlds["hydrostatic_pressure_levels"]);
 
-  atlas::idx_t levels = hatFlds["geostrophic_pressure_levels_minus_one"].levels();
-  atlas::idx_t nBins = augStateFlds["vertical_regression_matrices"].shape(0) / levels;
-
-  for (atlas::idx_t jn = 0; jn < hatFlds["hydrostatic_pressure_levels"].shape(0); ++jn) {
-    hPHatView(jn, levels - 1) +=
-     hPHatView(jn, levels) *
-     std::pow(pView(jn, levels-1) / pView(jn, levels), constants::rd_over_cp - 1.0);
-    hPHatView(jn, levels) = 0.0;
-
-    for (atlas::idx_t b = nBins -1; b >= 0; --b) {
-      if (interpWeightView(jn , b) > __FLT_EPSILON__) {
-        for (atlas::idx_t jl = levels - 1; jl >= 0; --jl) {
-          for (atlas::idx_t jl2 = levels - 1; jl2 >= 0; --jl2) {
-            gpHatView(jn, jl2) +=
-                                  interpWeightView(jn, b) *
-                                  vertRegView(b * levels + jl, jl2) *
-                                  hPHatView(jn, jl);
+  const idx_t nColumns = hatFlds["hydrostatic_pressure_levels"].shape(0);
+  const idx_t levels = hatFlds["geostrophic_pressure_levels_minus_one"].levels();
+  const idx_t nBins = augStateFlds["vertical_regression_matrices"].shape(0) / levels;
+
+  // The vertical regression couples all the levels of a column, so the columns
+  // of a tile are processed one after the other.
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      hPHatView(jn, levels - 1) +=
+       hPHatView(jn, levels) *
+       std::pow(pView(jn, levels-1) / pView(jn, levels), constants::rd_over_cp - 1.0);
+      hPHatView(jn, levels) = 0.0;
+
+      for (idx_t b = nBins -1; b >= 0; --b) {
+        if (interpWeightView(jn , b) > __FLT_EPSILON__) {
+          for (idx_t jl = levels - 1; jl >= 0; --jl) {
+            for (idx_t jl2 = levels - 1; jl2 >= 0; --jl2) {
+              gpHatView(jn, jl2) +=
+                                    interpWeightView(jn, b) *
+                                    vertRegView(b * levels + jl, jl2) *
+                                    hPHatView(jn, jl);
+            }
+            uPHatView(jn, jl) += hPHatView(jn, jl);
+            hPHatView(jn, jl) = 0.0;
           }
-          uPHatView(jn, jl) += hPHatView(jn, jl);
-          hPHatView(jn, jl) = 0.0;
         }
       }
     }
-  }
+  });
 }
 
 /// \details This calculates the hydrostatic exner field from the hydrostatic pressure
 void evalHydrostaticExnerTL(atlas::FieldSet & incFlds,
                             const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("evalHydrostaticExnerTL");
   const auto pView = make_view<const double, 2>(augStateFlds["hydrostatic_pressure_levels"]);
   const auto exnerView = make_view<const double, 2>(augStateFlds["hydrostatic_exner_levels"]);
   const auto pIncView = make_view<const double, 2>(incFlds["hydrostatic_pressure_levels"]);
   auto exnerIncView = make_view<double, 2>(incFlds["hydrostatic_exner_levels"]);
 
-  atlas::idx_t levels = incFlds["hydrostatic_exner_levels"].levels();
-  for (atlas::idx_t jn = 0; jn < incFlds["hydrostatic_exner_levels"].shape(0); ++jn) {
-    for (atlas::idx_t jl = 0; jl < levels; ++jl) {
-      exnerIncView(jn, jl) = pIncView(jn, jl) *
-        (constants::rd_over_cp * exnerView(jn, jl)) /
-        pView(jn, jl);
+  const idx_t nColumns = incFlds["hydrostatic_exner_levels"].shape(0);
+  const idx_t levels = incFlds["hydrostatic_exner_levels"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        exnerIncView(jn, jl) = pIncView(jn, jl) *
+          (constants::rd_over_cp * exnerView(jn, jl)) /
+          pView(jn, jl);
+      }
     }
-  }
+  });
 }
 
 /// \details This is the adjoint of the calculation of hydrostatic exner increments
 void evalHydrostaticExnerAD(atlas::FieldSet & hatFlds,
                             const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("evalHydrostaticExnerAD");
   const auto pView = make_view<const double, 2>(augStateFlds["hydrostatic_pressure_levels"]);
   const auto exnerView = make_view<const double, 2>(augStateFlds["hydrostatic_exner_levels"]);
   auto pHatView = make_view<double, 2>(hatFlds["hydrostatic_pressure_levels"]);
   auto exnerHatView = make_view<double, 2>(hatFlds["hydrostatic_exner_levels"]);
 
-  atlas::idx_t levels = hatFlds["hydrostatic_exner_levels"].levels();
-  for (atlas::idx_t jn = 0; jn < hatFlds["hydrostatic_exner_levels"].shape(0); ++jn) {
-    for (atlas::idx_t jl = 0; jl < levels; ++jl) {
-      pHatView(jn, jl) += exnerHatView(jn, jl) *
-        (constants::rd_over_cp * exnerView(jn, jl)) /
-        pView(jn, jl);
-      exnerHatView(jn, jl) = 0.0;
+  const idx_t nColumns = hatFlds["hydrostatic_exner_levels"].shape(0);
+  const idx_t levels = hatFlds["hydrostatic_exner_levels"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        pHatView(jn, jl) += exnerHatView(jn, jl) *
+          (constants::rd_over_cp * exnerView(jn, jl)) /
+          pView(jn, jl);
+        exnerHatView(jn, jl) = 0.0;
+      }
     }
-  }
+  });
 }
 
 
@@ -503,6 +624,7 @@ void evalHydrostaticExnerAD(atlas::FieldSet & hatFlds,
 ///          found in the past that it gives no benefit and that its contribution
 ///          is small.
 void evalMuThetavTL(atlas::FieldSet & incFlds,  const atlas::FieldSet & augState) {
+  const vader::ScopedTiming timing("evalMuThetavTL");
   const auto muRow1Column1View = make_view<const double, 2>(augState["muRow1Column1"]);
   const auto muRow1Column2View = make_view<const double, 2>(augState["muRow1Column2"]);
   const auto muRow2Column1View = make_view<const double, 2>(augState["muRow2Column1"]);
@@ -512,18 +634,24 @@ void evalMuThetavTL(atlas::FieldSet & incFlds,  const atlas::FieldSet & augState
   auto muIncView = make_view<double, 2>(incFlds["mu"]);
   auto thetavIncView = make_view<double, 2>(incFlds["virtual_potential_temperature"]);
 
-  for (atlas::idx_t jn = 0; jn < incFlds["mu"].shape(0); ++jn) {
-    for (atlas::idx_t jl = 0; jl < incFlds["mu"].levels(); ++jl) {
-      muIncView(jn, jl) = muRow1Column1View(jn, jl)  * qtIncView(jn, jl)
-                        + muRow1Column2View(jn, jl)  * thetaIncView(jn, jl);
-      thetavIncView(jn, jl) = muRow2Column1View(jn, jl)  * qtIncView(jn, jl)
-                            + muRow2Column2View(jn, jl)  * thetaIncView(jn, jl);
+  const idx_t nColumns = incFlds["mu"].shape(0);
+  const idx_t levels = incFlds["mu"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        muIncView(jn, jl) = muRow1Column1View(jn, jl)  * qtIncView(jn, jl)
+                          + muRow1Column2View(jn, jl)  * thetaIncView(jn, jl);
+        thetavIncView(jn, jl) = muRow2Column1View(jn, jl)  * qtIncView(jn, jl)
+                              + muRow2Column2View(jn, jl)  * thetaIncView(jn, jl);
+      }
     }
-  }
+  });
 }
 
 
 void evalMuThetavAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState) {
+  const vader::ScopedTiming timing("evalMuThetavAD");
   const auto muRow1Column1View = make_view<const double, 2>(augState["muRow1Column1"]);
   const auto muRow1Column2View = make_view<const double, 2>(augState["muRow1Column2"]);
   const auto muRow2Column1View = make_view<const double, 2>(augState["muRow2Column1"]);
@@ -533,20 +661,26 @@ void evalMuThetavAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState)
   auto muHatView = make_view<double, 2>(hatFlds["mu"]);
   auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
 
-  for (atlas::idx_t jn = 0; jn < hatFlds["mu"].shape(0); ++jn) {
-    for (atlas::idx_t jl = 0; jl < hatFlds["mu"].levels(); ++jl) {
-      thetaHatView(jn, jl) += muRow2Column2View(jn, jl) * thetavHatView(jn, jl);
-      qtHatView(jn, jl) += muRow2Column1View(jn, jl) * thetavHatView(jn, jl);
-      thetaHatView(jn, jl) += muRow1Column2View(jn, jl) * muHatView(jn, jl);
-      qtHatView(jn, jl) += muRow1Column1View(jn, jl) * muHatView(jn, jl);
-      thetavHatView(jn, jl) = 0.0;
-      muHatView(jn, jl) = 0.0;
+  const idx_t nColumns = hatFlds["mu"].shape(0);
+  const idx_t levels = hatFlds["mu"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        thetaHatView(jn, jl) += muRow2Column2View(jn, jl) * thetavHatView(jn, jl);
+        qtHatView(jn, jl) += muRow2Column1View(jn, jl) * thetavHatView(jn, jl);
+        thetaHatView(jn, jl) += muRow1Column2View(jn, jl) * muHatView(jn, jl);
+        qtHatView(jn, jl) += muRow1Column1View(jn, jl) * muHatView(jn, jl);
+        thetavHatView(jn, jl) = 0.0;
+        muHatView(jn, jl) = 0.0;
+      }
     }
-  }
+  });
 }
 
 
 void evalQtThetaTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augState) {
+  const vader::ScopedTiming timing("evalQtThetaTL");
   // Using Cramer's rule to calculate inverse.
   const auto muRecipDeterView = make_view<const double, 2>(augState["muRecipDeterminant"]);
   const auto muRow1Column1View = make_view<const double, 2>(augState["muRow1Column1"]);
@@ -558,27 +692,33 @@ void evalQtThetaTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augState)
   auto qtIncView = make_view<double, 2>(incFlds["qt"]);
   auto thetaIncView = make_view<double, 2>(incFlds["potential_temperature"]);
 
-  for (atlas::idx_t jn = 0; jn < incFlds["mu"].shape(0); ++jn) {
-    for (atlas::idx_t jl = 0; jl < incFlds["mu"].levels(); ++jl) {
-      // VAR equivalent in Var_UpPFtheta_qT.f90 for thetaIncView
-      // (beta2 * muA * theta_v' +   beta1 * mu') /
-      // (alpha1 * beta2 * muA - alpha2 * muA * beta1)
-      thetaIncView(jn, jl) =  muRecipDeterView(jn, jl) * (
-                             muRow1Column1View(jn, jl) * thetavIncView(jn, jl)
-                           - muRow2Column1View(jn, jl) * muIncView(jn, jl) );
-
-      // VAR equivalent in Var_UpPFtheta_qT.f90 for qtIncView
-      // (alpha1 * mu_v' -   alpha2 * muA * thetav') /
-      // (alpha1 * beta2 * muA - alpha2 * muA * beta1)
-      qtIncView(jn, jl) =  muRecipDeterView(jn, jl) * (
-                           muRow2Column2View(jn, jl) * muIncView(jn, jl) -
-                           muRow1Column2View(jn, jl) * thetavIncView(jn, jl) );
+  const idx_t nColumns = incFlds["mu"].shape(0);
+  const idx_t levels = incFlds["mu"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        // VAR equivalent in Var_UpPFtheta_qT.f90 for thetaIncView
+        // (beta2 * muA * theta_v' +   beta1 * mu') /
+        // (alpha1 * beta2 * muA - alpha2 * muA * beta1)
+        thetaIncView(jn, jl) =  muRecipDeterView(jn, jl) * (
+                               muRow1Column1View(jn, jl) * thetavIncView(jn, jl)
+                             - muRow2Column1View(jn, jl) * muIncView(jn, jl) );
+
+        // VAR equivalent in Var_UpPFtheta_qT.f90 for qtIncView
+        // (alpha1 * mu_v' -   alpha2 * muA * thetav') /
+        // (alpha1 * beta2 * muA - alpha2 * muA * beta1)
+        qtIncView(jn, jl) =  muRecipDeterView(jn, jl) * (
+                             muRow2Column2View(jn, jl) * muIncView(jn, jl) -
+                             muRow1Column2View(jn, jl) * thetavIncView(jn, jl) );
+      }
     }
-  }
+  });
 }
 
 
 void evalQtThetaAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState) {
+  const vader::ScopedTiming timing("evalQtThetaAD");
   const auto muRecipDeterView = make_view<const double, 2>(augState["muRecipDeterminant"]);
   const auto muRow1Column1View = make_view<const double, 2>(augState["muRow1Column1"]);
   const auto muRow1Column2View = make_view<const double, 2>(augState["muRow1Column2"]);
@@ -589,20 +729,25 @@ void evalQtThetaAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState)
   auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
   auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
 
-  for (atlas::idx_t jn = 0; jn < hatFlds["mu"].shape(0); ++jn) {
-    for (atlas::idx_t jl = 0; jl < hatFlds["mu"].levels(); ++jl) {
-      thetavHatView(jn, jl) += muRecipDeterView(jn, jl) *
-                               muRow1Column1View(jn, jl) * thetaHatView(jn, jl);
-      muHatView(jn, jl) -= muRecipDeterView(jn, jl) *
-                           muRow2Column1View(jn, jl) * thetaHatView(jn, jl);
-      thetavHatView(jn, jl) -= muRecipDeterView(jn, jl) *
-                               muRow1Column2View(jn, jl) * qtHatView(jn, jl);
-      muHatView(jn, jl) += muRecipDeterView(jn, jl) *
-                           muRow2Column2View(jn, jl) * qtHatView(jn, jl);
-      thetaHatView(jn, jl) = 0.0;
-      qtHatView(jn, jl) = 0.0;
+  const idx_t nColumns = hatFlds["mu"].shape(0);
+  const idx_t levels = hatFlds["mu"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        thetavHatView(jn, jl) += muRecipDeterView(jn, jl) *
+                                 muRow1Column1View(jn, jl) * thetaHatView(jn, jl);
+        muHatView(jn, jl) -= muRecipDeterView(jn, jl) *
+                             muRow2Column1View(jn, jl) * thetaHatView(jn, jl);
+        thetavHatView(jn, jl) -= muRecipDeterView(jn, jl) *
+                                 muRow1Column2View(jn, jl) * qtHatView(jn, jl);
+        muHatView(jn, jl) += muRecipDeterView(jn, jl) *
+                             muRow2Column2View(jn, jl) * qtHatView(jn, jl);
+        thetaHatView(jn, jl) = 0.0;
+        qtHatView(jn, jl) = 0.0;
+      }
     }
-  }
+  });
 }
 
 }  // namespace mo
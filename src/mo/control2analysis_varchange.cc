@@ -13,6 +13,8 @@
 #include "mo/control2analysis_varchange.h"
 #include "mo/functions.h"
 
+#include "vader/Instrumentation.h"
+
 using atlas::array::make_view;
 using atlas::util::Config;
 using atlas::idx_t;
@@ -21,75 +23,94 @@ namespace mo {
 
 
 void hexner2PThetav(atlas::FieldSet & fields) {
+  const vader::ScopedTiming timing("hexner2PThetav");
   const auto rpView = make_view<const double, 2>(fields["height_levels"]);
   const auto hexnerView = make_view<const double, 2>(fields["hydrostatic_exner_levels"]);
   auto pView = make_view<double, 2>(fields["air_pressure_levels_minus_one"]);
   auto vthetaView = make_view<double, 2>(fields["virtual_potential_temperature"]);
 
-  for (idx_t jn = 0; jn < fields["hydrostatic_exner_levels"].shape(0); ++jn) {
-    pView(jn, 0) = constants::p_zero * pow(hexnerView(jn, 0), (constants::cp / constants::rd));
-
-    for (idx_t jl = 1; jl < fields["hydrostatic_exner_levels"].levels(); ++jl) {
-      vthetaView(jn, jl) = -constants::grav * (rpView(jn, jl) - rpView(jn, jl-1)) /
-         (constants::cp * (hexnerView(jn, jl) - hexnerView(jn, jl-1)));
+  const idx_t nColumns = functions::computedColumns(fields["hydrostatic_exner_levels"]);
+  const idx_t levels = fields["hydrostatic_exner_levels"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      pView(jn, 0) = constants::p_zero * pow(hexnerView(jn, 0), (constants::cp / constants::rd));
+      for (idx_t jl = 1; jl < levels; ++jl) {
+        vthetaView(jn, jl) = -constants::grav * (rpView(jn, jl) - rpView(jn, jl-1)) /
+           (constants::cp * (hexnerView(jn, jl) - hexnerView(jn, jl-1)));
+      }
+      vthetaView(jn, 0) = vthetaView(jn, 1);
     }
-    vthetaView(jn, 0) = vthetaView(jn, 1);
-  }
+  });
 }
 
 void evalVirtualPotentialTemperature(atlas::FieldSet & fields) {
-  const auto qView = make_view<const double, 2>(fields["specific_humidity"]);
-  const auto thetaView = make_view<const double, 2>(fields["potential_temperature"]);
-  auto vthetaView = make_view<double, 2>(fields["virtual_potential_temperature"]);
-
-  auto fspace = fields["virtual_potential_temperature"].functionspace();
-
-  auto evaluateVTheta = [&] (idx_t i, idx_t j) {
-    vthetaView(i, j) = thetaView(i, j) * (1.0 + constants::c_virtual * qView(i, j)); };
-
-  auto conf = Config("levels", fields["virtual_potential_temperature"].levels()) |
-              Config("include_halo", true);
-
-  functions::parallelFor(fspace, evaluateVTheta, conf);
+  const vader::ScopedTiming timing("evalVirtualPotentialTemperature");
+  functions::pointwise(fields["virtual_potential_temperature"],
+    [](const double theta, const double q) {return theta * (1.0 + constants::c_virtual * q);},
+    fields["potential_temperature"], fields["specific_humidity"]);
 }
 
-/// \details Calculate the hydrostatic exner pressure (on levels)
-///          using air_pressure_minus_one and virtual potential temperature.
+namespace detail {
+template<idx_t L>
 void evalHydrostaticExnerLevels(atlas::FieldSet & fields) {
   const auto rpView = make_view<const double, 2>(fields["height_levels"]);
   const auto vthetaView = make_view<const double, 2>(fields["virtual_potential_temperature"]);
   const auto pView = make_view<const double, 2>(fields["air_pressure_levels_minus_one"]);
   auto hexnerView = make_view<double, 2>(fields["hydrostatic_exner_levels"]);
 
-  for (idx_t jn = 0; jn < fields["hydrostatic_exner_levels"].shape(0); ++jn) {
-    hexnerView(jn, 0) = pow(pView(jn, 0) / constants::p_zero,
-      constants::rd_over_cp);
-    for (idx_t jl = 1; jl < fields["hydrostatic_exner_levels"].levels(); ++jl) {
-      hexnerView(jn, jl) = hexnerView(jn, jl-1) -
-        (constants::grav * (rpView(jn, jl) - rpView(jn, jl-1))) /
-        (constants::cp * vthetaView(jn, jl-1));
+  const idx_t nColumns = functions::computedColumns(fields["hydrostatic_exner_levels"]);
+  const idx_t levels = functions::levelCount<L>(fields["hydrostatic_exner_levels"].levels());
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      hexnerView(jn, 0) = pow(pView(jn, 0) / constants::p_zero,
+        constants::rd_over_cp);
     }
-  }
+    for (idx_t jl = 1; jl < levels; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        hexnerView(jn, jl) = hexnerView(jn, jl-1) -
+          (constants::grav * (rpView(jn, jl) - rpView(jn, jl-1))) /
+          (constants::cp * vthetaView(jn, jl-1));
+      }
+    }
+  });
+}
+}  // namespace detail
+
+/// \details Calculate the hydrostatic exner pressure (on levels)
+///          using air_pressure_minus_one and virtual potential temperature.
+void evalHydrostaticExnerLevels(atlas::FieldSet & fields) {
+  const vader::ScopedTiming timing("evalHydrostaticExnerLevels");
+  functions::dispatchLevels(fields["hydrostatic_exner_levels"].levels(), [&](const auto levels) {
+    detail::evalHydrostaticExnerLevels<decltype(levels)::value>(fields); });
 }
 
 
 /// \details Calculate the hydrostatic pressure (on levels)
 ///           from hydrostatic exner
 void evalHydrostaticPressureLevels(atlas::FieldSet & fields) {
+  const vader::ScopedTiming timing("evalHydrostaticPressureLevels");
   const auto hexnerView = make_view<double, 2>(fields["hydrostatic_exner_levels"]);
   auto hpView = make_view<double, 2>(fields["hydrostatic_pressure_levels"]);
 
-  for (idx_t jn = 0; jn < fields["hydrostatic_pressure_levels"].shape(0); ++jn) {
-    for (idx_t jl = 0; jl < fields["hydrostatic_pressure_levels"].levels(); ++jl) {
-       hpView(jn, jl) = constants::p_zero *
-         pow(hexnerView(jn, jl), 1.0 / constants::rd_over_cp);
+  const idx_t nColumns = functions::computedColumns(fields["hydrostatic_pressure_levels"]);
+  const idx_t levels = fields["hydrostatic_pressure_levels"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        hpView(jn, jl) = constants::p_zero *
+          pow(hexnerView(jn, jl), 1.0 / constants::rd_over_cp);
+      }
     }
-  }
+  });
 }
 
 
 /// \details Calculate qT increment from the sum of q, qcl and qcf increments
 void qqclqcf2qt(atlas::FieldSet & fields) {
+  const vader::ScopedTiming timing("qqclqcf2qt");
   const auto qIncView = make_view<const double, 2>(fields["specific_humidity"]);
   const auto qclIncView = make_view<const double, 2>
                     (fields["mass_content_of_cloud_liquid_water_in_atmosphere_layer"]);
@@ -97,38 +118,50 @@ void qqclqcf2qt(atlas::FieldSet & fields) {
                     (fields["mass_content_of_cloud_ice_in_atmosphere_layer"]);
   auto qtIncView = make_view<double, 2>(fields["qt"]);
 
-  for (atlas::idx_t jn = 0; jn < fields["specific_humidity"].shape(0); ++jn) {
-    for (atlas::idx_t jl = 0; jl < fields["specific_humidity"].levels(); ++jl) {
-      qtIncView(jn, jl) = qIncView(jn, jl) + qclIncView(jn, jl) + qcfIncView(jn, jl);
+  const idx_t nColumns = functions::computedColumns(fields["specific_humidity"]);
+  const idx_t levels = fields["specific_humidity"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        qtIncView(jn, jl) = qIncView(jn, jl) + qclIncView(jn, jl) + qcfIncView(jn, jl);
+      }
     }
-  }
+  });
 }
 
 /// \details Calculate the dry air density
 ///          from the air_pressure_levels_minus_one,
 ///          air_temperature (which needs to be interpolated).
 void evalDryAirDensity(atlas::FieldSet & fields) {
+  const vader::ScopedTiming timing("evalDryAirDensity");
   const auto hlView = make_view<const double, 2>(fields["height_levels"]);
   const auto hView = make_view<const double, 2>(fields["height"]);
   const auto tView = make_view<const double, 2>(fields["air_temperature"]);
   const auto pView = make_view<const double, 2>(fields["air_pressure_levels_minus_one"]);
   auto rhoView = make_view<double, 2>(fields["dry_air_density_levels_minus_one"]);
 
-  for (idx_t jn = 0; jn < fields["dry_air_density_levels_minus_one"].shape(0); ++jn) {
-    rhoView(jn, 0) = pView(jn, 0) / (constants::rd * tView(jn, 0));
-    for (idx_t jl = 1; jl < fields["dry_air_density_levels_minus_one"].levels(); ++jl) {
-      rhoView(jn, jl) = pView(jn, jl) * (hView(jn, jl) - hView(jn, jl-1)) /
-        (constants::rd * (
-        (hView(jn, jl) - hlView(jn, jl)) * tView(jn, jl-1) +
-        (hlView(jn, jl) - hView(jn, jl-1)) * tView(jn, jl)));
+  const idx_t nColumns = functions::computedColumns(fields["dry_air_density_levels_minus_one"]);
+  const idx_t levels = fields["dry_air_density_levels_minus_one"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      rhoView(jn, 0) = pView(jn, 0) / (constants::rd * tView(jn, 0));
+      for (idx_t jl = 1; jl < levels; ++jl) {
+        rhoView(jn, jl) = pView(jn, jl) * (hView(jn, jl) - hView(jn, jl-1)) /
+          (constants::rd * (
+          (hView(jn, jl) - hlView(jn, jl)) * tView(jn, jl-1) +
+          (hlView(jn, jl) - hView(jn, jl-1)) * tView(jn, jl)));
+      }
     }
-  }
+  });
 }
 
 /// \details Calculate exner pressure levels
 ///          from air_pressure_levels_minus_one and using hydrostatic balance relation
 ///          for topmost level
 void evalExnerPressureLevels(atlas::FieldSet & fields) {
+  const vader::ScopedTiming timing("evalExnerPressureLevels");
   oops::Log::trace() << "[evalAirPressureLevels()] starting ..." << std::endl;
 
   const auto exnerMinusOneView = make_view<const double, 2>(fields["exner_levels_minus_one"]);
@@ -139,23 +172,28 @@ void evalExnerPressureLevels(atlas::FieldSet & fields) {
   const auto hlView = make_view<const double, 2>(fields["height_levels"]);
   auto exnerView = make_view<double, 2>(fields["exner_pressure_levels"]);
 
-  idx_t levels(fields["exner_pressure_levels"].levels());
-  for (idx_t jn = 0; jn < fields["exner_pressure_levels"].shape(0); ++jn) {
-    for (idx_t jl = 1; jl < levels - 1; ++jl) {
-      exnerView(jn, jl) = exnerMinusOneView(jn, jl);
-    }
+  const idx_t nColumns = functions::computedColumns(fields["exner_pressure_levels"]);
+  const idx_t levels(fields["exner_pressure_levels"].levels());
 
-    exnerView(jn, levels - 1) = exnerView(jn, levels - 2) -
-      (constants::grav * (hlView(jn, levels - 1) - hlView(jn, levels - 2))) /
-      (constants::cp * vthetaView(jn, levels - 2));
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 1; jl < levels - 1; ++jl) {
+        exnerView(jn, jl) = exnerMinusOneView(jn, jl);
+      }
 
-    exnerView(jn, levels - 1) = exnerView(jn, levels-1) > 0.0 ?
-      exnerView(jn, levels - 1) : constants::deps;
-  }
+      exnerView(jn, levels - 1) = exnerView(jn, levels - 2) -
+        (constants::grav * (hlView(jn, levels - 1) - hlView(jn, levels - 2))) /
+        (constants::cp * vthetaView(jn, levels - 2));
+
+      exnerView(jn, levels - 1) = exnerView(jn, levels-1) > 0.0 ?
+        exnerView(jn, levels - 1) : constants::deps;
+    }
+  });
 }
 
 
 void evalMoistureControlDependencies(atlas::FieldSet & fields) {
+  const vader::ScopedTiming timing("evalMoistureControlDependencies");
   const auto qtView = make_view<const double, 2>(fields["qt"]);
   const auto qView = make_view<const double, 2>(fields["specific_humidity"]);
   const auto thetaView = make_view<const double, 2>(fields["potential_temperature"]);
@@ -179,20 +217,25 @@ void evalMoistureControlDependencies(atlas::FieldSet & fields) {
   auto muRecipDeterminantView = make_view<double, 2>(fields["muRecipDeterminant"]);
 
   // the comments below are there to allow checking with the VAR code.
-  for (atlas::idx_t jn = 0; jn < fields["potential_temperature"].shape(0); ++jn) {
-    for (atlas::idx_t jl = 0; jl < fields["potential_temperature"].levels(); ++jl) {
-      muRow1Column1View(jn, jl) = muAView(jn, jl) / qsatView(jn, jl);  // beta2 * muA
-      muRow1Column2View(jn, jl) = -  qtView(jn, jl)  * muH1View(jn, jl)
-        * exnerView(jn, jl) * dlsvpdTView(jn, jl) * muRow1Column1View(jn, jl);
-      // alpha2 * muA
-      muRow2Column1View(jn, jl) = constants::c_virtual * thetaView(jn, jl);   // beta1
-      muRow2Column2View(jn, jl) = 1.0 + constants::c_virtual * qView(jn, jl);  // alpha1
-      muRecipDeterminantView(jn, jl) = 1.0 /(
-        muRow2Column2View(jn, jl) * muRow1Column1View(jn, jl)
-        - muRow1Column2View(jn, jl) * muRow2Column1View(jn, jl));
-           // 1/( alpha1 * beta2 * muA - alpha2 * muA * beta1)
+  const idx_t nColumns = functions::computedColumns(fields["potential_temperature"]);
+  const idx_t levels = fields["potential_temperature"].levels();
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        muRow1Column1View(jn, jl) = muAView(jn, jl) / qsatView(jn, jl);  // beta2 * muA
+        muRow1Column2View(jn, jl) = -  qtView(jn, jl)  * muH1View(jn, jl)
+          * exnerView(jn, jl) * dlsvpdTView(jn, jl) * muRow1Column1View(jn, jl);
+        // alpha2 * muA
+        muRow2Column1View(jn, jl) = constants::c_virtual * thetaView(jn, jl);   // beta1
+        muRow2Column2View(jn, jl) = 1.0 + constants::c_virtual * qView(jn, jl);  // alpha1
+        muRecipDeterminantView(jn, jl) = 1.0 /(
+          muRow2Column2View(jn, jl) * muRow1Column1View(jn, jl)
+          - muRow1Column2View(jn, jl) * muRow2Column1View(jn, jl));
+             // 1/( alpha1 * beta2 * muA - alpha2 * muA * beta1)
+      }
     }
-  }
+  });
 }
 
 }  // namespace mo
@@ -6,7 +6,16 @@
  */
 
 #include <Eigen/Core>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "atlas/array.h"
@@ -14,28 +23,108 @@
 
 #include "mo/constants.h"
 #include "mo/functions.h"
+#include "mo/lookup_cache.h"
 
 #include "oops/base/Variables.h"
 #include "oops/util/Logger.h"
 
+#include "vader/Instrumentation.h"
+
 using atlas::array::make_view;
 
 namespace mo {
 namespace functions {
 
+namespace {
+std::atomic<atlas::idx_t> columnBlockSize_{constants::columnBlockSize};
+#ifdef VADER_CHECKED_PARALLEL_FOR
+std::atomic<bool> checkedParallelFor_{true};
+#else
+std::atomic<bool> checkedParallelFor_{false};
+#endif
+thread_local bool deviceBackend_ = false;
+thread_local bool ownedColumnsOnly_ = false;
+thread_local bool genericLevels_ = false;
+}  // namespace
+
+bool checkedParallelFor() {
+  return checkedParallelFor_;
+}
+
+void setCheckedParallelFor(const bool checked) {
+  checkedParallelFor_ = checked;
+}
+
+std::size_t checkedParallelForThreads() {
+  // at least two threads, so that shared writes are seen even on a single core
+  return std::max(std::thread::hardware_concurrency(), 2u);
+}
+
+bool deviceBackendAvailable() {
+#ifdef VADER_DEVICE_BACKEND
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool deviceBackend() {
+  return deviceBackend_;
+}
+
+void setDeviceBackend(const bool device) {
+  if (device && !deviceBackendAvailable()) {
+    oops::Log::error() << "ERROR - the device backend is not available "
+                          "(build with ENABLE_VADER_DEVICE)" << std::endl;
+    throw std::runtime_error("device backend not available");
+  }
+  deviceBackend_ = device;
+}
+
+bool ownedColumnsOnly() {
+  return ownedColumnsOnly_;
+}
+
+void setOwnedColumnsOnly(const bool ownedOnly) {
+  ownedColumnsOnly_ = ownedOnly;
+}
+
+bool genericLevels() {
+  return genericLevels_;
+}
+
+void setGenericLevels(const bool generic) {
+  genericLevels_ = generic;
+}
+
+atlas::idx_t computedColumns(const atlas::Field & field) {
+  if (!ownedColumnsOnly() || !field.functionspace()) return field.shape(0);
+  atlas::idx_t nColumns(0);
+  executeFunc(field.functionspace(), [&](const auto & fspace) {nColumns = fspace.sizeOwned();});
+  return nColumns;
+}
+
+atlas::util::Config columnsConfig(const atlas::Field & field) {
+  return atlas::util::Config("columns", field.shape(0));
+}
+
+atlas::util::Config haloConfig() {
+  return atlas::util::Config("include_halo", !ownedColumnsOnly());
+}
+
+atlas::idx_t columnBlockSize() {
+  return columnBlockSize_;
+}
+
+void setColumnBlockSize(const atlas::idx_t blockSize) {
+  columnBlockSize_ = std::max(blockSize, static_cast<atlas::idx_t>(1));
+}
+
 std::vector<double> getLookUp(const std::string & sVPFilePath,
                               const std::string & shortName,
                               const std::size_t lookupSize) {
-  std::vector<double> values(lookupSize, 0);
-
-  umGetLookUp_f90(static_cast<int>(sVPFilePath.size()),
-                  sVPFilePath.c_str(),
-                  static_cast<int>(shortName.size()),
-                  shortName.c_str(),
-                  static_cast<int>(lookupSize),
-                  values[0]);
-
-  return std::vector<double>(values.begin(), values.end());
+  const auto table = LookUpCache::instance().getLookUp(sVPFilePath, shortName, lookupSize);
+  return std::vector<double>(table.begin(), table.end());
 }
 
 
@@ -52,64 +141,89 @@ std::vector<std::vector<double>> getLookUps(const std::string & sVPFilePath,
 }
 
 void getMIOFields(atlas::FieldSet & augStateFlds) {
-  const auto rhtView = make_view<const double, 2>(augStateFlds["rht"]);
-  const auto clView = make_view<const double, 2>
-                (augStateFlds["liquid_cloud_volume_fraction_in_atmosphere_layer"]);
-  const auto cfView = make_view<const double, 2>
-                (augStateFlds["ice_cloud_volume_fraction_in_atmosphere_layer"]);
-
-  auto cleffView = make_view<double, 2>(augStateFlds["cleff"]);
-  auto cfeffView = make_view<double, 2>(augStateFlds["cfeff"]);
-
-  Eigen::MatrixXd mioCoeffCl = createMIOCoeff(constants::mioCoefficientsFilePath, "qcl_coef");
-  Eigen::MatrixXd mioCoeffCf = createMIOCoeff(constants::mioCoefficientsFilePath, "qcf_coef");
-
-  for  (atlas::idx_t jn = 0; jn < augStateFlds["rht"].shape(0); ++jn) {
-    for (int jl = 0; jl < augStateFlds["rht"].levels(); ++jl) {
-      if (jl < constants::mioLevs) {
-        std::size_t ibin = (rhtView(jn, jl) > 1.0) ? constants::mioBins - 1 :
-                           static_cast<std::size_t>(floor(rhtView(jn, jl) / constants::rHTBin));
-
-        std::double_t ceffdenom = (1.0 -  clView(jn, jl) * cfView(jn, jl) );
-        if (ceffdenom > constants::tol) {
-          std::double_t clcf = clView(jn, jl) * cfView(jn, jl);
-          cleffView(jn, jl) = mioCoeffCl(jl, ibin) * (clView(jn, jl) - clcf) / ceffdenom;
-          cfeffView(jn, jl) = mioCoeffCf(jl, ibin) * (cfView(jn, jl) - clcf) / ceffdenom;
-        } else {
-          cleffView(jn, jl) = 0.5;
-          cfeffView(jn, jl) = 0.5;
+  const vader::ScopedTiming timing("getMIOFields");
+  // the view keeps the table (cached, mapped or node shared) alive during the loops
+  const LookUpCache::Table mioCoeffTable =
+    LookUpCache::instance().getMIOCoeffLevelMajor(constants::mioCoefficientsFilePath);
+  const double * mioCoeff = mioCoeffTable.data();
+  const atlas::idx_t nColumns = augStateFlds["rht"].shape(0);
+  const atlas::idx_t levels = augStateFlds["rht"].levels();
+  const atlas::idx_t mioLevels = std::min(levels,
+                                          static_cast<atlas::idx_t>(constants::mioLevs));
+  const double lastBin = static_cast<double>(constants::mioBins - 1);
+
+  // The fields have the value type (double or float) of rht; the effective cloud
+  // fractions are computed in double, as the pointwise kernels compute
+  dispatchValueType(augStateFlds["rht"], [&](const auto zero) {
+    typedef std::decay_t<decltype(zero)> T;
+    const auto rhtView = make_view<const T, 2>(augStateFlds["rht"]);
+    const auto clView = make_view<const T, 2>
+                  (augStateFlds["liquid_cloud_volume_fraction_in_atmosphere_layer"]);
+    const auto cfView = make_view<const T, 2>
+                  (augStateFlds["ice_cloud_volume_fraction_in_atmosphere_layer"]);
+
+    auto cleffView = make_view<T, 2>(augStateFlds["cleff"]);
+    auto cfeffView = make_view<T, 2>(augStateFlds["cfeff"]);
+
+    forEachColumnBlock(nColumns, [&](const atlas::idx_t jnBegin, const atlas::idx_t jnEnd) {
+      for (atlas::idx_t jl = 0; jl < mioLevels; ++jl) {
+        const double * mioCoeffLevel = mioCoeff + 2 * constants::mioBins * jl;
+        for (atlas::idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+          // The bin of rht > 1.0 is the last one, else floor(rht / rHTBin), clamped to
+          // the table so that the gather is always in bounds
+          const double rht = rhtView(jn, jl);
+          const double bin = rht > 1.0 ? lastBin : std::floor(rht / constants::rHTBin);
+          const atlas::idx_t ibin = static_cast<atlas::idx_t>(
+                                      std::min(std::max(bin, 0.0), lastBin));
+
+          const double cl = clView(jn, jl);
+          const double cf = cfView(jn, jl);
+          const double clcf = cl * cf;
+          const double ceffdenom = 1.0 - clcf;
+          const bool resolved = ceffdenom > constants::tol;
+          const double denom = resolved ? ceffdenom : 1.0;
+          const double cleff = mioCoeffLevel[2 * ibin] * (cl - clcf) / denom;
+          const double cfeff = mioCoeffLevel[2 * ibin + 1] * (cf - clcf) / denom;
+          cleffView(jn, jl) = static_cast<T>(resolved ? cleff : 0.5);
+          cfeffView(jn, jl) = static_cast<T>(resolved ? cfeff : 0.5);
         }
-      } else {
-        cleffView(jn, jl) = 0.0;
-        cfeffView(jn, jl) = 0.0;
       }
-    }
-  }
+      for (atlas::idx_t jl = mioLevels; jl < levels; ++jl) {
+        for (atlas::idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+          cleffView(jn, jl) = 0.0;
+          cfeffView(jn, jl) = 0.0;
+        }
+      }
+    });
+  });
 }
 
 Eigen::MatrixXd createMIOCoeff(const std::string mioFileName,
                                const std::string s)
 {
-    Eigen::MatrixXd mioCoeff(static_cast<std::size_t>(constants::mioLevs),
-                             static_cast<std::size_t>(constants::mioBins));
-
-    std::vector<double> valuesvec(constants::mioLookUpLength, 0);
-
-    umGetLookUp2D_f90(static_cast<int>(mioFileName.size()),
-                      mioFileName.c_str(),
-                      static_cast<int>(s.size()),
-                      s.c_str(),
-                      static_cast<int>(constants::mioBins),
-                      static_cast<int>(constants::mioLevs),
-                      valuesvec[0]);
-
-    for (int j = 0; j < constants::mioLevs; ++j) {
-        for (int i = 0; i < constants::mioBins; ++i) {
-            // Fortran returns column major order, but C++ needs row major
-            mioCoeff(j, i) = valuesvec[i * constants::mioLevs+j];
-        }
-    }
-    return mioCoeff;
+    const auto values = LookUpCache::instance().getLookUp2D(mioFileName, s,
+                                                            constants::mioBins,
+                                                            constants::mioLevs);
+
+    // The table is in the column major order of the Fortran reader (levels fastest),
+    // which is the storage order of an Eigen::MatrixXd of levels x bins: the matrix
+    // (mioCoeff(j, i) = values[i * mioLevs + j]) is a plain copy of the table
+    return Eigen::Map<const Eigen::MatrixXd>(values.data(),
+                                             static_cast<Eigen::Index>(constants::mioLevs),
+                                             static_cast<Eigen::Index>(constants::mioBins));
+}
+
+std::shared_ptr<const Eigen::MatrixXd> getMIOCoeff(const std::string & mioFileName,
+                                                   const std::string & s)
+{
+    // The transposed matrices are cached here; the file values by LookUpCache
+    static std::mutex mutex;
+    static std::map<std::pair<std::string, std::string>,
+                    std::shared_ptr<const Eigen::MatrixXd>> coeffs;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto & coeff = coeffs[std::make_pair(mioFileName, s)];
+    if (!coeff) coeff = std::make_shared<const Eigen::MatrixXd>(createMIOCoeff(mioFileName, s));
+    return coeff;
 }
 
 }  // namespace functions
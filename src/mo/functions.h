@@ -8,11 +8,20 @@
 #pragma once
 
 #include <Eigen/Core>
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "atlas/array/DataType.h"
+#include "atlas/array/MakeView.h"
 #include "atlas/field.h"
 #include "atlas/functionspace.h"
+#include "atlas/parallel/omp/omp.h"
 
 #include "oops/base/Variables.h"
 #include "oops/util/Logger.h"
@@ -37,19 +46,346 @@ void executeFunc(const atlas::FunctionSpace & fspace, const Functor & functor) {
   }
 }
 
+/// \brief true if parallelFor runs in checked mode (see parallelFor)
+/// (the default is false, or true when built with VADER_CHECKED_PARALLEL_FOR)
+bool checkedParallelFor();
+
+/// \brief switches the checked mode of parallelFor on or off for the process
+void setCheckedParallelFor(const bool checked);
+
+/// \brief number of threads used by parallelFor in checked mode
+std::size_t checkedParallelForThreads();
+
 /// \brief wrapper for 'parallel_for'
+/// \details In checked mode (setCheckedParallelFor, or Config("checked", true) for
+///          a single call) the (column, level) loop runs on std::threads rather than
+///          on the atlas OpenMP loop. The columns are split into contiguous ranges,
+///          one per thread, so a functor writing to shared state (e.g. a scratch
+///          scalar captured by reference) is reported by a thread sanitizer, which
+///          does not see through an uninstrumented OpenMP runtime. The checked mode
+///          needs the "levels" option; without it the call is not checked.
+///
+///          A function space that is not set (the fields have none, like the column
+///          blocks of a chunked Vader::changeVar) needs the "columns" (see
+///          columnsConfig) and "levels" options; all the columns are then computed.
 template<typename Functor>
 void parallelFor(const atlas::FunctionSpace & fspace,
                  const Functor& functor,
                  const atlas::util::Config& conf = atlas::util::Config()) {
-  executeFunc(fspace, [&](const auto& fspace){fspace.parallel_for(conf, functor);});
+  atlas::idx_t levels(0);
+  if (!fspace) {
+    atlas::idx_t nColumns(0);
+    if (!conf.get("columns", nColumns) || !conf.get("levels", levels)) {
+      oops::Log::error() << "ERROR - parallelFor without a function space needs the "
+                            "columns and levels options" << std::endl;
+      throw std::runtime_error("parallelFor without a function space");
+    }
+    atlas_omp_parallel_for(atlas::idx_t jn = 0; jn < nColumns; ++jn) {
+      for (atlas::idx_t jl = 0; jl < levels; ++jl) {
+        functor(jn, jl);
+      }
+    }
+    return;
+  }
+  if (!conf.getBool("checked", checkedParallelFor()) || !conf.get("levels", levels)) {
+    executeFunc(fspace, [&](const auto& fspace){fspace.parallel_for(conf, functor);});
+    return;
+  }
+  atlas::idx_t nColumns(0);
+  executeFunc(fspace, [&](const auto& fspace) {
+    nColumns = conf.getBool("include_halo", false) ? fspace.size() : fspace.sizeOwned(); });
+
+  const atlas::idx_t nThreads = checkedParallelForThreads();
+  std::vector<std::thread> threads;
+  for (atlas::idx_t jt = 0; jt < nThreads; ++jt) {
+    threads.emplace_back([&, jt]() {
+      const atlas::idx_t jnEnd = nColumns * (jt + 1) / nThreads;
+      for (atlas::idx_t jn = nColumns * jt / nThreads; jn < jnEnd; ++jn) {
+        for (atlas::idx_t jl = 0; jl < levels; ++jl) {
+          functor(jn, jl);
+        }
+      }
+    });
+  }
+  for (auto & thread : threads) thread.join();
 }
 
+/// \brief true if the kernels of the (non-linear) variable changes only compute the
+///        owned columns of their outputs, leaving the halos to be filled by a halo
+///        exchange (the default is false: the halos are computed too)
+/// \details The owned columns are the first columns of the fields. The kernels are
+///          column-local, so the owned columns of an output only depend on the owned
+///          columns of the inputs. The linear (TL and AD) kernels compute the halos
+///          regardless.
+///
+///          The mode is that of the calling thread (the kernels read it before they
+///          distribute their loops over threads), so that Vader instances with
+///          different halo policies do not affect each other or the direct callers of
+///          the kernels; see ScopedOwnedColumnsOnly.
+bool ownedColumnsOnly();
+
+/// \brief switches the owned-columns-only mode of the kernels on or off for the
+///        calling thread
+void setOwnedColumnsOnly(const bool ownedOnly);
+
+/// \brief sets the owned-columns-only mode of the calling thread for the lifetime of
+///        the object, and restores the previous mode on destruction
+class ScopedOwnedColumnsOnly {
+ public:
+  explicit ScopedOwnedColumnsOnly(const bool ownedOnly) : previous_(ownedColumnsOnly()) {
+    setOwnedColumnsOnly(ownedOnly);
+  }
+  ~ScopedOwnedColumnsOnly() {setOwnedColumnsOnly(previous_);}
+
+  ScopedOwnedColumnsOnly(const ScopedOwnedColumnsOnly &) = delete;
+  ScopedOwnedColumnsOnly & operator=(const ScopedOwnedColumnsOnly &) = delete;
+
+ private:
+  const bool previous_;
+};
+
+/// \brief number of columns of field the kernels compute: the owned columns if
+///        ownedColumnsOnly, else all the columns, halo included (shape(0)). (All the
+///        columns of a field without a function space: it has no halo.)
+atlas::idx_t computedColumns(const atlas::Field & field);
+
+/// \brief the "columns" option of the parallelFor calls of the kernels: the number of
+///        columns of field, used when field has no function space (see parallelFor)
+atlas::util::Config columnsConfig(const atlas::Field & field);
+
+/// \brief the "include_halo" option of the parallelFor calls of the kernels
+///        (false if ownedColumnsOnly)
+atlas::util::Config haloConfig();
+
+/// \brief calls functor(T()) with T the value type of field, double (real64) or
+///        float (real32)
+/// \details Kernels templated on their value type use this to dispatch on the data
+///          type of their fields, so that float fields are processed natively (half
+///          the memory traffic) rather than converted to double and back.
+template<typename Functor>
+void dispatchValueType(const atlas::Field & field, const Functor & functor) {
+  if (field.datatype() == atlas::array::DataType::real64()) {
+    functor(double());
+  } else if (field.datatype() == atlas::array::DataType::real32()) {
+    functor(float());
+  } else {
+    oops::Log::error() << "ERROR - field " << field.name() <<
+                          " is neither double nor float" << std::endl;
+    throw std::runtime_error("field data type not allowed");
+  }
+}
+
+/// \brief true if the mo kernels were built with the device backend
+///        (ENABLE_VADER_DEVICE, which defines VADER_DEVICE_BACKEND)
+bool deviceBackendAvailable();
+
+/// \brief true if pointwise runs its kernels on the device (the default is false)
+/// \details The backend is that of the calling thread, like ownedColumnsOnly, so that
+///          a Vader with the device backend does not move the outputs of the other
+///          Vader instances or of the direct callers of the kernels to the device; see
+///          ScopedDeviceBackend.
+bool deviceBackend();
+
+/// \brief switches the device backend of pointwise on or off for the calling thread
+/// (switching it on throws if the backend is not available)
+void setDeviceBackend(const bool device);
+
+/// \brief sets the device backend of the calling thread for the lifetime of the
+///        object, and restores the previous backend on destruction
+class ScopedDeviceBackend {
+ public:
+  explicit ScopedDeviceBackend(const bool device) : previous_(deviceBackend()) {
+    setDeviceBackend(device);
+  }
+  ~ScopedDeviceBackend() {setDeviceBackend(previous_);}
+
+  ScopedDeviceBackend(const ScopedDeviceBackend &) = delete;
+  ScopedDeviceBackend & operator=(const ScopedDeviceBackend &) = delete;
+
+ private:
+  const bool previous_;
+};
+
+namespace detail {
+#ifdef VADER_DEVICE_BACKEND
+template<typename T, typename Kernel, typename OutView, typename InViews, std::size_t... I>
+void pointwiseDevice(const atlas::idx_t nColumns, const atlas::idx_t levels,
+                     const Kernel & kernel, OutView & outView, const InViews & inViews,
+                     std::index_sequence<I...>) {
+  // the views and the kernel (which captures by value) are copied to the device;
+  // the views point to the device copies of the fields
+  const Kernel deviceKernel(kernel);
+#pragma acc parallel loop collapse(2) copyin(deviceKernel, outView, inViews)
+  for (atlas::idx_t i = 0; i < nColumns; ++i) {
+    for (atlas::idx_t j = 0; j < levels; ++j) {
+      outView(i, j) = static_cast<T>(deviceKernel(std::get<I>(inViews)(i, j)...));
+    }
+  }
+}
+#endif
+
+template<typename Kernel, typename OutView, typename InViews, std::size_t... I>
+void pointwise(const atlas::FunctionSpace & fspace, const atlas::util::Config & conf,
+               const Kernel & kernel, OutView & outView, const InViews & inViews,
+               std::index_sequence<I...>) {
+  typedef std::remove_const_t<typename OutView::value_type> T;
+  parallelFor(fspace, [&](const atlas::idx_t i, const atlas::idx_t j) {
+    outView(i, j) = static_cast<T>(kernel(std::get<I>(inViews)(i, j)...)); }, conf);
+}
+}  // namespace detail
+
+/// \brief evaluates output(i, j) = kernel(inputs(i, j)...) on every point of output,
+///        halo included (unless ownedColumnsOnly)
+/// \details This is the preferred way to write a point-wise kernel. The kernel only
+///          receives the input values of the point and returns the output value of
+///          the point, and it is called through a const reference, so it cannot
+///          carry state from one point to the next. Any scratch values are locals
+///          of the kernel, which makes it parallel-safe by construction. (The kernel
+///          should capture its parameters by value.) The inputs must have the
+///          function space, number of levels and value type (double or float, see
+///          dispatchValueType) of output. The kernel is called with values of that
+///          type, so a generic kernel also computes in that type.
+///
+///          With the device backend (setDeviceBackend) the loop runs on the device.
+///          The inputs are copied to the device only if their device copy is out of
+///          date, and the output is left on the device, its host copy marked out of
+///          date, so that a chain of pointwise kernels keeps its fields resident.
+///          The caller brings the host copies up to date (Field::updateHost) before
+///          reading them on the host.
+template<typename Kernel, typename... Inputs>
+void pointwise(atlas::Field & output, const Kernel & kernel, const Inputs & ... inputs) {
+  static_assert((std::is_same<Inputs, atlas::Field>::value && ...),
+                "pointwise inputs must be atlas fields");
+#ifdef VADER_DEVICE_BACKEND
+  if (deviceBackend()) {
+    for (const atlas::Field * input : {&inputs...}) {
+      if (input->deviceNeedsUpdate()) input->updateDevice();
+    }
+    if (!output.deviceAllocated()) output.allocateDevice();
+    dispatchValueType(output, [&](const auto zero) {
+      typedef std::decay_t<decltype(zero)> T;
+      auto outView = atlas::array::make_device_view<T, 2>(output);
+      const auto inViews =
+        std::make_tuple(atlas::array::make_device_view<const T, 2>(inputs)...);
+      detail::pointwiseDevice<T>(computedColumns(output), output.levels(), kernel, outView,
+                                 inViews, std::index_sequence_for<Inputs...>{});
+    });
+    output.setDeviceNeedsUpdate(false);
+    output.setHostNeedsUpdate(true);
+    return;
+  }
+#endif
+  const auto conf = atlas::util::Config("levels", output.levels()) | columnsConfig(output) |
+                    haloConfig();
+  dispatchValueType(output, [&](const auto zero) {
+    typedef std::decay_t<decltype(zero)> T;
+    auto outView = atlas::array::make_view<T, 2>(output);
+    const auto inViews = std::make_tuple(atlas::array::make_view<const T, 2>(inputs)...);
+    detail::pointwise(output.functionspace(), conf, kernel, outView, inViews,
+                      std::index_sequence_for<Inputs...>{});
+  });
+}
+
+/// \brief true if dispatchLevels calls the generic (L = 0) instantiation of the kernels
+///        for every number of levels (the default is false)
+/// \details The mode is that of the calling thread, like ownedColumnsOnly; the tests use
+///          it to check the compiled instantiations against the generic one.
+bool genericLevels();
+
+/// \brief switches the generic instantiation of dispatchLevels on or off for the
+///        calling thread
+void setGenericLevels(const bool generic);
+
+/// \brief sets the generic-levels mode of the calling thread for the lifetime of the
+///        object, and restores the previous mode on destruction
+class ScopedGenericLevels {
+ public:
+  explicit ScopedGenericLevels(const bool generic) : previous_(genericLevels()) {
+    setGenericLevels(generic);
+  }
+  ~ScopedGenericLevels() {setGenericLevels(previous_);}
+
+  ScopedGenericLevels(const ScopedGenericLevels &) = delete;
+  ScopedGenericLevels & operator=(const ScopedGenericLevels &) = delete;
+
+ private:
+  const bool previous_;
+};
+
+/// \brief calls functor(std::integral_constant<atlas::idx_t, L>()) with L = levels if
+///        levels is the number of levels (or levels + 1, for the fields on level
+///        boundaries) of an operational vertical grid (70, 90 or 137 levels), else
+///        with L = 0
+/// \details Kernels with a level recurrence are templated on L and take their number
+///          of levels from levelCount<L>, so that for the operational grids the trip
+///          counts of their level loops are known at compile time (and the loops can
+///          be unrolled and vectorised accordingly), while other grids use the generic
+///          (L = 0) instantiation.
+///
+///          With genericLevels, every number of levels uses the generic instantiation
+///          (see ScopedGenericLevels).
+template<typename Functor>
+void dispatchLevels(const atlas::idx_t levels, const Functor & functor) {
+  if (genericLevels()) {
+    functor(std::integral_constant<atlas::idx_t, 0>());
+    return;
+  }
+  switch (levels) {
+    case 70: functor(std::integral_constant<atlas::idx_t, 70>()); break;
+    case 71: functor(std::integral_constant<atlas::idx_t, 71>()); break;
+    case 90: functor(std::integral_constant<atlas::idx_t, 90>()); break;
+    case 91: functor(std::integral_constant<atlas::idx_t, 91>()); break;
+    case 137: functor(std::integral_constant<atlas::idx_t, 137>()); break;
+    case 138: functor(std::integral_constant<atlas::idx_t, 138>()); break;
+    default: functor(std::integral_constant<atlas::idx_t, 0>());
+  }
+}
+
+/// \brief the number of levels of a kernel instantiated by dispatchLevels: L, or the
+///        runtime number of levels for the generic instantiation (L = 0)
+template<atlas::idx_t L>
+constexpr atlas::idx_t levelCount(const atlas::idx_t levels) {
+  return L > 0 ? L : levels;
+}
+
+/// \brief number of columns in the tiles processed by forEachColumnBlock
+atlas::idx_t columnBlockSize();
+
+/// \brief sets the number of columns per tile (a block size of 1 processes the
+///        columns one at a time)
+void setColumnBlockSize(const atlas::idx_t blockSize);
+
+/// \brief calls functor(jnBegin, jnEnd) for consecutive tiles of columns
+///        [jnBegin, jnEnd) covering [0, nColumns)
+/// \details Kernels with a level to level recurrence loop over the levels inside
+///          the tile and over the columns of the tile innermost. The recurrence
+///          is then carried by independent columns and vectorises across them,
+///          while the tile stays in cache. Kernels without a recurrence loop over
+///          the columns of the tile and over the levels innermost, so that each
+///          column is read contiguously. The loop bounds (levels, number of
+///          columns) are read once, outside the tile loops.
+///
+///          The tiles are distributed over the OpenMP threads. Each column is
+///          only written by the thread owning its tile and the operations within
+///          a column keep their order, so the results (including adjoint
+///          accumulations into a column) are bitwise independent of the number
+///          of threads. The functor must therefore only write to the columns of
+///          its tile and to its own locals.
+template<typename Functor>
+void forEachColumnBlock(const atlas::idx_t nColumns, const Functor & functor) {
+  const atlas::idx_t blockSize = columnBlockSize();
+  const atlas::idx_t nBlocks = (nColumns + blockSize - 1) / blockSize;
+  atlas_omp_parallel_for(atlas::idx_t jb = 0; jb < nBlocks; ++jb) {
+    const atlas::idx_t jnBegin = jb * blockSize;
+    functor(jnBegin, std::min(jnBegin + blockSize, nColumns));
+  }
+}
 
 //--
 // ++ I/O processing ++
 
 /// \brief function to read data from a netcdf file
+/// (the values are cached process-wide by LookUpCache; see mo/lookup_cache.h)
 /// sVPFilePath: the path and name of the netcdf file
 /// shortname: array to be read from the file
 /// lookupSize: dimension of the array
@@ -69,6 +405,15 @@ std::vector<std::vector<double>> getLookUps(const std::string & sVPFilePath,
 
 /// \details getMIOFields returns the effective cloud fractions
 ///          for the moisture incrementing operator (MIO)
+///
+///          The levels below mioLevs are computed and the levels above are zeroed in
+///          separate loops. The coefficients are read from the level-major table of
+///          LookUpCache::getMIOCoeffLevelMajor (cached, mapped or node shared like the
+///          other tables), the bin and the cloud fraction denominator are selected
+///          without branches (so the inner loop over the columns of a tile vectorises),
+///          and the tiles are threaded by forEachColumnBlock. The cleff and cfeff fields
+///          are those the linearised MIO (qtTemperature2qqclqcfTL/AD) then reads.
+///          The fields are double or float, all of the value type of rht.
 void getMIOFields(atlas::FieldSet & augStateFlds);
 
 /// \details This extracts the scaling coefficients that are applied to Cleff and Cfeff
@@ -77,6 +422,11 @@ void getMIOFields(atlas::FieldSet & augStateFlds);
 Eigen::MatrixXd createMIOCoeff(const std::string mioFileName,
                                const std::string s);
 
+/// \details As createMIOCoeff, but the matrix is built once per process and shared
+///          read-only between callers
+std::shared_ptr<const Eigen::MatrixXd> getMIOCoeff(const std::string & mioFileName,
+                                                   const std::string & s);
+
 extern "C" {
   void umGetLookUp_f90(
     const int &,
@@ -0,0 +1,229 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#include "atlas/array/MakeView.h"
+#include "atlas/field/Field.h"
+
+#include "mo/constants.h"
+#include "mo/functions.h"
+#include "mo/hydrostatic_balance.h"
+
+#include "vader/Instrumentation.h"
+
+using atlas::array::make_view;
+using atlas::idx_t;
+
+namespace mo {
+
+HydrostaticBalanceTraj setupHydrostaticBalanceTraj(const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("setupHydrostaticBalanceTraj");
+  const auto pView = make_view<const double, 2>(augStateFlds["air_pressure_levels"]);
+  const auto hPView = make_view<const double, 2>(augStateFlds["hydrostatic_pressure_levels"]);
+  const auto hexnerView = make_view<const double, 2>(augStateFlds["hydrostatic_exner_levels"]);
+  const auto thetavView = make_view<const double, 2>(
+    augStateFlds["virtual_potential_temperature"]);
+  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
+  const auto interpWeightView = make_view<const double, 2>(augStateFlds["interpolation_weights"]);
+  const auto vertRegView = make_view<const double, 2>(augStateFlds["vertical_regression_matrices"]);
+
+  HydrostaticBalanceTraj traj;
+  traj.nColumns = augStateFlds["virtual_potential_temperature"].shape(0);
+  traj.levels = augStateFlds["virtual_potential_temperature"].levels();
+  traj.nBins = augStateFlds["interpolation_weights"].shape(1);
+  const idx_t nColumns = traj.nColumns;
+  const idx_t levels = traj.levels;
+  const idx_t nBins = traj.nBins;
+
+  traj.exnerOverPressure.resize((levels + 1) * nColumns);
+  traj.thetavCoefficient.resize(levels * nColumns);
+  traj.topPressureRatio.resize(nColumns);
+  traj.interpWeights.resize(nBins * nColumns);
+  traj.vertReg.resize(nBins * levels * levels);
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jl = 0; jl < levels + 1; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        traj.exnerOverPressure[jl * nColumns + jn] =
+          (constants::rd_over_cp * hexnerView(jn, jl)) / hPView(jn, jl);
+      }
+    }
+    for (idx_t jl = 0; jl < levels; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        traj.thetavCoefficient[jl * nColumns + jn] =
+          (constants::cp * thetavView(jn, jl) * thetavView(jn, jl)) /
+          (constants::grav * (hlView(jn, jl+1) - hlView(jn, jl)));
+      }
+    }
+    for (idx_t b = 0; b < nBins; ++b) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        traj.interpWeights[b * nColumns + jn] = interpWeightView(jn, b);
+      }
+    }
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      traj.topPressureRatio[jn] =
+        std::pow(pView(jn, levels-1) / pView(jn, levels), constants::rd_over_cp - 1.0);
+    }
+  });
+  for (idx_t jr = 0; jr < nBins * levels; ++jr) {
+    for (idx_t jl2 = 0; jl2 < levels; ++jl2) {
+      traj.vertReg[jr * levels + jl2] = vertRegView(jr, jl2);
+    }
+  }
+  return traj;
+}
+
+void hydrostaticBalanceTL(atlas::FieldSet & incFlds, const HydrostaticBalanceTraj & traj) {
+  const vader::ScopedTiming timing("hydrostaticBalanceTL");
+  const auto gPIncView = make_view<const double, 2>(
+    incFlds["geostrophic_pressure_levels_minus_one"]);
+  const auto uPIncView = make_view<const double, 2>(
+    incFlds["unbalanced_pressure_levels_minus_one"]);
+  auto thetavIncView = make_view<double, 2>(incFlds["virtual_potential_temperature"]);
+  const bool hasHPInc = incFlds.has("hydrostatic_pressure_levels");
+  const bool hasHexnerInc = incFlds.has("hydrostatic_exner_levels");
+
+  const idx_t nColumns = traj.nColumns;
+  const idx_t levels = traj.levels;
+  const idx_t nBins = traj.nBins;
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    const idx_t nTile = jnEnd - jnBegin;
+    // Tile-local hydrostatic pressure and exner increments, level-major
+    std::vector<double> hPInc((levels + 1) * nTile);
+    std::vector<double> hexnerInc((levels + 1) * nTile);
+
+    // The vertical regression couples all the levels of a column
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      const idx_t jt = jn - jnBegin;
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        double balanced = 0.0;
+        for (idx_t b = 0; b < nBins; ++b) {
+          const double weight = traj.interpWeights[b * nColumns + jn];
+          if (weight > __FLT_EPSILON__) {
+            const double * const row = traj.vertReg.data() + (b * levels + jl) * levels;
+            double regressed = 0.0;
+            for (idx_t jl2 = 0; jl2 < levels; ++jl2) {
+              regressed += row[jl2] * gPIncView(jn, jl2);
+            }
+            balanced += weight * regressed;
+          }
+        }
+        hPInc[jl * nTile + jt] = uPIncView(jn, jl) + balanced;
+      }
+      hPInc[levels * nTile + jt] = hPInc[(levels - 1) * nTile + jt] * traj.topPressureRatio[jn];
+    }
+
+    for (idx_t jl = 0; jl < levels + 1; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        hexnerInc[jl * nTile + jn - jnBegin] =
+          hPInc[jl * nTile + jn - jnBegin] * traj.exnerOverPressure[jl * nColumns + jn];
+      }
+    }
+    for (idx_t jl = 0; jl < levels; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        thetavIncView(jn, jl) =
+          (hexnerInc[(jl + 1) * nTile + jn - jnBegin] - hexnerInc[jl * nTile + jn - jnBegin]) *
+          traj.thetavCoefficient[jl * nColumns + jn];
+      }
+    }
+
+    if (hasHPInc) {
+      auto hPIncView = make_view<double, 2>(incFlds["hydrostatic_pressure_levels"]);
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        for (idx_t jl = 0; jl < levels + 1; ++jl) {
+          hPIncView(jn, jl) = hPInc[jl * nTile + jn - jnBegin];
+        }
+      }
+    }
+    if (hasHexnerInc) {
+      auto hexnerIncView = make_view<double, 2>(incFlds["hydrostatic_exner_levels"]);
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        for (idx_t jl = 0; jl < levels + 1; ++jl) {
+          hexnerIncView(jn, jl) = hexnerInc[jl * nTile + jn - jnBegin];
+        }
+      }
+    }
+  });
+}
+
+void hydrostaticBalanceAD(atlas::FieldSet & hatFlds, const HydrostaticBalanceTraj & traj) {
+  const vader::ScopedTiming timing("hydrostaticBalanceAD");
+  auto gPHatView = make_view<double, 2>(hatFlds["geostrophic_pressure_levels_minus_one"]);
+  auto uPHatView = make_view<double, 2>(hatFlds["unbalanced_pressure_levels_minus_one"]);
+  auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
+  const bool hasHPHat = hatFlds.has("hydrostatic_pressure_levels");
+  const bool hasHexnerHat = hatFlds.has("hydrostatic_exner_levels");
+
+  const idx_t nColumns = traj.nColumns;
+  const idx_t levels = traj.levels;
+  const idx_t nBins = traj.nBins;
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    const idx_t nTile = jnEnd - jnBegin;
+    // Tile-local hydrostatic pressure and exner adjoints, level-major
+    std::vector<double> hPHat((levels + 1) * nTile, 0.0);
+    std::vector<double> hexnerHat((levels + 1) * nTile, 0.0);
+
+    if (hasHPHat) {
+      auto hPHatView = make_view<double, 2>(hatFlds["hydrostatic_pressure_levels"]);
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        for (idx_t jl = 0; jl < levels + 1; ++jl) {
+          hPHat[jl * nTile + jn - jnBegin] = hPHatView(jn, jl);
+          hPHatView(jn, jl) = 0.0;
+        }
+      }
+    }
+    if (hasHexnerHat) {
+      auto hexnerHatView = make_view<double, 2>(hatFlds["hydrostatic_exner_levels"]);
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        for (idx_t jl = 0; jl < levels + 1; ++jl) {
+          hexnerHat[jl * nTile + jn - jnBegin] = hexnerHatView(jn, jl);
+          hexnerHatView(jn, jl) = 0.0;
+        }
+      }
+    }
+
+    for (idx_t jl = levels - 1; jl >= 0; --jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        const double thetavHat = thetavHatView(jn, jl) * traj.thetavCoefficient[jl * nColumns + jn];
+        hexnerHat[(jl + 1) * nTile + jn - jnBegin] += thetavHat;
+        hexnerHat[jl * nTile + jn - jnBegin] -= thetavHat;
+        thetavHatView(jn, jl) = 0.0;
+      }
+    }
+    for (idx_t jl = 0; jl < levels + 1; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        hPHat[jl * nTile + jn - jnBegin] +=
+          hexnerHat[jl * nTile + jn - jnBegin] * traj.exnerOverPressure[jl * nColumns + jn];
+      }
+    }
+
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      const idx_t jt = jn - jnBegin;
+      hPHat[(levels - 1) * nTile + jt] += hPHat[levels * nTile + jt] * traj.topPressureRatio[jn];
+      for (idx_t jl = levels - 1; jl >= 0; --jl) {
+        const double hat = hPHat[jl * nTile + jt];
+        uPHatView(jn, jl) += hat;
+        for (idx_t b = nBins - 1; b >= 0; --b) {
+          const double weight = traj.interpWeights[b * nColumns + jn];
+          if (weight > __FLT_EPSILON__) {
+            const double * const row = traj.vertReg.data() + (b * levels + jl) * levels;
+            for (idx_t jl2 = levels - 1; jl2 >= 0; --jl2) {
+              gPHatView(jn, jl2) += weight * row[jl2] * hat;
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+}  // namespace mo
@@ -0,0 +1,61 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "atlas/field/FieldSet.h"
+#include "atlas/library/config.h"
+
+namespace mo {
+
+/// \brief trajectory coefficients of the hydrostatic balance operator
+///
+/// \details Structure of arrays: one array per coefficient, level-major
+///          (index jl * nColumns + jn), so that the innermost loop over the columns
+///          of a tile is unit stride. Computed once per trajectory (outer loop) by
+///          setupHydrostaticBalanceTraj; the TL and AD then read these arrays
+///          instead of the trajectory fields.
+struct HydrostaticBalanceTraj {
+  atlas::idx_t nColumns = 0;
+  /// levels of virtual potential temperature; the pressure and exner have levels + 1
+  atlas::idx_t levels = 0;
+  atlas::idx_t nBins = 0;
+  /// rd_over_cp * hydrostatic_exner_levels / hydrostatic_pressure_levels (levels + 1)
+  std::vector<double> exnerOverPressure;
+  /// cp * thetav^2 / (grav * dz), the inverse of the hydrostatic relation (levels)
+  std::vector<double> thetavCoefficient;
+  /// (p(levels-1) / p(levels))^(rd_over_cp - 1), extrapolating the top pressure
+  std::vector<double> topPressureRatio;
+  /// interpolation weights of the regression bins (nBins)
+  std::vector<double> interpWeights;
+  /// vertical regression matrices, index (b * levels + jl) * levels + jl2
+  std::vector<double> vertReg;
+};
+
+/// \brief computes the coefficients of the hydrostatic balance operator from the
+///        trajectory (air_pressure_levels, hydrostatic_pressure_levels,
+///        hydrostatic_exner_levels, virtual_potential_temperature, height_levels,
+///        interpolation_weights and vertical_regression_matrices)
+HydrostaticBalanceTraj setupHydrostaticBalanceTraj(const atlas::FieldSet & augStateFlds);
+
+/// \brief fused tangent linear of evalHydrostaticPressureTL, evalHydrostaticExnerTL and
+///        hexner2ThetavTL: virtual_potential_temperature increments from geostrophic
+///        and unbalanced pressure increments, in one sweep over each tile of columns
+/// \details The intermediate hydrostatic_pressure_levels and hydrostatic_exner_levels
+///          increments stay in cache; they are only written if incFlds has them. All
+///          the regression bins with a weight contribute (as in the adjoint).
+void hydrostaticBalanceTL(atlas::FieldSet & incFlds, const HydrostaticBalanceTraj & traj);
+
+/// \brief adjoint of hydrostaticBalanceTL
+/// \details Adds to the geostrophic and unbalanced pressure adjoints, then zeroes the
+///          virtual_potential_temperature adjoint (and the intermediate adjoints, which
+///          contribute if hatFlds has them).
+void hydrostaticBalanceAD(atlas::FieldSet & hatFlds, const HydrostaticBalanceTraj & traj);
+
+}  // namespace mo
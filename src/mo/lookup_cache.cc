@@ -0,0 +1,196 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "eckit/mpi/Comm.h"
+
+#include "mo/constants.h"
+#include "mo/functions.h"
+#include "mo/lookup_cache.h"
+#include "mo/node_shared_memory.h"
+
+#include "oops/util/Logger.h"
+
+namespace mo {
+namespace functions {
+
+namespace {
+/// reads the table through the Fortran netcdf readers
+void readTable(const std::string & filePath, const std::string & shortName,
+               const std::size_t dim1, const std::size_t dim2, double * values) {
+  if (dim2 == 0) {
+    umGetLookUp_f90(static_cast<int>(filePath.size()),
+                    filePath.c_str(),
+                    static_cast<int>(shortName.size()),
+                    shortName.c_str(),
+                    static_cast<int>(dim1),
+                    values[0]);
+  } else {
+    umGetLookUp2D_f90(static_cast<int>(filePath.size()),
+                      filePath.c_str(),
+                      static_cast<int>(shortName.size()),
+                      shortName.c_str(),
+                      static_cast<int>(dim1),
+                      static_cast<int>(dim2),
+                      values[0]);
+  }
+}
+}  // namespace
+
+LookUpCache & LookUpCache::instance() {
+  static LookUpCache cache;
+  return cache;
+}
+
+LookUpCache::Table LookUpCache::getLookUp(const std::string & filePath,
+                                          const std::string & shortName,
+                                          const std::size_t lookupSize) {
+  return load(Key(filePath, shortName, lookupSize, 0), [&](double * values) {
+    readTable(filePath, shortName, lookupSize, 0, values); });
+}
+
+LookUpCache::Table LookUpCache::getLookUp2D(const std::string & filePath,
+                                            const std::string & shortName,
+                                            const std::size_t dim1,
+                                            const std::size_t dim2) {
+  return load(Key(filePath, shortName, dim1, dim2), [&](double * values) {
+    readTable(filePath, shortName, dim1, dim2, values); });
+}
+
+LookUpCache::Table LookUpCache::getMIOCoeffLevelMajor(const std::string & filePath) {
+  // The source tables are loaded first (outside the lock of the derived table); they
+  // are bin-major, levels fastest (see createMIOCoeff)
+  const Table tableCl = getLookUp2D(filePath, "qcl_coef", constants::mioBins,
+                                    constants::mioLevs);
+  const Table tableCf = getLookUp2D(filePath, "qcf_coef", constants::mioBins,
+                                    constants::mioLevs);
+  return load(Key(filePath, mioLevelMajorName, 2 * constants::mioBins, constants::mioLevs),
+              [&](double * values) {
+    for (std::size_t jl = 0; jl < constants::mioLevs; ++jl) {
+      for (std::size_t ibin = 0; ibin < constants::mioBins; ++ibin) {
+        values[2 * (jl * constants::mioBins + ibin)] = tableCl[ibin * constants::mioLevs + jl];
+        values[2 * (jl * constants::mioBins + ibin) + 1] =
+          tableCf[ibin * constants::mioLevs + jl];
+      }
+    }
+  });
+}
+
+void LookUpCache::setBroadcast(const eckit::mpi::Comm & comm, const std::size_t root) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  comm_ = &comm;
+  root_ = root;
+}
+
+void LookUpCache::setTableFile(const std::string & path) {
+  // Mapped outside the lock; the mapping is only replaced once it is valid
+  const auto tableFile = path.empty() ? nullptr : std::make_shared<const TableFile>(path);
+  std::lock_guard<std::mutex> lock(mutex_);
+  tableFile_ = tableFile;
+}
+
+void LookUpCache::setNodeShared(const eckit::mpi::Comm & comm) {
+  const auto nodeShared = std::make_shared<const NodeSharedMemory>(comm);
+  std::lock_guard<std::mutex> lock(mutex_);
+  nodeShared_ = nodeShared;
+}
+
+void LookUpCache::preload() {
+  oops::Log::trace() << "[LookUpCache::preload()] starting ..." << std::endl;
+  for (const auto & var : {"svp", "dlsvp", "svpW", "dlsvpW"}) {
+    getLookUp(constants::commonVarChangeFilePath, var, constants::svpLookUpLength);
+  }
+  for (const auto & var : {"qcl_coef", "qcf_coef"}) {
+    getLookUp2D(constants::mioCoefficientsFilePath, var,
+                constants::mioBins, constants::mioLevs);
+  }
+  getMIOCoeffLevelMajor(constants::mioCoefficientsFilePath);
+  oops::Log::trace() << "[LookUpCache::preload()] ... exit" << std::endl;
+}
+
+void LookUpCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tables_.clear();
+}
+
+std::size_t LookUpCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tables_.size();
+}
+
+std::size_t LookUpCache::hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return hits_;
+}
+
+std::size_t LookUpCache::misses() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return misses_;
+}
+
+LookUpCache::Table LookUpCache::load(const Key & key,
+                                     const std::function<void(double *)> & fill) {
+  // The lock is held while reading, so that concurrent requests for a table
+  // read the file once
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = tables_.find(key);
+  if (it != tables_.end()) {
+    ++hits_;
+    return it->second;
+  }
+  ++misses_;
+
+  const std::string & filePath = std::get<0>(key);
+  const std::string & shortName = std::get<1>(key);
+  const std::size_t dim1 = std::get<2>(key);
+  const std::size_t dim2 = std::get<3>(key);
+  const std::size_t size = dim2 == 0 ? dim1 : dim1 * dim2;
+
+  if (tableFile_) {
+    const double * mapped = tableFile_->find(filePath, shortName, dim1, dim2);
+    if (mapped != nullptr) {
+      oops::Log::debug() << "LookUpCache: mapping " << shortName << " of " << filePath
+                         << " from " << tableFile_->path() << std::endl;
+      Table table(tableFile_, mapped, size);
+      tables_[key] = table;
+      return table;
+    }
+    oops::Log::debug() << "LookUpCache: " << tableFile_->path() << " does not hold "
+                       << shortName << " of " << filePath << std::endl;
+  }
+
+  if (nodeShared_) {
+    oops::Log::debug() << "LookUpCache: reading " << shortName << " from " << filePath
+                       << " into a node shared window" << std::endl;
+    const double * shared = nodeShared_->allocate(size, fill);
+    Table table(nodeShared_, shared, size);
+    tables_[key] = table;
+    return table;
+  }
+
+  oops::Log::debug() << "LookUpCache: reading " << shortName << " from "
+                     << filePath << std::endl;
+  // Aligned like the tables of the table file and of the node shared windows
+  std::shared_ptr<double> values(
+    new (std::align_val_t(TableFile::alignment)) double[size](),
+    [](double * p) {::operator delete[](p, std::align_val_t(TableFile::alignment));});
+  if (comm_ == nullptr || comm_->rank() == root_) fill(values.get());
+  if (comm_ != nullptr) comm_->broadcast(values.get(), values.get() + size, root_);
+
+  Table table(values, values.get(), size);
+  tables_[key] = table;
+  return table;
+}
+
+}  // namespace functions
+}  // namespace mo
@@ -0,0 +1,145 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "eckit/mpi/Comm.h"
+
+#include "mo/node_shared_memory.h"
+#include "mo/table_file.h"
+
+namespace mo {
+namespace functions {
+
+/// \brief process-wide cache of the lookup tables read from netcdf files
+///
+/// \details Tables are keyed by (file path, variable name, dimensions) and are read
+/// through the Fortran readers the first time they are requested. They are handed
+/// out as shared read-only views and are never modified, so a view can be used
+/// concurrently and stays valid after clear().
+///
+/// By default every MPI task reads the file itself. After setBroadcast(comm) only
+/// the root task of comm reads it and the values are broadcast; loads are then
+/// collective, so all the tasks of comm must request the same tables in the same
+/// order. Calling preload on all the tasks at startup guarantees that.
+///
+/// After setTableFile(path) the tables held in that binary table file (see
+/// mo/table_file.h) are served from its read-only mapping instead: no netcdf read,
+/// no broadcast and no copy. The tables the file does not hold are still read from
+/// their netcdf files.
+///
+/// After setNodeShared(comm) the tables read from the netcdf files are placed in MPI-3
+/// shared memory windows, one copy per node of comm (see mo/node_shared_memory.h):
+/// they are read once, by the first task of comm, and broadcast to the first task of
+/// each node (the broadcast set by setBroadcast is not used for them). Their loads are
+/// collective over comm, like broadcast loads.
+///
+/// The tables are 64 byte aligned, whatever their source.
+///
+/// Derived tables, computed from the tables of a file (getMIOCoeffLevelMajor), are
+/// cached, mapped from the table file or placed in the shared memory windows in the
+/// same way, under a variable name of their own.
+///
+class LookUpCache {
+ public:
+  /// \brief shared read-only view of a table; it keeps the values it refers to (a
+  /// copy read from the netcdf file, or the mapping of the table file) alive
+  class Table {
+   public:
+    Table() {}
+    Table(std::shared_ptr<const void> owner, const double * data, const std::size_t size) :
+      owner_(std::move(owner)), data_(data), size_(size) {}
+
+    const double * data() const {return data_;}
+    std::size_t size() const {return size_;}
+    const double & operator[](const std::size_t i) const {return data_[i];}
+    const double * begin() const {return data_;}
+    const double * end() const {return data_ + size_;}
+
+   private:
+    std::shared_ptr<const void> owner_;
+    const double * data_ = nullptr;
+    std::size_t size_ = 0;
+  };
+
+  static LookUpCache & instance();
+
+  /// \brief 1D table of lookupSize values
+  Table getLookUp(const std::string & filePath,
+                  const std::string & shortName,
+                  const std::size_t lookupSize);
+
+  /// \brief 2D table of dim1 x dim2 values, in the (column major) order of the file
+  Table getLookUp2D(const std::string & filePath,
+                    const std::string & shortName,
+                    const std::size_t dim1,
+                    const std::size_t dim2);
+
+  /// \brief the qcl_coef and qcf_coef MIO coefficients of the file at filePath,
+  /// level-major and interleaved: the coefficients of level jl and bin ibin are at
+  /// 2 * (jl * mioBins + ibin) (qcl) and the next value (qcf), so that the bins of a
+  /// level are contiguous. A derived table of the name mioLevelMajorName and of
+  /// dimensions 2 mioBins x mioLevs.
+  Table getMIOCoeffLevelMajor(const std::string & filePath);
+  static constexpr const char * mioLevelMajorName = "mio_coef_level_major";
+
+  /// \brief serve the tables held in the binary table file at path from its mapping
+  /// from now on (the tables already cached are not reloaded); throws if path is not
+  /// a valid table file. An empty path stops using the table file.
+  void setTableFile(const std::string & path);
+
+  /// \brief place the tables read from the netcdf files from now on in shared memory
+  /// windows, one copy per node of comm; collective over comm. Throws if vader was
+  /// built without ENABLE_VADER_SHARED_TABLES.
+  void setNodeShared(const eckit::mpi::Comm & comm);
+
+  /// \brief read on the root task of comm and broadcast from now on
+  void setBroadcast(const eckit::mpi::Comm & comm, const std::size_t root = 0);
+
+  /// \brief loads the svp and MIO tables (and the derived MIO table) used by the mo
+  /// functions
+  void preload();
+
+  /// \brief drops the cached tables (views already handed out remain valid)
+  void clear();
+
+  std::size_t size() const;
+
+  /// \brief number of requests served from the cache and loaded from the files
+  std::size_t hits() const;
+  std::size_t misses() const;
+
+ private:
+  typedef std::tuple<std::string, std::string, std::size_t, std::size_t> Key;
+
+  LookUpCache() {}
+  /// the table of key: cached, mapped from the table file, or filled by fill (on the
+  /// reading task, into a node shared window or a local copy)
+  Table load(const Key &, const std::function<void(double *)> & fill);
+
+  mutable std::mutex mutex_;
+  std::map<Key, Table> tables_;
+  std::size_t hits_ = 0;
+  std::size_t misses_ = 0;
+  const eckit::mpi::Comm * comm_ = nullptr;
+  std::size_t root_ = 0;
+  std::shared_ptr<const TableFile> tableFile_;
+  std::shared_ptr<const NodeSharedMemory> nodeShared_;
+};
+
+}  // namespace functions
+}  // namespace mo
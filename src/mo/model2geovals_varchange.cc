@@ -8,6 +8,7 @@
 
 #include <cmath>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "atlas/array.h"
@@ -19,6 +20,8 @@
 
 #include "oops/util/Logger.h"
 
+#include "vader/Instrumentation.h"
+
 using atlas::array::make_view;
 using atlas::idx_t;
 using atlas::util::Config;
@@ -41,23 +44,13 @@ void setUniformValue_rank2(atlas::Field & field, const double value)
 
 bool evalTotalMassMoistAir(atlas::FieldSet & fields)
 {
+  const vader::ScopedTiming timing("evalTotalMassMoistAir");
   oops::Log::trace() << "[evalTotalMassMoistAir()] starting ..." << std::endl;
 
-  const auto ds_m_v  = make_view<const double, 2>(fields["m_v"]);
-  const auto ds_m_ci = make_view<const double, 2>(fields["m_ci"]);
-  const auto ds_m_cl = make_view<const double, 2>(fields["m_cl"]);
-  const auto ds_m_r  = make_view<const double, 2>(fields["m_r"]);
-  auto ds_m_t  = make_view<double, 2>(fields["m_t"]);
-
-  auto fspace = fields["m_t"].functionspace();
-
-  auto evaluateMt = [&] (idx_t i, idx_t j) {
-    ds_m_t(i, j) = 1 + ds_m_v(i, j) + ds_m_ci(i, j) + ds_m_cl(i, j) + ds_m_r(i, j); };
-
-  auto conf = Config("levels", fields["m_t"].levels()) |
-              Config("include_halo", true);
-
-  functions::parallelFor(fspace, evaluateMt, conf);
+  functions::pointwise(fields["m_t"],
+    [](const double m_v, const double m_ci, const double m_cl, const double m_r) {
+      return 1 + m_v + m_ci + m_cl + m_r; },
+    fields["m_v"], fields["m_ci"], fields["m_cl"], fields["m_r"]);
 
   oops::Log::trace() << "[evalTotalMassMoistAir()] ... exit" << std::endl;
 
@@ -72,23 +65,13 @@ bool evalTotalMassMoistAir(atlas::FieldSet & fields)
 ///
 bool evalRatioToMt(atlas::FieldSet & fields, const std::vector<std::string> & vars)
 {
+  const vader::ScopedTiming timing("evalRatioToMt");
   oops::Log::trace() << "[evalRatioToMt()] starting ..." << std::endl;
 
-  // fields[0] = m_x = [ mv | mci | mcl | m_r ]
-  const auto ds_m_x  = make_view<const double, 2>(fields[vars[0]]);
-  const auto ds_m_t  = make_view<const double, 2>(fields[vars[1]]);
-  auto ds_tfield  = make_view<double, 2>(fields[vars[2]]);
-
-  auto fspace = fields[vars[1]].functionspace();
-
-  auto evaluateRatioToMt = [&] (idx_t i, idx_t j) {
-    ds_tfield(i, j) = ds_m_x(i, j) / ds_m_t(i, j);
-  };
-
-  auto conf = Config("levels", fields[1].levels()) |
-              Config("include_halo", true);
-
-  functions::parallelFor(fspace, evaluateRatioToMt, conf);
+  // vars[0] = m_x = [ mv | mci | mcl | m_r ]
+  functions::pointwise(fields[vars[2]],
+    [](const double m_x, const double m_t) {return m_x / m_t;},
+    fields[vars[0]], fields[vars[1]]);
 
   oops::Log::trace() << "[evalRatioToMt()] ... exit" << std::endl;
 
@@ -98,6 +81,7 @@ bool evalRatioToMt(atlas::FieldSet & fields, const std::vector<std::string> & va
 
 bool evalSpecificHumidity(atlas::FieldSet & fields)
 {
+  const vader::ScopedTiming timing("evalSpecificHumidity");
   oops::Log::trace() << "[evalSpecificHumidity()] starting ..." << std::endl;
 
   std::vector<std::string> fnames {"m_v", "m_t", "specific_humidity"};
@@ -109,8 +93,67 @@ bool evalSpecificHumidity(atlas::FieldSet & fields)
   return rvalue;
 }
 
+bool evalMoisturePartition(atlas::FieldSet & fields)
+{
+  const vader::ScopedTiming timing("evalMoisturePartition");
+  oops::Log::trace() << "[evalMoisturePartition()] starting ..." << std::endl;
+
+  const std::vector<std::string> mxNames{"m_v", "m_ci", "m_cl", "m_r"};
+  const std::vector<std::string> qxNames{"specific_humidity",
+                                         "mass_content_of_cloud_ice_in_atmosphere_layer",
+                                         "mass_content_of_cloud_liquid_water_in_atmosphere_layer",
+                                         "qrain"};
+
+  // The fields have the value type (double or float) of m_v, as for evalRatioToMt;
+  // the partition is computed in double, like the pointwise kernels of evalRatioToMt
+  functions::dispatchValueType(fields["m_v"], [&](const auto zero) {
+    typedef std::decay_t<decltype(zero)> T;
+    const auto ds_m_v  = make_view<const T, 2>(fields["m_v"]);
+    const auto ds_m_ci = make_view<const T, 2>(fields["m_ci"]);
+    const auto ds_m_cl = make_view<const T, 2>(fields["m_cl"]);
+    const auto ds_m_r  = make_view<const T, 2>(fields["m_r"]);
+
+    // Only the outputs present in the fieldset are evaluated
+    std::vector<atlas::array::ArrayView<const T, 2>> mxViews;
+    std::vector<atlas::array::ArrayView<T, 2>> qxViews;
+    for (std::size_t iv = 0; iv < qxNames.size(); ++iv) {
+      if (fields.has(qxNames[iv])) {
+        mxViews.push_back(make_view<const T, 2>(fields[mxNames[iv]]));
+        qxViews.push_back(make_view<T, 2>(fields[qxNames[iv]]));
+      }
+    }
+    const bool evaluateMt = fields.has("m_t");
+    std::vector<atlas::array::ArrayView<T, 2>> mtView;
+    if (evaluateMt) mtView.push_back(make_view<T, 2>(fields["m_t"]));
+
+    const std::size_t nqx = qxViews.size();
+    auto fspace = fields["m_v"].functionspace();
+
+    auto evaluatePartition = [&] (idx_t i, idx_t j) {
+      // m_t rounded to T, as the ratios of evalRatioToMt read it from the m_t field
+      const T m_t = static_cast<T>(1.0 + static_cast<double>(ds_m_v(i, j)) + ds_m_ci(i, j) +
+                                   ds_m_cl(i, j) + ds_m_r(i, j));
+      if (evaluateMt) mtView[0](i, j) = m_t;
+      for (std::size_t iv = 0; iv < nqx; ++iv) {
+        qxViews[iv](i, j) = static_cast<T>(static_cast<double>(mxViews[iv](i, j)) / m_t);
+      }
+    };
+
+    auto conf = Config("levels", fields["m_v"].levels()) |
+                functions::columnsConfig(fields["m_v"]) |
+                functions::haloConfig();
+
+    functions::parallelFor(fspace, evaluatePartition, conf);
+  });
+
+  oops::Log::trace() << "[evalMoisturePartition()] ... exit" << std::endl;
+
+  return true;
+}
+
 bool evalRelativeHumidity(atlas::FieldSet & fields)
 {
+  const vader::ScopedTiming timing("evalRelativeHumidity");
   oops::Log::trace() << "[evalRelativeHumidity()] starting ..." << std::endl;
 
   bool cap_super_sat(false);
@@ -119,21 +162,11 @@ bool evalRelativeHumidity(atlas::FieldSet & fields)
     fields["relative_humidity"].metadata().get("cap_super_sat", cap_super_sat);
   }
 
-  const auto qView = make_view<const double, 2>(fields["specific_humidity"]);
-  const auto qsatView = make_view<const double, 2>(fields["qsat"]);
-  auto rhView = make_view<double, 2>(fields["relative_humidity"]);
-
-  auto conf = Config("levels", fields["relative_humidity"].levels()) |
-              Config("include_halo", true);
-
-  auto evaluateRH = [&] (idx_t i, idx_t j) {
-    rhView(i, j) = fmax(qView(i, j) / qsatView(i, j) * 100.0, 0.0);
-    rhView(i, j) = (cap_super_sat && (rhView(i, j) > 100.0)) ? 100.0 : rhView(i, j);
-  };
-
-  auto fspace = fields["relative_humidity"].functionspace();
-
-  functions::parallelFor(fspace, evaluateRH, conf);
+  functions::pointwise(fields["relative_humidity"],
+    [cap_super_sat](const double q, const double qsat) {
+      const double rh = fmax(q / qsat * 100.0, 0.0);
+      return (cap_super_sat && (rh > 100.0)) ? 100.0 : rh;
+    }, fields["specific_humidity"], fields["qsat"]);
 
   oops::Log::trace() << "[evalRelativeHumidity()] ... exit" << std::endl;
 
@@ -142,6 +175,7 @@ bool evalRelativeHumidity(atlas::FieldSet & fields)
 
 bool evalTotalRelativeHumidity(atlas::FieldSet & fields)
 {
+  const vader::ScopedTiming timing("evalTotalRelativeHumidity");
   oops::Log::trace() << "[evalTotalRelativeHumidity()] starting ..." << std::endl;
 
   const auto qView = make_view<const double, 2>(fields["specific_humidity"]);
@@ -154,7 +188,8 @@ bool evalTotalRelativeHumidity(atlas::FieldSet & fields)
   auto rhtView = make_view<double, 2>(fields["rht"]);
 
   auto conf = Config("levels", fields["rht"].levels()) |
-              Config("include_halo", true);
+              functions::columnsConfig(fields["rht"]) |
+              functions::haloConfig();
 
   auto evaluateRHT = [&] (idx_t i, idx_t j) {
     rhtView(i, j) = (qView(i, j) + qclView(i, j) + qciView(i, j)
@@ -177,6 +212,7 @@ bool evalTotalRelativeHumidity(atlas::FieldSet & fields)
 
 bool evalMassCloudIce(atlas::FieldSet & fields)
 {
+  const vader::ScopedTiming timing("evalMassCloudIce");
   oops::Log::trace() << "[evalMassCloudIce()] starting ..." << std::endl;
 
   std::vector<std::string> fnames {"m_ci", "m_t",
@@ -191,6 +227,7 @@ bool evalMassCloudIce(atlas::FieldSet & fields)
 
 bool evalMassCloudLiquid(atlas::FieldSet & fields)
 {
+  const vader::ScopedTiming timing("evalMassCloudLiquid");
   oops::Log::trace() << "[evalMassCloudLiquid()] starting ..." << std::endl;
 
   std::vector<std::string> fnames {"m_cl", "m_t",
@@ -205,6 +242,7 @@ bool evalMassCloudLiquid(atlas::FieldSet & fields)
 
 bool evalMassRain(atlas::FieldSet & fields)
 {
+  const vader::ScopedTiming timing("evalMassRain");
   oops::Log::trace() << "[evalMassRain()] starting ..." << std::endl;
 
   std::vector<std::string> fnames {"m_r", "m_t", "qrain"};
@@ -218,21 +256,12 @@ bool evalMassRain(atlas::FieldSet & fields)
 
 bool evalAirTemperature(atlas::FieldSet & fields)
 {
+  const vader::ScopedTiming timing("evalAirTemperature");
   oops::Log::trace() << "[evalAirTemperature()] starting ..." << std::endl;
 
-  const auto ds_theta  = make_view<const double, 2>(fields["potential_temperature"]);
-  const auto ds_exner = make_view<const double, 2>(fields["exner"]);
-  auto ds_atemp = make_view<double, 2>(fields["air_temperature"]);
-
-  auto fspace = fields["air_temperature"].functionspace();
-
-  auto evaluateAirTemp = [&] (idx_t i, idx_t j) {
-    ds_atemp(i, j) = ds_theta(i, j) * ds_exner(i, j); };
-
-  auto conf = Config("levels", fields["air_temperature"].levels()) |
-              Config("include_halo", true);
-
-  functions::parallelFor(fspace, evaluateAirTemp, conf);
+  functions::pointwise(fields["air_temperature"],
+    [](const double theta, const double exner) {return theta * exner;},
+    fields["potential_temperature"], fields["exner"]);
 
   oops::Log::trace() << "[evalAirTemperature()] ... exit" << std::endl;
 
@@ -245,6 +274,7 @@ bool evalAirTemperature(atlas::FieldSet & fields)
 
 bool evalSpecificHumidityFromRH_2m(atlas::FieldSet & fields)
 {
+  const vader::ScopedTiming timing("evalSpecificHumidityFromRH_2m");
   oops::Log::trace() << "[evalSpecificHumidityFromRH_2m()] starting ..." << std::endl;
 
   const auto ds_qsat = make_view<const double, 2>(fields["qsat"]);
@@ -258,7 +288,8 @@ bool evalSpecificHumidityFromRH_2m(atlas::FieldSet & fields)
 
   auto conf = Config("levels",
     fields["specific_humidity_at_two_meters_above_surface"].levels()) |
-              Config("include_halo", true);
+              functions::columnsConfig(fields["specific_humidity_at_two_meters_above_surface"]) |
+              functions::haloConfig();
 
   functions::parallelFor(fspace, evaluateSpecificHumidity_2m, conf);
 
@@ -270,6 +301,7 @@ bool evalSpecificHumidityFromRH_2m(atlas::FieldSet & fields)
 
 bool evalParamAParamB(atlas::FieldSet & fields)
 {
+  const vader::ScopedTiming timing("evalParamAParamB");
   oops::Log::trace() << "[evalParamAParamB2()] starting ..." << std::endl;
 
   std::size_t blindex;
@@ -288,25 +320,26 @@ bool evalParamAParamB(atlas::FieldSet & fields)
   auto param_aView = make_view<double, 2>(fields["param_a"]);
   auto param_bView = make_view<double, 2>(fields["param_b"]);
 
-  // temperature at level above boundary layer
-  double t_bl;
-  // temperature at model surface height
-  double t_msh;
-
-  double exp_pmsh = constants::Lclr * constants::rd / constants::grav;
+  const double exp_pmsh = constants::Lclr * constants::rd / constants::grav;
 
-  for (idx_t jn = 0; jn < param_aView.shape(0); ++jn) {
-    t_bl = (-constants::grav / constants::rd) *
-           (heightLevelsView(jn, blindex + 1) - heightLevelsView(jn, blindex)) /
-           log(pressureLevelsView(jn, blindex + 1) / pressureLevelsView(jn, blindex));
+  functions::forEachColumnBlock(functions::computedColumns(fields["param_a"]),
+                                [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      // temperature at level above boundary layer
+      double t_bl = (-constants::grav / constants::rd) *
+             (heightLevelsView(jn, blindex + 1) - heightLevelsView(jn, blindex)) /
+             log(pressureLevelsView(jn, blindex + 1) / pressureLevelsView(jn, blindex));
 
-    t_bl = t_bl / (1.0 + constants::c_virtual * specificHumidityView(jn, blindex));
+      t_bl = t_bl / (1.0 + constants::c_virtual * specificHumidityView(jn, blindex));
 
-    t_msh = t_bl + constants::Lclr * (heightView(jn, blindex) - heightLevelsView(jn, 0));
+      // temperature at model surface height
+      const double t_msh = t_bl + constants::Lclr *
+                           (heightView(jn, blindex) - heightLevelsView(jn, 0));
 
-    param_aView(jn, 0) = heightLevelsView(jn, 0) + t_msh / constants::Lclr;
-    param_bView(jn, 0) = t_msh / (pow(pressureLevelsView(jn, 0), exp_pmsh) * constants::Lclr);
-  }
+      param_aView(jn, 0) = heightLevelsView(jn, 0) + t_msh / constants::Lclr;
+      param_bView(jn, 0) = t_msh / (pow(pressureLevelsView(jn, 0), exp_pmsh) * constants::Lclr);
+    }
+  });
 
   oops::Log::trace() << "[evalParamAParamB()] ... exit" << std::endl;
 
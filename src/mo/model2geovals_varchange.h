@@ -70,6 +70,19 @@ bool evalRatioToMt(atlas::FieldSet & fields);
 ///
 bool evalSpecificHumidity(atlas::FieldSet & fields);
 
+/// \brief function to evaluate the 'total mass of moist air' and the specific
+/// quantities derived from it in a single sweep:
+///   m_t = (1 + m_v + m_ci + m_cl + m_r)
+///   q = m_v/m_t, qci = m_ci/m_t, qcl = m_cl/m_t, qrain = m_r/m_t
+/// Each output ('m_t', 'specific_humidity',
+/// 'mass_content_of_cloud_ice_in_atmosphere_layer',
+/// 'mass_content_of_cloud_liquid_water_in_atmosphere_layer', 'qrain') is only
+/// evaluated if it is present in the fieldset. The results are identical to
+/// calling evalTotalMassMoistAir followed by the individual evalRatioToMt functions.
+/// The fields are double or float (all of the value type of 'm_v').
+///
+bool evalMoisturePartition(atlas::FieldSet & fields);
+
 /// \brief function to evaluate the 'relative humidity':
 ///   rh = q/qsat*100
 /// where ...
@@ -0,0 +1,137 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifdef VADER_SHARED_TABLES
+#include <mpi.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "eckit/mpi/Comm.h"
+
+#include "mo/node_shared_memory.h"
+
+#include "oops/util/Logger.h"
+
+namespace mo {
+namespace functions {
+
+namespace {
+constexpr std::size_t sharedAlignment = 64;
+
+void sharedMemoryError(const std::string & message) {
+  oops::Log::error() << "ERROR - NodeSharedMemory: " << message << std::endl;
+  throw std::runtime_error("NodeSharedMemory: " + message);
+}
+
+#ifdef VADER_SHARED_TABLES
+void checkMPI(const int err, const char * call) {
+  if (err != MPI_SUCCESS) sharedMemoryError(std::string(call) + " failed with error code " +
+                                            std::to_string(err));
+}
+#endif
+}  // namespace
+
+struct NodeSharedMemory::Impl {
+#ifdef VADER_SHARED_TABLES
+  MPI_Comm node = MPI_COMM_NULL;     // the tasks of the node
+  MPI_Comm leaders = MPI_COMM_NULL;  // the first tasks of the nodes (null on the others)
+#endif
+  int nodeSize = 1;
+  int nodeRank = 0;
+};
+
+bool NodeSharedMemory::available() {
+#ifdef VADER_SHARED_TABLES
+  return true;
+#else
+  return false;
+#endif
+}
+
+NodeSharedMemory::NodeSharedMemory(const eckit::mpi::Comm & comm) : impl_(new Impl()) {
+  oops::Log::trace() << "[NodeSharedMemory::NodeSharedMemory()] starting ..." << std::endl;
+#ifdef VADER_SHARED_TABLES
+  const MPI_Comm world = MPI_Comm_f2c(comm.communicator());
+  checkMPI(MPI_Comm_split_type(world, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &impl_->node),
+           "MPI_Comm_split_type");
+  checkMPI(MPI_Comm_size(impl_->node, &impl_->nodeSize), "MPI_Comm_size");
+  checkMPI(MPI_Comm_rank(impl_->node, &impl_->nodeRank), "MPI_Comm_rank");
+  // Keyed by rank, so the first task of comm is the first leader
+  checkMPI(MPI_Comm_split(world, impl_->nodeRank == 0 ? 0 : MPI_UNDEFINED, 0, &impl_->leaders),
+           "MPI_Comm_split");
+  oops::Log::debug() << "NodeSharedMemory: " << impl_->nodeSize << " tasks on the node of "
+                     << comm.name() << " task " << comm.rank() << std::endl;
+#else
+  sharedMemoryError("vader was built without ENABLE_VADER_SHARED_TABLES");
+#endif
+  oops::Log::trace() << "[NodeSharedMemory::NodeSharedMemory()] ... exit" << std::endl;
+}
+
+NodeSharedMemory::~NodeSharedMemory() {
+#ifdef VADER_SHARED_TABLES
+  // The communicators cannot be freed once MPI is finalized (see the class comment)
+  int finalized = 0;
+  MPI_Finalized(&finalized);
+  if (!finalized) {
+    if (impl_->leaders != MPI_COMM_NULL) MPI_Comm_free(&impl_->leaders);
+    if (impl_->node != MPI_COMM_NULL) MPI_Comm_free(&impl_->node);
+  }
+#endif
+}
+
+std::size_t NodeSharedMemory::nodeSize() const {return impl_->nodeSize;}
+std::size_t NodeSharedMemory::nodeRank() const {return impl_->nodeRank;}
+
+const double * NodeSharedMemory::allocate(const std::size_t size,
+                                          const std::function<void(double *)> & fill) const {
+#ifdef VADER_SHARED_TABLES
+  // Allocated on the first task of the node, with room to align the values
+  const MPI_Aint bytes = impl_->nodeRank == 0 ?
+                         static_cast<MPI_Aint>(size * sizeof(double) + sharedAlignment) : 0;
+  double * local = nullptr;
+  MPI_Win win;
+  checkMPI(MPI_Win_allocate_shared(bytes, sizeof(double), MPI_INFO_NULL, impl_->node,
+                                   &local, &win), "MPI_Win_allocate_shared");
+  MPI_Aint sharedBytes = 0;
+  int dispUnit = 0;
+  char * shared = nullptr;
+  checkMPI(MPI_Win_shared_query(win, 0, &sharedBytes, &dispUnit, &shared),
+           "MPI_Win_shared_query");
+  // The window is mapped at the same offset within a page on all the tasks, so
+  // they all align to the same element
+  const std::uintptr_t misalignment = reinterpret_cast<std::uintptr_t>(shared) %
+                                      sharedAlignment;
+  double * values = reinterpret_cast<double *>(
+                      shared + (misalignment == 0 ? 0 : sharedAlignment - misalignment));
+
+  // A passive target epoch that stays open: the values are only read once filled
+  checkMPI(MPI_Win_lock_all(MPI_MODE_NOCHECK, win), "MPI_Win_lock_all");
+  if (impl_->leaders != MPI_COMM_NULL) {
+    int leaderRank = 0;
+    checkMPI(MPI_Comm_rank(impl_->leaders, &leaderRank), "MPI_Comm_rank");
+    if (leaderRank == 0) fill(values);
+    checkMPI(MPI_Bcast(values, static_cast<int>(size), MPI_DOUBLE, 0, impl_->leaders),
+             "MPI_Bcast");
+  }
+  checkMPI(MPI_Win_sync(win), "MPI_Win_sync");
+  checkMPI(MPI_Barrier(impl_->node), "MPI_Barrier");
+  checkMPI(MPI_Win_sync(win), "MPI_Win_sync");
+  return values;
+#else
+  sharedMemoryError("vader was built without ENABLE_VADER_SHARED_TABLES");
+  return nullptr;
+#endif
+}
+
+}  // namespace functions
+}  // namespace mo
@@ -0,0 +1,63 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include "eckit/mpi/Comm.h"
+
+namespace mo {
+namespace functions {
+
+/// \brief allocates read-only arrays of doubles in MPI-3 shared memory windows, one
+/// copy per node
+///
+/// \details The tasks of the communicator are split into their nodes
+/// (MPI_COMM_TYPE_SHARED). An array is allocated on the first task of each node,
+/// in a window that the other tasks of the node map (MPI_Win_allocate_shared), and
+/// is filled once per job: by the first task of the communicator, then broadcast to
+/// the first tasks of the other nodes. The construction and allocate are collective
+/// over the communicator.
+///
+/// The windows are never freed: the arrays are process-wide immutable tables, that
+/// are released by MPI_Finalize. (Freeing a window is collective, and the static
+/// caches that hold the arrays are destroyed in no particular order, after
+/// MPI_Finalize.)
+///
+/// The windows need vader built with ENABLE_VADER_SHARED_TABLES; without it
+/// available() is false and the construction throws.
+///
+class NodeSharedMemory {
+ public:
+  static bool available();
+
+  explicit NodeSharedMemory(const eckit::mpi::Comm & comm);
+  ~NodeSharedMemory();
+
+  NodeSharedMemory(const NodeSharedMemory &) = delete;
+  NodeSharedMemory & operator=(const NodeSharedMemory &) = delete;
+
+  /// \brief number of tasks on the node of this task, and its rank among them
+  std::size_t nodeSize() const;
+  std::size_t nodeRank() const;
+
+  /// \brief allocates size doubles, shared by the tasks of the node and 64 byte
+  /// aligned; fill(values) is only called on the first task of the communicator.
+  /// The returned pointer is valid for the lifetime of the process.
+  const double * allocate(const std::size_t size,
+                          const std::function<void(double *)> & fill) const;
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace functions
+}  // namespace mo
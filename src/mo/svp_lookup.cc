@@ -0,0 +1,36 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <string>
+#include <vector>
+
+#include "mo/constants.h"
+#include "mo/lookup_cache.h"
+#include "mo/svp_lookup.h"
+
+#include "oops/util/Logger.h"
+
+namespace mo {
+namespace svp {
+
+const LookupTables & LookupTables::instance() {
+  static const LookupTables tables;
+  return tables;
+}
+
+LookupTables::LookupTables() {
+  oops::Log::trace() << "[svp::LookupTables()] loading "
+                     << constants::commonVarChangeFilePath << std::endl;
+  const std::vector<std::string> vars{"svp", "dlsvp", "svpW", "dlsvpW"};
+  for (std::size_t t = 0; t < nTables; ++t) {
+    tables_[t] = functions::LookUpCache::instance().getLookUp(
+                   constants::commonVarChangeFilePath, vars[t], tableLength);
+  }
+}
+
+}  // namespace svp
+}  // namespace mo
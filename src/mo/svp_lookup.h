@@ -0,0 +1,73 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include "mo/constants.h"
+#include "mo/lookup_cache.h"
+
+namespace mo {
+namespace svp {
+
+/// \brief tables held in the saturation vapour pressure lookup file
+enum class Table : std::size_t {
+  svp = 0,     // saturation vapour pressure wrt ice below 0 C [Pa]
+  dlsvp = 1,   // temperature gradient of svp [Pa/K]
+  svpW = 2,    // saturation vapour pressure wrt water [Pa]
+  dlsvpW = 3   // temperature gradient of svpW [Pa/K]
+};
+
+static constexpr std::size_t nTables = 4;
+static constexpr std::size_t tableLength =
+  static_cast<std::size_t>(constants::svpLookUpLength);
+
+/// \brief process-wide, immutable svp lookup tables
+///
+/// \details The tables are loaded from constants::commonVarChangeFilePath through
+/// the LookUpCache the first time instance() is called (the initialisation is
+/// thread-safe) and are never modified afterwards, so they can be read concurrently
+/// without locking. They are views of the cached tables, not copies: with a table
+/// file or node shared tables (see mo/lookup_cache.h) the kernels read the mapped or
+/// node shared values. Each table is cache-line aligned to allow aligned vector loads.
+///
+class LookupTables {
+ public:
+  static const LookupTables & instance();
+
+  const double * table(const Table t) const {
+    return tables_[static_cast<std::size_t>(t)].data();
+  }
+
+ private:
+  LookupTables();
+
+  std::array<functions::LookUpCache::Table, nTables> tables_;
+};
+
+/// \brief interpolates a lookup table to temperature tVal [K]
+///
+/// \details The temperature is normalised to a fractional table index and
+/// clamped to the table bounds; the index below it (never the last entry)
+/// and the linear interpolation weight are derived from it. Only
+/// per-call locals and min/max operations are used, so the function is safe to
+/// call from threaded loops and allows the compiler to vectorise them.
+///
+inline double lookup(const double * table, const double tVal) {
+  constexpr double tMax = static_cast<double>(tableLength - 1);
+  const double t = std::min(std::max((tVal - constants::TLoBound) / constants::Tinc, 0.0),
+                            tMax);
+  const std::size_t i = std::min(static_cast<std::size_t>(t), tableLength - 2);
+  const double w = t - static_cast<double>(i);
+  return w * table[i + 1] + (1 - w) * table[i];
+}
+
+}  // namespace svp
+}  // namespace mo
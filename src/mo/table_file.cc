@@ -0,0 +1,198 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mo/table_file.h"
+
+#include "oops/util/Logger.h"
+
+namespace mo {
+namespace functions {
+
+namespace {
+const char tableFileMagic[8] = {'V', 'A', 'D', 'E', 'R', 'T', 'A', 'B'};
+constexpr std::uint32_t tableFileVersion = 1;
+constexpr std::uint32_t byteOrderMark = 0x01020304;
+
+std::size_t alignUp(const std::size_t bytes) {
+  return (bytes + TableFile::alignment - 1) / TableFile::alignment * TableFile::alignment;
+}
+
+std::size_t tableLength(const std::size_t dim1, const std::size_t dim2) {
+  return dim2 == 0 ? dim1 : dim1 * dim2;
+}
+
+void tableFileError(const std::string & path, const std::string & message) {
+  oops::Log::error() << "ERROR - table file " << path << ": " << message << std::endl;
+  throw std::runtime_error("table file " + path + ": " + message);
+}
+}  // namespace
+
+struct TableFile::Header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byteOrder;
+  std::uint64_t nTables;
+  char reserved[40];
+};
+
+struct TableFile::Entry {
+  char source[48];  // maxNameLength characters and the terminating null
+  char name[48];
+  std::uint64_t dim1;
+  std::uint64_t dim2;
+  std::uint64_t offset;  // of the values, in bytes from the start of the file
+  std::uint64_t reserved;
+};
+
+std::string tableSourceName(const std::string & path) {
+  const std::size_t slash = path.find_last_of('/');
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+TableFile::TableFile(const std::string & path) : path_(path) {
+  oops::Log::trace() << "[TableFile::TableFile()] mapping " << path << std::endl;
+  static_assert(sizeof(Header) == alignment, "the table file header is 64 bytes");
+  static_assert(sizeof(Entry) == 2 * alignment, "table file directory entries are 128 bytes");
+
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) tableFileError(path, "cannot be opened");
+  struct stat status;
+  if (::fstat(fd, &status) != 0) {
+    ::close(fd);
+    tableFileError(path, "cannot be stat'ed");
+  }
+  bytes_ = static_cast<std::size_t>(status.st_size);
+  if (bytes_ < sizeof(Header)) {
+    ::close(fd);
+    tableFileError(path, "is too short to be a table file");
+  }
+  data_ = ::mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping stays valid once the descriptor is closed
+  ::close(fd);
+  if (data_ == MAP_FAILED) {
+    data_ = nullptr;
+    tableFileError(path, "cannot be mapped");
+  }
+
+  const Header & header = *static_cast<const Header *>(data_);
+  std::string message;
+  if (std::memcmp(header.magic, tableFileMagic, sizeof(tableFileMagic)) != 0) {
+    message = "is not a table file";
+  } else if (header.version != tableFileVersion) {
+    message = "has format version " + std::to_string(header.version) + ", expected " +
+              std::to_string(tableFileVersion);
+  } else if (header.byteOrder != byteOrderMark) {
+    message = "was written on a machine of the other byte order";
+  } else if (bytes_ < sizeof(Header) + header.nTables * sizeof(Entry)) {
+    message = "is truncated (directory)";
+  } else {
+    nTables_ = header.nTables;
+    const Entry * entries = reinterpret_cast<const Entry *>(&header + 1);
+    for (std::size_t jt = 0; jt < nTables_ && message.empty(); ++jt) {
+      const Entry & entry = entries[jt];
+      if (entry.source[maxNameLength] != '\0' || entry.name[maxNameLength] != '\0' ||
+          entry.offset % alignment != 0 ||
+          entry.offset + tableLength(entry.dim1, entry.dim2) * sizeof(double) > bytes_) {
+        message = "has an invalid directory entry";
+      }
+    }
+  }
+  if (!message.empty()) {
+    ::munmap(data_, bytes_);
+    data_ = nullptr;
+    tableFileError(path, message);
+  }
+  oops::Log::debug() << "TableFile: mapped " << nTables_ << " tables from " << path
+                     << std::endl;
+}
+
+TableFile::~TableFile() {
+  if (data_ != nullptr) ::munmap(data_, bytes_);
+}
+
+const double * TableFile::find(const std::string & sourcePath, const std::string & name,
+                               const std::size_t dim1, const std::size_t dim2) const {
+  const std::string source = tableSourceName(sourcePath);
+  const Entry * entries = reinterpret_cast<const Entry *>(
+                            static_cast<const Header *>(data_) + 1);
+  for (std::size_t jt = 0; jt < nTables_; ++jt) {
+    const Entry & entry = entries[jt];
+    if (source == entry.source && name == entry.name &&
+        entry.dim1 == dim1 && entry.dim2 == dim2) {
+      return reinterpret_cast<const double *>(static_cast<const char *>(data_) +
+                                              entry.offset);
+    }
+  }
+  return nullptr;
+}
+
+void TableFile::write(const std::string & path, const std::vector<TableFileEntry> & tables) {
+  oops::Log::trace() << "[TableFile::write()] writing " << path << std::endl;
+  Header header{};
+  std::memcpy(header.magic, tableFileMagic, sizeof(tableFileMagic));
+  header.version = tableFileVersion;
+  header.byteOrder = byteOrderMark;
+  header.nTables = tables.size();
+
+  std::vector<Entry> entries(tables.size(), Entry{});
+  std::size_t offset = alignUp(sizeof(Header) + tables.size() * sizeof(Entry));
+  for (std::size_t jt = 0; jt < tables.size(); ++jt) {
+    const TableFileEntry & table = tables[jt];
+    if (table.source.size() > maxNameLength || table.name.size() > maxNameLength) {
+      tableFileError(path, "the names of " + table.source + ":" + table.name +
+                           " are longer than " + std::to_string(maxNameLength) +
+                           " characters");
+    }
+    if (table.values.size() != tableLength(table.dim1, table.dim2)) {
+      tableFileError(path, "the size of " + table.source + ":" + table.name +
+                           " does not match its dimensions");
+    }
+    std::strncpy(entries[jt].source, table.source.c_str(), maxNameLength);
+    std::strncpy(entries[jt].name, table.name.c_str(), maxNameLength);
+    entries[jt].dim1 = table.dim1;
+    entries[jt].dim2 = table.dim2;
+    entries[jt].offset = offset;
+    offset = alignUp(offset + table.values.size() * sizeof(double));
+  }
+
+  // Written next to path then renamed, so that a file being mapped is never partial
+  const std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out) tableFileError(tmpPath, "cannot be created");
+    const std::vector<char> padding(alignment, 0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(Entry));
+    std::size_t written = sizeof(Header) + entries.size() * sizeof(Entry);
+    for (std::size_t jt = 0; jt < tables.size(); ++jt) {
+      out.write(padding.data(), entries[jt].offset - written);
+      out.write(reinterpret_cast<const char *>(tables[jt].values.data()),
+                tables[jt].values.size() * sizeof(double));
+      written = entries[jt].offset + tables[jt].values.size() * sizeof(double);
+    }
+    if (!out) tableFileError(tmpPath, "cannot be written");
+  }
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    tableFileError(path, "cannot be renamed from " + tmpPath);
+  }
+}
+
+}  // namespace functions
+}  // namespace mo
@@ -0,0 +1,83 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mo {
+namespace functions {
+
+/// \brief a table to be written to a TableFile
+struct TableFileEntry {
+  std::string source;    // file name (without directory) of the netcdf file of the table
+  std::string name;      // variable name in the netcdf file
+  std::size_t dim1 = 0;
+  std::size_t dim2 = 0;  // 0 for a 1D table
+  std::vector<double> values;
+};
+
+/// \brief read-only memory mapping of a binary lookup table file
+///
+/// \details The binary format holds precomputed copies of lookup tables read from
+/// netcdf files, so that they can be mapped rather than read through the netcdf
+/// library. The file is:
+/// * a 64 byte header: the magic "VADERTAB", the format version, a byte order mark
+///   (the file is in the byte order of the machine that wrote it, and is rejected
+///   on a machine of the other order), the number of tables
+/// * a directory of 128 byte entries: the source file name and variable name
+///   (null-terminated, at most 47 characters each), the dimensions and the offset
+///   of the values
+/// * the values of each table, as doubles in the order the netcdf readers return
+///   them (column major for a 2D table), each table starting on a 64 byte boundary
+///
+/// Tables are looked up by the file name of their netcdf file (the directory
+/// is ignored), their variable name and their dimensions. The mapping is shared and
+/// read-only, so the MPI tasks of a node that map the same file share its pages in
+/// the page cache, and the values are read on first touch.
+///
+class TableFile {
+ public:
+  /// \brief maps path; throws if it cannot be mapped or is not a table file
+  explicit TableFile(const std::string & path);
+  ~TableFile();
+
+  TableFile(const TableFile &) = delete;
+  TableFile & operator=(const TableFile &) = delete;
+
+  const std::string & path() const {return path_;}
+  std::size_t size() const {return nTables_;}
+
+  /// \brief values of the table (dim1 x dim2 values; dim2 is 0 for a 1D table), or
+  /// nullptr if the file does not hold it
+  const double * find(const std::string & sourcePath, const std::string & name,
+                      const std::size_t dim1, const std::size_t dim2) const;
+
+  /// \brief writes the tables to a new table file at path; throws on failure
+  static void write(const std::string & path, const std::vector<TableFileEntry> & tables);
+
+  static constexpr std::size_t alignment = 64;
+  static constexpr std::size_t maxNameLength = 47;
+
+ private:
+  struct Header;
+  struct Entry;
+
+  std::string path_;
+  void * data_ = nullptr;
+  std::size_t bytes_ = 0;
+  std::size_t nTables_ = 0;
+};
+
+/// \brief file name, without its directory, of path
+std::string tableSourceName(const std::string & path);
+
+}  // namespace functions
+}  // namespace mo
@@ -0,0 +1,517 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "atlas/array/MakeView.h"
+#include "atlas/field/Field.h"
+
+#include "eckit/exception/Exceptions.h"
+
+#include "mo/constants.h"
+#include "mo/functions.h"
+#include "mo/trajectory_coefficients.h"
+
+#include "vader/Instrumentation.h"
+
+using atlas::array::make_view;
+using atlas::idx_t;
+
+namespace mo {
+
+namespace {
+// Names of the coefficients (the factor of the increment they multiply)
+const char airTemperatureTheta[] = "air temperature: theta";
+const char airTemperatureExner[] = "air temperature: exner";
+const char airTemperatureExnerAbove[] = "air temperature: exner above";
+const char dryAirDensityExner[] = "dry air density: exner";
+const char dryAirDensityTheta[] = "dry air density: theta";
+const char dryAirDensityThetaBelow[] = "dry air density: theta below";
+const char muRow1Column1[] = "muRow1Column1";
+const char muRow1Column2[] = "muRow1Column2";
+const char muRow2Column1[] = "muRow2Column1";
+const char muRow2Column2[] = "muRow2Column2";
+const char qtThetaThetavToTheta[] = "qt theta: thetav to theta";
+const char qtThetaMuToTheta[] = "qt theta: mu to theta";
+const char qtThetaMuToQt[] = "qt theta: mu to qt";
+const char qtThetaThetavToQt[] = "qt theta: thetav to qt";
+
+bool hasFields(const atlas::FieldSet & fields, const std::vector<std::string> & names) {
+  for (const auto & name : names) {
+    if (!fields.has(name)) return false;
+  }
+  return true;
+}
+
+template<typename T>
+void setupAirTemperature(const atlas::FieldSet & augStateFlds,
+                         TrajectoryCoefficients<T> & coefficients) {
+  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
+  const auto hView = make_view<const double, 2>(augStateFlds["height"]);
+  const auto exnerView = make_view<const double, 2>(augStateFlds["exner_levels_minus_one"]);
+  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
+
+  const idx_t nColumns = coefficients.nColumns();
+  const idx_t lvls = augStateFlds["potential_temperature"].levels();
+  const idx_t lvlsm1 = lvls - 1;
+  T * const thetaCoeff = coefficients.add(airTemperatureTheta, lvls);
+  T * const exnerCoeff = coefficients.add(airTemperatureExner, lvls);
+  T * const exnerAboveCoeff = coefficients.add(airTemperatureExnerAbove, lvls);
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    // t' = (((h - hl) exner(+1) + (hl(+1) - h) exner) theta' +
+    //       ((h - hl) exner'(+1) + (hl(+1) - h) exner') theta) / (hl(+1) - hl)
+    for (idx_t jl = 0; jl < lvlsm1; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        const double dz = hlView(jn, jl + 1) - hlView(jn, jl);
+        const double wAbove = hView(jn, jl) - hlView(jn, jl);
+        const double wBelow = hlView(jn, jl + 1) - hView(jn, jl);
+        thetaCoeff[jl * nColumns + jn] =
+          (wAbove * exnerView(jn, jl + 1) + wBelow * exnerView(jn, jl)) / dz;
+        exnerAboveCoeff[jl * nColumns + jn] = wAbove * thetaView(jn, jl) / dz;
+        exnerCoeff[jl * nColumns + jn] = wBelow * thetaView(jn, jl) / dz;
+      }
+    }
+    // The exner above the model top is in hydrostatic balance; its increment is
+    // folded into the coefficients of the top level
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      const double exnerTopVal = exnerView(jn, lvlsm1) -
+        (constants::grav * (hlView(jn, lvls) - hlView(jn, lvlsm1))) /
+        (constants::cp * thetaView(jn, lvlsm1));
+      const double dz = hlView(jn, lvls) - hlView(jn, lvlsm1);
+      const double wAbove = hView(jn, lvlsm1) - hlView(jn, lvlsm1);
+      const double wBelow = hlView(jn, lvls) - hView(jn, lvlsm1);
+      const double exnerTopCoeff = wAbove * thetaView(jn, lvlsm1) / dz;
+      thetaCoeff[lvlsm1 * nColumns + jn] =
+        (wAbove * exnerTopVal + wBelow * exnerView(jn, lvlsm1)) / dz +
+        exnerTopCoeff * (exnerView(jn, lvlsm1) - exnerTopVal) / thetaView(jn, lvlsm1);
+      exnerCoeff[lvlsm1 * nColumns + jn] = exnerTopCoeff + wBelow * thetaView(jn, lvlsm1) / dz;
+      exnerAboveCoeff[lvlsm1 * nColumns + jn] = 0.0;
+    }
+  });
+}
+
+template<typename T>
+void setupDryAirDensity(const atlas::FieldSet & augStateFlds,
+                        TrajectoryCoefficients<T> & coefficients) {
+  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
+  const auto hView = make_view<const double, 2>(augStateFlds["height"]);
+  const auto exnerView = make_view<const double, 2>(augStateFlds["exner_levels_minus_one"]);
+  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
+  const auto rhoView = make_view<const double, 2>(augStateFlds["dry_air_density_levels_minus_one"]);
+
+  const idx_t nColumns = coefficients.nColumns();
+  const idx_t levels = augStateFlds["dry_air_density_levels_minus_one"].levels();
+  T * const exnerCoeff = coefficients.add(dryAirDensityExner, levels);
+  T * const thetaCoeff = coefficients.add(dryAirDensityTheta, levels);
+  T * const thetaBelowCoeff = coefficients.add(dryAirDensityThetaBelow, levels);
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    // rho' = rho (exner' / exner - theta' / theta), theta interpolated to the rho levels
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      exnerCoeff[jn] = rhoView(jn, 0) / exnerView(jn, 0);
+      thetaCoeff[jn] = rhoView(jn, 0) / thetaView(jn, 0);
+      thetaBelowCoeff[jn] = 0.0;
+    }
+    for (idx_t jl = 1; jl < levels; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        const double wLevel = hlView(jn, jl) - hView(jn, jl-1);
+        const double wBelow = hView(jn, jl) - hlView(jn, jl);
+        const double thetaInterp = wLevel * thetaView(jn, jl) + wBelow * thetaView(jn, jl-1);
+        exnerCoeff[jl * nColumns + jn] = rhoView(jn, jl) / exnerView(jn, jl);
+        thetaCoeff[jl * nColumns + jn] = rhoView(jn, jl) * wLevel / thetaInterp;
+        thetaBelowCoeff[jl * nColumns + jn] = rhoView(jn, jl) * wBelow / thetaInterp;
+      }
+    }
+  });
+}
+
+template<typename T>
+void setupMu(const atlas::FieldSet & augState, TrajectoryCoefficients<T> & coefficients) {
+  const auto m11View = make_view<const double, 2>(augState["muRow1Column1"]);
+  const auto m12View = make_view<const double, 2>(augState["muRow1Column2"]);
+  const auto m21View = make_view<const double, 2>(augState["muRow2Column1"]);
+  const auto m22View = make_view<const double, 2>(augState["muRow2Column2"]);
+  const bool inverse = augState.has("muRecipDeterminant");
+
+  const idx_t nColumns = coefficients.nColumns();
+  const idx_t levels = augState["muRow1Column1"].levels();
+  T * const m11 = coefficients.add(muRow1Column1, levels);
+  T * const m12 = coefficients.add(muRow1Column2, levels);
+  T * const m21 = coefficients.add(muRow2Column1, levels);
+  T * const m22 = coefficients.add(muRow2Column2, levels);
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jl = 0; jl < levels; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        m11[jl * nColumns + jn] = m11View(jn, jl);
+        m12[jl * nColumns + jn] = m12View(jn, jl);
+        m21[jl * nColumns + jn] = m21View(jn, jl);
+        m22[jl * nColumns + jn] = m22View(jn, jl);
+      }
+    }
+  });
+
+  if (inverse) {
+    // The inverse matrix (Cramer's rule), with the reciprocal determinant folded in
+    const auto recipDeterView = make_view<const double, 2>(augState["muRecipDeterminant"]);
+    T * const thetavToTheta = coefficients.add(qtThetaThetavToTheta, levels);
+    T * const muToTheta = coefficients.add(qtThetaMuToTheta, levels);
+    T * const muToQt = coefficients.add(qtThetaMuToQt, levels);
+    T * const thetavToQt = coefficients.add(qtThetaThetavToQt, levels);
+    functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+          thetavToTheta[jl * nColumns + jn] = recipDeterView(jn, jl) * m11View(jn, jl);
+          muToTheta[jl * nColumns + jn] = recipDeterView(jn, jl) * m21View(jn, jl);
+          muToQt[jl * nColumns + jn] = recipDeterView(jn, jl) * m22View(jn, jl);
+          thetavToQt[jl * nColumns + jn] = recipDeterView(jn, jl) * m12View(jn, jl);
+        }
+      }
+    });
+  }
+}
+}  // namespace
+
+// ------------------------------------------------------------------------------------------------
+template<typename T>
+T * TrajectoryCoefficients<T>::add(const std::string & name, const idx_t levels) {
+  std::vector<T> & coefficient = coefficients_[name];
+  coefficient.assign(static_cast<std::size_t>(levels) * nColumns_, T(0));
+  return coefficient.data();
+}
+
+template<typename T>
+const T * TrajectoryCoefficients<T>::get(const std::string & name) const {
+  const auto it = coefficients_.find(name);
+  ASSERT_MSG(it != coefficients_.end(), "TrajectoryCoefficients: no coefficient " + name);
+  return it->second.data();
+}
+
+template<typename T>
+std::size_t TrajectoryCoefficients<T>::bytes() const {
+  std::size_t size = 0;
+  for (const auto & coefficient : coefficients_) size += coefficient.second.size();
+  return size * sizeof(T);
+}
+
+template<typename T>
+TrajectoryCoefficients<T> setupTrajectoryCoefficients(const atlas::FieldSet & augStateFlds) {
+  const vader::ScopedTiming timing("setupTrajectoryCoefficients");
+  idx_t nColumns = 0;
+  for (idx_t jf = 0; jf < augStateFlds.size(); ++jf) {
+    if (augStateFlds[jf].functionspace()) {
+      nColumns = augStateFlds[jf].shape(0);
+      break;
+    }
+  }
+  TrajectoryCoefficients<T> coefficients(nColumns);
+  const std::vector<std::string> airTemperatureFields{"height_levels", "height",
+    "exner_levels_minus_one", "potential_temperature"};
+  if (hasFields(augStateFlds, airTemperatureFields)) {
+    setupAirTemperature(augStateFlds, coefficients);
+    if (augStateFlds.has("dry_air_density_levels_minus_one")) {
+      setupDryAirDensity(augStateFlds, coefficients);
+    }
+  }
+  if (hasFields(augStateFlds, {"muRow1Column1", "muRow1Column2", "muRow2Column1",
+                               "muRow2Column2"})) {
+    setupMu(augStateFlds, coefficients);
+  }
+  return coefficients;
+}
+
+namespace precomputed {
+
+// ------------------------------------------------------------------------------------------------
+template<typename T>
+void evalAirTemperatureTL(atlas::FieldSet & incFlds,
+                          const TrajectoryCoefficients<T> & coefficients) {
+  const vader::ScopedTiming timing("precomputed::evalAirTemperatureTL");
+  const auto exnerIncView = make_view<const double, 2>(incFlds["exner_levels_minus_one"]);
+  const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
+  auto tIncView = make_view<double, 2>(incFlds["air_temperature"]);
+  const T * const thetaCoeff = coefficients.get(airTemperatureTheta);
+  const T * const exnerCoeff = coefficients.get(airTemperatureExner);
+  const T * const exnerAboveCoeff = coefficients.get(airTemperatureExnerAbove);
+
+  const idx_t nColumns = tIncView.shape(0);
+  const idx_t lvls(incFlds["air_temperature"].levels());
+  const idx_t lvlsm1 = lvls - 1;
+  ASSERT(nColumns == coefficients.nColumns());
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jl = 0; jl < lvlsm1; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        const idx_t jc = jl * nColumns + jn;
+        tIncView(jn, jl) = static_cast<double>(thetaCoeff[jc]) * thetaIncView(jn, jl) +
+                           static_cast<double>(exnerAboveCoeff[jc]) * exnerIncView(jn, jl + 1) +
+                           static_cast<double>(exnerCoeff[jc]) * exnerIncView(jn, jl);
+      }
+    }
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      const idx_t jc = lvlsm1 * nColumns + jn;
+      tIncView(jn, lvlsm1) = static_cast<double>(thetaCoeff[jc]) * thetaIncView(jn, lvlsm1) +
+                             static_cast<double>(exnerCoeff[jc]) * exnerIncView(jn, lvlsm1);
+    }
+  });
+}
+
+template<typename T>
+void evalAirTemperatureAD(atlas::FieldSet & hatFlds,
+                          const TrajectoryCoefficients<T> & coefficients) {
+  const vader::ScopedTiming timing("precomputed::evalAirTemperatureAD");
+  auto exnerHatView = make_view<double, 2>(hatFlds["exner_levels_minus_one"]);
+  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
+  auto tHatView = make_view<double, 2>(hatFlds["air_temperature"]);
+  const T * const thetaCoeff = coefficients.get(airTemperatureTheta);
+  const T * const exnerCoeff = coefficients.get(airTemperatureExner);
+  const T * const exnerAboveCoeff = coefficients.get(airTemperatureExnerAbove);
+
+  const idx_t nColumns = tHatView.shape(0);
+  const idx_t lvls(hatFlds["air_temperature"].levels());
+  const idx_t lvlsm1 = lvls - 1;
+  ASSERT(nColumns == coefficients.nColumns());
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      const idx_t jc = lvlsm1 * nColumns + jn;
+      thetaHatView(jn, lvlsm1) += static_cast<double>(thetaCoeff[jc]) * tHatView(jn, lvlsm1);
+      exnerHatView(jn, lvlsm1) += static_cast<double>(exnerCoeff[jc]) * tHatView(jn, lvlsm1);
+      tHatView(jn, lvlsm1) = 0.0;
+    }
+    for (idx_t jl = lvls - 2; jl >= 0; --jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        const idx_t jc = jl * nColumns + jn;
+        thetaHatView(jn, jl) += static_cast<double>(thetaCoeff[jc]) * tHatView(jn, jl);
+        exnerHatView(jn, jl + 1) += static_cast<double>(exnerAboveCoeff[jc]) * tHatView(jn, jl);
+        exnerHatView(jn, jl) += static_cast<double>(exnerCoeff[jc]) * tHatView(jn, jl);
+        tHatView(jn, jl) = 0.0;
+      }
+    }
+  });
+}
+
+// ------------------------------------------------------------------------------------------------
+template<typename T>
+void evalDryAirDensityTL(atlas::FieldSet & incFlds,
+                         const TrajectoryCoefficients<T> & coefficients) {
+  const vader::ScopedTiming timing("precomputed::evalDryAirDensityTL");
+  const auto exnerIncView = make_view<const double, 2>(incFlds["exner_levels_minus_one"]);
+  const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
+  auto rhoIncView = make_view<double, 2>(incFlds["dry_air_density_levels_minus_one"]);
+  const T * const exnerCoeff = coefficients.get(dryAirDensityExner);
+  const T * const thetaCoeff = coefficients.get(dryAirDensityTheta);
+  const T * const thetaBelowCoeff = coefficients.get(dryAirDensityThetaBelow);
+
+  const idx_t nColumns = rhoIncView.shape(0);
+  const idx_t levels = incFlds["dry_air_density_levels_minus_one"].levels();
+  ASSERT(nColumns == coefficients.nColumns());
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jl = 1; jl < levels; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        const idx_t jc = jl * nColumns + jn;
+        rhoIncView(jn, jl) = static_cast<double>(exnerCoeff[jc]) * exnerIncView(jn, jl) -
+                             static_cast<double>(thetaCoeff[jc]) * thetaIncView(jn, jl) -
+                             static_cast<double>(thetaBelowCoeff[jc]) * thetaIncView(jn, jl-1);
+      }
+    }
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      rhoIncView(jn, 0) = static_cast<double>(exnerCoeff[jn]) * exnerIncView(jn, 0) -
+                          static_cast<double>(thetaCoeff[jn]) * thetaIncView(jn, 0);
+    }
+  });
+}
+
+template<typename T>
+void evalDryAirDensityAD(atlas::FieldSet & hatFlds,
+                         const TrajectoryCoefficients<T> & coefficients) {
+  const vader::ScopedTiming timing("precomputed::evalDryAirDensityAD");
+  auto exnerHatView = make_view<double, 2>(hatFlds["exner_levels_minus_one"]);
+  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
+  auto rhoHatView = make_view<double, 2>(hatFlds["dry_air_density_levels_minus_one"]);
+  const T * const exnerCoeff = coefficients.get(dryAirDensityExner);
+  const T * const thetaCoeff = coefficients.get(dryAirDensityTheta);
+  const T * const thetaBelowCoeff = coefficients.get(dryAirDensityThetaBelow);
+
+  const idx_t nColumns = rhoHatView.shape(0);
+  const idx_t levels = hatFlds["dry_air_density_levels_minus_one"].levels();
+  ASSERT(nColumns == coefficients.nColumns());
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+      exnerHatView(jn, 0) += static_cast<double>(exnerCoeff[jn]) * rhoHatView(jn, 0);
+      thetaHatView(jn, 0) -= static_cast<double>(thetaCoeff[jn]) * rhoHatView(jn, 0);
+      rhoHatView(jn, 0) = 0.0;
+    }
+    for (idx_t jl = levels-1; jl >= 1; --jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        const idx_t jc = jl * nColumns + jn;
+        exnerHatView(jn, jl) += static_cast<double>(exnerCoeff[jc]) * rhoHatView(jn, jl);
+        thetaHatView(jn, jl) -= static_cast<double>(thetaCoeff[jc]) * rhoHatView(jn, jl);
+        thetaHatView(jn, jl-1) -= static_cast<double>(thetaBelowCoeff[jc]) * rhoHatView(jn, jl);
+        rhoHatView(jn, jl) = 0.0;
+      }
+    }
+  });
+}
+
+// ------------------------------------------------------------------------------------------------
+template<typename T>
+void evalMuThetavTL(atlas::FieldSet & incFlds, const TrajectoryCoefficients<T> & coefficients) {
+  const vader::ScopedTiming timing("precomputed::evalMuThetavTL");
+  const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
+  const auto qtIncView = make_view<const double, 2>(incFlds["qt"]);
+  auto muIncView = make_view<double, 2>(incFlds["mu"]);
+  auto thetavIncView = make_view<double, 2>(incFlds["virtual_potential_temperature"]);
+  const T * const m11 = coefficients.get(muRow1Column1);
+  const T * const m12 = coefficients.get(muRow1Column2);
+  const T * const m21 = coefficients.get(muRow2Column1);
+  const T * const m22 = coefficients.get(muRow2Column2);
+
+  const idx_t nColumns = incFlds["mu"].shape(0);
+  const idx_t levels = incFlds["mu"].levels();
+  ASSERT(nColumns == coefficients.nColumns());
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jl = 0; jl < levels; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        const idx_t jc = jl * nColumns + jn;
+        muIncView(jn, jl) = static_cast<double>(m11[jc]) * qtIncView(jn, jl)
+                          + static_cast<double>(m12[jc]) * thetaIncView(jn, jl);
+        thetavIncView(jn, jl) = static_cast<double>(m21[jc]) * qtIncView(jn, jl)
+                              + static_cast<double>(m22[jc]) * thetaIncView(jn, jl);
+      }
+    }
+  });
+}
+
+template<typename T>
+void evalMuThetavAD(atlas::FieldSet & hatFlds, const TrajectoryCoefficients<T> & coefficients) {
+  const vader::ScopedTiming timing("precomputed::evalMuThetavAD");
+  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
+  auto qtHatView = make_view<double, 2>(hatFlds["qt"]);
+  auto muHatView = make_view<double, 2>(hatFlds["mu"]);
+  auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
+  const T * const m11 = coefficients.get(muRow1Column1);
+  const T * const m12 = coefficients.get(muRow1Column2);
+  const T * const m21 = coefficients.get(muRow2Column1);
+  const T * const m22 = coefficients.get(muRow2Column2);
+
+  const idx_t nColumns = hatFlds["mu"].shape(0);
+  const idx_t levels = hatFlds["mu"].levels();
+  ASSERT(nColumns == coefficients.nColumns());
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jl = 0; jl < levels; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        const idx_t jc = jl * nColumns + jn;
+        thetaHatView(jn, jl) += static_cast<double>(m22[jc]) * thetavHatView(jn, jl);
+        qtHatView(jn, jl) += static_cast<double>(m21[jc]) * thetavHatView(jn, jl);
+        thetaHatView(jn, jl) += static_cast<double>(m12[jc]) * muHatView(jn, jl);
+        qtHatView(jn, jl) += static_cast<double>(m11[jc]) * muHatView(jn, jl);
+        thetavHatView(jn, jl) = 0.0;
+        muHatView(jn, jl) = 0.0;
+      }
+    }
+  });
+}
+
+// ------------------------------------------------------------------------------------------------
+template<typename T>
+void evalQtThetaTL(atlas::FieldSet & incFlds, const TrajectoryCoefficients<T> & coefficients) {
+  const vader::ScopedTiming timing("precomputed::evalQtThetaTL");
+  const auto muIncView = make_view<const double, 2>(incFlds["mu"]);
+  const auto thetavIncView = make_view<const double, 2>(incFlds["virtual_potential_temperature"]);
+  auto qtIncView = make_view<double, 2>(incFlds["qt"]);
+  auto thetaIncView = make_view<double, 2>(incFlds["potential_temperature"]);
+  const T * const thetavToTheta = coefficients.get(qtThetaThetavToTheta);
+  const T * const muToTheta = coefficients.get(qtThetaMuToTheta);
+  const T * const muToQt = coefficients.get(qtThetaMuToQt);
+  const T * const thetavToQt = coefficients.get(qtThetaThetavToQt);
+
+  const idx_t nColumns = incFlds["mu"].shape(0);
+  const idx_t levels = incFlds["mu"].levels();
+  ASSERT(nColumns == coefficients.nColumns());
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jl = 0; jl < levels; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        const idx_t jc = jl * nColumns + jn;
+        thetaIncView(jn, jl) = static_cast<double>(thetavToTheta[jc]) * thetavIncView(jn, jl)
+                             - static_cast<double>(muToTheta[jc]) * muIncView(jn, jl);
+        qtIncView(jn, jl) = static_cast<double>(muToQt[jc]) * muIncView(jn, jl)
+                          - static_cast<double>(thetavToQt[jc]) * thetavIncView(jn, jl);
+      }
+    }
+  });
+}
+
+template<typename T>
+void evalQtThetaAD(atlas::FieldSet & hatFlds, const TrajectoryCoefficients<T> & coefficients) {
+  const vader::ScopedTiming timing("precomputed::evalQtThetaAD");
+  auto qtHatView = make_view<double, 2>(hatFlds["qt"]);
+  auto muHatView = make_view<double, 2>(hatFlds["mu"]);
+  auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
+  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
+  const T * const thetavToTheta = coefficients.get(qtThetaThetavToTheta);
+  const T * const muToTheta = coefficients.get(qtThetaMuToTheta);
+  const T * const muToQt = coefficients.get(qtThetaMuToQt);
+  const T * const thetavToQt = coefficients.get(qtThetaThetavToQt);
+
+  const idx_t nColumns = hatFlds["mu"].shape(0);
+  const idx_t levels = hatFlds["mu"].levels();
+  ASSERT(nColumns == coefficients.nColumns());
+
+  functions::forEachColumnBlock(nColumns, [&](const idx_t jnBegin, const idx_t jnEnd) {
+    for (idx_t jl = 0; jl < levels; ++jl) {
+      for (idx_t jn = jnBegin; jn < jnEnd; ++jn) {
+        const idx_t jc = jl * nColumns + jn;
+        thetavHatView(jn, jl) += static_cast<double>(thetavToTheta[jc]) * thetaHatView(jn, jl);
+        muHatView(jn, jl) -= static_cast<double>(muToTheta[jc]) * thetaHatView(jn, jl);
+        thetavHatView(jn, jl) -= static_cast<double>(thetavToQt[jc]) * qtHatView(jn, jl);
+        muHatView(jn, jl) += static_cast<double>(muToQt[jc]) * qtHatView(jn, jl);
+        thetaHatView(jn, jl) = 0.0;
+        qtHatView(jn, jl) = 0.0;
+      }
+    }
+  });
+}
+
+}  // namespace precomputed
+
+// ------------------------------------------------------------------------------------------------
+// Explicit instantiations: double, and float for a store of half the footprint
+#define MO_INSTANTIATE_TRAJECTORY_COEFFICIENTS(T) \
+  template class TrajectoryCoefficients<T>; \
+  template TrajectoryCoefficients<T> setupTrajectoryCoefficients<T>(const atlas::FieldSet &); \
+  template void precomputed::evalAirTemperatureTL<T>(atlas::FieldSet &, \
+                                                     const TrajectoryCoefficients<T> &); \
+  template void precomputed::evalAirTemperatureAD<T>(atlas::FieldSet &, \
+                                                     const TrajectoryCoefficients<T> &); \
+  template void precomputed::evalDryAirDensityTL<T>(atlas::FieldSet &, \
+                                                    const TrajectoryCoefficients<T> &); \
+  template void precomputed::evalDryAirDensityAD<T>(atlas::FieldSet &, \
+                                                    const TrajectoryCoefficients<T> &); \
+  template void precomputed::evalMuThetavTL<T>(atlas::FieldSet &, \
+                                               const TrajectoryCoefficients<T> &); \
+  template void precomputed::evalMuThetavAD<T>(atlas::FieldSet &, \
+                                               const TrajectoryCoefficients<T> &); \
+  template void precomputed::evalQtThetaTL<T>(atlas::FieldSet &, \
+                                              const TrajectoryCoefficients<T> &); \
+  template void precomputed::evalQtThetaAD<T>(atlas::FieldSet &, \
+                                              const TrajectoryCoefficients<T> &);
+
+MO_INSTANTIATE_TRAJECTORY_COEFFICIENTS(double)
+MO_INSTANTIATE_TRAJECTORY_COEFFICIENTS(float)
+
+#undef MO_INSTANTIATE_TRAJECTORY_COEFFICIENTS
+
+}  // namespace mo
@@ -0,0 +1,89 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "atlas/field/FieldSet.h"
+#include "atlas/library/config.h"
+
+namespace mo {
+
+/// \brief store of the per-(column, level) trajectory coefficients of the linear
+///        variable changes
+///
+/// \details The coefficients only depend on the trajectory, so they are built once
+/// per outer loop by setupTrajectoryCoefficients and the TL/AD kernels of
+/// mo::precomputed are then multiply-adds of the increments with them.
+///
+/// Each coefficient is a contiguous level-major array (index jl * nColumns + jn), so
+/// that the innermost loop over the columns of a tile is unit stride. The
+/// coefficients are computed in double precision and stored as T: float halves the
+/// footprint of the store where that accuracy is enough. The increments stay double.
+///
+template<typename T>
+class TrajectoryCoefficients {
+ public:
+  explicit TrajectoryCoefficients(const atlas::idx_t nColumns = 0) : nColumns_(nColumns) {}
+
+  atlas::idx_t nColumns() const {return nColumns_;}
+  bool has(const std::string & name) const {return coefficients_.count(name) > 0;}
+
+  /// \brief allocates the coefficient called name, of levels levels
+  T * add(const std::string & name, const atlas::idx_t levels);
+  /// \brief the coefficient called name (which must have been added)
+  const T * get(const std::string & name) const;
+
+  /// \brief memory footprint of the coefficients
+  std::size_t bytes() const;
+
+ private:
+  atlas::idx_t nColumns_;
+  std::map<std::string, std::vector<T>> coefficients_;
+};
+
+/// \brief builds the coefficients of the mo::precomputed kernels whose trajectory
+///        fields are in augStateFlds:
+///        * evalAirTemperature: height_levels, height, exner_levels_minus_one and
+///          potential_temperature
+///        * evalDryAirDensity: the same, and dry_air_density_levels_minus_one
+///        * evalMuThetav: muRow1Column1, muRow1Column2, muRow2Column1 and muRow2Column2
+///        * evalQtTheta: the same, and muRecipDeterminant
+template<typename T>
+TrajectoryCoefficients<T> setupTrajectoryCoefficients(const atlas::FieldSet & augStateFlds);
+
+namespace precomputed {
+
+/// \details The kernels of mo/control2analysis_linearvarchange.h, reading their
+///          trajectory from a TrajectoryCoefficients store built by
+///          setupTrajectoryCoefficients instead of from the trajectory fields.
+template<typename T>
+void evalAirTemperatureTL(atlas::FieldSet & incFlds, const TrajectoryCoefficients<T> &);
+template<typename T>
+void evalAirTemperatureAD(atlas::FieldSet & hatFlds, const TrajectoryCoefficients<T> &);
+
+template<typename T>
+void evalDryAirDensityTL(atlas::FieldSet & incFlds, const TrajectoryCoefficients<T> &);
+template<typename T>
+void evalDryAirDensityAD(atlas::FieldSet & hatFlds, const TrajectoryCoefficients<T> &);
+
+template<typename T>
+void evalMuThetavTL(atlas::FieldSet & incFlds, const TrajectoryCoefficients<T> &);
+template<typename T>
+void evalMuThetavAD(atlas::FieldSet & hatFlds, const TrajectoryCoefficients<T> &);
+
+template<typename T>
+void evalQtThetaTL(atlas::FieldSet & incFlds, const TrajectoryCoefficients<T> &);
+template<typename T>
+void evalQtThetaAD(atlas::FieldSet & hatFlds, const TrajectoryCoefficients<T> &);
+
+}  // namespace precomputed
+}  // namespace mo
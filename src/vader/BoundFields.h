@@ -0,0 +1,87 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_BOUNDFIELDS_H_
+#define SRC_VADER_BOUNDFIELDS_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "atlas/array/MakeView.h"
+#include "atlas/field/Field.h"
+#include "atlas/field/FieldSet.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief RecipeFields holds the positions of the fields of a planned recipe
+ *
+ *  \details The positions are those in the fieldset the plan is executed on (the
+ *           caller's fields in their order, then the intermediates in plan order),
+ *           resolved when the plan is created. The ingredients are in the order of
+ *           RecipeBase::ingredients, the products as in the CompiledCookbook (the
+ *           variable the recipe is listed under, then the other RecipeBase::products);
+ *           a product that is not in the fieldset has position npos.
+ */
+struct RecipeFields {
+    static constexpr atlas::idx_t npos = -1;
+    std::vector<atlas::idx_t> ingredients;
+    std::vector<atlas::idx_t> products;
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief BoundFields gives a recipe its fields without looking them up by name
+ *
+ *  \details BoundFields refers to the fieldset of the execution and to the positions
+ *           of the recipe's fields in it (RecipeFields). It is built on the stack for
+ *           each execution, and neither allocates nor hashes: the fields are indexed
+ *           by position, and the views made from them (make_view of a rank 2 field)
+ *           only copy its shape, strides and data pointer.
+ */
+class BoundFields {
+ public:
+    BoundFields(atlas::FieldSet & fieldset, const RecipeFields & positions) :
+        fieldset_(fieldset), positions_(positions) {}
+
+    std::size_t nIngredients() const {return positions_.ingredients.size();}
+    std::size_t nProducts() const {return positions_.products.size();}
+
+    /// The i-th ingredient
+    const atlas::Field & ingredient(const std::size_t i) const {
+        return fieldset_[positions_.ingredients[i]];
+    }
+    /// true if the i-th product is in the fieldset
+    bool hasProduct(const std::size_t i) const {
+        return positions_.products[i] != RecipeFields::npos;
+    }
+    /// The i-th product (which must be in the fieldset)
+    atlas::Field & product(const std::size_t i) const {
+        return fieldset_[positions_.products[i]];
+    }
+
+    /// Read-only view of the i-th ingredient, with value type T
+    template<typename T>
+    atlas::array::ArrayView<const T, 2> ingredientView(const std::size_t i) const {
+        return atlas::array::make_view<const T, 2>(ingredient(i));
+    }
+    /// View of the i-th product, with value type T
+    template<typename T>
+    atlas::array::ArrayView<T, 2> productView(const std::size_t i) const {
+        return atlas::array::make_view<T, 2>(product(i));
+    }
+
+    /// The whole fieldset, for the recipes that look their fields up by name
+    atlas::FieldSet & fieldset() const {return fieldset_;}
+
+ private:
+    atlas::FieldSet & fieldset_;
+    const RecipeFields & positions_;
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_BOUNDFIELDS_H_
@@ -0,0 +1,352 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "oops/util/Logger.h"
+#include "vader/CompiledCookbook.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+CompiledCookbook::VarId CompiledCookbook::intern(const std::string & name) {
+    auto it = varIds_.find(name);
+    if (it != varIds_.end()) return it->second;
+    const VarId var = varNames_.size();
+    varIds_[name] = var;
+    varNames_.push_back(name);
+    return var;
+}
+// ------------------------------------------------------------------------------------------------
+CompiledCookbook::VarId CompiledCookbook::variableId(const std::string & name) const {
+    auto it = varIds_.find(name);
+    return it == varIds_.end() ? npos : it->second;
+}
+// ------------------------------------------------------------------------------------------------
+void CompiledCookbook::compile(const std::unordered_map<std::string,
+                                     std::vector<std::unique_ptr<RecipeBase>>> & cookbook) {
+    oops::Log::trace() << "entering CompiledCookbook::compile" << std::endl;
+    varIds_.clear();
+    varNames_.clear();
+    recipes_.clear();
+    descriptors_.clear();
+
+    // Sort the products so that the ids do not depend on the unordered_map ordering
+    std::vector<std::string> products;
+    for (const auto & entry : cookbook) products.push_back(entry.first);
+    std::sort(products.begin(), products.end());
+    for (const auto & product : products) intern(product);
+
+    // Recipes, their ingredients and their products
+    std::vector<std::vector<VarId>> ingredients;
+    productsOffset_.assign(1, 0);
+    productsIndex_.clear();
+    for (const auto & product : products) {
+        for (const auto & rec : cookbook.at(product)) {
+            recipes_.push_back(rec.get());
+            descriptors_.push_back(RecipeDescriptor{rec->name(), varIds_.at(product),
+                                                    rec->requiresSetup(), rec->hasTLAD(),
+                                                    rec->executesOnDevice(), rec->columnwise(),
+                                                    rec->cost(), rec->name() + "TL",
+                                                    rec->name() + "AD"});
+            ingredients.emplace_back();
+            for (const auto & ingredient : rec->ingredients()) {
+                ingredients.back().push_back(intern(ingredient));
+            }
+            productsIndex_.push_back(varIds_.at(product));
+            for (const auto & recProduct : rec->products()) {
+                if (recProduct != product) productsIndex_.push_back(intern(recProduct));
+            }
+            productsOffset_.push_back(productsIndex_.size());
+        }
+    }
+
+    // variable -> recipes. Recipes were added product by product, in priority order.
+    recipesOffset_.assign(varNames_.size() + 1, 0);
+    for (const auto & descriptor : descriptors_) ++recipesOffset_[descriptor.product + 1];
+    for (std::size_t var = 0; var < varNames_.size(); ++var) {
+        recipesOffset_[var + 1] += recipesOffset_[var];
+    }
+    recipesIndex_.resize(recipes_.size());
+    std::vector<std::size_t> fill(recipesOffset_.begin(), recipesOffset_.end() - 1);
+    for (RecipeId rec = 0; rec < recipes_.size(); ++rec) {
+        recipesIndex_[fill[descriptors_[rec].product]++] = rec;
+    }
+
+    // recipe -> ingredients
+    ingredientsOffset_.assign(1, 0);
+    ingredientsIndex_.clear();
+    for (const auto & recIngredients : ingredients) {
+        ingredientsIndex_.insert(ingredientsIndex_.end(), recIngredients.begin(),
+                                 recIngredients.end());
+        ingredientsOffset_.push_back(ingredientsIndex_.size());
+    }
+
+    oops::Log::debug() << "CompiledCookbook: " << varNames_.size() << " variables, " <<
+        recipes_.size() << " recipes" << std::endl;
+    if (hasCycle()) {
+        oops::Log::warning() << "Warning: the Vader cookbook contains cyclic dependencies. "
+            "Cyclic paths will not be planned." << std::endl;
+    }
+    oops::Log::trace() << "leaving CompiledCookbook::compile" << std::endl;
+}
+// ------------------------------------------------------------------------------------------------
+double CompiledCookbook::cost(const RecipeId rec) const {
+    const RecipeCost & recipeCost = descriptors_[rec].cost;
+    return std::max(recipeCost.flopsPerPoint, flopsPerByte * recipeCost.bytesPerPoint);
+}
+// ------------------------------------------------------------------------------------------------
+bool CompiledCookbook::hasCycle() const {
+    // 0: not visited, 1: on the current path, 2: finished
+    std::vector<char> state(varNames_.size(), 0);
+    std::function<bool(VarId)> visit = [&](const VarId var) {
+        if (state[var] == 1) return true;
+        if (state[var] == 2) return false;
+        state[var] = 1;
+        for (auto rec = recipesBegin(var); rec != recipesEnd(var); ++rec) {
+            for (auto ing = ingredientsBegin(*rec); ing != ingredientsEnd(*rec); ++ing) {
+                if (visit(*ing)) return true;
+            }
+        }
+        state[var] = 2;
+        return false;
+    };
+    for (VarId var = 0; var < varNames_.size(); ++var) {
+        if (visit(var)) return true;
+    }
+    return false;
+}
+// ------------------------------------------------------------------------------------------------
+bool CompiledCookbook::planRecipe(const std::vector<char> & allocated,
+                                  std::vector<char> & needed,
+                                  const VarId targetVariable,
+                                  const RecipeId rec,
+                                  std::vector<RecipeId> & plan,
+                                  std::vector<char> & onStack,
+                                  const bool linear,
+                                  const bool cheapest) const {
+    oops::Log::debug() << "Checking to see if we have ingredients for recipe: " <<
+        descriptors_[rec].name << std::endl;
+    if (linear && !descriptors_[rec].hasTLAD) {
+        oops::Log::debug() << "Recipe " << descriptors_[rec].name <<
+            " has no tangent linear and adjoint." << std::endl;
+        return false;
+    }
+    if (allocated[targetVariable] == intermediate &&
+        ingredientsBegin(rec) == ingredientsEnd(rec)) {
+        // An intermediate field is shaped after the first ingredient of its recipe
+        oops::Log::debug() << "Recipe " << descriptors_[rec].name <<
+            " has no ingredients to allocate intermediate " << varNames_[targetVariable] <<
+            " from." << std::endl;
+        return false;
+    }
+    // The recipes planned for the ingredients of a recipe that turns out not to be
+    // viable are rolled back by planVariable (their products would be intermediates
+    // that no recipe consumes).
+    for (auto ing = ingredientsBegin(rec); ing != ingredientsEnd(rec); ++ing) {
+        if (*ing == targetVariable) {
+            oops::Log::error() << "Error: Ingredient list for " <<
+                descriptors_[rec].name << " contains the target." << std::endl;
+            return false;
+        }
+        bool haveIngredient = allocated[*ing] && !needed[*ing];
+        if (!haveIngredient) {
+            oops::Log::debug() << "ingredient " << varNames_[*ing] <<
+                " not found. Checking if Vader can make it." << std::endl;
+            haveIngredient = planVariable(allocated, needed, *ing, plan, onStack, linear,
+                                          cheapest);
+        }
+        oops::Log::debug() << "ingredient " << varNames_[*ing] <<
+            (haveIngredient ? " is" : " is not") << " available." << std::endl;
+        if (!haveIngredient) {
+            oops::Log::debug() << "Do not have all the ingredients for this recipe." <<
+                std::endl;
+            return false;
+        }
+    }
+    oops::Log::debug() <<
+        "All ingredients are in the fieldset. Adding recipe to recipeExecutionPlan." <<
+        std::endl;
+    plan.push_back(rec);
+    for (auto prod = productsBegin(rec); prod != productsEnd(rec); ++prod) {
+        needed[*prod] = 0;
+    }
+    return true;
+}
+// ------------------------------------------------------------------------------------------------
+std::size_t CompiledCookbook::neededProducts(const std::vector<char> & allocated,
+                                             const std::vector<char> & needed,
+                                             const RecipeId rec) const {
+    std::size_t count = 0;
+    for (auto prod = productsBegin(rec); prod != productsEnd(rec); ++prod) {
+        if (allocated[*prod] == inFieldSet && needed[*prod]) ++count;
+    }
+    return count;
+}
+// ------------------------------------------------------------------------------------------------
+bool CompiledCookbook::overwritesPopulated(const std::vector<char> & allocated,
+                                           const std::vector<char> & needed,
+                                           const RecipeId rec) const {
+    for (auto prod = productsBegin(rec); prod != productsEnd(rec); ++prod) {
+        if (allocated[*prod] && !needed[*prod]) return true;
+    }
+    return false;
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Plan Variable
+*
+* \details **planVariable** contains Vader's primary algorithm for attempting to
+* populate an unpopulated field. It:
+* * Checks the cookbook for recipes for the desired field (the targetVariable)
+* * Checks each recipe to see if its required ingredients have been provided
+*   (recipes with several products are deferred unless they populate at least two
+*   needed variables, and skipped if they would overwrite a populated field)
+* * If an ingredient is missing, recursively calls itself to attempt to get it
+* * Adds the first viable recipe (or, for a cheapest plan, the viable recipe of least
+*   marginal cost, the first of them in case of a tie) to the plan, after the recipes
+*   producing its ingredients
+* * If successful, marks the products of the recipe as no longer needed and returns 'true'
+* * Otherwise rolls back the plan (and the needed flags) to what they were before the
+*   recipe was tried, so that the plan only holds recipes whose products are used
+*
+* Variables on the current planning path are marked, so that an ingredient that
+* depends on itself (a cycle in the cookbook) makes the recipe non-viable.
+*
+* \param[in] allocated flags, by variable id, the fields allocated in the fieldset
+*            (inFieldSet) or that Vader may allocate (intermediate)
+* \param[in,out] needed flags, by variable id, the fields that still need populating
+* \param[in] targetVariable id of the variable this instance is trying to populate
+* \param[in,out] plan ordered list of viable recipes that will get exectued later
+* \param[in] linear if true, only the recipes with a tangent linear and adjoint
+*            (RecipeBase::hasTLAD) are viable
+* \param[in] cheapest if true, the viable recipes are compared by their marginal cost
+*            (see CompiledCookbook); each target is planned in turn, so the plan shares
+*            the intermediates of the targets planned before it
+* \return boolean 'true' if it successfully creates a plan for targetVariable, else false
+*
+*/
+bool CompiledCookbook::planVariable(const std::vector<char> & allocated,
+                                    std::vector<char> & needed,
+                                    const VarId targetVariable,
+                                    std::vector<RecipeId> & plan,
+                                    const bool linear,
+                                    const bool cheapest) const {
+    std::vector<char> onStack(varNames_.size(), 0);
+    return planVariable(allocated, needed, targetVariable, plan, onStack, linear, cheapest);
+}
+// ------------------------------------------------------------------------------------------------
+bool CompiledCookbook::planVariable(const std::vector<char> & allocated,
+                                    std::vector<char> & needed,
+                                    const VarId targetVariable,
+                                    std::vector<RecipeId> & plan,
+                                    std::vector<char> & onStack,
+                                    const bool linear,
+                                    const bool cheapest) const {
+    const std::string & targetName = varNames_[targetVariable];
+    oops::Log::trace() << "entering CompiledCookbook::planVariable for variable: " <<
+        targetName << std::endl;
+
+    if (!allocated[targetVariable]) {
+        oops::Log::debug() << "Field '" << targetName <<
+            "' is not allocated the fieldset. Vader cannot make it." << std::endl;
+        return false;
+    }
+    if (!needed[targetVariable]) {
+        oops::Log::debug() << targetName <<
+            " is no longer in the variable list neededVars." << std::endl;
+        return true;
+    }
+    if (onStack[targetVariable]) {
+        oops::Log::debug() << targetName <<
+            " is already being planned (cyclic dependency in the cookbook)." << std::endl;
+        return false;
+    }
+    if (recipesBegin(targetVariable) == recipesEnd(targetVariable)) {
+        oops::Log::debug() << "Vader cookbook does not contain a recipe for: "
+            << targetName << std::endl;
+        return false;
+    }
+
+    onStack[targetVariable] = 1;
+    bool variablePlanned = false;
+    // First pass: single-product recipes, and multi-product recipes that populate
+    // several needed variables. Second pass: the deferred multi-product recipes.
+    std::vector<RecipeId> deferred;
+    // The cheapest viable candidate (of the pass) and the plan it gives
+    bool cheapestFound = false;
+    double cheapestCost = 0.0;
+    std::vector<char> cheapestNeeded;
+    std::vector<RecipeId> cheapestPlan;
+    for (int pass = 0; pass < 2 && !variablePlanned; ++pass) {
+        const RecipeId * candBegin = recipesBegin(targetVariable);
+        const RecipeId * candEnd = recipesEnd(targetVariable);
+        if (pass == 1) {
+            candBegin = deferred.data();
+            candEnd = deferred.data() + deferred.size();
+        }
+        for (auto rec = candBegin; rec != candEnd && !variablePlanned; ++rec) {
+            if (productsEnd(*rec) - productsBegin(*rec) > 1) {
+                if (overwritesPopulated(allocated, needed, *rec)) {
+                    oops::Log::debug() << "Recipe " << descriptors_[*rec].name <<
+                        " would overwrite a populated field." << std::endl;
+                    continue;
+                }
+                if (pass == 0 && neededProducts(allocated, needed, *rec) < 2) {
+                    deferred.push_back(*rec);
+                    continue;
+                }
+            }
+            if (!cheapest) {
+                const std::size_t planSize = plan.size();
+                const std::vector<char> neededBefore(needed);
+                variablePlanned = planRecipe(allocated, needed, targetVariable, *rec, plan,
+                                             onStack, linear, cheapest);
+                if (!variablePlanned) {
+                    // Roll back what was planned for the ingredients of the recipe
+                    plan.resize(planSize);
+                    needed = neededBefore;
+                }
+                continue;
+            }
+            // Plan the candidate on copies, and keep the cheapest of the viable ones
+            std::vector<char> candNeeded(needed);
+            std::vector<RecipeId> candPlan(plan);
+            if (!planRecipe(allocated, candNeeded, targetVariable, *rec, candPlan, onStack,
+                            linear, cheapest)) continue;
+            double candCost = 0.0;
+            for (std::size_t jr = plan.size(); jr < candPlan.size(); ++jr) {
+                candCost += cost(candPlan[jr]);
+            }
+            oops::Log::debug() << "Recipe " << descriptors_[*rec].name <<
+                " is viable, with a marginal cost of " << candCost <<
+                " flops per point." << std::endl;
+            if (!cheapestFound || candCost < cheapestCost) {
+                cheapestFound = true;
+                cheapestCost = candCost;
+                cheapestNeeded.swap(candNeeded);
+                cheapestPlan.swap(candPlan);
+            }
+        }
+        if (cheapestFound) {
+            needed.swap(cheapestNeeded);
+            plan.swap(cheapestPlan);
+            variablePlanned = true;
+        }
+    }
+    onStack[targetVariable] = 0;
+
+    oops::Log::trace() << "leaving CompiledCookbook::planVariable for variable: " <<
+        targetName << std::endl;
+    return variablePlanned;
+}
+
+}  // namespace vader
@@ -0,0 +1,181 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_COMPILEDCOOKBOOK_H_
+#define SRC_VADER_COMPILEDCOOKBOOK_H_
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "RecipeBase.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief RecipeDescriptor holds what Vader needs to know about a recipe to plan and
+ *         execute it
+ *
+ *  \details The descriptor is read from the recipe (its name and flags, all virtual
+ *           calls) once, when the cookbook is compiled, so that executing a plan only
+ *           calls the recipe's setup and execute. The ingredients and products are in
+ *           the CompiledCookbook tables, as interned ids.
+ */
+struct RecipeDescriptor {
+    std::string name;
+    std::size_t product;  // the variable the recipe is listed under in the cookbook
+    bool requiresSetup;
+    bool hasTLAD;
+    bool executesOnDevice;
+    bool columnwise;
+    RecipeCost cost;
+    // The instrumentation names of executeTL and executeAD (name + "TL" / "AD")
+    std::string nameTL;
+    std::string nameAD;
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief CompiledCookbook is an integer-indexed form of the Vader cookbook
+ *
+ *  \details The variables and recipes of the cookbook are interned to dense
+ *           integer ids when Vader is constructed. The dependency graph is stored
+ *           in two flat CSR-style tables:
+ *           * variable -> recipes producing it (in cookbook priority order)
+ *           * recipe -> ingredients
+ *           * recipe -> products
+ *
+ *           The recipes themselves remain owned by the Vader cookbook, so the
+ *           cookbook must outlive its compiled form.
+ *
+ *           Planning is a depth-first (post-order, hence topological) walk over
+ *           this graph. Variables currently being planned are marked so that a
+ *           cyclic cookbook is detected rather than recursed into forever.
+ *
+ *           A recipe populating several variables (see RecipeBase::products) is
+ *           only viable if none of its allocated products is already populated,
+ *           and it is only tried after the single-product alternatives unless at
+ *           least two of its allocated products are needed.
+ *
+ *           The allocated flags passed to planVariable are 0 (not allocated),
+ *           inFieldSet, or intermediate: not in the fieldset, but Vader may allocate
+ *           the field itself (see Vader::createPlan) if it is the ingredient of a
+ *           planned recipe.
+ *
+ *           A linear plan (for Vader::changeVarTraj) only uses the recipes that have
+ *           a tangent linear and adjoint.
+ *
+ *           By default the first viable recipe, in cookbook priority order, is
+ *           planned. A cheapest plan instead plans the viable recipe of least
+ *           marginal cost: the cost of the recipes it adds to the plan, those of its
+ *           missing ingredients included, so that a variable that is already planned
+ *           or in the fieldset costs nothing. The cost of a recipe is the roofline
+ *           estimate cost(rec), in flops per column point.
+ */
+class CompiledCookbook : private boost::noncopyable {
+ public:
+    typedef std::size_t VarId;
+    typedef std::size_t RecipeId;
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+    static constexpr char inFieldSet = 1;
+    static constexpr char intermediate = 2;
+    /// Machine balance of the cost model: flops per byte of memory traffic
+    static constexpr double flopsPerByte = 4.0;
+
+    CompiledCookbook() {}
+    void compile(const std::unordered_map<std::string,
+                                          std::vector<std::unique_ptr<RecipeBase>>> & cookbook);
+
+    std::size_t nVariables() const {return varNames_.size();}
+    std::size_t nRecipes() const {return recipes_.size();}
+
+    /// Returns the id of a variable, or npos if the cookbook does not know it
+    VarId variableId(const std::string &) const;
+    const std::string & variableName(const VarId var) const {return varNames_[var];}
+
+    RecipeBase & recipe(const RecipeId rec) const {return *recipes_[rec];}
+    const RecipeDescriptor & descriptor(const RecipeId rec) const {return descriptors_[rec];}
+    const std::string & recipeName(const RecipeId rec) const {return descriptors_[rec].name;}
+    /// The variable rec is listed under in the cookbook
+    VarId product(const RecipeId rec) const {return descriptors_[rec].product;}
+    /// Estimated cost of rec per column point, in flops: the larger of its flops and
+    /// of its memory traffic at the machine balance (flopsPerByte)
+    double cost(const RecipeId rec) const;
+
+    /// Recipes producing var, in cookbook priority order
+    const RecipeId * recipesBegin(const VarId var) const
+        {return recipesIndex_.data() + recipesOffset_[var];}
+    const RecipeId * recipesEnd(const VarId var) const
+        {return recipesIndex_.data() + recipesOffset_[var + 1];}
+
+    /// Ingredients of rec
+    const VarId * ingredientsBegin(const RecipeId rec) const
+        {return ingredientsIndex_.data() + ingredientsOffset_[rec];}
+    const VarId * ingredientsEnd(const RecipeId rec) const
+        {return ingredientsIndex_.data() + ingredientsOffset_[rec + 1];}
+
+    /// All the products of rec, including product(rec)
+    const VarId * productsBegin(const RecipeId rec) const
+        {return productsIndex_.data() + productsOffset_[rec];}
+    const VarId * productsEnd(const RecipeId rec) const
+        {return productsIndex_.data() + productsOffset_[rec + 1];}
+
+    /// Plans targetVariable; see the definition for details
+    bool planVariable(const std::vector<char> & allocated,
+                      std::vector<char> & needed,
+                      const VarId targetVariable,
+                      std::vector<RecipeId> & plan,
+                      const bool linear = false,
+                      const bool cheapest = false) const;
+
+ private:
+    VarId intern(const std::string &);
+    bool planVariable(const std::vector<char> & allocated,
+                      std::vector<char> & needed,
+                      const VarId targetVariable,
+                      std::vector<RecipeId> & plan,
+                      std::vector<char> & onStack,
+                      const bool linear,
+                      const bool cheapest) const;
+    bool planRecipe(const std::vector<char> & allocated,
+                    std::vector<char> & needed,
+                    const VarId targetVariable,
+                    const RecipeId rec,
+                    std::vector<RecipeId> & plan,
+                    std::vector<char> & onStack,
+                    const bool linear,
+                    const bool cheapest) const;
+    bool hasCycle() const;
+    std::size_t neededProducts(const std::vector<char> & allocated,
+                               const std::vector<char> & needed,
+                               const RecipeId rec) const;
+    bool overwritesPopulated(const std::vector<char> & allocated,
+                             const std::vector<char> & needed,
+                             const RecipeId rec) const;
+
+    std::unordered_map<std::string, VarId> varIds_;
+    std::vector<std::string> varNames_;
+
+    std::vector<RecipeBase *> recipes_;
+    std::vector<RecipeDescriptor> descriptors_;
+
+    // CSR tables: entries for item i are index[offset[i]] ... index[offset[i+1]-1]
+    std::vector<std::size_t> recipesOffset_;
+    std::vector<RecipeId> recipesIndex_;
+    std::vector<std::size_t> ingredientsOffset_;
+    std::vector<VarId> ingredientsIndex_;
+    std::vector<std::size_t> productsOffset_;
+    std::vector<VarId> productsIndex_;
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_COMPILEDCOOKBOOK_H_
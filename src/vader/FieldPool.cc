@@ -0,0 +1,61 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <mutex>
+#include <string>
+
+#include "atlas/option.h"
+#include "oops/util/Logger.h"
+#include "vader/FieldPool.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+FieldPool::Key FieldPool::makeKey(const atlas::FunctionSpace & fspace, const int levels,
+                                  const atlas::array::DataType datatype) {
+    return Key(fspace.get(), levels, datatype.kind());
+}
+// ------------------------------------------------------------------------------------------------
+atlas::Field FieldPool::acquire(const std::string & name, const atlas::FunctionSpace & fspace,
+                                const int levels, const atlas::array::DataType datatype) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = fields_.find(makeKey(fspace, levels, datatype));
+        if (it != fields_.end()) {
+            atlas::Field field = it->second;
+            fields_.erase(it);
+            field.rename(name);
+            return field;
+        }
+        ++allocations_;
+    }
+    oops::Log::debug() << "FieldPool: allocating intermediate field " << name << std::endl;
+    return fspace.createField(atlas::option::name(name) | atlas::option::levels(levels) |
+                              atlas::option::datatype(datatype));
+}
+// ------------------------------------------------------------------------------------------------
+void FieldPool::release(const atlas::Field & field) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fields_.emplace(makeKey(field.functionspace(), field.levels(), field.datatype()), field);
+}
+// ------------------------------------------------------------------------------------------------
+void FieldPool::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fields_.clear();
+}
+// ------------------------------------------------------------------------------------------------
+std::size_t FieldPool::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fields_.size();
+}
+// ------------------------------------------------------------------------------------------------
+std::size_t FieldPool::allocations() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocations_;
+}
+
+}  // namespace vader
@@ -0,0 +1,59 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_FIELDPOOL_H_
+#define SRC_VADER_FIELDPOOL_H_
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include <boost/noncopyable.hpp>
+
+#include "atlas/array/DataType.h"
+#include "atlas/field/Field.h"
+#include "atlas/functionspace.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief FieldPool recycles the fields Vader allocates for intermediate variables
+ *
+ *  \details Released fields are kept, keyed by (function space, levels, data type),
+ *           and handed out again by acquire under the requested name, so that the
+ *           memory is reused across changeVar calls. A pooled field holds a reference
+ *           to its function space, which therefore stays alive (and keeps its
+ *           address) while the field is in the pool. The values of an acquired field
+ *           are undefined. All methods are thread-safe.
+ */
+class FieldPool : private boost::noncopyable {
+ public:
+    atlas::Field acquire(const std::string & name, const atlas::FunctionSpace &,
+                         const int levels, const atlas::array::DataType);
+    void release(const atlas::Field &);
+    void clear();
+
+    /// Number of fields held in the pool
+    std::size_t size() const;
+    /// Number of fields allocated by acquire (rather than recycled)
+    std::size_t allocations() const;
+
+ private:
+    typedef std::tuple<const void *, int, atlas::array::DataType::kind_t> Key;
+    static Key makeKey(const atlas::FunctionSpace &, const int levels,
+                       const atlas::array::DataType);
+
+    mutable std::mutex mutex_;
+    std::multimap<Key, atlas::Field> fields_;
+    std::size_t allocations_ = 0;
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_FIELDPOOL_H_
@@ -0,0 +1,60 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "atlas/array.h"
+#include "atlas/array/DataType.h"
+#include "vader/FieldSignature.h"
+
+namespace vader {
+
+namespace {
+// FNV-1a over the bit patterns of the values, one value at a time
+template<typename T>
+std::uint64_t hashValues(const atlas::Field & field) {
+    const auto view = atlas::array::make_view<const T, 2>(field);
+    std::uint64_t hash = 14695981039346656037ull;
+    for (atlas::idx_t jn = 0; jn < view.shape(0); ++jn) {
+        for (atlas::idx_t jl = 0; jl < view.shape(1); ++jl) {
+            const T value = view(jn, jl);
+            std::uint64_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(T));
+            hash = (hash ^ bits) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+}  // namespace
+
+// ------------------------------------------------------------------------------------------------
+FieldSignature fieldSignature(const atlas::Field & field, const bool hashContents) {
+    FieldSignature signature;
+    signature.field = field.get();
+    if (field.metadata().has(fieldVersionKey)) {
+        signature.version = field.metadata().getLong(fieldVersionKey);
+        signature.valid = true;
+    } else if (hashContents && field.rank() == 2) {
+        if (field.datatype() == atlas::array::DataType::real64()) {
+            signature.hash = hashValues<double>(field);
+            signature.valid = true;
+        } else if (field.datatype() == atlas::array::DataType::real32()) {
+            signature.hash = hashValues<float>(field);
+            signature.valid = true;
+        }
+    }
+    return signature;
+}
+// ------------------------------------------------------------------------------------------------
+std::int64_t nextFieldVersion() {
+    static std::atomic<std::int64_t> version{0};
+    return ++version;
+}
+
+}  // namespace vader
@@ -0,0 +1,53 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_FIELDSIGNATURE_H_
+#define SRC_VADER_FIELDSIGNATURE_H_
+
+#include <cstdint>
+
+#include "atlas/field/Field.h"
+
+namespace vader {
+
+/// Metadata key of the field versions. Vader sets it on the fields it populates;
+/// callers that modify a field outside Vader should set it to a new value (e.g. from
+/// nextFieldVersion) or remove it.
+constexpr char fieldVersionKey[] = "vader_version";
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief FieldSignature identifies the contents of a field
+ *
+ *  \details The signature is the identity of the field and its version, read from
+ *           the fieldVersionKey metadata. A field without a version is identified by
+ *           a hash of its values instead (only for rank 2 real fields, which are the
+ *           ones Vader works with); other fields have an invalid signature, which
+ *           never compares equal.
+ */
+struct FieldSignature {
+    const void * field = nullptr;
+    std::int64_t version = -1;
+    std::uint64_t hash = 0;
+    bool valid = false;
+
+    bool operator==(const FieldSignature & other) const {
+        return valid && other.valid && field == other.field && version == other.version &&
+               hash == other.hash;
+    }
+    bool operator!=(const FieldSignature & other) const {return !(*this == other);}
+};
+
+/// Signature of a field; with hashContents false, a field without a version gets an
+/// invalid signature rather than a hash
+FieldSignature fieldSignature(const atlas::Field &, const bool hashContents = true);
+
+/// A new version, distinct from the versions returned before in this process
+std::int64_t nextFieldVersion();
+
+}  // namespace vader
+
+#endif  // SRC_VADER_FIELDSIGNATURE_H_
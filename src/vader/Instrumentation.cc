@@ -0,0 +1,114 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "eckit/log/JSON.h"
+#include "vader/Instrumentation.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+Instrumentation & Instrumentation::kernels() {
+    static Instrumentation instrumentation;
+    return instrumentation;
+}
+// ------------------------------------------------------------------------------------------------
+void Instrumentation::record(const std::string & name, const double seconds,
+                             const std::size_t bytesRead, const std::size_t bytesWritten) {
+    if (!enabled_) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    TimingStats & stats = stats_[name];
+    ++stats.calls;
+    stats.seconds += seconds;
+    stats.bytesRead += bytesRead;
+    stats.bytesWritten += bytesWritten;
+}
+// ------------------------------------------------------------------------------------------------
+std::map<std::string, TimingStats> Instrumentation::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+// ------------------------------------------------------------------------------------------------
+void Instrumentation::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.clear();
+}
+// ------------------------------------------------------------------------------------------------
+ScopedTiming::ScopedTiming(Instrumentation & instrumentation, const char * name) :
+    instrumentation_(instrumentation.enabled() ? &instrumentation : nullptr), name_(name)
+{
+    if (instrumentation_) start_ = std::chrono::steady_clock::now();
+}
+// ------------------------------------------------------------------------------------------------
+ScopedTiming::~ScopedTiming() {
+    if (instrumentation_) {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+        instrumentation_->record(name_, elapsed.count(), bytesRead_, bytesWritten_);
+    }
+}
+// ------------------------------------------------------------------------------------------------
+namespace {
+void writeStats(eckit::JSON & json, const std::map<std::string, TimingStats> & allStats) {
+    json.startObject();
+    for (const auto & entry : allStats) {
+        const TimingStats & stats = entry.second;
+        json << entry.first;
+        json.startObject();
+        json << "calls" << stats.calls;
+        json << "seconds" << stats.seconds;
+        json << "bytes read" << stats.bytesRead;
+        json << "bytes written" << stats.bytesWritten;
+        json.endObject();
+    }
+    json.endObject();
+}
+}  // namespace
+// ------------------------------------------------------------------------------------------------
+void InstrumentationReport::writeJSON(std::ostream & out) const {
+    eckit::JSON json(out);
+    json.startObject();
+    json << "recipes";
+    writeStats(json, recipes);
+    json << "phases";
+    writeStats(json, phases);
+    json << "kernels";
+    writeStats(json, kernels);
+    json << "caches";
+    json.startObject();
+    for (const auto & entry : caches) {
+        json << entry.first;
+        json.startObject();
+        json << "hits" << entry.second.hits;
+        json << "misses" << entry.second.misses;
+        json << "hit rate" << entry.second.hitRate();
+        json.endObject();
+    }
+    json.endObject();
+    json << "plans";
+    json.startList();
+    for (const auto & plan : plans) {
+        json.startObject();
+        json << "recipes";
+        json.startList();
+        for (const auto & recipe : plan.recipes) json << recipe;
+        json.endList();
+        json << "predicted flops per point" << plan.flopsPerPoint;
+        json << "predicted bytes per point" << plan.bytesPerPoint;
+        json << "predicted roofline cost" << plan.rooflineCost;
+        json.endObject();
+    }
+    json.endList();
+    json.endObject();
+}
+
+}  // namespace vader
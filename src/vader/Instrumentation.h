@@ -0,0 +1,128 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_INSTRUMENTATION_H_
+#define SRC_VADER_INSTRUMENTATION_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+/// Call count, wall time and memory traffic accumulated under one name
+struct TimingStats {
+    std::size_t calls = 0;
+    double seconds = 0.0;
+    std::size_t bytesRead = 0;
+    std::size_t bytesWritten = 0;
+};
+
+/// Hit and miss counts of a cache
+struct CacheStats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    double hitRate() const {return hits + misses == 0 ? 0.0 :
+                                   static_cast<double>(hits) / (hits + misses);}
+};
+
+/// Recipes of a plan, in execution order, and its predicted cost per column point (see
+/// ExecutionPlan)
+struct PlanStats {
+    std::vector<std::string> recipes;
+    double flopsPerPoint = 0.0;
+    double bytesPerPoint = 0.0;
+    double rooflineCost = 0.0;
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief Instrumentation accumulates TimingStats by name
+ *
+ *  \details Nothing is recorded while the instrumentation is disabled (the default),
+ *           so that an instrumentation point then only costs the load of a flag. All
+ *           methods are thread-safe.
+ *
+ *           kernels() is the process-wide instance the mo kernels record into (see
+ *           ScopedTiming). The Vader instances own the instances for their recipes.
+ */
+class Instrumentation : private boost::noncopyable {
+ public:
+    static Instrumentation & kernels();
+
+    bool enabled() const {return enabled_;}
+    void setEnabled(const bool enabled) {enabled_ = enabled;}
+
+    void record(const std::string & name, const double seconds,
+                const std::size_t bytesRead = 0, const std::size_t bytesWritten = 0);
+    std::map<std::string, TimingStats> stats() const;
+    void reset();
+
+ private:
+    std::atomic<bool> enabled_{false};
+    mutable std::mutex mutex_;
+    std::map<std::string, TimingStats> stats_;
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief ScopedTiming records the wall time of its scope into an Instrumentation
+ *
+ *  \details The clock is only read if the instrumentation is enabled when the
+ *           ScopedTiming is constructed. The bytes can be set until the end of the
+ *           scope, e.g. once the fields touched are known.
+ */
+class ScopedTiming : private boost::noncopyable {
+ public:
+    /// Times the scope as the kernel 'name' in Instrumentation::kernels()
+    explicit ScopedTiming(const char * name) : ScopedTiming(Instrumentation::kernels(), name) {}
+    ScopedTiming(Instrumentation & instrumentation, const char * name);
+    ~ScopedTiming();
+
+    bool enabled() const {return instrumentation_ != nullptr;}
+    void setBytes(const std::size_t bytesRead, const std::size_t bytesWritten)
+        {bytesRead_ = bytesRead; bytesWritten_ = bytesWritten;}
+
+ private:
+    Instrumentation * instrumentation_;  // nullptr if the instrumentation is disabled
+    const char * name_;
+    std::size_t bytesRead_ = 0;
+    std::size_t bytesWritten_ = 0;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief InstrumentationReport is a snapshot of the instrumentation of a Vader instance
+ *
+ *  \details
+ *           * recipes: the recipe executions, with the bytes of their ingredients
+ *             (read) and products (written)
+ *           * phases: "createPlan" (plan building, on plan cache misses) and
+ *             "executePlan" (recipe execution) of changeVar
+ *           * kernels: the mo kernels, process-wide
+ *           * caches: the hit rates of the plan cache and of the lookup table cache
+ *           * plans: the plans created, with their predicted cost
+ */
+struct InstrumentationReport {
+    std::map<std::string, TimingStats> recipes;
+    std::map<std::string, TimingStats> phases;
+    std::map<std::string, TimingStats> kernels;
+    std::map<std::string, CacheStats> caches;
+    std::vector<PlanStats> plans;
+
+    void writeJSON(std::ostream &) const;
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_INSTRUMENTATION_H_
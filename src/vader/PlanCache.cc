@@ -0,0 +1,60 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "vader/PlanCache.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+PlanCache::Key PlanCache::makeKey(const atlas::FieldSet & afieldset,
+                                  const oops::Variables & neededVars) {
+    return Key{afieldset.field_names(), neededVars.variables()};
+}
+// ------------------------------------------------------------------------------------------------
+std::shared_ptr<const ExecutionPlan> PlanCache::find(const Key & key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = plans_.find(key);
+    if (it == plans_.end()) {
+        ++misses_;
+        return nullptr;
+    }
+    ++hits_;
+    return it->second;
+}
+// ------------------------------------------------------------------------------------------------
+void PlanCache::insert(const Key & key, std::shared_ptr<const ExecutionPlan> plan) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    plans_[key] = std::move(plan);
+}
+// ------------------------------------------------------------------------------------------------
+void PlanCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    plans_.clear();
+}
+// ------------------------------------------------------------------------------------------------
+std::size_t PlanCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return plans_.size();
+}
+// ------------------------------------------------------------------------------------------------
+std::size_t PlanCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+// ------------------------------------------------------------------------------------------------
+std::size_t PlanCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+}  // namespace vader
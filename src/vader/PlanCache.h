@@ -0,0 +1,98 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_PLANCACHE_H_
+#define SRC_VADER_PLANCACHE_H_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "atlas/field/FieldSet.h"
+#include "BoundFields.h"
+#include "CompiledCookbook.h"
+#include "oops/base/Variables.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief ExecutionPlan holds a compiled recipe execution plan
+ *
+ *  \details The recipes are referenced by their CompiledCookbook ids so that
+ *           replaying a plan needs no cookbook lookups or string comparisons.
+ *           plannedVars lists the variables the plan populates, i.e. the
+ *           variables to be removed from neededVars.
+ *
+ *           levels groups the recipes into dependency levels: the ingredients of
+ *           a recipe in level n are only produced by recipes in levels < n, so the
+ *           recipes within a level can be executed concurrently.
+ *
+ *           intermediates lists the variables that are not in the fieldset but are
+ *           ingredients of planned recipes, with the recipe producing each of them,
+ *           in plan order. Vader allocates them for the execution of the plan.
+ *
+ *           fields holds the positions of the fields of each planned recipe in the
+ *           fieldset of the execution (see RecipeFields), indexed by RecipeId, so that
+ *           the recipes are bound to their fields without name lookups.
+ *
+ *           setupOnce has a flag per recipe (indexed by RecipeId): the recipes that
+ *           require setup are set up once per plan, that is once per fieldset structure,
+ *           before their first execution with the plan.
+ *
+ *           cost is the predicted cost of the plan per column point: the sums of the
+ *           RecipeCost of its recipes, and of their CompiledCookbook::cost.
+ */
+struct ExecutionPlan {
+    std::vector<CompiledCookbook::RecipeId> recipes;
+    std::vector<std::vector<CompiledCookbook::RecipeId>> levels;
+    oops::Variables plannedVars;
+    std::vector<std::pair<CompiledCookbook::VarId, CompiledCookbook::RecipeId>> intermediates;
+    std::vector<RecipeFields> fields;
+    mutable std::unique_ptr<std::once_flag[]> setupOnce;
+    RecipeCost cost;
+    double rooflineCost = 0.0;
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief PlanCache stores execution plans keyed by fieldset signature
+ *
+ *  \details A plan only depends on the names of the fields allocated in the
+ *           fieldset (in their order, which gives the positions of the fields the
+ *           recipes are bound to) and on the list of variables that are needed, so
+ *           those two lists form the key. All methods are thread-safe.
+ */
+class PlanCache : private boost::noncopyable {
+ public:
+    typedef std::pair<std::vector<std::string>, std::vector<std::string>> Key;
+
+    static Key makeKey(const atlas::FieldSet &, const oops::Variables &);
+
+    /// Returns the cached plan for key, or nullptr if there is none
+    std::shared_ptr<const ExecutionPlan> find(const Key &) const;
+    void insert(const Key &, std::shared_ptr<const ExecutionPlan>);
+    void clear();
+
+    std::size_t size() const;
+    std::size_t hits() const;
+    std::size_t misses() const;
+
+ private:
+    mutable std::mutex mutex_;
+    std::map<Key, std::shared_ptr<const ExecutionPlan>> plans_;
+    mutable std::size_t hits_ = 0;
+    mutable std::size_t misses_ = 0;
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_PLANCACHE_H_
@@ -7,6 +7,7 @@
 
 #include "vader/RecipeBase.h"
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -71,6 +72,18 @@ RecipeFactory::createParameters(const std::string &name) {
   return it->second->makeParameters();
 }
 
+int RecipeBase::productLevels(const atlas::FieldSet & afieldset) const {
+  return afieldset.field(ingredients().front()).levels();
+}
+
+RecipeCost RecipeBase::cost() const {
+  const std::size_t nProducts = std::max<std::size_t>(products().size(), 1);
+  RecipeCost recipeCost;
+  recipeCost.flopsPerPoint = nProducts;
+  recipeCost.bytesPerPoint = 8.0 * (ingredients().size() + nProducts);
+  return recipeCost;
+}
+
 void RecipeBase::print(std::ostream & os) const {
   os << name();
 }
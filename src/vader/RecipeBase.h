@@ -22,6 +22,7 @@
 #include "oops/util/parameters/RequiredParameter.h"
 #include "oops/util/parameters/RequiredPolymorphicParameter.h"
 #include "oops/util/Printable.h"
+#include "vader/BoundFields.h"
 
 namespace vader {
 
@@ -37,6 +38,15 @@ class RecipeParametersBase : public oops::Parameters {
      this};
 };
 
+// ------------------------------------------------------------------------------------------------
+/// Estimated cost of an execution of a recipe, per column point (per level of each
+/// column) of its products: the floating-point operations, and the bytes of the
+/// ingredients read and of the products written. (See RecipeBase::cost.)
+struct RecipeCost {
+  double flopsPerPoint = 0.0;
+  double bytesPerPoint = 0.0;
+};
+
 // ------------------------------------------------------------------------------------------------
 /*! \brief RecipeBase class defines interface for individual variable
            transformations.
@@ -58,14 +68,73 @@ class RecipeBase : public util::Printable,
 /// Ingredients (list of variables required to setup and execute recipe)
   virtual std::vector<std::string> ingredients() const = 0;
 
-/// Flag indicating whether the recipe requires setup.
+/// Products (list of variables populated by the recipe). The default, an empty
+/// list, means the recipe only populates the variable it is listed under in the
+/// cookbook. Recipes that populate several variables in one pass list all of them.
+  virtual std::vector<std::string> products() const { return {}; }
+
+/// Number of levels of the products, used when Vader allocates a product as an
+/// intermediate field. The function space and data type of the intermediate are those
+/// of the first ingredient; the default number of levels is also that of the first
+/// ingredient.
+  virtual int productLevels(const atlas::FieldSet &) const;
+
+/// Estimated cost of execute, per column point. It is read once, when Vader compiles
+/// its cookbook, and used by the planner to choose between alternative recipes (see
+/// VaderParameters cheapestPlan). The default counts one flop per product and 8 bytes
+/// per ingredient and product; recipes doing more work per point override it.
+  virtual RecipeCost cost() const;
+
+/// Flag indicating whether the recipe requires setup. (It is read once, when Vader
+/// compiles its cookbook; see RecipeDescriptor.)
   virtual bool requiresSetup() { return false; }
+/// setup is called once per plan, i.e. per fieldset structure, with the first fieldset
+/// the plan is executed on, so it should only depend on the structure of the fieldset
+/// (field names, shapes, metadata), not on the values of the fields.
 /// setup must return true on success, false on failure
   virtual bool setup(atlas::FieldSet &) { return true; }
 
 /// Execute method performs the variable change
 /// execute must return true on success, false on failure
+/// (The batched Vader::changeVar calls execute concurrently for different fieldsets,
+/// after a first call: only that first call may modify the state of the recipe.)
   virtual bool execute(atlas::FieldSet &) = 0;
+/// Execute with the fields Vader bound to the recipe when it planned it (see
+/// BoundFields); this is the method Vader calls. The default calls
+/// execute(fields.fieldset()). Recipes override it to use their bound fields rather
+/// than looking them up by name on every call.
+  virtual bool execute(const BoundFields & fields) { return execute(fields.fieldset()); }
+
+/// Flag indicating whether execute can run on the device backend (see VaderParameters
+/// backend), i.e. whether it only calls kernels that run on the device and leaves
+/// their fields there. The fields of the other recipes are brought up to date on the
+/// host before they execute.
+  virtual bool executesOnDevice() const { return false; }
+
+/// Flag indicating whether execute is column-local and runs on blocks of columns: the
+/// products of a column only depend on the ingredients of that column, and execute
+/// accepts fields without a function space (the column blocks of a chunked
+/// changeVar, see VaderParameters blockColumns). Plans with a recipe that is not
+/// columnwise are executed on the whole fields.
+  virtual bool columnwise() const { return false; }
+
+/// Flag indicating whether the recipe implements the linearized variable change
+/// (setupTraj, executeTL and executeAD). Only those recipes are used by
+/// Vader::changeVarTraj, changeVarTL and changeVarAD.
+  virtual bool hasTLAD() const { return false; }
+/// setupTraj is called once per trajectory with the trajectory fieldset, after the
+/// trajectory has been populated, so that the recipe can cache the quantities its
+/// executeTL and executeAD derive from the trajectory.
+/// setupTraj must return true on success, false on failure
+  virtual bool setupTraj(const atlas::FieldSet &) { return true; }
+/// executeTL computes the increments of the products from the increments of the
+/// ingredients (first argument), linearized about the trajectory (second argument)
+/// executeTL must return true on success, false on failure
+  virtual bool executeTL(atlas::FieldSet &, const atlas::FieldSet &) { return false; }
+/// executeAD adds the adjoint of the products to the adjoint of the ingredients,
+/// then zeroes the adjoint of the products
+/// executeAD must return true on success, false on failure
+  virtual bool executeAD(atlas::FieldSet &, const atlas::FieldSet &) { return false; }
 
  private:
   virtual void print(std::ostream &) const;
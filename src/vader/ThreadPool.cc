@@ -0,0 +1,98 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "vader/ThreadPool.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+ThreadPool::ThreadPool(const std::size_t nThreads) {
+    for (std::size_t i = 1; i < nThreads; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+// ------------------------------------------------------------------------------------------------
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto & worker : workers_) worker.join();
+}
+// ------------------------------------------------------------------------------------------------
+void ThreadPool::run(const std::size_t nTasks, const std::function<void(std::size_t)> & task) {
+    if (nTasks == 0) return;
+    std::unique_lock<std::mutex> runLock(runMutex_, std::try_to_lock);
+    if (!runLock.owns_lock()) {
+        // The workers are busy with another call
+        std::exception_ptr exception;
+        for (std::size_t i = 0; i < nTasks; ++i) {
+            try {
+                task(i);
+            } catch (...) {
+                if (!exception) exception = std::current_exception();
+            }
+        }
+        if (exception) std::rethrow_exception(exception);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        nTasks_ = nTasks;
+        nextTask_ = 0;
+        exception_ = nullptr;
+        busyWorkers_ = workers_.size();
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] {return busyWorkers_ == 0;});
+    task_ = nullptr;
+    if (exception_) std::rethrow_exception(exception_);
+}
+// ------------------------------------------------------------------------------------------------
+void ThreadPool::runTasks() {
+    for (std::size_t i = nextTask_++; i < nTasks_; i = nextTask_++) {
+        try {
+            (*task_)(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!exception_) exception_ = std::current_exception();
+        }
+    }
+}
+// ------------------------------------------------------------------------------------------------
+void ThreadPool::workerLoop() {
+    std::size_t generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] {return stop_ || generation_ != generation;});
+            if (stop_) return;
+            generation = generation_;
+        }
+        runTasks();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --busyWorkers_;
+        }
+        done_.notify_one();
+    }
+}
+
+}  // namespace vader
@@ -0,0 +1,69 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_THREADPOOL_H_
+#define SRC_VADER_THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief ThreadPool is a fixed-size pool of worker threads
+ *
+ *  \details run(nTasks, task) calls task(0) ... task(nTasks-1) concurrently on
+ *           the pool and on the calling thread, and returns when all the calls
+ *           have completed. If any call throws, the first exception is
+ *           re-thrown by run once all the tasks have finished.
+ *
+ *           Calls to run on the same pool may overlap (e.g. concurrent
+ *           Vader::changeVar calls on one Vader): the pool runs the tasks of one
+ *           call at a time, and a call made while it is busy (from another thread,
+ *           or from a task of the pool) runs its tasks on the calling thread alone.
+ */
+class ThreadPool : private boost::noncopyable {
+ public:
+    /// nThreads is the total number of threads, including the calling thread
+    explicit ThreadPool(const std::size_t nThreads);
+    ~ThreadPool();
+
+    std::size_t size() const {return workers_.size() + 1;}
+
+    void run(const std::size_t nTasks, const std::function<void(std::size_t)> & task);
+
+ private:
+    void workerLoop();
+    void runTasks();
+
+    std::vector<std::thread> workers_;
+    std::mutex runMutex_;  // held by the call of run the workers are executing
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    // State of the current run, guarded by mutex_ (except for the atomics)
+    const std::function<void(std::size_t)> * task_ = nullptr;
+    std::size_t nTasks_ = 0;
+    std::atomic<std::size_t> nextTask_{0};
+    std::size_t busyWorkers_ = 0;
+    std::size_t generation_ = 0;
+    std::exception_ptr exception_;
+    bool stop_ = false;
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_THREADPOOL_H_
@@ -8,6 +8,7 @@
 #ifndef SRC_VADER_VADERPARAMETERS_H_
 #define SRC_VADER_VADERPARAMETERS_H_
 
+#include <string>
 #include <vector>
 
 #include "oops/util/parameters/OptionalParameter.h"
@@ -32,6 +33,121 @@ class VaderParameters : public oops::Parameters {
      "recipe parameters",
      "Parameters to configure individual recipe functionality",
      this};
+
+  /// 'threads' is the number of threads used to execute the recipes of a plan.
+  /// Recipes that do not depend on each other are executed concurrently when
+  /// this is greater than one. The default executes the plan serially.
+  oops::Parameter<int> threads{
+     "threads",
+     "Number of threads used to execute independent recipes concurrently",
+     1,
+     this};
+
+  /// 'allocate intermediate fields' lets Vader plan recipes whose ingredients are not
+  /// in the fieldset, allocating those intermediate fields itself. The intermediate
+  /// fields are not added to the caller's fieldset; their memory is recycled
+  /// across changeVar calls.
+  oops::Parameter<bool> allocateIntermediates{
+     "allocate intermediate fields",
+     "Allocate the intermediate fields of recipe chains that are missing from the fieldset",
+     false,
+     this};
+
+  /// 'block columns' switches on the chunked execution of changeVar: the columns are
+  /// split into blocks of this many columns, and the whole plan is executed block by
+  /// block, with block-sized intermediate fields (only the caller's fields are full
+  /// size). This lowers the peak memory of plans with intermediates and keeps the
+  /// fields of a block in cache from one recipe to the next. Plans are only chunked if
+  /// all their recipes are columnwise (RecipeBase::columnwise) and all the fields are
+  /// contiguous rank 2 double or float fields with the same number of columns, and
+  /// neither the device backend nor 'skip unchanged recipes' is used; other plans,
+  /// and the batched and linear variable changes, execute on the whole fields. The
+  /// default, 0, executes all plans on the whole fields.
+  oops::Parameter<int> blockColumns{
+     "block columns",
+     "Number of columns per block of the chunked execution of changeVar (0: not chunked)",
+     0,
+     this};
+
+  /// 'skip unchanged recipes' skips the recipes whose ingredients and products are
+  /// unchanged since their last execution by this Vader instance. Fields are compared
+  /// by their "vader_version" metadata, which Vader bumps on the products it computes,
+  /// or else by a hash of their values. Callers that modify a versioned field must
+  /// set a new version (vader::nextFieldVersion) or remove the metadata.
+  oops::Parameter<bool> skipUnchanged{
+     "skip unchanged recipes",
+     "Skip the recipes whose ingredients have not changed since their last execution",
+     false,
+     this};
+
+  /// 'cheapest plan' makes the planner choose, for each needed variable, the viable
+  /// recipe of least estimated cost (see RecipeBase::cost and CompiledCookbook) given
+  /// the fields in the fieldset and the variables already planned, rather than the
+  /// first viable recipe in cookbook priority order.
+  oops::Parameter<bool> cheapestPlan{
+     "cheapest plan",
+     "Plan the viable recipes of least estimated cost rather than in cookbook order",
+     false,
+     this};
+
+  /// 'backend' selects where the recipes that can run on a device (see
+  /// RecipeBase::executesOnDevice) execute: "host" or "device". The device backend
+  /// needs the mo kernels built with ENABLE_VADER_DEVICE. With it the fields stay on
+  /// the device between such recipes, and are only copied back to the host for the
+  /// host recipes and at the end of changeVar. Callers that modify a field on the
+  /// host between calls mark its device copy out of date (Field::setDeviceNeedsUpdate).
+  /// The backend only applies to the recipes of this Vader.
+  oops::Parameter<std::string> backend{
+     "backend",
+     "Execution backend of the device-capable recipes: host or device",
+     "host",
+     this};
+
+  /// 'halo' is the halo policy of changeVar: "compute" computes the halo columns of
+  /// the products in every recipe; "exchange" only computes the owned columns in the
+  /// mo kernels and fills the halos of all the products with one aggregated halo
+  /// exchange (per function space) at the end of the plan. The policy is that of this
+  /// Vader only: it applies while its recipes execute.
+  oops::Parameter<std::string> halo{
+     "halo",
+     "Halo policy of changeVar: compute or exchange",
+     "compute",
+     this};
+
+  /// 'lookup table file' is a binary table file (see mo/table_file.h, and the
+  /// vader_convert_lookup_tables tool that writes it from the netcdf files) from which
+  /// the mo lookup tables are mapped rather than read through netcdf. The table file
+  /// is process-wide.
+  oops::OptionalParameter<std::string> lookupTableFile{
+     "lookup table file",
+     "Binary table file the mo lookup tables are mapped from",
+     this};
+
+  /// 'shared lookup tables' places the mo lookup tables read from the netcdf files in
+  /// MPI-3 shared memory windows, one copy per node of the default eckit communicator,
+  /// read once per job (see mo/lookup_cache.h). It needs vader built with
+  /// ENABLE_VADER_SHARED_TABLES. The tables are then loaded when Vader is constructed,
+  /// which is collective over the communicator. The option is process-wide.
+  oops::Parameter<bool> sharedLookupTables{
+     "shared lookup tables",
+     "Share the mo lookup tables between the MPI tasks of a node",
+     false,
+     this};
+
+  /// 'instrumentation' switches on the recording of the wall times, calls and
+  /// memory traffic of the recipes and of the mo kernels (see Vader::instrumentation).
+  oops::Parameter<bool> instrumentation{
+     "instrumentation",
+     "Record per-recipe and per-kernel timings and memory traffic",
+     false,
+     this};
+
+  /// 'instrumentation file' is the file the instrumentation report is written to,
+  /// as JSON, when Vader is destroyed. (With several MPI tasks the rank is appended.)
+  oops::OptionalParameter<std::string> instrumentationFile{
+     "instrumentation file",
+     "File the instrumentation report is written to when Vader is destroyed",
+     this};
 };
 
 }  // namespace vader
@@ -19,6 +19,10 @@
 // Recipe headers
 #include "recipes/PressureToDelP.h"
 #include "recipes/TempToPTemp.h"
+#ifdef VADER_ENABLE_MO
+#include "recipes/MoisturePartition.h"
+#include "recipes/MoistureRatios.h"
+#endif
 
 namespace vader
 {
@@ -34,6 +38,15 @@ std::unordered_map<std::string, std::vector<std::string>> Vader::getDefaultCookb
         // Value: a vector of recipe names that will be searched, in order,
         //        by Vader for viability
         {VV_PT, {TempToPTemp::Name}},
+#ifdef VADER_ENABLE_MO
+        // MoisturePartition produces m_t and all four specific quantities in one
+        // sweep. The planner only prefers it when several of them are needed.
+        {VV_MT, {TotalMassMoistAir::Name, MoisturePartition::Name}},
+        {VV_Q, {SpecificHumidityFromMt::Name, MoisturePartition::Name}},
+        {VV_CLI, {MassCloudIceFromMt::Name, MoisturePartition::Name}},
+        {VV_CLW, {MassCloudLiquidFromMt::Name, MoisturePartition::Name}},
+        {VV_QRAIN, {MassRainFromMt::Name, MoisturePartition::Name}},
+#endif
         // TODO(vahl) get PressureToDelP recipe working
         /*{VV_DELP, {PressureToDelP::Name}}*/};
 }
@@ -0,0 +1,63 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <string>
+#include <vector>
+
+#include "atlas/field/FieldSet.h"
+#include "mo/model2geovals_varchange.h"
+#include "oops/util/Logger.h"
+#include "vader/recipes/MoisturePartition.h"
+#include "vader/vadervariables.h"
+
+namespace vader
+{
+// ------------------------------------------------------------------------------------------------
+
+// Static attribute initialization
+const char MoisturePartition::Name[] = "MoisturePartition";
+const std::vector<std::string> MoisturePartition::Ingredients = {VV_MV, VV_MCI, VV_MCL, VV_MR};
+const std::vector<std::string> MoisturePartition::Products = {VV_MT, VV_Q, VV_CLI, VV_CLW,
+                                                              VV_QRAIN};
+
+// Register the maker
+static RecipeMaker<MoisturePartition> makerMoisturePartition_(MoisturePartition::Name);
+
+MoisturePartition::MoisturePartition()
+{
+    oops::Log::trace() << "MoisturePartition::MoisturePartition()" << std::endl;
+}
+
+MoisturePartition::MoisturePartition(const Parameters_ &)
+{
+    oops::Log::trace() << "MoisturePartition::MoisturePartition(params)" << std::endl;
+}
+
+std::string MoisturePartition::name() const
+{
+    return MoisturePartition::Name;
+}
+
+std::vector<std::string> MoisturePartition::ingredients() const
+{
+    return MoisturePartition::Ingredients;
+}
+
+std::vector<std::string> MoisturePartition::products() const
+{
+    return MoisturePartition::Products;
+}
+
+bool MoisturePartition::execute(atlas::FieldSet & afieldset)
+{
+    oops::Log::trace() << "entering MoisturePartition::execute function" << std::endl;
+    const bool moisture_partition_filled = mo::evalMoisturePartition(afieldset);
+    oops::Log::trace() << "leaving MoisturePartition::execute function" << std::endl;
+    return moisture_partition_filled;
+}
+
+}  // namespace vader
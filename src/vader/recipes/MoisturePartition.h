@@ -0,0 +1,63 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_RECIPES_MOISTUREPARTITION_H_
+#define SRC_VADER_RECIPES_MOISTUREPARTITION_H_
+
+#include <string>
+#include <vector>
+
+#include "atlas/field/FieldSet.h"
+#include "oops/util/parameters/RequiredParameter.h"
+#include "vader/RecipeBase.h"
+
+namespace vader {
+
+class MoisturePartitionParameters : public RecipeParametersBase {
+  OOPS_CONCRETE_PARAMETERS(MoisturePartitionParameters, RecipeParametersBase)
+
+ public:
+  oops::RequiredParameter<std::string> name{
+     "recipe name",
+     this};
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief MoisturePartition class defines a fused recipe for the moisture species
+ *
+ *  \details This instantiation of RecipeBase produces, in a single sweep over the
+ *           mixing ratios, the total mass of moist air m_t and the specific
+ *           humidity, cloud ice, cloud liquid and rain contents (q = m_x / m_t).
+ *           Only the products allocated in the fieldset are written. The results
+ *           are identical to those of TotalMassMoistAir followed by the
+ *           individual *FromMt recipes, which re-read m_t in one pass each.
+ *
+ *           The recipe is listed under each of its products in the cookbook; the
+ *           planner prefers it when at least two of them are needed.
+ */
+class MoisturePartition : public RecipeBase {
+ public:
+    static const char Name[];
+    static const std::vector<std::string> Ingredients;
+    static const std::vector<std::string> Products;
+
+    typedef MoisturePartitionParameters Parameters_;
+
+    MoisturePartition();
+    explicit MoisturePartition(const Parameters_ &);
+
+    // Recipe base class overrides
+    std::string name() const override;
+    std::vector<std::string> ingredients() const override;
+    std::vector<std::string> products() const override;
+    bool execute(atlas::FieldSet &) override;
+    bool columnwise() const override { return true; }
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_RECIPES_MOISTUREPARTITION_H_
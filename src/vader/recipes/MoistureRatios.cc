@@ -0,0 +1,82 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <string>
+#include <vector>
+
+#include "atlas/field/FieldSet.h"
+#include "mo/model2geovals_varchange.h"
+#include "oops/util/Logger.h"
+#include "vader/recipes/MoistureRatios.h"
+#include "vader/vadervariables.h"
+
+namespace vader
+{
+// ------------------------------------------------------------------------------------------------
+
+// Static attribute initialization
+const char TotalMassMoistAir::Name[] = "TotalMassMoistAir";
+const std::vector<std::string> TotalMassMoistAir::Ingredients = {VV_MV, VV_MCI, VV_MCL, VV_MR};
+const char SpecificHumidityFromMt::Name[] = "SpecificHumidityFromMt";
+const std::vector<std::string> SpecificHumidityFromMt::Ingredients = {VV_MV, VV_MT};
+const char MassCloudIceFromMt::Name[] = "MassCloudIceFromMt";
+const std::vector<std::string> MassCloudIceFromMt::Ingredients = {VV_MCI, VV_MT};
+const char MassCloudLiquidFromMt::Name[] = "MassCloudLiquidFromMt";
+const std::vector<std::string> MassCloudLiquidFromMt::Ingredients = {VV_MCL, VV_MT};
+const char MassRainFromMt::Name[] = "MassRainFromMt";
+const std::vector<std::string> MassRainFromMt::Ingredients = {VV_MR, VV_MT};
+
+// Register the makers
+static RecipeMaker<TotalMassMoistAir> makerTotalMassMoistAir_(TotalMassMoistAir::Name);
+static RecipeMaker<SpecificHumidityFromMt>
+    makerSpecificHumidityFromMt_(SpecificHumidityFromMt::Name);
+static RecipeMaker<MassCloudIceFromMt> makerMassCloudIceFromMt_(MassCloudIceFromMt::Name);
+static RecipeMaker<MassCloudLiquidFromMt> makerMassCloudLiquidFromMt_(MassCloudLiquidFromMt::Name);
+static RecipeMaker<MassRainFromMt> makerMassRainFromMt_(MassRainFromMt::Name);
+
+// ------------------------------------------------------------------------------------------------
+std::string TotalMassMoistAir::name() const {return TotalMassMoistAir::Name;}
+std::vector<std::string> TotalMassMoistAir::ingredients() const
+    {return TotalMassMoistAir::Ingredients;}
+bool TotalMassMoistAir::execute(atlas::FieldSet & afieldset) {
+    oops::Log::trace() << "TotalMassMoistAir::execute" << std::endl;
+    return mo::evalTotalMassMoistAir(afieldset);
+}
+// ------------------------------------------------------------------------------------------------
+std::string SpecificHumidityFromMt::name() const {return SpecificHumidityFromMt::Name;}
+std::vector<std::string> SpecificHumidityFromMt::ingredients() const
+    {return SpecificHumidityFromMt::Ingredients;}
+bool SpecificHumidityFromMt::execute(atlas::FieldSet & afieldset) {
+    oops::Log::trace() << "SpecificHumidityFromMt::execute" << std::endl;
+    return mo::evalSpecificHumidity(afieldset);
+}
+// ------------------------------------------------------------------------------------------------
+std::string MassCloudIceFromMt::name() const {return MassCloudIceFromMt::Name;}
+std::vector<std::string> MassCloudIceFromMt::ingredients() const
+    {return MassCloudIceFromMt::Ingredients;}
+bool MassCloudIceFromMt::execute(atlas::FieldSet & afieldset) {
+    oops::Log::trace() << "MassCloudIceFromMt::execute" << std::endl;
+    return mo::evalMassCloudIce(afieldset);
+}
+// ------------------------------------------------------------------------------------------------
+std::string MassCloudLiquidFromMt::name() const {return MassCloudLiquidFromMt::Name;}
+std::vector<std::string> MassCloudLiquidFromMt::ingredients() const
+    {return MassCloudLiquidFromMt::Ingredients;}
+bool MassCloudLiquidFromMt::execute(atlas::FieldSet & afieldset) {
+    oops::Log::trace() << "MassCloudLiquidFromMt::execute" << std::endl;
+    return mo::evalMassCloudLiquid(afieldset);
+}
+// ------------------------------------------------------------------------------------------------
+std::string MassRainFromMt::name() const {return MassRainFromMt::Name;}
+std::vector<std::string> MassRainFromMt::ingredients() const
+    {return MassRainFromMt::Ingredients;}
+bool MassRainFromMt::execute(atlas::FieldSet & afieldset) {
+    oops::Log::trace() << "MassRainFromMt::execute" << std::endl;
+    return mo::evalMassRain(afieldset);
+}
+
+}  // namespace vader
@@ -0,0 +1,147 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_RECIPES_MOISTURERATIOS_H_
+#define SRC_VADER_RECIPES_MOISTURERATIOS_H_
+
+#include <string>
+#include <vector>
+
+#include "atlas/field/FieldSet.h"
+#include "oops/util/parameters/RequiredParameter.h"
+#include "vader/RecipeBase.h"
+
+namespace vader {
+
+class MoistureRatiosParameters : public RecipeParametersBase {
+  OOPS_CONCRETE_PARAMETERS(MoistureRatiosParameters, RecipeParametersBase)
+
+ public:
+  oops::RequiredParameter<std::string> name{
+     "recipe name",
+     this};
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief TotalMassMoistAir class defines a recipe for the total mass of moist air
+ *
+ *  \details This instantiation of RecipeBase produces m_t = 1 + m_v + m_ci + m_cl + m_r
+ *           from the mixing ratios of water vapour, cloud ice, cloud liquid and rain.
+ */
+class TotalMassMoistAir : public RecipeBase {
+ public:
+    static const char Name[];
+    static const std::vector<std::string> Ingredients;
+
+    typedef MoistureRatiosParameters Parameters_;
+
+    TotalMassMoistAir() {}
+    explicit TotalMassMoistAir(const Parameters_ &) {}
+
+    // Recipe base class overrides
+    std::string name() const override;
+    std::vector<std::string> ingredients() const override;
+    bool execute(atlas::FieldSet &) override;
+    bool executesOnDevice() const override { return true; }
+    bool columnwise() const override { return true; }
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief SpecificHumidityFromMt class defines a recipe for specific humidity
+ *
+ *  \details This instantiation of RecipeBase produces q = m_v / m_t.
+ */
+class SpecificHumidityFromMt : public RecipeBase {
+ public:
+    static const char Name[];
+    static const std::vector<std::string> Ingredients;
+
+    typedef MoistureRatiosParameters Parameters_;
+
+    SpecificHumidityFromMt() {}
+    explicit SpecificHumidityFromMt(const Parameters_ &) {}
+
+    // Recipe base class overrides
+    std::string name() const override;
+    std::vector<std::string> ingredients() const override;
+    bool execute(atlas::FieldSet &) override;
+    bool executesOnDevice() const override { return true; }
+    bool columnwise() const override { return true; }
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief MassCloudIceFromMt class defines a recipe for the mass content of cloud ice
+ *
+ *  \details This instantiation of RecipeBase produces qci = m_ci / m_t.
+ */
+class MassCloudIceFromMt : public RecipeBase {
+ public:
+    static const char Name[];
+    static const std::vector<std::string> Ingredients;
+
+    typedef MoistureRatiosParameters Parameters_;
+
+    MassCloudIceFromMt() {}
+    explicit MassCloudIceFromMt(const Parameters_ &) {}
+
+    // Recipe base class overrides
+    std::string name() const override;
+    std::vector<std::string> ingredients() const override;
+    bool execute(atlas::FieldSet &) override;
+    bool executesOnDevice() const override { return true; }
+    bool columnwise() const override { return true; }
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief MassCloudLiquidFromMt class defines a recipe for the mass content of cloud liquid
+ *
+ *  \details This instantiation of RecipeBase produces qcl = m_cl / m_t.
+ */
+class MassCloudLiquidFromMt : public RecipeBase {
+ public:
+    static const char Name[];
+    static const std::vector<std::string> Ingredients;
+
+    typedef MoistureRatiosParameters Parameters_;
+
+    MassCloudLiquidFromMt() {}
+    explicit MassCloudLiquidFromMt(const Parameters_ &) {}
+
+    // Recipe base class overrides
+    std::string name() const override;
+    std::vector<std::string> ingredients() const override;
+    bool execute(atlas::FieldSet &) override;
+    bool executesOnDevice() const override { return true; }
+    bool columnwise() const override { return true; }
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief MassRainFromMt class defines a recipe for the specific rain content
+ *
+ *  \details This instantiation of RecipeBase produces qrain = m_r / m_t.
+ */
+class MassRainFromMt : public RecipeBase {
+ public:
+    static const char Name[];
+    static const std::vector<std::string> Ingredients;
+
+    typedef MoistureRatiosParameters Parameters_;
+
+    MassRainFromMt() {}
+    explicit MassRainFromMt(const Parameters_ &) {}
+
+    // Recipe base class overrides
+    std::string name() const override;
+    std::vector<std::string> ingredients() const override;
+    bool execute(atlas::FieldSet &) override;
+    bool executesOnDevice() const override { return true; }
+    bool columnwise() const override { return true; }
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_RECIPES_MOISTURERATIOS_H_
@@ -5,13 +5,20 @@
  * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
  */
 
-#include <math.h>
+#include <cmath>
 #include <iostream>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 #include "atlas/array.h"
+#include "atlas/array/DataType.h"
 #include "atlas/field/Field.h"
+#include "atlas/parallel/omp/omp.h"
 #include "atlas/util/Metadata.h"
+#ifdef VADER_ENABLE_MO
+#include "mo/functions.h"
+#endif
 #include "oops/util/Logger.h"
 #include "vader/recipes/TempToPTemp.h"
 #include "vader/vadervariables.h"
@@ -31,6 +38,20 @@ const double default_hPa_p0 = 1000.0;
 // Register the maker
 static RecipeMaker<TempToPTemp> makerTempToPTemp_(TempToPTemp::Name);
 
+namespace {
+// Calls functor(T()) with T the value type of the field (double or float) and
+// returns its result; false for any other data type
+template<typename Functor>
+bool dispatchValueType(const atlas::Field & field, const Functor & functor)
+{
+    if (field.datatype() == atlas::array::DataType::real64()) return functor(double());
+    if (field.datatype() == atlas::array::DataType::real32()) return functor(float());
+    oops::Log::error() << "TempToPTemp: field " << field.name() <<
+        " is neither double nor float." << std::endl;
+    return false;
+}
+}  // namespace
+
 TempToPTemp::TempToPTemp() :
     p0_{p0_not_in_params},
     kappa_{default_kappa}
@@ -59,22 +80,26 @@ std::vector<std::string> TempToPTemp::ingredients() const
     return TempToPTemp::Ingredients;
 }
 
-bool TempToPTemp::execute(atlas::FieldSet & afieldset)
+RecipeCost TempToPTemp::cost() const
 {
-    bool potential_temperature_filled = false;
-
-    oops::Log::trace() << "entering TempToPTemp::execute function"
-        << std::endl;
-
-    atlas::Field temperature = afieldset.field(VV_TS);
-    atlas::Field surface_pressure = afieldset.field(VV_PS);
-    atlas::Field potential_temperature = afieldset.field(VV_PT);
-    std::string t_units, ps_units;
+    // One multiply by the exner factor of the column per point (the pow and the read
+    // of the surface pressure are per column); temperature read, potential
+    // temperature written
+    RecipeCost recipeCost;
+    recipeCost.flopsPerPoint = 1.0;
+    recipeCost.bytesPerPoint = 16.0;
+    return recipeCost;
+}
 
-    temperature.metadata().get("units", t_units);
-    surface_pressure.metadata().get("units", ps_units);
+bool TempToPTemp::deduceP0(const atlas::Field & temperature,
+                           const atlas::Field & surface_pressure)
+{
     if (p0_ == p0_not_in_params)
     {
+        std::string t_units, ps_units;
+
+        temperature.metadata().get("units", t_units);
+        surface_pressure.metadata().get("units", ps_units);
         oops::Log::debug() << "TempToPTemp: p0 not in parameters. Deducing "
             "value from pressure units." << std::endl;
         if (ps_units == "Pa")
@@ -93,26 +118,180 @@ bool TempToPTemp::execute(atlas::FieldSet & afieldset)
         std::endl;
     oops::Log::debug() << "TempToPTemp::execute: kappa value: " << kappa_ <<
     std::endl;
+    return true;
+}
 
-    auto temperature_view = atlas::array::make_view<double, 2>(temperature);
-    auto surface_pressure_view = atlas::array::make_view<double, 2>(surface_pressure);
-    auto potential_temperature_view = atlas::array::make_view<double, 2>(potential_temperature);
+bool TempToPTemp::execute(atlas::FieldSet & afieldset)
+{
+    atlas::Field potential_temperature = afieldset.field(VV_PT);
+    return computePotentialTemperature(afieldset.field(VV_TS), afieldset.field(VV_PS),
+                                       potential_temperature);
+}
 
-    size_t grid_size = surface_pressure.size();
+bool TempToPTemp::execute(const BoundFields & fields)
+{
+    // The ingredients are bound in the order of Ingredients; the product is VV_PT
+    return computePotentialTemperature(fields.ingredient(0), fields.ingredient(1),
+                                       fields.product(0));
+}
 
-    int nlevels = temperature.levels();
-    for (int level = 0; level < nlevels; ++level) {
-      for ( size_t jnode = 0; jnode < grid_size ; ++jnode ) {
-        potential_temperature_view(jnode, level) =
-            temperature_view(jnode, level) * pow(p0_ / surface_pressure_view(jnode, 0), kappa_);
-      }
-    }
+bool TempToPTemp::computePotentialTemperature(const atlas::Field & temperature,
+                                              const atlas::Field & surface_pressure,
+                                              atlas::Field & potential_temperature)
+{
+    bool potential_temperature_filled = false;
+
+    oops::Log::trace() << "entering TempToPTemp::execute function"
+        << std::endl;
 
-    potential_temperature_filled = true;
+    if (!deduceP0(temperature, surface_pressure)) return false;
+
+    potential_temperature_filled = dispatchValueType(temperature, [&](const auto zero) {
+        typedef std::decay_t<decltype(zero)> T;
+        const auto temperature_view = atlas::array::make_view<const T, 2>(temperature);
+        const auto surface_pressure_view =
+            atlas::array::make_view<const T, 2>(surface_pressure);
+        auto potential_temperature_view = atlas::array::make_view<T, 2>(potential_temperature);
+
+        const atlas::idx_t nlevels = temperature.levels();
+
+        // The exner factor (p0 / ps)^kappa only depends on the node, so it is computed
+        // once per column rather than once per level (and in a scalar, so that the
+        // execution needs no work array). Node outer, level inner: the levels of a
+        // node are contiguous in the atlas layout.
+        const auto computeColumns = [&](const atlas::idx_t jnBegin, const atlas::idx_t jnEnd) {
+            for (atlas::idx_t jnode = jnBegin; jnode < jnEnd; ++jnode) {
+                const T factor = static_cast<T>(
+                    std::pow(p0_ / surface_pressure_view(jnode, 0), kappa_));
+                for (atlas::idx_t level = 0; level < nlevels; ++level) {
+                    potential_temperature_view(jnode, level) =
+                        temperature_view(jnode, level) * factor;
+                }
+            }
+        };
+#ifdef VADER_ENABLE_MO
+        // The tiles and the columns (owned only, or halo included) of the mo kernels,
+        // so that the recipe follows the threading and halo policy of the Vader
+        mo::functions::forEachColumnBlock(
+            mo::functions::computedColumns(potential_temperature), computeColumns);
+#else
+        const atlas::idx_t nnodes = surface_pressure.shape(0);
+        atlas_omp_parallel_for(atlas::idx_t jnode = 0; jnode < nnodes; ++jnode) {
+            computeColumns(jnode, jnode + 1);
+        }
+#endif
+        return true;
+    });
 
     oops::Log::trace() << "leaving TempToPTemp::execute function" << std::endl;
 
     return potential_temperature_filled;
 }
 
+bool TempToPTemp::setupTraj(const atlas::FieldSet & trajectory)
+{
+    oops::Log::trace() << "entering TempToPTemp::setupTraj function" << std::endl;
+
+    trajTemperature_ = trajectory.field(VV_TS);
+    const atlas::Field surface_pressure = trajectory.field(VV_PS);
+    if (!deduceP0(trajTemperature_, surface_pressure)) return false;
+
+    const bool setup = dispatchValueType(surface_pressure, [&](const auto zero) {
+        typedef std::decay_t<decltype(zero)> T;
+        const auto surface_pressure_view =
+            atlas::array::make_view<const T, 2>(surface_pressure);
+        const atlas::idx_t nnodes = surface_pressure.shape(0);
+
+        // The exner factor and its derivative with respect to the surface pressure,
+        // computed once per trajectory rather than in every TL and AD call
+        trajExnerFactor_.resize(nnodes);
+        trajExnerFactorDerivative_.resize(nnodes);
+        atlas_omp_parallel_for(atlas::idx_t jnode = 0; jnode < nnodes; ++jnode) {
+            const double ps = surface_pressure_view(jnode, 0);
+            trajExnerFactor_[jnode] = std::pow(p0_ / ps, kappa_);
+            trajExnerFactorDerivative_[jnode] = -kappa_ * trajExnerFactor_[jnode] / ps;
+        }
+        return true;
+    });
+
+    oops::Log::trace() << "leaving TempToPTemp::setupTraj function" << std::endl;
+    return setup;
+}
+
+bool TempToPTemp::executeTL(atlas::FieldSet & increments, const atlas::FieldSet &)
+{
+    oops::Log::trace() << "entering TempToPTemp::executeTL function" << std::endl;
+
+    // The increments and the trajectory may have different value types
+    const bool executed = dispatchValueType(increments.field(VV_TS), [&](const auto zero) {
+        typedef std::decay_t<decltype(zero)> T;
+        return dispatchValueType(trajTemperature_, [&](const auto trajZero) {
+            typedef std::decay_t<decltype(trajZero)> U;
+            const auto temperature_view = atlas::array::make_view<const U, 2>(trajTemperature_);
+            const auto temperature_inc_view =
+                atlas::array::make_view<const T, 2>(increments.field(VV_TS));
+            const auto surface_pressure_inc_view =
+                atlas::array::make_view<const T, 2>(increments.field(VV_PS));
+            auto potential_temperature_inc_view =
+                atlas::array::make_view<T, 2>(increments.field(VV_PT));
+
+            const atlas::idx_t nnodes = trajExnerFactor_.size();
+            const atlas::idx_t nlevels = trajTemperature_.levels();
+
+            atlas_omp_parallel_for(atlas::idx_t jnode = 0; jnode < nnodes; ++jnode) {
+                const double factor = trajExnerFactor_[jnode];
+                const double dfactor = trajExnerFactorDerivative_[jnode] *
+                                       surface_pressure_inc_view(jnode, 0);
+                for (atlas::idx_t level = 0; level < nlevels; ++level) {
+                    potential_temperature_inc_view(jnode, level) =
+                        temperature_inc_view(jnode, level) * factor +
+                        temperature_view(jnode, level) * dfactor;
+                }
+            }
+            return true;
+        });
+    });
+
+    oops::Log::trace() << "leaving TempToPTemp::executeTL function" << std::endl;
+    return executed;
+}
+
+bool TempToPTemp::executeAD(atlas::FieldSet & hats, const atlas::FieldSet &)
+{
+    oops::Log::trace() << "entering TempToPTemp::executeAD function" << std::endl;
+
+    // The adjoints and the trajectory may have different value types
+    const bool executed = dispatchValueType(hats.field(VV_TS), [&](const auto zero) {
+        typedef std::decay_t<decltype(zero)> T;
+        return dispatchValueType(trajTemperature_, [&](const auto trajZero) {
+            typedef std::decay_t<decltype(trajZero)> U;
+            const auto temperature_view = atlas::array::make_view<const U, 2>(trajTemperature_);
+            auto temperature_hat_view = atlas::array::make_view<T, 2>(hats.field(VV_TS));
+            auto surface_pressure_hat_view = atlas::array::make_view<T, 2>(hats.field(VV_PS));
+            auto potential_temperature_hat_view =
+                atlas::array::make_view<T, 2>(hats.field(VV_PT));
+
+            const atlas::idx_t nnodes = trajExnerFactor_.size();
+            const atlas::idx_t nlevels = trajTemperature_.levels();
+
+            atlas_omp_parallel_for(atlas::idx_t jnode = 0; jnode < nnodes; ++jnode) {
+                const double factor = trajExnerFactor_[jnode];
+                double dfactor_hat = 0.0;
+                for (atlas::idx_t level = 0; level < nlevels; ++level) {
+                    const double pt_hat = potential_temperature_hat_view(jnode, level);
+                    temperature_hat_view(jnode, level) += factor * pt_hat;
+                    dfactor_hat += temperature_view(jnode, level) * pt_hat;
+                    potential_temperature_hat_view(jnode, level) = 0.0;
+                }
+                surface_pressure_hat_view(jnode, 0) +=
+                    trajExnerFactorDerivative_[jnode] * dfactor_hat;
+            }
+            return true;
+        });
+    });
+
+    oops::Log::trace() << "leaving TempToPTemp::executeAD function" << std::endl;
+    return executed;
+}
+
 }  // namespace vader
@@ -11,6 +11,7 @@
 #include <string>
 #include <vector>
 
+#include "atlas/field/Field.h"
 #include "atlas/field/FieldSet.h"
 #include "oops/util/parameters/Parameter.h"
 #include "oops/util/parameters/RequiredParameter.h"
@@ -37,6 +38,15 @@ class TempToPTempParameters : public RecipeParametersBase {
  *           p0 and kappa can be specified via the constructor configuration.
  *           If they are not, the code will attempt to provide default values.
  *           (See https://glossary.ametsoc.org/wiki/Potential_temperature)
+ *
+ *           The fields may be double or float (all the fields of an execute, or
+ *           of the increments, of one type); the double path is unchanged.
+ *
+ *           The recipe uses the fields bound by Vader (execute(const BoundFields &))
+ *           rather than looking them up by name.
+ *
+ *           The recipe has a tangent linear and adjoint; the exner factor of the
+ *           trajectory is computed once, in setupTraj.
  */
 class TempToPTemp : public RecipeBase {
  public:
@@ -52,10 +62,27 @@ class TempToPTemp : public RecipeBase {
     std::string name() const override;
     std::vector<std::string> ingredients() const override;
     bool execute(atlas::FieldSet &) override;
+    bool execute(const BoundFields &) override;
+    RecipeCost cost() const override;
+    bool columnwise() const override { return true; }
+    bool hasTLAD() const override { return true; }
+    bool setupTraj(const atlas::FieldSet &) override;
+    bool executeTL(atlas::FieldSet &, const atlas::FieldSet &) override;
+    bool executeAD(atlas::FieldSet &, const atlas::FieldSet &) override;
 
  private:
+    bool deduceP0(const atlas::Field & temperature, const atlas::Field & surface_pressure);
+    bool computePotentialTemperature(const atlas::Field & temperature,
+                                     const atlas::Field & surface_pressure,
+                                     atlas::Field & potential_temperature);
+
     double p0_;
     const double kappa_;
+    // Trajectory, set by setupTraj: the temperature, and the exner factor (p0 / ps)^kappa
+    // and its derivative with respect to ps, per node
+    atlas::Field trajTemperature_;
+    std::vector<double> trajExnerFactor_;
+    std::vector<double> trajExnerFactorDerivative_;
 };
 
 }  // namespace vader
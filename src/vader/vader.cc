@@ -6,23 +6,45 @@
  */
 
 #include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "atlas/array.h"
 #include "atlas/field/Field.h"
+#include "atlas/functionspace/FunctionSpace.h"
+#include "eckit/mpi/Comm.h"
+#ifdef VADER_ENABLE_MO
+#include "mo/functions.h"
+#include "mo/lookup_cache.h"
+#endif
 #include "oops/util/Logger.h"
 #include "oops/util/Timer.h"
+#include "vader/BoundFields.h"
 #include "vader/cookbook.h"
+#include "vader/FieldSignature.h"
 #include "vader/vader.h"
 
 namespace vader {
 
 // ------------------------------------------------------------------------------------------------
 Vader::~Vader() {
+    oops::Log::debug() << "Vader plan cache: " << planCache_.size() << " plans, " <<
+        planCache_.hits() << " hits, " << planCache_.misses() << " misses" << std::endl;
+    if (!instrumentationFile_.empty()) {
+        std::string fileName(instrumentationFile_);
+        if (eckit::mpi::comm().size() > 1) {
+            fileName += "." + std::to_string(eckit::mpi::comm().rank());
+        }
+        std::ofstream out(fileName);
+        instrumentation().writeJSON(out);
+        out << std::endl;
+    }
     oops::Log::trace() << "Vader::~Vader done" << std::endl;
 }
 // ------------------------------------------------------------------------------------------------
@@ -81,6 +103,88 @@ Vader::Vader(const VaderParameters & parameters) {
     } else {
         createCookbook(definition, *parameters.recipeParams.value());
     }
+    compiledCookbook_.compile(cookbook_);
+
+    if (parameters.threads.value() > 1) {
+        threadPool_ = std::make_unique<ThreadPool>(parameters.threads.value());
+    }
+
+    allocateIntermediates_ = parameters.allocateIntermediates.value();
+    cheapestPlan_ = parameters.cheapestPlan.value();
+    ASSERT_MSG(parameters.blockColumns.value() >= 0, "Vader block columns must not be negative");
+    blockColumns_ = parameters.blockColumns.value();
+
+    skipUnchanged_ = parameters.skipUnchanged.value();
+    recipeMemo_.resize(1, std::vector<RecipeMemo>(compiledCookbook_.nRecipes()));
+
+    const std::string & backend = parameters.backend.value();
+    ASSERT_MSG(backend == "host" || backend == "device",
+               "Vader backend must be \"host\" or \"device\", not \"" + backend + "\"");
+    if (backend == "device") {
+#ifdef VADER_ENABLE_MO
+        // The kernels only run on the device while the device recipes of this Vader
+        // execute (see executeRecipeNL)
+        ASSERT_MSG(mo::functions::deviceBackendAvailable(),
+                   "The Vader device backend is not available (build with ENABLE_VADER_DEVICE)");
+        deviceBackend_ = true;
+#else
+        ASSERT_MSG(false, "The Vader device backend needs the mo kernels (ENABLE_VADER_MO)");
+#endif
+    }
+
+    const std::string & halo = parameters.halo.value();
+    ASSERT_MSG(halo == "compute" || halo == "exchange",
+               "Vader halo policy must be \"compute\" or \"exchange\", not \"" + halo + "\"");
+    // The kernels only compute the owned columns while the recipes of this Vader
+    // execute (see executeRecipeNL)
+    exchangeHalos_ = halo == "exchange";
+
+    if (parameters.lookupTableFile.value() != boost::none) {
+#ifdef VADER_ENABLE_MO
+        mo::functions::LookUpCache::instance().setTableFile(
+            *parameters.lookupTableFile.value());
+#else
+        ASSERT_MSG(false, "The Vader lookup table file needs the mo kernels (ENABLE_VADER_MO)");
+#endif
+    }
+
+    if (parameters.sharedLookupTables.value()) {
+#ifdef VADER_ENABLE_MO
+        // Loaded here, so that all the tasks load the tables in the same order
+        mo::functions::LookUpCache::instance().setNodeShared(eckit::mpi::comm());
+        mo::functions::LookUpCache::instance().preload();
+#else
+        ASSERT_MSG(false, "The Vader shared lookup tables need the mo kernels (ENABLE_VADER_MO)");
+#endif
+    }
+
+    if (parameters.instrumentation.value()) {
+        recipeInstrumentation_.setEnabled(true);
+        phaseInstrumentation_.setEnabled(true);
+        // The kernel instrumentation is process-wide and stays enabled
+        Instrumentation::kernels().setEnabled(true);
+        if (parameters.instrumentationFile.value() != boost::none) {
+            instrumentationFile_ = *parameters.instrumentationFile.value();
+        }
+    }
+}
+// ------------------------------------------------------------------------------------------------
+InstrumentationReport Vader::instrumentation() const {
+    InstrumentationReport report;
+    report.recipes = recipeInstrumentation_.stats();
+    report.phases = phaseInstrumentation_.stats();
+    if (recipeInstrumentation_.enabled()) {
+        report.kernels = Instrumentation::kernels().stats();
+        report.caches["plan cache"] = CacheStats{planCache_.hits(), planCache_.misses()};
+#ifdef VADER_ENABLE_MO
+        const auto & lookUpCache = mo::functions::LookUpCache::instance();
+        report.caches["lookup table cache"] = CacheStats{lookUpCache.hits(),
+                                                         lookUpCache.misses()};
+#endif
+        std::lock_guard<std::mutex> lock(planStatsMutex_);
+        report.plans = planStats_;
+    }
+    return report;
 }
 // ------------------------------------------------------------------------------------------------
 /*! \brief Change Variable
@@ -98,6 +202,9 @@ Vader::Vader(const VaderParameters & parameters) {
 * variables it was able to populate will have been removed from the neededVars
 * list. Any variable names remaining in neededVars remain unpopulated.
 *
+* With the 'block columns' parameter set, chunkable plans are executed block of
+* columns by block of columns (see executePlanChunked).
+*
 * \param[in,out] afieldset This is the FieldSet described above
 * \param[in,out] neededVars Names of unpopulated Fields in afieldset
 * \returns List of variables VADER was able to populate
@@ -111,20 +218,23 @@ oops::Variables Vader::changeVar(atlas::FieldSet & afieldset,
 
     oops::Variables varsProduced(neededVars);
 
-    auto fieldSetFieldNames = afieldset.field_names();
-    // Loop through all the requested fields in neededVars
-    // Since neededVars can be modified by planVariable and planVariable calls
-    // itself recursively, we make a copy of the list here before we start.
-    std::vector<std::string> targetVariables{neededVars.variables()};
-    std::vector<std::pair<std::string, std::string>> plan;
-
-    for (auto targetVariable : targetVariables) {
-        oops::Log::debug() <<
-            "Vader::changeVar calling Vader::planVariable for: "
-            << targetVariable << std::endl;
-        planVariable(afieldset, neededVars, targetVariable, plan);
+    std::shared_ptr<const ExecutionPlan> plan = findPlan(afieldset, neededVars);
+    {
+        ScopedTiming timing(phaseInstrumentation_, "executePlan");
+        if (blockColumns_ > 0 && chunkable(afieldset, *plan)) {
+            executePlanChunked(afieldset, *plan);
+        } else if (plan->intermediates.empty()) {
+            executePlanNL(afieldset, *plan);
+        } else {
+            std::vector<atlas::Field> intermediates;
+            atlas::FieldSet workingFieldSet = withIntermediates(afieldset, *plan, intermediates,
+                                                                fieldPool_);
+            executePlanNL(workingFieldSet, *plan);
+            for (const auto & field : intermediates) fieldPool_.release(field);
+        }
+        if (deviceBackend_) updateHostFields(afieldset);
+        if (exchangeHalos_) exchangeHalos(afieldset, *plan);
     }
-    executePlanNL(afieldset, plan);
 
     oops::Log::debug() << "neededVars remaining after Vader::changeVar: " << neededVars
         << std::endl;
@@ -133,142 +243,763 @@ oops::Variables Vader::changeVar(atlas::FieldSet & afieldset,
     return varsProduced;
 }
 // ------------------------------------------------------------------------------------------------
-/*! \brief Plan Variable
+/*! \brief Change Variable (batched)
 *
-* \details **planVariable** contains Vader's primary algorithm for attempting to
-* populate an unpopulated field. It:
-* * Checks the cookbook for recipes for the desired field (the targetVariable)
-* * Checks each recipe to see if its required ingredients have been provided
-* * If an ingredient is missing, recursively calls itself to attempt to get it
-* * Adds the variable and recipe name to the "recipeExecutionPlan" if the recipe is viable.
-* * If successful, removes the targetVariable from neededVars and returns 'true'
+* \details This **changeVar** populates neededVars in each fieldset of members, like
+* changeVar does for a single fieldset. The members must have the same fields, so
+* that a single plan (created, or found in the plan cache, for the first member)
+* applies to all of them. Each recipe is executed for all the members before the next
+* recipe, which amortises its setup, lookup table loads and coefficients across the
+* members. With a thread pool the members (and the independent recipes) are executed
+* concurrently, once the first member has run the recipes of the dependency level.
 *
-* \param[in,out] afieldset A fieldset containg both populated and unpopulated fields
-* \param[in,out] neededVars Names of unpopulated Fields in afieldset
-* \param[in] targetVariable variable name this instance is trying to populate
-* \param[in,out] plan ordered list of viable recipes that will get exectued later
-* \return boolean 'true' if it successfully creates a plan for targetVariable, else false
+* \param[in,out] members The fieldsets (one per ensemble member), as for changeVar
+* \param[in,out] neededVars Names of unpopulated Fields in each of the members
+* \returns List of variables VADER was able to populate in all the members
 *
 */
-bool Vader::planVariable(atlas::FieldSet & afieldset,
-                         oops::Variables & neededVars,
-                         const std::string targetVariable,
-                         std::vector<std::pair<std::string, std::string>> & plan) const {
-    bool variablePlanned = false;
-
-    oops::Log::trace() << "entering Vader::planVariable for variable: " << targetVariable <<
+oops::Variables Vader::changeVar(std::vector<atlas::FieldSet> & members,
+                                 oops::Variables & neededVars) const {
+    util::Timer timer(classname(), "changeVar");
+    oops::Log::trace() << "entering Vader::changeVar (" << members.size() << " members)" <<
         std::endl;
+    if (members.empty()) return oops::Variables();
+    oops::Variables varsProduced(neededVars);
 
-    auto fieldSetFieldNames = afieldset.field_names();
+    const PlanCache::Key planKey = PlanCache::makeKey(members[0], neededVars);
+    for (std::size_t jm = 1; jm < members.size(); ++jm) {
+        ASSERT_MSG(PlanCache::makeKey(members[jm], neededVars) == planKey,
+                   "Vader::changeVar members must have the same fields");
+    }
+    std::shared_ptr<const ExecutionPlan> plan = findPlan(members[0], neededVars);
+    if (skipUnchanged_) {
+        std::lock_guard<std::mutex> lock(memoMutex_);
+        if (recipeMemo_.size() < members.size()) {
+            recipeMemo_.resize(members.size(),
+                               std::vector<RecipeMemo>(compiledCookbook_.nRecipes()));
+        }
+    }
+    {
+        ScopedTiming timing(phaseInstrumentation_, "executePlan");
+        std::vector<std::vector<atlas::Field>> intermediates(members.size());
+        std::vector<atlas::FieldSet> workingFieldSets;
+        for (std::size_t jm = 0; jm < members.size(); ++jm) {
+            workingFieldSets.push_back(withIntermediates(members[jm], *plan, intermediates[jm],
+                                                       fieldPool_));
+        }
+        executePlanNL(workingFieldSets, *plan);
+        for (const auto & memberIntermediates : intermediates) {
+            for (const auto & field : memberIntermediates) fieldPool_.release(field);
+        }
+        if (deviceBackend_) {
+            for (const auto & member : members) updateHostFields(member);
+        }
+        if (exchangeHalos_) {
+            // One exchange for the products of all the members
+            atlas::FieldSet allMembers;
+            for (const auto & member : members) {
+                for (atlas::idx_t jf = 0; jf < member.size(); ++jf) allMembers.add(member[jf]);
+            }
+            exchangeHalos(allMembers, *plan);
+        }
+    }
 
-    if (std::find(fieldSetFieldNames.begin(),
-        fieldSetFieldNames.end(), targetVariable) == fieldSetFieldNames.end()) {
-        oops::Log::debug() << "Field '" << targetVariable <<
-            "' is not allocated the fieldset. Vader cannot make it." << std::endl;
-        oops::Log::trace() << "leaving Vader::planVariable for variable: " <<
-            targetVariable << std::endl;
-        return false;
+    varsProduced -= neededVars;
+    oops::Log::trace() << "leaving Vader::changeVar" << std::endl;
+    return varsProduced;
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Change Variable Trajectory
+*
+* \details **changeVarTraj** sets the trajectory of the linearized variable change
+* (changeVarTL and changeVarAD). It populates neededVars in the trajectory fieldset
+* like changeVar does, but only with the recipes that have a tangent linear and
+* adjoint, then calls their setupTraj. This is meant to be called once per outer
+* loop: the plan, the trajectory fields (including any intermediate fields) and the
+* quantities the recipes cache in setupTraj are reused by every changeVarTL and
+* changeVarAD until the next call. (The linear plans are not put in the plan cache.)
+*
+* \param[in,out] trajectory The trajectory fieldset; it must outlive the linear calls
+* \param[in,out] neededVars Names of unpopulated Fields in trajectory
+* \returns List of variables the linearized variable change populates
+*
+*/
+oops::Variables Vader::changeVarTraj(atlas::FieldSet & trajectory,
+                                     oops::Variables & neededVars) {
+    util::Timer timer(classname(), "changeVarTraj");
+    oops::Log::trace() << "entering Vader::changeVarTraj " << std::endl;
+    oops::Variables varsProduced(neededVars);
+
+    for (const auto & field : trajIntermediates_) fieldPool_.release(field);
+    trajIntermediates_.clear();
+    {
+        ScopedTiming timing(phaseInstrumentation_, "createPlan");
+        trajPlan_ = createPlan(trajectory, neededVars, true);
+    }
+    trajectory_ = withIntermediates(trajectory, *trajPlan_, trajIntermediates_, fieldPool_);
+    {
+        ScopedTiming timing(phaseInstrumentation_, "executePlan");
+        executePlanNL(trajectory_, *trajPlan_);
+        if (deviceBackend_) updateHostFields(trajectory_);
+        // The linear recipes read the trajectory, intermediates included, in the halos
+        if (exchangeHalos_) exchangeHalos(trajectory_, *trajPlan_);
+    }
+    {
+        ScopedTiming timing(phaseInstrumentation_, "setupTraj");
+        for (const auto rec : trajPlan_->recipes) {
+            const bool setupSuccess = compiledCookbook_.recipe(rec).setupTraj(trajectory_);
+            ASSERT(setupSuccess);
+        }
     }
 
-    // Since this function is called recursively, make sure targetVariable is
-    // still needed
-    if (!neededVars.has(targetVariable)) {
-        oops::Log::debug() << targetVariable <<
-            " is no longer in the variable list neededVars." << std::endl;
-        oops::Log::trace() << "leaving Vader::planVariable for variable: "
-            << targetVariable << std::endl;
-        return true;
+    varsProduced -= neededVars;
+    oops::Log::trace() << "leaving Vader::changeVarTraj" << std::endl;
+    return varsProduced;
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Change Variable Tangent Linear
+*
+* \details **changeVarTL** calls the executeTL method of the recipes planned by
+* changeVarTraj, in plan order. The increments fieldset holds the increments of the
+* ingredients and the allocated increments of the variables to populate.
+*
+* \param[in,out] increments The increments fieldset
+* \param[in,out] neededVars Names of unpopulated Fields in increments; the variables
+*                 populated are removed
+* \returns List of variables VADER was able to populate
+*
+*/
+oops::Variables Vader::changeVarTL(atlas::FieldSet & increments,
+                                   oops::Variables & neededVars) const {
+    util::Timer timer(classname(), "changeVarTL");
+    ASSERT_MSG(trajPlan_, "Vader::changeVarTL called before changeVarTraj");
+    oops::Variables varsProduced(neededVars);
+    {
+        ScopedTiming timing(phaseInstrumentation_, "executePlanTL");
+        std::vector<atlas::Field> intermediates;
+        atlas::FieldSet workingFieldSet = withIntermediates(increments, *trajPlan_,
+                                                            intermediates, linearFieldPool_);
+        executePlanTL(workingFieldSet, *trajPlan_);
+        for (const auto & field : intermediates) linearFieldPool_.release(field);
     }
+    neededVars -= trajPlan_->plannedVars;
+    varsProduced -= neededVars;
+    return varsProduced;
+}
+// ------------------------------------------------------------------------------------------------
+namespace {
+/// Zeroes a rank 2 double or float field (the intermediates have the data type of the
+/// first ingredient of their producer)
+void zeroField(atlas::Field & field) {
+    if (field.datatype() == atlas::array::DataType::real32()) {
+        atlas::array::make_view<float, 2>(field).assign(0.0f);
+    } else {
+        ASSERT_MSG(field.datatype() == atlas::array::DataType::real64(),
+                   "Vader: field " + field.name() + " is neither double nor float");
+        atlas::array::make_view<double, 2>(field).assign(0.0);
+    }
+}
+}  // namespace
+// ------------------------------------------------------------------------------------------------
+/*! \brief Change Variable Adjoint
+*
+* \details **changeVarAD** calls the executeAD method of the recipes planned by
+* changeVarTraj, in reverse plan order. The adjoint of the populated variables (in
+* the fieldset on input) is added to the adjoint of the ingredients, and then zeroed.
+*
+* \param[in,out] hats The adjoint fieldset
+* \param[in,out] neededVars Names of the variables populated by changeVarTL; the
+*                 variables whose adjoint was propagated are removed
+* \returns List of variables whose adjoint VADER propagated
+*
+*/
+oops::Variables Vader::changeVarAD(atlas::FieldSet & hats,
+                                   oops::Variables & neededVars) const {
+    util::Timer timer(classname(), "changeVarAD");
+    ASSERT_MSG(trajPlan_, "Vader::changeVarAD called before changeVarTraj");
+    oops::Variables varsProduced(neededVars);
+    {
+        ScopedTiming timing(phaseInstrumentation_, "executePlanAD");
+        std::vector<atlas::Field> intermediates;
+        atlas::FieldSet workingFieldSet = withIntermediates(hats, *trajPlan_, intermediates,
+                                                            linearFieldPool_);
+        // The adjoints of the intermediates are accumulated from those of their consumers
+        for (auto & field : intermediates) zeroField(field);
+        executePlanAD(workingFieldSet, *trajPlan_);
+        for (const auto & field : intermediates) linearFieldPool_.release(field);
+    }
+    neededVars -= trajPlan_->plannedVars;
+    varsProduced -= neededVars;
+    return varsProduced;
+}
+// ------------------------------------------------------------------------------------------------
+atlas::FieldSet Vader::withIntermediates(atlas::FieldSet & afieldset, const ExecutionPlan & plan,
+                                         std::vector<atlas::Field> & intermediates,
+                                         FieldPool & pool) const {
+    // The recipes see the caller's fields (shared, not copied) and the intermediate
+    // fields, acquired from pool, which the caller returns to it afterwards
+    atlas::FieldSet workingFieldSet;
+    for (atlas::idx_t jf = 0; jf < afieldset.size(); ++jf) {
+        workingFieldSet.add(afieldset[jf]);
+    }
+    for (const auto & intermediate : plan.intermediates) {
+        const CompiledCookbook::RecipeId producer = intermediate.second;
+        const atlas::Field & shape = workingFieldSet.field(
+            compiledCookbook_.variableName(*compiledCookbook_.ingredientsBegin(producer)));
+        intermediates.push_back(pool.acquire(
+            compiledCookbook_.variableName(intermediate.first), shape.functionspace(),
+            compiledCookbook_.recipe(producer).productLevels(workingFieldSet),
+            shape.datatype()));
+        workingFieldSet.add(intermediates.back());
+    }
+    return workingFieldSet;
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Find Plan
+*
+* \details **findPlan** returns the cached plan for the structure of the fieldset and
+* neededVars, creating (and caching) it on a miss. The planned variables are removed
+* from neededVars.
+*
+*/
+std::shared_ptr<const ExecutionPlan> Vader::findPlan(atlas::FieldSet & afieldset,
+                                                    oops::Variables & neededVars) const {
+    const PlanCache::Key planKey = PlanCache::makeKey(afieldset, neededVars);
+    std::shared_ptr<const ExecutionPlan> plan = planCache_.find(planKey);
+    if (plan) {
+        oops::Log::debug() << "Vader::changeVar re-using cached plan" << std::endl;
+        neededVars -= plan->plannedVars;
+    } else {
+        ScopedTiming timing(phaseInstrumentation_, "createPlan");
+        plan = createPlan(afieldset, neededVars);
+        planCache_.insert(planKey, plan);
+    }
+    return plan;
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Create Plan
+*
+* \details **createPlan** flags the fields allocated in the fieldset and the variables
+* in neededVars by their CompiledCookbook ids, then calls CompiledCookbook::planVariable
+* for each of the needed variables. The variables that were planned (all the products
+* of the planned recipes) are removed from neededVars.
+*
+* \param[in,out] afieldset A fieldset containg both populated and unpopulated fields
+* \param[in,out] neededVars Names of unpopulated Fields in afieldset
+* \param[in] linear if true, only the recipes with a tangent linear and adjoint are used
+* \returns The compiled plan
+*
+*/
+std::shared_ptr<const ExecutionPlan> Vader::createPlan(atlas::FieldSet & afieldset,
+                                                       oops::Variables & neededVars,
+                                                       const bool linear) const {
+    oops::Log::trace() << "entering Vader::createPlan" << std::endl;
+    auto plan = std::make_shared<ExecutionPlan>();
 
-    auto recipeList = cookbook_.find(targetVariable);
+    const std::size_t nVars = compiledCookbook_.nVariables();
+    std::vector<char> allocated(nVars, 0);
+    std::vector<char> needed(nVars, 0);
+    if (allocateIntermediates_) {
+        // Any variable may be allocated as an intermediate; it must then be populated
+        allocated.assign(nVars, CompiledCookbook::intermediate);
+        needed.assign(nVars, 1);
+    }
+    for (const auto & fieldName : afieldset.field_names()) {
+        const auto var = compiledCookbook_.variableId(fieldName);
+        if (var != CompiledCookbook::npos) {
+            allocated[var] = CompiledCookbook::inFieldSet;
+            needed[var] = 0;
+        }
+    }
+    std::vector<CompiledCookbook::VarId> targetVariables;
+    for (const auto & neededVar : neededVars.variables()) {
+        const auto var = compiledCookbook_.variableId(neededVar);
+        if (var == CompiledCookbook::npos) {
+            oops::Log::debug() << "Vader cookbook does not contain a recipe for: "
+                << neededVar << std::endl;
+        } else {
+            // A target missing from the fieldset would not be returned to the caller
+            if (allocated[var] != CompiledCookbook::inFieldSet) allocated[var] = 0;
+            needed[var] = 1;
+            targetVariables.push_back(var);
+        }
+    }
 
-    // If recipeList is found, recipeList->second is a vector of unique_ptr's
-    // to Recipe objects that produce 'variableName'
-    if ((recipeList != cookbook_.end()) && !recipeList->second.empty()) {
+    for (const auto targetVariable : targetVariables) {
         oops::Log::debug() <<
-            "Vader cookbook contains at least one recipe for '" << targetVariable << "'" <<
-            std::endl;
-        for (int i=0; i < recipeList->second.size(); ++i) {
-            oops::Log::debug() << "Checking to see if we have ingredients for recipe: " <<
-                recipeList->second[i]->name() << std::endl;
-            bool haveIngredient = false;
-            for (auto ingredient : recipeList->second[i]->ingredients()) {
-                if (ingredient == targetVariable) {
-                    oops::Log::error() << "Error: Ingredient list for " <<
-                        recipeList->second[i]->name() << " contains the target." << std::endl;
-                    // This could cause infinite recursion if we didn't check.
-                    // TODO(vahl): infinite recursion probably still possible
-                    //       with badly-constructed cookbook.
-                    break;
-                }
-                haveIngredient =
-                    (std::find(fieldSetFieldNames.begin(), fieldSetFieldNames.end(), ingredient)
-                        != fieldSetFieldNames.end()) && (!neededVars.has(ingredient));
-                if (!haveIngredient) {
-                    oops::Log::debug() << "ingredient " << ingredient <<
-                        " not found. Recursively checking if Vader can make it." << std::endl;
-                    haveIngredient = planVariable(afieldset, neededVars, ingredient, plan);
-                }
-                oops::Log::debug() << "ingredient " << ingredient <<
-                    (haveIngredient ? " is" : " is not") << " available." << std::endl;
-                if (!haveIngredient) break;
-            }
-            if (haveIngredient) {
-                oops::Log::debug() <<
-                    "All ingredients are in the fieldset. Adding recipe to recipeExecutionPlan." <<
-                    std::endl;
-                plan.push_back(std::pair<std::string, std::string> ({targetVariable,
-                                                                  recipeList->second[i]->name()}));
-                variablePlanned = true;
-                neededVars -= targetVariable;
+            "Vader::createPlan calling CompiledCookbook::planVariable for: "
+            << compiledCookbook_.variableName(targetVariable) << std::endl;
+        compiledCookbook_.planVariable(allocated, needed, targetVariable, plan->recipes,
+                                       linear, cheapestPlan_);
+    }
+
+    oops::Variables originalNeededVars(neededVars);
+    std::vector<char> isIntermediate(nVars, 0);
+    for (const auto rec : plan->recipes) {
+        for (auto ing = compiledCookbook_.ingredientsBegin(rec);
+             ing != compiledCookbook_.ingredientsEnd(rec); ++ing) {
+            if (allocated[*ing] == CompiledCookbook::intermediate) {
+                isIntermediate[*ing] = 1;
             } else {
-                oops::Log::debug() << "Do not have all the ingredients for this recipe." <<
-                    std::endl;
+                ASSERT(afieldset.has_field(compiledCookbook_.variableName(*ing)));
             }
         }
-    } else {
-        oops::Log::debug() << "Vader cookbook does not contain a recipe for: "
-            << targetVariable << std::endl;
+        for (auto prod = compiledCookbook_.productsBegin(rec);
+             prod != compiledCookbook_.productsEnd(rec); ++prod) {
+            neededVars -= compiledCookbook_.variableName(*prod);
+        }
+    }
+    // Intermediates in the order of their producers, so that the first ingredient of
+    // a producer (which gives the shape of its products) is allocated before them
+    for (const auto rec : plan->recipes) {
+        for (auto prod = compiledCookbook_.productsBegin(rec);
+             prod != compiledCookbook_.productsEnd(rec); ++prod) {
+            if (isIntermediate[*prod]) {
+                plan->intermediates.emplace_back(*prod, rec);
+                isIntermediate[*prod] = 0;
+            }
+        }
+    }
+    plan->plannedVars = originalNeededVars;
+    plan->plannedVars -= neededVars;
+
+    // Positions of the fields of the recipes in the fieldset of the execution: the
+    // caller's fields, then the intermediates (see withIntermediates)
+    std::vector<atlas::idx_t> position(nVars, RecipeFields::npos);
+    for (atlas::idx_t jf = 0; jf < afieldset.size(); ++jf) {
+        const auto var = compiledCookbook_.variableId(afieldset[jf].name());
+        if (var != CompiledCookbook::npos) position[var] = jf;
+    }
+    for (std::size_t ji = 0; ji < plan->intermediates.size(); ++ji) {
+        position[plan->intermediates[ji].first] = afieldset.size() + ji;
+    }
+    plan->fields.resize(compiledCookbook_.nRecipes());
+    plan->setupOnce = std::make_unique<std::once_flag[]>(compiledCookbook_.nRecipes());
+    for (const auto rec : plan->recipes) {
+        RecipeFields & fields = plan->fields[rec];
+        for (auto ing = compiledCookbook_.ingredientsBegin(rec);
+             ing != compiledCookbook_.ingredientsEnd(rec); ++ing) {
+            ASSERT(position[*ing] != RecipeFields::npos);
+            fields.ingredients.push_back(position[*ing]);
+        }
+        bool populates = false;
+        for (auto prod = compiledCookbook_.productsBegin(rec);
+             prod != compiledCookbook_.productsEnd(rec); ++prod) {
+            fields.products.push_back(position[*prod]);
+            populates = populates || position[*prod] != RecipeFields::npos;
+        }
+        // A planned recipe populates a field of the fieldset or an intermediate
+        ASSERT_MSG(populates, "Vader plan: recipe " + compiledCookbook_.recipeName(rec) +
+                              " has none of its products in the fieldset");
     }
-    oops::Log::trace() << "leaving Vader::planVariable for variable: " << targetVariable <<
-        std::endl;
-    return variablePlanned;
-}
 
+    // Dependency level of each recipe: one more than the deepest level producing
+    // one of its ingredients, 0 if all of them were already in the fieldset
+    std::vector<std::size_t> producerLevel(nVars, CompiledCookbook::npos);
+    for (const auto rec : plan->recipes) {
+        std::size_t level = 0;
+        for (auto ing = compiledCookbook_.ingredientsBegin(rec);
+             ing != compiledCookbook_.ingredientsEnd(rec); ++ing) {
+            if (producerLevel[*ing] != CompiledCookbook::npos) {
+                level = std::max(level, producerLevel[*ing] + 1);
+            }
+        }
+        for (auto prod = compiledCookbook_.productsBegin(rec);
+             prod != compiledCookbook_.productsEnd(rec); ++prod) {
+            producerLevel[*prod] = level;
+        }
+        if (plan->levels.size() <= level) plan->levels.resize(level + 1);
+        plan->levels[level].push_back(rec);
+    }
+
+    // Predicted cost
+    for (const auto rec : plan->recipes) {
+        const RecipeCost & recipeCost = compiledCookbook_.descriptor(rec).cost;
+        plan->cost.flopsPerPoint += recipeCost.flopsPerPoint;
+        plan->cost.bytesPerPoint += recipeCost.bytesPerPoint;
+        plan->rooflineCost += compiledCookbook_.cost(rec);
+    }
+    oops::Log::debug() << "Vader::createPlan predicted cost: " << plan->cost.flopsPerPoint <<
+        " flops, " << plan->cost.bytesPerPoint << " bytes per point" << std::endl;
+    if (recipeInstrumentation_.enabled()) {
+        PlanStats stats;
+        for (const auto rec : plan->recipes) {
+            stats.recipes.push_back(compiledCookbook_.recipeName(rec));
+        }
+        stats.flopsPerPoint = plan->cost.flopsPerPoint;
+        stats.bytesPerPoint = plan->cost.bytesPerPoint;
+        stats.rooflineCost = plan->rooflineCost;
+        std::lock_guard<std::mutex> lock(planStatsMutex_);
+        planStats_.push_back(stats);
+    }
+
+    oops::Log::trace() << "leaving Vader::createPlan" << std::endl;
+    return plan;
+}
+// ------------------------------------------------------------------------------------------------
 /*! \brief Execute Plan (non-linear)
 *
-* \details **executePlanNL** calls, in order, the 'execute' (non-linear) method of the
-* recipes specified in the recipeExecutionPlan that is passed in. (The recipeExecutionPlan is
-* created through calls to planVariable.)
+* \details **executePlanNL** calls the 'execute' (non-linear) method of the recipes
+* specified in the plan that is passed in. (The plan is created by createPlan or
+* retrieved from the plan cache.) Without a thread pool the recipes are executed in
+* order. With a thread pool the dependency levels of the plan are executed in order,
+* and the recipes within a level concurrently.
 *
 * \param[in,out] afieldset A fieldset containg both populated and unpopulated fields
-* \param[in] recipeExecutionPlan ordered list of recipes that are to be exectued
+* \param[in] plan compiled plan holding the ordered list of recipes that are to be exectued
 *
 */
-void Vader::executePlanNL(atlas::FieldSet & afieldset,
-            const std::vector<std::pair<std::string, std::string>> & recipeExecutionPlan) const {
+void Vader::executePlanNL(atlas::FieldSet & afieldset, const ExecutionPlan & plan) const {
     oops::Log::trace() << "entering Vader::executePlanNL" <<  std::endl;
-    // We must get the recipes specified in the recipeExecutionPlan out of the cookbook,
-    // where they live
-    for (auto varPlan : recipeExecutionPlan) {
-        oops::Log::debug() << "Attempting to calculate variable " << varPlan.first <<
-            " using recipe with name: " << varPlan.second << std::endl;
-        ASSERT(afieldset.has_field(varPlan.first));
-        auto recipeList = cookbook_.find(varPlan.first);
-        size_t recipeIndex = 0;
-        while (recipeIndex < recipeList->second.size() &&
-               recipeList->second[recipeIndex]->name() != varPlan.second) recipeIndex++;
-        ASSERT(recipeIndex < recipeList->second.size());
-        for (auto ingredient :  recipeList->second[recipeIndex]->ingredients()) {
-            ASSERT(afieldset.has_field(ingredient));
-        }
-        if (recipeList->second[recipeIndex]->requiresSetup()) {
-            recipeList->second[recipeIndex]->setup(afieldset);
-        }
-        const bool recipeSuccess = recipeList->second[recipeIndex]->execute(afieldset);
-        ASSERT(recipeSuccess);  // At least for now, we'll require the execution to be successful
+    if (threadPool_) {
+        for (const auto & level : plan.levels) {
+            if (level.size() == 1) {
+                executeRecipeNL(afieldset, plan, level[0]);
+            } else {
+                threadPool_->run(level.size(), [&](const std::size_t i) {
+                    executeRecipeNL(afieldset, plan, level[i]);
+                });
+            }
+        }
+    } else {
+        for (const auto rec : plan.recipes) {
+            executeRecipeNL(afieldset, plan, rec);
+        }
     }
     oops::Log::trace() << "leaving Vader::executePlanNL" <<  std::endl;
 }
+// ------------------------------------------------------------------------------------------------
+/*! \brief Execute Plan (non-linear, batched)
+*
+* \details This **executePlanNL** executes the plan for several members, recipe by
+* recipe: each recipe is executed for all the members before the next. With a thread
+* pool, the first member executes each dependency level as above, so that the recipes
+* do their one-off work (e.g. loading a lookup table) once, then the recipes of the
+* level are executed concurrently for the other members.
+*
+*/
+void Vader::executePlanNL(std::vector<atlas::FieldSet> & members,
+                          const ExecutionPlan & plan) const {
+    oops::Log::trace() << "entering Vader::executePlanNL (batched)" <<  std::endl;
+    if (threadPool_) {
+        const std::size_t nOthers = members.size() - 1;
+        for (const auto & level : plan.levels) {
+            if (level.size() == 1) {
+                executeRecipeNL(members[0], plan, level[0]);
+            } else {
+                threadPool_->run(level.size(), [&](const std::size_t i) {
+                    executeRecipeNL(members[0], plan, level[i]);
+                });
+            }
+            if (nOthers > 0) {
+                // Consecutive tasks execute the same recipe
+                threadPool_->run(level.size() * nOthers, [&](const std::size_t i) {
+                    const std::size_t member = 1 + i % nOthers;
+                    executeRecipeNL(members[member], plan, level[i / nOthers], member);
+                });
+            }
+        }
+    } else {
+        for (const auto rec : plan.recipes) {
+            for (std::size_t jm = 0; jm < members.size(); ++jm) {
+                executeRecipeNL(members[jm], plan, rec, jm);
+            }
+        }
+    }
+    oops::Log::trace() << "leaving Vader::executePlanNL (batched)" <<  std::endl;
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Chunkable
+*
+* \details **chunkable** is true if the plan can be executed on blocks of columns
+* (see VaderParameters blockColumns): all its recipes are columnwise, and all the
+* fields of the fieldset are contiguous rank 2 double or float fields with the same
+* number of columns, so that a block of a field is a view of consecutive values.
+*
+*/
+bool Vader::chunkable(const atlas::FieldSet & afieldset, const ExecutionPlan & plan) const {
+    if (deviceBackend_ || skipUnchanged_ || plan.recipes.empty() || afieldset.size() == 0) {
+        return false;
+    }
+    for (const auto rec : plan.recipes) {
+        if (!compiledCookbook_.descriptor(rec).columnwise) {
+            oops::Log::debug() << "Vader::changeVar not chunked: recipe " <<
+                compiledCookbook_.recipeName(rec) << " is not columnwise" << std::endl;
+            return false;
+        }
+    }
+    for (atlas::idx_t jf = 0; jf < afieldset.size(); ++jf) {
+        const atlas::Field & field = afieldset[jf];
+        const bool real = field.datatype() == atlas::array::DataType::real64() ||
+                          field.datatype() == atlas::array::DataType::real32();
+        if (field.rank() != 2 || !real || field.shape(0) != afieldset[0].shape(0) ||
+            field.stride(1) != 1 || field.stride(0) != field.shape(1)) {
+            oops::Log::debug() << "Vader::changeVar not chunked: field " << field.name() <<
+                " cannot be split into blocks of columns" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+// ------------------------------------------------------------------------------------------------
+namespace {
+/// The columns [begin, begin + n) of a (chunkable) field, as a field without function
+/// space wrapping its values, with its levels and metadata
+atlas::Field columnBlock(atlas::Field & field, const atlas::idx_t begin, const atlas::idx_t n) {
+    const auto shape = atlas::array::make_shape(n, field.shape(1));
+    const atlas::idx_t offset = begin * field.stride(0);
+    atlas::Field block;
+    if (field.datatype() == atlas::array::DataType::real64()) {
+        block = atlas::Field(field.name(), field.array().host_data<double>() + offset, shape);
+    } else {
+        block = atlas::Field(field.name(), field.array().host_data<float>() + offset, shape);
+    }
+    block.set_levels(field.levels());
+    block.metadata() = field.metadata();
+    return block;
+}
+}  // namespace
+// ------------------------------------------------------------------------------------------------
+/*! \brief Execute Plan (chunked)
+*
+* \details **executePlanChunked** executes the plan block by block: the columns
+* computed (the owned columns with the "exchange" halo policy, else all of them) are
+* split into blocks of blockColumns columns, and the plan is executed, as by
+* executePlanNL, on a fieldset of blocks of the caller's fields and of block-sized
+* intermediate fields. The intermediates are allocated once for all the blocks, so
+* they never hold more than a block, and the fields of a block stay in cache across
+* the recipes. The fieldsets of the blocks have the fields of withIntermediates, in
+* the same order, so the recipes are bound to them by the plan positions. (The
+* recipes requiring setup are set up with the first block; the metadata the recipes
+* set on the blocks of the products is not copied back to the caller's fields.)
+*
+*/
+void Vader::executePlanChunked(atlas::FieldSet & afieldset, const ExecutionPlan & plan) const {
+    oops::Log::trace() << "entering Vader::executePlanChunked" <<  std::endl;
+    atlas::idx_t nColumns = afieldset[0].shape(0);
+#ifdef VADER_ENABLE_MO
+    {
+        const mo::functions::ScopedOwnedColumnsOnly ownedColumnsOnly(exchangeHalos_);
+        nColumns = mo::functions::computedColumns(afieldset[0]);
+    }
+#endif
+    const atlas::idx_t blockColumns = std::min(static_cast<atlas::idx_t>(blockColumns_),
+                                               nColumns);
+
+    // Block-sized intermediates, shaped like withIntermediates shapes them
+    atlas::FieldSet shapes;
+    for (atlas::idx_t jf = 0; jf < afieldset.size(); ++jf) shapes.add(afieldset[jf]);
+    std::vector<atlas::Field> intermediates;
+    for (const auto & intermediate : plan.intermediates) {
+        const CompiledCookbook::RecipeId producer = intermediate.second;
+        const atlas::Field & shape = shapes.field(
+            compiledCookbook_.variableName(*compiledCookbook_.ingredientsBegin(producer)));
+        const int levels = compiledCookbook_.recipe(producer).productLevels(shapes);
+        atlas::Field field(compiledCookbook_.variableName(intermediate.first), shape.datatype(),
+                           atlas::array::make_shape(blockColumns, levels));
+        field.set_levels(levels);
+        intermediates.push_back(field);
+        shapes.add(field);
+    }
+
+    for (atlas::idx_t begin = 0; begin < nColumns; begin += blockColumns) {
+        const atlas::idx_t n = std::min(blockColumns, nColumns - begin);
+        atlas::FieldSet block;
+        for (atlas::idx_t jf = 0; jf < afieldset.size(); ++jf) {
+            block.add(columnBlock(afieldset[jf], begin, n));
+        }
+        for (auto & field : intermediates) block.add(columnBlock(field, 0, n));
+        executePlanNL(block, plan);
+    }
+    oops::Log::trace() << "leaving Vader::executePlanChunked" <<  std::endl;
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Execute Plan (tangent linear)
+*
+* \details **executePlanTL** calls the 'executeTL' method of the recipes of the plan,
+* in the same order (and with the same concurrency) as executePlanNL.
+*
+*/
+void Vader::executePlanTL(atlas::FieldSet & increments, const ExecutionPlan & plan) const {
+    auto executeRecipeTL = [&](const CompiledCookbook::RecipeId rec) {
+        ScopedTiming timing(recipeInstrumentation_,
+                            compiledCookbook_.descriptor(rec).nameTL.c_str());
+        const bool recipeSuccess = compiledCookbook_.recipe(rec).executeTL(increments,
+                                                                           trajectory_);
+        ASSERT(recipeSuccess);
+    };
+    if (threadPool_) {
+        for (const auto & level : plan.levels) {
+            if (level.size() == 1) {
+                executeRecipeTL(level[0]);
+            } else {
+                threadPool_->run(level.size(), [&](const std::size_t i) {
+                    executeRecipeTL(level[i]);
+                });
+            }
+        }
+    } else {
+        for (const auto rec : plan.recipes) executeRecipeTL(rec);
+    }
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Execute Plan (adjoint)
+*
+* \details **executePlanAD** calls the 'executeAD' method of the recipes of the plan
+* in reverse order. This is always serial: recipes of the same dependency level may
+* share ingredients, whose adjoints they would then update concurrently.
+*
+*/
+void Vader::executePlanAD(atlas::FieldSet & hats, const ExecutionPlan & plan) const {
+    for (auto rec = plan.recipes.rbegin(); rec != plan.recipes.rend(); ++rec) {
+        ScopedTiming timing(recipeInstrumentation_,
+                            compiledCookbook_.descriptor(*rec).nameAD.c_str());
+        const bool recipeSuccess = compiledCookbook_.recipe(*rec).executeAD(hats, trajectory_);
+        ASSERT(recipeSuccess);
+    }
+}
+// ------------------------------------------------------------------------------------------------
+void Vader::executeRecipeNL(atlas::FieldSet & afieldset, const ExecutionPlan & plan,
+                            const CompiledCookbook::RecipeId rec,
+                            const std::size_t member) const {
+    // The ingredients of the recipe were checked when the plan was created
+    oops::Log::debug() << "Attempting to calculate variable " <<
+        compiledCookbook_.variableName(compiledCookbook_.product(rec)) <<
+        " using recipe with name: " << compiledCookbook_.recipeName(rec) << std::endl;
+    RecipeBase & recipe = compiledCookbook_.recipe(rec);
+    const RecipeDescriptor & descriptor = compiledCookbook_.descriptor(rec);
+    const BoundFields fields(afieldset, plan.fields[rec]);
+#ifdef VADER_ENABLE_MO
+    // The halo policy and the backend of this Vader, on the thread executing the recipe
+    const mo::functions::ScopedOwnedColumnsOnly ownedColumnsOnly(exchangeHalos_);
+    const mo::functions::ScopedDeviceBackend device(deviceBackend_ &&
+                                                    descriptor.executesOnDevice);
+#endif
+    RecipeMemo memo;
+    if (skipUnchanged_) {
+        for (std::size_t ji = 0; ji < fields.nIngredients(); ++ji) {
+            memo.ingredients.push_back(fieldSignature(fields.ingredient(ji)));
+        }
+        for (std::size_t jp = 0; jp < fields.nProducts(); ++jp) {
+            if (fields.hasProduct(jp)) {
+                memo.products.push_back(fieldSignature(fields.product(jp), false));
+            }
+        }
+        bool unchanged;
+        {
+            std::lock_guard<std::mutex> lock(memoMutex_);
+            unchanged = memo.ingredients == recipeMemo_[member][rec].ingredients &&
+                        memo.products == recipeMemo_[member][rec].products;
+        }
+        if (unchanged) {
+            oops::Log::debug() << "Skipping recipe " << descriptor.name <<
+                ": ingredients and products unchanged since its last execution" << std::endl;
+            phaseInstrumentation_.record("skipped recipes", 0.0);
+            return;
+        }
+    }
+    ScopedTiming timing(recipeInstrumentation_, descriptor.name.c_str());
+    if (timing.enabled()) {
+        std::size_t bytesRead = 0;
+        std::size_t bytesWritten = 0;
+        for (std::size_t ji = 0; ji < fields.nIngredients(); ++ji) {
+            bytesRead += fields.ingredient(ji).bytes();
+        }
+        for (std::size_t jp = 0; jp < fields.nProducts(); ++jp) {
+            if (fields.hasProduct(jp)) bytesWritten += fields.product(jp).bytes();
+        }
+        timing.setBytes(bytesRead, bytesWritten);
+    }
+    const bool onHost = deviceBackend_ && !descriptor.executesOnDevice;
+    if (onHost) {
+        // The device recipes may have left the ingredients (and products) on the device
+        std::lock_guard<std::mutex> lock(deviceMutex_);
+        for (std::size_t ji = 0; ji < fields.nIngredients(); ++ji) {
+            if (fields.ingredient(ji).hostNeedsUpdate()) fields.ingredient(ji).updateHost();
+        }
+        for (std::size_t jp = 0; jp < fields.nProducts(); ++jp) {
+            if (fields.hasProduct(jp) && fields.product(jp).hostNeedsUpdate()) {
+                fields.product(jp).updateHost();
+            }
+        }
+    }
+    if (descriptor.requiresSetup) {
+        std::call_once(plan.setupOnce[rec], [&]() {
+            const bool setupSuccess = recipe.setup(afieldset);
+            ASSERT(setupSuccess);
+        });
+    }
+    const bool recipeSuccess = recipe.execute(fields);
+    ASSERT(recipeSuccess);  // At least for now, we'll require the execution to be successful
+    if (onHost) {
+        // The device copies of the products are now out of date
+        std::lock_guard<std::mutex> lock(deviceMutex_);
+        for (std::size_t jp = 0; jp < fields.nProducts(); ++jp) {
+            if (fields.hasProduct(jp)) fields.product(jp).setDeviceNeedsUpdate(true);
+        }
+    }
+    if (skipUnchanged_) {
+        // New versions for the products, so that the recipes consuming them see the change
+        memo.products.clear();
+        for (std::size_t jp = 0; jp < fields.nProducts(); ++jp) {
+            if (fields.hasProduct(jp)) {
+                fields.product(jp).metadata().set(fieldVersionKey, nextFieldVersion());
+                memo.products.push_back(fieldSignature(fields.product(jp), false));
+            }
+        }
+        std::lock_guard<std::mutex> lock(memoMutex_);
+        recipeMemo_[member][rec] = std::move(memo);
+    }
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Update Host Fields
+*
+* \details **updateHostFields** copies back to the host the fields of the fieldset
+* whose host copy is out of date (those populated by device recipes), so that the
+* caller sees the results of the plan. The device copies stay valid.
+*
+*/
+void Vader::updateHostFields(const atlas::FieldSet & afieldset) const {
+    ScopedTiming timing(phaseInstrumentation_, "updateHost");
+    for (atlas::idx_t jf = 0; jf < afieldset.size(); ++jf) {
+        if (afieldset[jf].hostNeedsUpdate()) afieldset[jf].updateHost();
+    }
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Exchange Halos
+*
+* \details **exchangeHalos** fills the halos of the products of the plan that are in
+* the fieldset, for the "exchange" halo policy. The products are grouped by function
+* space into one fieldset each, so that there is a single (aggregated) halo exchange
+* per function space rather than one per field.
+*
+*/
+void Vader::exchangeHalos(const atlas::FieldSet & afieldset, const ExecutionPlan & plan) const {
+    ScopedTiming timing(phaseInstrumentation_, "haloExchange");
+    std::vector<char> isProduct(compiledCookbook_.nVariables(), 0);
+    for (const auto rec : plan.recipes) {
+        for (auto prod = compiledCookbook_.productsBegin(rec);
+             prod != compiledCookbook_.productsEnd(rec); ++prod) {
+            isProduct[*prod] = 1;
+        }
+    }
+    std::vector<std::pair<atlas::FunctionSpace, atlas::FieldSet>> dirtyFields;
+    for (atlas::idx_t jf = 0; jf < afieldset.size(); ++jf) {
+        const atlas::Field & field = afieldset[jf];
+        const auto var = compiledCookbook_.variableId(field.name());
+        if (var == CompiledCookbook::npos || !isProduct[var]) continue;
+        auto group = std::find_if(dirtyFields.begin(), dirtyFields.end(),
+            [&](const auto & entry) {return entry.first.get() == field.functionspace().get();});
+        if (group == dirtyFields.end()) {
+            dirtyFields.emplace_back(field.functionspace(), atlas::FieldSet());
+            group = dirtyFields.end() - 1;
+        }
+        group->second.add(field);
+    }
+    for (auto & group : dirtyFields) {
+        group.first.haloExchange(group.second);
+        group.second.set_dirty(false);
+    }
+}
 
 }  // namespace vader
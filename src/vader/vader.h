@@ -8,15 +8,23 @@
 #ifndef SRC_VADER_VADER_H_
 #define SRC_VADER_VADER_H_
 
+#include <cstddef>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "atlas/field/FieldSet.h"
+#include "CompiledCookbook.h"
+#include "FieldPool.h"
+#include "FieldSignature.h"
+#include "Instrumentation.h"
 #include "oops/base/Variables.h"
+#include "PlanCache.h"
 #include "RecipeBase.h"
+#include "ThreadPool.h"
 #include "VaderParameters.h"
 
 
@@ -37,7 +45,33 @@ namespace vader {
  *           recipe. The 'cookbook' is the container (an unordered_map) that
  *           contains the recipes to be attempted when specified output variable
  *           is desired. The cookbook can contain multiple recipes that produce
- *           the same output variable.
+ *           the same output variable. At construction the cookbook is compiled
+ *           into an integer-indexed dependency graph (CompiledCookbook) which is
+ *           used for planning and execution.
+ *
+ *           Plans are cached, keyed by the names of the fields allocated in the
+ *           fieldset and by the variables that are needed, so that repeated calls
+ *           with the same fieldset structure skip the planning step.
+ *
+ *           When VaderParameters specifies more than one thread, the recipes of
+ *           each dependency level of a plan are executed concurrently on a thread
+ *           pool. Each recipe only writes its own product, so the results are the
+ *           same as for the (default) serial execution.
+ *
+ *           With 'skip unchanged recipes', the signatures (see FieldSignature) of the
+ *           ingredients and products of each recipe are remembered after it runs, and
+ *           the recipe is skipped while they are unchanged.
+ *
+ *           The batched changeVar plans once for a vector of fieldsets with the
+ *           same fields (ensemble members) and runs each recipe over all the
+ *           members before the next, so that its lookup tables and coefficients are
+ *           loaded once and stay in cache.
+ *
+ *           The linearized variable change reuses the plan of the trajectory:
+ *           changeVarTraj plans and populates the trajectory and sets up the
+ *           recipes' trajectory, then changeVarTL replays the plan with the
+ *           tangent linear of the recipes, and changeVarAD replays it backwards
+ *           with their adjoint.
  */
 
 class Vader {
@@ -48,6 +82,22 @@ class Vader {
 
     /// Calculates as many variables in the list as possible
     oops::Variables changeVar(atlas::FieldSet &, oops::Variables &) const;
+    /// As changeVar, for several fieldsets (e.g. ensemble members) of the same structure
+    oops::Variables changeVar(std::vector<atlas::FieldSet> &, oops::Variables &) const;
+
+    /// Sets the trajectory of the linearized variable change (once per outer loop)
+    oops::Variables changeVarTraj(atlas::FieldSet &, oops::Variables &);
+    /// Tangent linear of the variable change set up by changeVarTraj
+    oops::Variables changeVarTL(atlas::FieldSet &, oops::Variables &) const;
+    /// Adjoint of the variable change set up by changeVarTraj
+    oops::Variables changeVarAD(atlas::FieldSet &, oops::Variables &) const;
+
+    /// Plan cache statistics
+    std::size_t planCacheHits() const {return planCache_.hits();}
+    std::size_t planCacheMisses() const {return planCache_.misses();}
+
+    /// Snapshot of the instrumentation (empty unless enabled in the parameters)
+    InstrumentationReport instrumentation() const;
 
  private:
     std::unordered_map<std::string, std::vector<std::unique_ptr<RecipeBase>>>
@@ -58,12 +108,64 @@ class Vader {
     void createCookbook(std::unordered_map<std::string, std::vector<std::string>>,
                         const std::vector<RecipeParametersWrapper> & allRecpParamWraps =
                               std::vector<RecipeParametersWrapper>());
-    bool planVariable(atlas::FieldSet & afieldset,
-                      oops::Variables & neededVars,
-                      const std::string targetVariable,
-                      std::vector<std::pair<std::string, std::string>> & plan) const;
-    void executePlanNL(atlas::FieldSet & afieldset,
-                       const std::vector<std::pair<std::string, std::string>> & mealPlan) const;
+    std::shared_ptr<const ExecutionPlan> findPlan(atlas::FieldSet & afieldset,
+                                                 oops::Variables & neededVars) const;
+    std::shared_ptr<const ExecutionPlan> createPlan(atlas::FieldSet & afieldset,
+                                                    oops::Variables & neededVars,
+                                                    const bool linear = false) const;
+    atlas::FieldSet withIntermediates(atlas::FieldSet & afieldset, const ExecutionPlan & plan,
+                                      std::vector<atlas::Field> & intermediates,
+                                      FieldPool & pool) const;
+    void executePlanNL(atlas::FieldSet & afieldset, const ExecutionPlan & plan) const;
+    void executePlanNL(std::vector<atlas::FieldSet> & members, const ExecutionPlan & plan) const;
+    bool chunkable(const atlas::FieldSet & afieldset, const ExecutionPlan & plan) const;
+    void executePlanChunked(atlas::FieldSet & afieldset, const ExecutionPlan & plan) const;
+    void executePlanTL(atlas::FieldSet & increments, const ExecutionPlan & plan) const;
+    void executePlanAD(atlas::FieldSet & hats, const ExecutionPlan & plan) const;
+    void executeRecipeNL(atlas::FieldSet & afieldset, const ExecutionPlan & plan,
+                         const CompiledCookbook::RecipeId rec,
+                         const std::size_t member = 0) const;
+    void updateHostFields(const atlas::FieldSet & afieldset) const;
+    void exchangeHalos(const atlas::FieldSet & afieldset, const ExecutionPlan & plan) const;
+
+    CompiledCookbook compiledCookbook_;
+    mutable PlanCache planCache_;
+    std::unique_ptr<ThreadPool> threadPool_;
+    bool allocateIntermediates_ = false;
+    bool cheapestPlan_ = false;
+    int blockColumns_ = 0;
+    mutable FieldPool fieldPool_;
+    // The intermediates of changeVarTL and changeVarAD hold increments and adjoints,
+    // which are not versioned: they are kept apart from the fields of the nonlinear
+    // plans, whose (pointer, version) signatures would otherwise be those of fields
+    // overwritten since (see skipUnchanged_)
+    mutable FieldPool linearFieldPool_;
+    /// Signatures of the ingredients and products of a recipe at its last execution
+    struct RecipeMemo {
+        std::vector<FieldSignature> ingredients;
+        std::vector<FieldSignature> products;
+    };
+    bool skipUnchanged_ = false;
+    mutable std::vector<std::vector<RecipeMemo>> recipeMemo_;  // by member, then RecipeId
+    mutable std::mutex memoMutex_;
+    // With the device backend, the fields of the device recipes stay on the device;
+    // deviceMutex_ serializes the host and device updates of the concurrent recipes
+    bool deviceBackend_ = false;
+    mutable std::mutex deviceMutex_;
+    // With the "exchange" halo policy, the halos of the products are exchanged at the
+    // end of the plan rather than computed
+    bool exchangeHalos_ = false;
+    // Set by changeVarTraj: the linear plan, and the trajectory fields it is
+    // linearized about (the caller's and the intermediate fields)
+    std::shared_ptr<const ExecutionPlan> trajPlan_;
+    atlas::FieldSet trajectory_;
+    std::vector<atlas::Field> trajIntermediates_;
+    mutable Instrumentation recipeInstrumentation_;
+    mutable Instrumentation phaseInstrumentation_;
+    std::string instrumentationFile_;
+    // The plans created, when the instrumentation is enabled
+    mutable std::vector<PlanStats> planStats_;
+    mutable std::mutex planStatsMutex_;
 };
 
 }  // namespace vader
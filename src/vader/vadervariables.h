@@ -44,6 +44,12 @@ const char VV_CLSEFR[] = "effective_radius_of_snow_particle";
 const char VV_CLGEFR[] = "effective_radius_of_graupel_particle";
 const char VV_CLHEFR[] = "effective_radius_of_hail_particle";
 const char VV_CLDFRAC[]= "cloud_area_fraction_in_atmosphere_layer";
+const char VV_MV[]    = "m_v";    // mixing ratio of water vapour
+const char VV_MCI[]   = "m_ci";   // mixing ratio of cloud ice
+const char VV_MCL[]   = "m_cl";   // mixing ratio of cloud liquid
+const char VV_MR[]    = "m_r";    // mixing ratio of rain
+const char VV_MT[]    = "m_t";    // total mass of moist air
+const char VV_QRAIN[] = "qrain";  // specific rain content
 const char VV_SFC_P2M[] = "air_pressure_at_two_meters_above_surface";    // (Pa)
 const char VV_SFC_Q2M[] = "specific_humidity_at_two_meters_above_surface";
 const char VV_SFC_T2M[] = "surface_temperature";  // (K)
@@ -0,0 +1,179 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+// Checks that the kernels instantiated by mo::functions::dispatchLevels for the level
+// counts of the operational grids (70/71, 90/91 and 137/138 levels) give bitwise the
+// results of their generic (L = 0) instantiation, which dispatchLevels calls instead
+// under mo::functions::ScopedGenericLevels. The exit code is 1 if any check fails.
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "atlas/array.h"
+#include "atlas/field.h"
+#include "atlas/library.h"
+
+#include "mo/control2analysis_linearvarchange.h"
+#include "mo/control2analysis_varchange.h"
+#include "mo/functions.h"
+
+namespace {
+
+using atlas::array::make_view;
+using atlas::idx_t;
+
+// Not a multiple of the column block size, so that the last tile is a partial one
+constexpr idx_t nColumns = 37;
+
+// ------------------------------------------------------------------------------------------------
+/// A functionspace-less field of nColumns columns and the given number of levels,
+/// filled with value(jn, jl)
+template<typename Value>
+atlas::Field createField(const std::string & name, const idx_t levels, const Value & value) {
+  atlas::Field field(name, atlas::array::make_datatype<double>(),
+                     atlas::array::make_shape(nColumns, levels));
+  field.set_levels(levels);
+  auto view = make_view<double, 2>(field);
+  for (idx_t jn = 0; jn < nColumns; ++jn) {
+    for (idx_t jl = 0; jl < levels; ++jl) view(jn, jl) = value(jn, jl);
+  }
+  return field;
+}
+
+/// A smooth perturbation in [-1, 1], different in every column and on every level
+double wave(const idx_t jn, const idx_t jl, const double phase = 0.0) {
+  return std::sin(0.37 * static_cast<double>(jn) + 0.11 * static_cast<double>(jl) + phase);
+}
+
+/// Heights of the level boundaries (jl) and of the levels (jl + 0.5), increasing with jl
+double height(const idx_t jn, const double jl) {
+  return 20.0 * jl * (1.0 + 0.02 * jl) + 0.5 * std::cos(0.37 * static_cast<double>(jn));
+}
+
+/// Copies of the fields of fset
+atlas::FieldSet copy(const atlas::FieldSet & fset) {
+  atlas::FieldSet copied;
+  for (const auto & field : fset) {
+    const auto view = make_view<const double, 2>(field);
+    copied.add(createField(field.name(), field.levels(),
+                           [&view](const idx_t jn, const idx_t jl) {return view(jn, jl);}));
+  }
+  return copied;
+}
+
+/// Reports and returns the number of the given fields of fset that differ from reference
+int compare(const std::string & kernel, const idx_t levels, const atlas::FieldSet & fset,
+            const atlas::FieldSet & reference, const std::vector<std::string> & names) {
+  int failures = 0;
+  for (const auto & name : names) {
+    const auto view = make_view<const double, 2>(fset[name]);
+    const auto referenceView = make_view<const double, 2>(reference[name]);
+    bool equal = true;
+    for (idx_t jn = 0; jn < view.shape(0); ++jn) {
+      for (idx_t jl = 0; jl < view.shape(1); ++jl) {
+        if (view(jn, jl) != referenceView(jn, jl)) equal = false;
+      }
+    }
+    if (!equal) {
+      std::cout << kernel << ": " << name << " at " << levels
+                << " levels differs from the generic kernel" << std::endl;
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+/// Runs kernel on a copy of fset with the dispatched and with the generic instantiation
+template<typename Kernel>
+int checkKernel(const std::string & name, const idx_t levels, const atlas::FieldSet & fset,
+                const std::vector<std::string> & outputs, const Kernel & kernel) {
+  atlas::FieldSet dispatched = copy(fset);
+  kernel(dispatched);
+  atlas::FieldSet generic = copy(fset);
+  {
+    const mo::functions::ScopedGenericLevels genericLevels(true);
+    kernel(generic);
+  }
+  return compare(name, levels, dispatched, generic, outputs);
+}
+
+// ------------------------------------------------------------------------------------------------
+/// evalHydrostaticExnerLevels, dispatched on the levels of hydrostatic_exner_levels
+int checkHydrostaticExnerLevels(const idx_t levels) {
+  atlas::FieldSet fset;
+  fset.add(createField("height_levels", levels + 1,
+                       [](const idx_t jn, const idx_t jl) {return height(jn, jl);}));
+  fset.add(createField("virtual_potential_temperature", levels,
+                       [](const idx_t jn, const idx_t jl) {
+                         return 290.0 + 0.5 * static_cast<double>(jl) + 2.0 * wave(jn, jl);}));
+  fset.add(createField("air_pressure_levels_minus_one", levels,
+                       [](const idx_t jn, const idx_t jl) {
+                         return 1.0e5 * std::exp(-0.02 * static_cast<double>(jl)) +
+                                5.0e2 * wave(jn, jl);}));
+  fset.add(createField("hydrostatic_exner_levels", levels,
+                       [](const idx_t, const idx_t) {return 0.0;}));
+  return checkKernel("evalHydrostaticExnerLevels", levels, fset, {"hydrostatic_exner_levels"},
+                     [](atlas::FieldSet & fields) {mo::evalHydrostaticExnerLevels(fields);});
+}
+
+/// The linearisation state of evalAirTemperatureTL/AD, with levels levels
+atlas::FieldSet createAirTemperatureState(const idx_t levels) {
+  atlas::FieldSet state;
+  state.add(createField("height_levels", levels + 1,
+                        [](const idx_t jn, const idx_t jl) {return height(jn, jl);}));
+  state.add(createField("height", levels, [](const idx_t jn, const idx_t jl) {
+                          return height(jn, static_cast<double>(jl) + 0.5);}));
+  state.add(createField("exner_levels_minus_one", levels, [](const idx_t jn, const idx_t jl) {
+                          return 1.0 - 0.004 * static_cast<double>(jl) + 0.01 * wave(jn, jl);}));
+  state.add(createField("potential_temperature", levels, [](const idx_t jn, const idx_t jl) {
+                          return 290.0 + 0.5 * static_cast<double>(jl) + 2.0 * wave(jn, jl);}));
+  return state;
+}
+
+/// The increments (or adjoint variables) of evalAirTemperatureTL/AD, with levels levels
+atlas::FieldSet createAirTemperatureIncrements(const idx_t levels) {
+  atlas::FieldSet increments;
+  increments.add(createField("exner_levels_minus_one", levels,
+                             [](const idx_t jn, const idx_t jl) {
+                               return 1.0e-4 * wave(jn, jl, 1.0);}));
+  increments.add(createField("potential_temperature", levels,
+                             [](const idx_t jn, const idx_t jl) {return wave(jn, jl, 2.0);}));
+  increments.add(createField("air_temperature", levels,
+                             [](const idx_t jn, const idx_t jl) {return wave(jn, jl, 3.0);}));
+  return increments;
+}
+
+/// evalAirTemperatureTL and evalAirTemperatureAD, dispatched on the levels of
+/// air_temperature
+int checkAirTemperature(const idx_t levels) {
+  const atlas::FieldSet state = createAirTemperatureState(levels);
+  const atlas::FieldSet increments = createAirTemperatureIncrements(levels);
+  int failures = checkKernel("evalAirTemperatureTL", levels, increments, {"air_temperature"},
+    [&state](atlas::FieldSet & incFlds) {mo::evalAirTemperatureTL(incFlds, state);});
+  failures += checkKernel("evalAirTemperatureAD", levels, increments,
+    {"exner_levels_minus_one", "potential_temperature", "air_temperature"},
+    [&state](atlas::FieldSet & hatFlds) {mo::evalAirTemperatureAD(hatFlds, state);});
+  return failures;
+}
+
+}  // namespace
+
+// ------------------------------------------------------------------------------------------------
+int main(int argc, char ** argv) {
+  atlas::Library::instance().initialise(argc, argv);
+  int failures = 0;
+  for (const idx_t levels : {70, 71, 90, 91, 137, 138}) {
+    failures += checkHydrostaticExnerLevels(levels);
+    failures += checkAirTemperature(levels);
+  }
+  std::cout << "vader_test_dispatch_levels: " << (failures == 0 ? "passed" : "FAILED")
+            << std::endl;
+  atlas::Library::instance().finalise();
+  return failures == 0 ? 0 : 1;
+}
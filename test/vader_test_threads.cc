@@ -0,0 +1,220 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+// Checks that overlapping calls of ThreadPool::run, from several threads and from the
+// tasks of the pool, run every task once per call, and (with the mo recipes) that
+// concurrent Vader::changeVar calls on one Vader with a thread pool give the same
+// results as a serial Vader. The exit code is 1 if any check fails.
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "atlas/array.h"
+#include "atlas/field.h"
+#include "atlas/library.h"
+
+#include "eckit/config/LocalConfiguration.h"
+
+#include "oops/base/Variables.h"
+
+#include "vader/ThreadPool.h"
+#include "vader/vader.h"
+
+namespace {
+
+using atlas::array::make_view;
+using atlas::idx_t;
+
+constexpr int nCallers = 4;
+
+// ------------------------------------------------------------------------------------------------
+int checkThreadPool() {
+  constexpr int nRuns = 200;
+  constexpr std::size_t nTasks = 64;
+  vader::ThreadPool pool(4);
+  int failures = 0;
+
+  // Each caller counts the tasks of its own runs
+  std::vector<std::vector<int>> counts(nCallers, std::vector<int>(nTasks, 0));
+  std::vector<std::thread> callers;
+  for (int jc = 0; jc < nCallers; ++jc) {
+    callers.emplace_back([&pool, &counts, jc]() {
+      for (int jr = 0; jr < nRuns; ++jr) {
+        pool.run(nTasks, [&counts, jc](const std::size_t task) {++counts[jc][task];});
+      }
+    });
+  }
+  for (auto & caller : callers) caller.join();
+  for (int jc = 0; jc < nCallers; ++jc) {
+    for (std::size_t jt = 0; jt < nTasks; ++jt) {
+      if (counts[jc][jt] != nRuns) {
+        std::cout << "ThreadPool::run: task " << jt << " of caller " << jc << " ran "
+                  << counts[jc][jt] << " times in " << nRuns << " runs" << std::endl;
+        ++failures;
+      }
+    }
+  }
+
+  // Runs from the tasks of a run
+  std::atomic<int> nested{0};
+  pool.run(nTasks, [&pool, &nested](std::size_t) {
+    pool.run(nTasks, [&nested](std::size_t) {++nested;});
+  });
+  if (nested != static_cast<int>(nTasks * nTasks)) {
+    std::cout << "ThreadPool::run: " << nested << " nested tasks ran, expected "
+              << nTasks * nTasks << std::endl;
+    ++failures;
+  }
+
+  // The first exception of a run that overlaps another is re-thrown after all its tasks
+  std::atomic<int> ran{0};
+  try {
+    pool.run(nTasks, [&pool, &ran](std::size_t) {
+      pool.run(nTasks, [&ran](const std::size_t task) {
+        ++ran;
+        if (task == 0) throw std::runtime_error("task 0");
+      });
+    });
+    std::cout << "ThreadPool::run: the exception of a nested run was lost" << std::endl;
+    ++failures;
+  } catch (const std::runtime_error &) {
+  }
+  if (ran != static_cast<int>(nTasks * nTasks)) {
+    std::cout << "ThreadPool::run: " << ran << " nested tasks ran before the exception, "
+              << "expected " << nTasks * nTasks << std::endl;
+    ++failures;
+  }
+  return failures;
+}
+
+#ifdef VADER_ENABLE_MO
+// ------------------------------------------------------------------------------------------------
+const std::vector<std::string> & products() {
+  static const std::vector<std::string> names{
+    "potential_temperature", "m_t", "specific_humidity",
+    "mass_content_of_cloud_ice_in_atmosphere_layer",
+    "mass_content_of_cloud_liquid_water_in_atmosphere_layer", "qrain"};
+  return names;
+}
+
+std::vector<std::string> fieldNames() {
+  std::vector<std::string> names{"air_temperature", "surface_pressure", "m_v", "m_ci", "m_cl",
+                                 "m_r"};
+  names.insert(names.end(), products().begin(), products().end());
+  return names;
+}
+
+bool equal(const atlas::Field & field, const atlas::Field & reference) {
+  const auto view = make_view<const double, 2>(field);
+  const auto referenceView = make_view<const double, 2>(reference);
+  for (idx_t jn = 0; jn < view.shape(0); ++jn) {
+    for (idx_t jl = 0; jl < view.shape(1); ++jl) {
+      if (view(jn, jl) != referenceView(jn, jl)) return false;
+    }
+  }
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+/// A fieldset with the ingredients and products of potential temperature and of the
+/// moisture partition, which are independent recipes of the same dependency level
+atlas::FieldSet createFieldSet() {
+  constexpr idx_t nColumns = 500;
+  constexpr idx_t nLevels = 20;
+  atlas::FieldSet fset;
+  for (const auto & name : fieldNames()) {
+    const idx_t levels = name == "surface_pressure" ? 1 : nLevels;
+    atlas::Field field(name, atlas::array::make_datatype<double>(),
+                       atlas::array::make_shape(nColumns, levels));
+    field.set_levels(levels);
+    auto view = make_view<double, 2>(field);
+    for (idx_t jn = 0; jn < nColumns; ++jn) {
+      for (idx_t jl = 0; jl < levels; ++jl) {
+        const double x = std::sin(0.01 * static_cast<double>(jn) +
+                                  0.1 * static_cast<double>(jl));
+        if (name == "air_temperature") {
+          view(jn, jl) = 260.0 + 20.0 * x;
+        } else if (name == "surface_pressure") {
+          view(jn, jl) = 1.0e5 + 2.0e3 * x;
+        } else {
+          view(jn, jl) = 1.0e-3 * (1.5 + x);
+        }
+      }
+    }
+    fset.add(field);
+  }
+  fset["surface_pressure"].metadata().set("units", "Pa");
+  return fset;
+}
+
+/// Calls changeVar on fset and returns the number of products that differ from reference
+int changeVar(const vader::Vader & vader, atlas::FieldSet & fset,
+              const atlas::FieldSet & reference) {
+  oops::Variables neededVars(products());
+  vader.changeVar(fset, neededVars);
+  int differences = 0;
+  for (const auto & name : products()) {
+    if (!equal(fset[name], reference[name])) ++differences;
+  }
+  return differences;
+}
+
+// ------------------------------------------------------------------------------------------------
+int checkConcurrentChangeVar() {
+  constexpr int nCalls = 20;
+  atlas::FieldSet reference = createFieldSet();
+  {
+    oops::Variables neededVars(products());
+    vader::Vader(vader::VaderParameters()).changeVar(reference, neededVars);
+  }
+
+  eckit::LocalConfiguration conf;
+  conf.set("threads", 2);
+  vader::VaderParameters params;
+  params.validateAndDeserialize(conf);
+  const vader::Vader vader(params);
+
+  std::vector<int> differences(nCallers, 0);
+  std::vector<std::thread> callers;
+  for (int jc = 0; jc < nCallers; ++jc) {
+    callers.emplace_back([&vader, &reference, &differences, jc]() {
+      atlas::FieldSet fset = createFieldSet();
+      for (int jr = 0; jr < nCalls; ++jr) differences[jc] += changeVar(vader, fset, reference);
+    });
+  }
+  for (auto & caller : callers) caller.join();
+  int failures = 0;
+  for (int jc = 0; jc < nCallers; ++jc) {
+    if (differences[jc] != 0) {
+      std::cout << "Vader::changeVar: " << differences[jc] << " products of caller " << jc
+                << " differ from the serial Vader" << std::endl;
+      ++failures;
+    }
+  }
+  return failures;
+}
+#endif
+
+}  // namespace
+
+// ------------------------------------------------------------------------------------------------
+int main(int argc, char ** argv) {
+  atlas::Library::instance().initialise(argc, argv);
+  int failures = checkThreadPool();
+#ifdef VADER_ENABLE_MO
+  failures += checkConcurrentChangeVar();
+#endif
+  std::cout << "vader_test_threads: " << (failures == 0 ? "passed" : "FAILED") << std::endl;
+  atlas::Library::instance().finalise();
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+// Converts the netcdf lookup tables of the mo kernels (the svp tables and the MIO
+// coefficients, with their derived level-major table) to a binary table file that Vader
+// maps instead of reading the netcdf files (see the "lookup table file" Vader parameter
+// and mo/table_file.h).
+//
+// Usage: vader_convert_lookup_tables OUTPUT [--svp FILE] [--mio FILE]
+//
+// The tables are read, with the readers of the kernels, from FILE, by default from
+// the paths the kernels read them from (mo::constants::commonVarChangeFilePath and
+// mioCoefficientsFilePath). They are stored under the names of those paths, so the
+// table file serves the kernels whatever the name of the file they were converted
+// from. The written file is mapped back and checked against the netcdf values.
+//
+// The table file is in the byte order of the machine that wrote it.
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "eckit/runtime/Main.h"
+
+#include "mo/constants.h"
+#include "mo/lookup_cache.h"
+#include "mo/table_file.h"
+
+namespace {
+
+void usage() {
+  std::cerr << "Usage: vader_convert_lookup_tables OUTPUT [--svp FILE] [--mio FILE]"
+            << std::endl;
+  std::exit(2);
+}
+
+}  // namespace
+
+int main(int argc, char ** argv) {
+  eckit::Main::initialise(argc, argv);
+  using mo::functions::LookUpCache;
+  using mo::functions::TableFile;
+  using mo::functions::TableFileEntry;
+  using mo::functions::tableSourceName;
+  namespace constants = mo::constants;
+
+  std::string output;
+  std::string svpPath = constants::commonVarChangeFilePath;
+  std::string mioPath = constants::mioCoefficientsFilePath;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--svp") == 0 && i + 1 < argc) {
+      svpPath = argv[++i];
+    } else if (std::strcmp(argv[i], "--mio") == 0 && i + 1 < argc) {
+      mioPath = argv[++i];
+    } else if (argv[i][0] != '-' && output.empty()) {
+      output = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if (output.empty()) usage();
+
+  // Read through the netcdf readers of the kernels
+  LookUpCache & cache = LookUpCache::instance();
+  std::vector<TableFileEntry> tables;
+  for (const auto & var : {"svp", "dlsvp", "svpW", "dlsvpW"}) {
+    const auto table = cache.getLookUp(svpPath, var, constants::svpLookUpLength);
+    tables.push_back(TableFileEntry{tableSourceName(constants::commonVarChangeFilePath), var,
+                                    static_cast<std::size_t>(constants::svpLookUpLength), 0,
+                                    std::vector<double>(table.begin(), table.end())});
+  }
+  for (const auto & var : {"qcl_coef", "qcf_coef"}) {
+    const auto table = cache.getLookUp2D(mioPath, var, constants::mioBins, constants::mioLevs);
+    tables.push_back(TableFileEntry{tableSourceName(constants::mioCoefficientsFilePath), var,
+                                    constants::mioBins, constants::mioLevs,
+                                    std::vector<double>(table.begin(), table.end())});
+  }
+  // and the derived level-major MIO table, so that getMIOFields maps it too
+  const auto levelMajor = cache.getMIOCoeffLevelMajor(mioPath);
+  tables.push_back(TableFileEntry{tableSourceName(constants::mioCoefficientsFilePath),
+                                  LookUpCache::mioLevelMajorName, 2 * constants::mioBins,
+                                  constants::mioLevs,
+                                  std::vector<double>(levelMajor.begin(), levelMajor.end())});
+
+  TableFile::write(output, tables);
+
+  // Map it back and check it
+  const TableFile tableFile(output);
+  for (const auto & table : tables) {
+    const double * mapped = tableFile.find(table.source, table.name, table.dim1, table.dim2);
+    if (mapped == nullptr ||
+        std::memcmp(mapped, table.values.data(), table.values.size() * sizeof(double)) != 0) {
+      std::cerr << "vader_convert_lookup_tables: " << table.source << ":" << table.name
+                << " differs in " << output << std::endl;
+      return 1;
+    }
+  }
+  std::cout << "vader_convert_lookup_tables: wrote " << tables.size() << " tables to "
+            << output << std::endl;
+  return 0;
+}